@@ -113,6 +113,11 @@ class AArch64Arch : public Arch {
       uint64_t address, const std::string &instr_bytes,
       Instruction &inst) const override;
 
+  // Decode only the length, category and branch target of an instruction.
+  bool DecodeInstructionBoundary(
+      uint64_t address, const uint8_t *bytes, size_t num_bytes,
+      InstructionBoundary &boundary) const override;
+
   // Maximum number of bytes in an instruction.
   uint64_t MaxInstructionSize(void) const override;
 
@@ -801,6 +806,7 @@ bool AArch64Arch::DecodeInstruction(
   inst.pc = address;
   inst.next_pc = address + kInstructionSize;
   inst.category = Instruction::kCategoryInvalid;
+  inst.isel_id = Instruction::kInvalidISelID;
 
   if (kInstructionSize != inst_bytes.size()) {
     inst.category = Instruction::kCategoryError;
@@ -824,6 +830,63 @@ bool AArch64Arch::DecodeInstruction(
     return false;
   }
 
+  // Many decoders append size, arrangement, or condition suffixes to the
+  // name of the iform (e.g. `_64` or `_8B`). The iform only identifies the
+  // semantics function if the name was left as is.
+  if (inst.function == aarch64::InstFormToString(dinst.iform)) {
+    inst.isel_id = static_cast<uint32_t>(dinst.iform);
+  }
+
+  return true;
+}
+
+// Instructions are all the same size, so this only needs to extract the
+// encoding fields, and not build any operands.
+bool AArch64Arch::DecodeInstructionBoundary(
+    uint64_t address, const uint8_t *bytes, size_t num_bytes,
+    InstructionBoundary &boundary) const {
+
+  aarch64::InstData dinst = {};
+  if (kInstructionSize > num_bytes || 0 != (address % kInstructionSize) ||
+      !aarch64::TryExtract(bytes, dinst)) {
+    return false;
+  }
+
+  boundary.pc = address;
+  boundary.next_pc = address + kInstructionSize;
+  boundary.branch_taken_pc = 0;
+  boundary.category = InstCategory(dinst);
+
+  int64_t disp = 0;
+  switch (dinst.iclass) {
+    case aarch64::InstName::B:
+      if (aarch64::InstForm::B_ONLY_CONDBRANCH == dinst.iform) {
+        disp = dinst.imm19.simm19 << 2;
+      } else {
+        disp = dinst.imm26.simm26 << 2;
+      }
+      break;
+
+    case aarch64::InstName::BL:
+      disp = dinst.imm26.simm26 << 2;
+      break;
+
+    case aarch64::InstName::CBZ:
+    case aarch64::InstName::CBNZ:
+      disp = dinst.imm19.simm19 << 2;
+      break;
+
+    case aarch64::InstName::TBZ:
+    case aarch64::InstName::TBNZ:
+      disp = dinst.imm14.simm14 << 2;
+      break;
+
+    default:
+      return true;
+  }
+
+  boundary.branch_taken_pc = static_cast<uint64_t>(
+      static_cast<int64_t>(address) + disp);
   return true;
 }
 
@@ -3630,6 +3693,95 @@ bool TryDecodeLDAR_LR64_LDSTEXCL(const InstData &data, Instruction &inst) {
   return true;
 }
 
+static bool TryDecodeCAS(const InstData &data, Instruction &inst,
+                         RegClass rclass, uint64_t size) {
+  AddRegOperand(inst, kActionWrite, rclass, kUseAsValue, data.Rs);
+  AddRegOperand(inst, kActionRead, rclass, kUseAsValue, data.Rs);
+  AddRegOperand(inst, kActionRead, rclass, kUseAsValue, data.Rt);
+  AddBasePlusOffsetMemOp(inst, kActionWrite, size, data.Rn, 0);
+  return true;
+}
+
+// CASB  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASB_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 8);
+}
+
+// CASAB  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASAB_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 8);
+}
+
+// CASALB  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASALB_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 8);
+}
+
+// CASLB  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASLB_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 8);
+}
+
+// CASH  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASH_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 16);
+}
+
+// CASAH  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASAH_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 16);
+}
+
+// CASALH  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASALH_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 16);
+}
+
+// CASLH  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASLH_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 16);
+}
+
+// CAS  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCAS_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 32);
+}
+
+// CASA  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASA_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 32);
+}
+
+// CASAL  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASAL_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 32);
+}
+
+// CASL  <Ws>, <Wt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASL_C32_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegW, 32);
+}
+
+// CAS  <Xs>, <Xt>, [<Xn|SP>{,#0}]
+bool TryDecodeCAS_C64_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegX, 64);
+}
+
+// CASA  <Xs>, <Xt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASA_C64_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegX, 64);
+}
+
+// CASAL  <Xs>, <Xt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASAL_C64_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegX, 64);
+}
+
+// CASL  <Xs>, <Xt>, [<Xn|SP>{,#0}]
+bool TryDecodeCASL_C64_LDSTEXCL(const InstData &data, Instruction &inst) {
+  return TryDecodeCAS(data, inst, kRegX, 64);
+}
+
 // REV16  <Wd>, <Wn>
 bool TryDecodeREV16_32_DP_1SRC(const InstData &data, Instruction &inst) {
   return TryDecodeRdW_Rn(data, inst, kRegW);
@@ -3994,6 +4146,90 @@ bool TryDecodeRBIT_64_DP_1SRC(const InstData &data, Instruction &inst) {
   return TryDecodeRdW_Rn(data, inst, kRegX);
 }
 
+// CNT  <Vd>.<T>, <Vn>.<T>
+bool TryDecodeCNT_ASIMDMISC_R(const InstData &data, Instruction &inst) {
+  if (data.size) {
+    return false;  // `if size != '00' then ReservedValue();`.
+  }
+  AddArrangementSpecifier(inst, data.Q ? 128 : 64, 8);
+  return TryDecodeRdW_Rn(data, inst, data.Q ? kRegQ : kRegD);
+}
+
+// CLZ  <Vd>.<T>, <Vn>.<T>
+bool TryDecodeCLZ_ASIMDMISC_R(const InstData &data, Instruction &inst) {
+  if (data.size == 3) {
+    return false;  // `if size == '11' then ReservedValue();`.
+  }
+  AddArrangementSpecifier(inst, data.Q ? 128 : 64, 8UL << data.size);
+  return TryDecodeRdW_Rn(data, inst, data.Q ? kRegQ : kRegD);
+}
+
+// CRC32B  <Wd>, <Wn>, <Wm>
+bool TryDecodeCRC32B_32C_DP_2SRC(const InstData &data, Instruction &inst) {
+  return TryDecodeRdW_Rn_Rm(data, inst, kRegW);
+}
+
+// CRC32H  <Wd>, <Wn>, <Wm>
+bool TryDecodeCRC32H_32C_DP_2SRC(const InstData &data, Instruction &inst) {
+  return TryDecodeRdW_Rn_Rm(data, inst, kRegW);
+}
+
+// CRC32W  <Wd>, <Wn>, <Wm>
+bool TryDecodeCRC32W_32C_DP_2SRC(const InstData &data, Instruction &inst) {
+  return TryDecodeRdW_Rn_Rm(data, inst, kRegW);
+}
+
+// CRC32X  <Wd>, <Wn>, <Xm>
+bool TryDecodeCRC32X_64C_DP_2SRC(const InstData &data, Instruction &inst) {
+  AddRegOperand(inst, kActionWrite, kRegW, kUseAsValue, data.Rd);
+  AddRegOperand(inst, kActionRead, kRegW, kUseAsValue, data.Rn);
+  AddRegOperand(inst, kActionRead, kRegX, kUseAsValue, data.Rm);
+  return true;
+}
+
+// CRC32CB  <Wd>, <Wn>, <Wm>
+bool TryDecodeCRC32CB_32C_DP_2SRC(const InstData &data, Instruction &inst) {
+  return TryDecodeRdW_Rn_Rm(data, inst, kRegW);
+}
+
+// CRC32CH  <Wd>, <Wn>, <Wm>
+bool TryDecodeCRC32CH_32C_DP_2SRC(const InstData &data, Instruction &inst) {
+  return TryDecodeRdW_Rn_Rm(data, inst, kRegW);
+}
+
+// CRC32CW  <Wd>, <Wn>, <Wm>
+bool TryDecodeCRC32CW_32C_DP_2SRC(const InstData &data, Instruction &inst) {
+  return TryDecodeRdW_Rn_Rm(data, inst, kRegW);
+}
+
+// CRC32CX  <Wd>, <Wn>, <Xm>
+bool TryDecodeCRC32CX_64C_DP_2SRC(const InstData &data, Instruction &inst) {
+  return TryDecodeCRC32X_64C_DP_2SRC(data, inst);
+}
+
+// AESE  <Vd>.16B, <Vn>.16B
+bool TryDecodeAESE_B_CRYPTOAES(const InstData &data, Instruction &inst) {
+  AddRegOperand(inst, kActionWrite, kRegQ, kUseAsValue, data.Rd);
+  AddRegOperand(inst, kActionRead, kRegQ, kUseAsValue, data.Rd);
+  AddRegOperand(inst, kActionRead, kRegQ, kUseAsValue, data.Rn);
+  return true;
+}
+
+// AESD  <Vd>.16B, <Vn>.16B
+bool TryDecodeAESD_B_CRYPTOAES(const InstData &data, Instruction &inst) {
+  return TryDecodeAESE_B_CRYPTOAES(data, inst);
+}
+
+// AESMC  <Vd>.16B, <Vn>.16B
+bool TryDecodeAESMC_B_CRYPTOAES(const InstData &data, Instruction &inst) {
+  return TryDecodeRdW_Rn(data, inst, kRegQ);
+}
+
+// AESIMC  <Vd>.16B, <Vn>.16B
+bool TryDecodeAESIMC_B_CRYPTOAES(const InstData &data, Instruction &inst) {
+  return TryDecodeRdW_Rn(data, inst, kRegQ);
+}
+
 }  // namespace aarch64
 
 // TODO(pag): We pretend that these are singletons, but they aren't really!
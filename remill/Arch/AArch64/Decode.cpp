@@ -642,44 +642,6 @@ bool TryDecodeSCVTF_ASIMDSHF_C(const InstData &, Instruction &) {
   return false;
 }
 
-// CLZ CLZ_asimdmisc_R:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 0
-//  11 1
-//  12 0 opcode   0
-//  13 0 opcode   1
-//  14 1 opcode   2
-//  15 0 opcode   3
-//  16 0 opcode   4
-//  17 0
-//  18 0
-//  19 0
-//  20 0
-//  21 1
-//  22 x size     0
-//  23 x size     1
-//  24 0
-//  25 1
-//  26 1
-//  27 1
-//  28 0
-//  29 1 U        0
-//  30 x Q        0
-//  31 0
-// CLZ  <Vd>.<T>, <Vn>.<T>
-bool TryDecodeCLZ_ASIMDMISC_R(const InstData &, Instruction &) {
-  return false;
-}
-
 // FCVT FCVT_SH_floatdp1:
 //   0 x Rd       0
 //   1 x Rd       1
@@ -4442,44 +4404,6 @@ bool TryDecodeST1_ASISDLSEP_R4_R4(const InstData &, Instruction &) {
   return false;
 }
 
-// AESIMC AESIMC_B_cryptoaes:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 0
-//  11 1
-//  12 1 D        0
-//  13 1
-//  14 1
-//  15 0
-//  16 0
-//  17 0
-//  18 0
-//  19 1
-//  20 0
-//  21 1
-//  22 0 size     0
-//  23 0 size     1
-//  24 0
-//  25 1
-//  26 1
-//  27 1
-//  28 0
-//  29 0
-//  30 1
-//  31 0
-// AESIMC  <Vd>.16B, <Vn>.16B
-bool TryDecodeAESIMC_B_CRYPTOAES(const InstData &, Instruction &) {
-  return false;
-}
-
 // UADDW UADDW_asimddiff_W:
 //   0 x Rd       0
 //   1 x Rd       1
@@ -5278,44 +5202,6 @@ bool TryDecodeLDUMAXLB_32_MEMOP(const InstData &, Instruction &) {
   return false;
 }
 
-// AESE AESE_B_cryptoaes:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 0
-//  11 1
-//  12 0 D        0
-//  13 0
-//  14 1
-//  15 0
-//  16 0
-//  17 0
-//  18 0
-//  19 1
-//  20 0
-//  21 1
-//  22 0 size     0
-//  23 0 size     1
-//  24 0
-//  25 1
-//  26 1
-//  27 1
-//  28 0
-//  29 0
-//  30 1
-//  31 0
-// AESE  <Vd>.16B, <Vn>.16B
-bool TryDecodeAESE_B_CRYPTOAES(const InstData &, Instruction &) {
-  return false;
-}
-
 // STXR STXR_SR32_ldstexcl:
 //   0 x Rt       0
 //   1 x Rt       1
@@ -10751,82 +10637,6 @@ bool TryDecodeFMAX_D_FLOATDP2(const InstData &, Instruction &) {
   return false;
 }
 
-// AESD AESD_B_cryptoaes:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 0
-//  11 1
-//  12 1 D        0
-//  13 0
-//  14 1
-//  15 0
-//  16 0
-//  17 0
-//  18 0
-//  19 1
-//  20 0
-//  21 1
-//  22 0 size     0
-//  23 0 size     1
-//  24 0
-//  25 1
-//  26 1
-//  27 1
-//  28 0
-//  29 0
-//  30 1
-//  31 0
-// AESD  <Vd>.16B, <Vn>.16B
-bool TryDecodeAESD_B_CRYPTOAES(const InstData &, Instruction &) {
-  return false;
-}
-
-// AESMC AESMC_B_cryptoaes:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 0
-//  11 1
-//  12 0 D        0
-//  13 1
-//  14 1
-//  15 0
-//  16 0
-//  17 0
-//  18 0
-//  19 1
-//  20 0
-//  21 1
-//  22 0 size     0
-//  23 0 size     1
-//  24 0
-//  25 1
-//  26 1
-//  27 1
-//  28 0
-//  29 0
-//  30 1
-//  31 0
-// AESMC  <Vd>.16B, <Vn>.16B
-bool TryDecodeAESMC_B_CRYPTOAES(const InstData &, Instruction &) {
-  return false;
-}
-
 // LD2 LD2_asisdlso_B2_2b:
 //   0 x Rt       0
 //   1 x Rt       1
@@ -14172,310 +13982,6 @@ bool TryDecodeFRINTP_D_FLOATDP1(const InstData &, Instruction &) {
   return false;
 }
 
-// CASA CASA_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 0 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 1 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 0 size     0
-//  31 1 size     1
-// CASA  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASA_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CASAL CASAL_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 1 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 1 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 0 size     0
-//  31 1 size     1
-// CASAL  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASAL_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CAS CAS_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 0 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 0 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 0 size     0
-//  31 1 size     1
-// CAS  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCAS_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CASL CASL_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 1 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 0 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 0 size     0
-//  31 1 size     1
-// CASL  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASL_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CASA CASA_C64_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 0 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 1 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 1 size     0
-//  31 1 size     1
-// CASA  <Xs>, <Xt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASA_C64_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CASAL CASAL_C64_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 1 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 1 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 1 size     0
-//  31 1 size     1
-// CASAL  <Xs>, <Xt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASAL_C64_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CAS CAS_C64_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 0 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 0 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 1 size     0
-//  31 1 size     1
-// CAS  <Xs>, <Xt>, [<Xn|SP>{,#0}]
-bool TryDecodeCAS_C64_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CASL CASL_C64_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 1 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 0 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 1 size     0
-//  31 1 size     1
-// CASL  <Xs>, <Xt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASL_C64_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
 // WFE WFE_HI_system:
 //   0 1 Rt       0
 //   1 1 Rt       1
@@ -15426,158 +14932,6 @@ bool TryDecodeCMEQ_ASISDSAME_ONLY(const InstData &, Instruction &) {
   return false;
 }
 
-// CRC32CB CRC32CB_32C_dp_2src:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 0 sz       0
-//  11 0 sz       1
-//  12 1 C        0
-//  13 0 opcode2  3
-//  14 1 opcode2  4
-//  15 0 opcode2  5
-//  16 x Rm       0
-//  17 x Rm       1
-//  18 x Rm       2
-//  19 x Rm       3
-//  20 x Rm       4
-//  21 0
-//  22 1
-//  23 1
-//  24 0
-//  25 1
-//  26 0
-//  27 1
-//  28 1
-//  29 0 S        0
-//  30 0 op       0
-//  31 0 sf       0
-// CRC32CB  <Wd>, <Wn>, <Wm>
-bool TryDecodeCRC32CB_32C_DP_2SRC(const InstData &, Instruction &) {
-  return false;
-}
-
-// CRC32CH CRC32CH_32C_dp_2src:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 sz       0
-//  11 0 sz       1
-//  12 1 C        0
-//  13 0 opcode2  3
-//  14 1 opcode2  4
-//  15 0 opcode2  5
-//  16 x Rm       0
-//  17 x Rm       1
-//  18 x Rm       2
-//  19 x Rm       3
-//  20 x Rm       4
-//  21 0
-//  22 1
-//  23 1
-//  24 0
-//  25 1
-//  26 0
-//  27 1
-//  28 1
-//  29 0 S        0
-//  30 0 op       0
-//  31 0 sf       0
-// CRC32CH  <Wd>, <Wn>, <Wm>
-bool TryDecodeCRC32CH_32C_DP_2SRC(const InstData &, Instruction &) {
-  return false;
-}
-
-// CRC32CW CRC32CW_32C_dp_2src:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 0 sz       0
-//  11 1 sz       1
-//  12 1 C        0
-//  13 0 opcode2  3
-//  14 1 opcode2  4
-//  15 0 opcode2  5
-//  16 x Rm       0
-//  17 x Rm       1
-//  18 x Rm       2
-//  19 x Rm       3
-//  20 x Rm       4
-//  21 0
-//  22 1
-//  23 1
-//  24 0
-//  25 1
-//  26 0
-//  27 1
-//  28 1
-//  29 0 S        0
-//  30 0 op       0
-//  31 0 sf       0
-// CRC32CW  <Wd>, <Wn>, <Wm>
-bool TryDecodeCRC32CW_32C_DP_2SRC(const InstData &, Instruction &) {
-  return false;
-}
-
-// CRC32CX CRC32CX_64C_dp_2src:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 sz       0
-//  11 1 sz       1
-//  12 1 C        0
-//  13 0 opcode2  3
-//  14 1 opcode2  4
-//  15 0 opcode2  5
-//  16 x Rm       0
-//  17 x Rm       1
-//  18 x Rm       2
-//  19 x Rm       3
-//  20 x Rm       4
-//  21 0
-//  22 1
-//  23 1
-//  24 0
-//  25 1
-//  26 0
-//  27 1
-//  28 1
-//  29 0 S        0
-//  30 0 op       0
-//  31 1 sf       0
-// CRC32CX  <Wd>, <Wn>, <Xm>
-bool TryDecodeCRC32CX_64C_DP_2SRC(const InstData &, Instruction &) {
-  return false;
-}
-
 // UADDLP UADDLP_asimdmisc_P:
 //   0 x Rd       0
 //   1 x Rd       1
@@ -22836,158 +22190,6 @@ bool TryDecodeUHADD_ASIMDSAME_ONLY(const InstData &, Instruction &) {
   return false;
 }
 
-// CASAH CASAH_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 0 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 1 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 1 size     0
-//  31 0 size     1
-// CASAH  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASAH_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CASALH CASALH_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 1 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 1 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 1 size     0
-//  31 0 size     1
-// CASALH  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASALH_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CASH CASH_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 0 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 0 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 1 size     0
-//  31 0 size     1
-// CASH  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASH_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CASLH CASLH_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 1 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 0 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 1 size     0
-//  31 0 size     1
-// CASLH  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASLH_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
 // ADCS ADCS_32_addsub_carry:
 //   0 x Rd       0
 //   1 x Rd       1
@@ -29982,158 +29184,6 @@ bool TryDecodePRFM_P_LOADLIT(const InstData &, Instruction &) {
   return false;
 }
 
-// CASAB CASAB_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 0 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 1 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 0 size     0
-//  31 0 size     1
-// CASAB  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASAB_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CASALB CASALB_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 1 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 1 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 0 size     0
-//  31 0 size     1
-// CASALB  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASALB_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CASB CASB_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 0 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 0 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 0 size     0
-//  31 0 size     1
-// CASB  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASB_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
-// CASLB CASLB_C32_ldstexcl:
-//   0 x Rt       0
-//   1 x Rt       1
-//   2 x Rt       2
-//   3 x Rt       3
-//   4 x Rt       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 Rt2      0
-//  11 1 Rt2      1
-//  12 1 Rt2      2
-//  13 1 Rt2      3
-//  14 1 Rt2      4
-//  15 1 o0       0
-//  16 x Rs       0
-//  17 x Rs       1
-//  18 x Rs       2
-//  19 x Rs       3
-//  20 x Rs       4
-//  21 1 o1       0
-//  22 0 L        0
-//  23 1 o2       0
-//  24 0
-//  25 0
-//  26 0
-//  27 1
-//  28 0
-//  29 0
-//  30 0 size     0
-//  31 0 size     1
-// CASLB  <Ws>, <Wt>, [<Xn|SP>{,#0}]
-bool TryDecodeCASLB_C32_LDSTEXCL(const InstData &, Instruction &) {
-  return false;
-}
-
 // SUBS NEGS_SUBS_32_addsub_shift:
 //   0 x Rd       0
 //   1 x Rd       1
@@ -30895,44 +29945,6 @@ bool TryDecodeFMAXNM_D_FLOATDP2(const InstData &, Instruction &) {
   return false;
 }
 
-// CNT CNT_asimdmisc_R:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 0
-//  11 1
-//  12 1 opcode   0
-//  13 0 opcode   1
-//  14 1 opcode   2
-//  15 0 opcode   3
-//  16 0 opcode   4
-//  17 0
-//  18 0
-//  19 0
-//  20 0
-//  21 1
-//  22 x size     0
-//  23 x size     1
-//  24 0
-//  25 1
-//  26 1
-//  27 1
-//  28 0
-//  29 0 U        0
-//  30 x Q        0
-//  31 0
-// CNT  <Vd>.<T>, <Vn>.<T>
-bool TryDecodeCNT_ASIMDMISC_R(const InstData &, Instruction &) {
-  return false;
-}
-
 // SQSHL SQSHL_asisdshf_R:
 //   0 x Rd       0
 //   1 x Rd       1
@@ -36747,158 +35759,6 @@ bool TryDecodeLD4_ASISDLSOP_DX4_R4D(const InstData &, Instruction &) {
   return false;
 }
 
-// CRC32B CRC32B_32C_dp_2src:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 0 sz       0
-//  11 0 sz       1
-//  12 0 C        0
-//  13 0 opcode2  3
-//  14 1 opcode2  4
-//  15 0 opcode2  5
-//  16 x Rm       0
-//  17 x Rm       1
-//  18 x Rm       2
-//  19 x Rm       3
-//  20 x Rm       4
-//  21 0
-//  22 1
-//  23 1
-//  24 0
-//  25 1
-//  26 0
-//  27 1
-//  28 1
-//  29 0 S        0
-//  30 0 op       0
-//  31 0 sf       0
-// CRC32B  <Wd>, <Wn>, <Wm>
-bool TryDecodeCRC32B_32C_DP_2SRC(const InstData &, Instruction &) {
-  return false;
-}
-
-// CRC32H CRC32H_32C_dp_2src:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 sz       0
-//  11 0 sz       1
-//  12 0 C        0
-//  13 0 opcode2  3
-//  14 1 opcode2  4
-//  15 0 opcode2  5
-//  16 x Rm       0
-//  17 x Rm       1
-//  18 x Rm       2
-//  19 x Rm       3
-//  20 x Rm       4
-//  21 0
-//  22 1
-//  23 1
-//  24 0
-//  25 1
-//  26 0
-//  27 1
-//  28 1
-//  29 0 S        0
-//  30 0 op       0
-//  31 0 sf       0
-// CRC32H  <Wd>, <Wn>, <Wm>
-bool TryDecodeCRC32H_32C_DP_2SRC(const InstData &, Instruction &) {
-  return false;
-}
-
-// CRC32W CRC32W_32C_dp_2src:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 0 sz       0
-//  11 1 sz       1
-//  12 0 C        0
-//  13 0 opcode2  3
-//  14 1 opcode2  4
-//  15 0 opcode2  5
-//  16 x Rm       0
-//  17 x Rm       1
-//  18 x Rm       2
-//  19 x Rm       3
-//  20 x Rm       4
-//  21 0
-//  22 1
-//  23 1
-//  24 0
-//  25 1
-//  26 0
-//  27 1
-//  28 1
-//  29 0 S        0
-//  30 0 op       0
-//  31 0 sf       0
-// CRC32W  <Wd>, <Wn>, <Wm>
-bool TryDecodeCRC32W_32C_DP_2SRC(const InstData &, Instruction &) {
-  return false;
-}
-
-// CRC32X CRC32X_64C_dp_2src:
-//   0 x Rd       0
-//   1 x Rd       1
-//   2 x Rd       2
-//   3 x Rd       3
-//   4 x Rd       4
-//   5 x Rn       0
-//   6 x Rn       1
-//   7 x Rn       2
-//   8 x Rn       3
-//   9 x Rn       4
-//  10 1 sz       0
-//  11 1 sz       1
-//  12 0 C        0
-//  13 0 opcode2  3
-//  14 1 opcode2  4
-//  15 0 opcode2  5
-//  16 x Rm       0
-//  17 x Rm       1
-//  18 x Rm       2
-//  19 x Rm       3
-//  20 x Rm       4
-//  21 0
-//  22 1
-//  23 1
-//  24 0
-//  25 1
-//  26 0
-//  27 1
-//  28 1
-//  29 0 S        0
-//  30 0 op       0
-//  31 1 sf       0
-// CRC32X  <Wd>, <Wn>, <Xm>
-bool TryDecodeCRC32X_64C_DP_2SRC(const InstData &, Instruction &) {
-  return false;
-}
-
 // URSHR URSHR_asisdshf_R:
 //   0 x Rd       0
 //   1 x Rd       1
@@ -16,6 +16,7 @@
 
 #include "remill/Arch/Runtime/Intrinsics.h"
 #include "remill/Arch/Runtime/Operators.h"
+#include "remill/Arch/Runtime/Crypto.h"
 
 #include <fenv.h>
 #include <algorithm>
@@ -106,6 +107,7 @@ DEF_ISEL(INVALID_INSTRUCTION) = HandleInvalidInstruction;
 #include "remill/Arch/AArch64/Semantics/BRANCH.cpp"
 #include "remill/Arch/AArch64/Semantics/CALL_RET.cpp"
 #include "remill/Arch/AArch64/Semantics/CONVERT.cpp"
+#include "remill/Arch/AArch64/Semantics/CRYPTO.cpp"
 #include "remill/Arch/AArch64/Semantics/DATAXFER.cpp"
 #include "remill/Arch/AArch64/Semantics/LOGICAL.cpp"
 #include "remill/Arch/AArch64/Semantics/MISC.cpp"
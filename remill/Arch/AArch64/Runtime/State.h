@@ -37,6 +37,48 @@ static_assert(0 == __builtin_offsetof(Reg, dword),
 static_assert(0 == __builtin_offsetof(Reg, qword),
               "Invalid packing of `Reg::qword`.");
 
+#if DENSE_STATE
+
+struct alignas(8) GPR final {
+  Reg x0;
+  Reg x1;
+  Reg x2;
+  Reg x3;
+  Reg x4;
+  Reg x5;
+  Reg x6;
+  Reg x7;
+  Reg x8;
+  Reg x9;
+  Reg x10;
+  Reg x11;
+  Reg x12;
+  Reg x13;
+  Reg x14;
+  Reg x15;
+  Reg x16;
+  Reg x17;
+  Reg x18;
+  Reg x19;
+  Reg x20;
+  Reg x21;
+  Reg x22;
+  Reg x23;
+  Reg x24;
+  Reg x25;
+  Reg x26;
+  Reg x27;
+  Reg x28;
+  Reg x29;
+  Reg x30;
+  Reg sp;  // Stack pointer.
+  Reg pc;  // Program counter of the CURRENT instruction!
+} __attribute__((packed));
+
+static_assert(264 == sizeof(GPR), "Invalid structure packing of `GPR`.");
+
+#else
+
 struct alignas(8) GPR final {
   // Prevents LLVM from casting a `GPR` into an `i64` to access `X0`.
   volatile uint64_t _0;
@@ -112,6 +154,8 @@ struct alignas(8) GPR final {
 
 static_assert(528 == sizeof(GPR), "Invalid structure packing of `GPR`.");
 
+#endif  // DENSE_STATE
+
 union PSTATE final {
   uint64_t flat;
   struct {
@@ -238,6 +282,27 @@ union FPSR {
 static_assert(sizeof(FPSR) == 8, "Invalid packing of `union FPSR`.");
 
 // System registers affecting control and status of the machine.
+#if DENSE_STATE
+
+struct alignas(8) SR final {
+  Reg tpidr_el0;  // Thread pointer for EL0.
+  Reg tpidrro_el0;  // Read-only thread pointer for EL0.
+
+  bool n;  //  Negative condition flag.
+  bool z;  //  Zero condition flag
+  bool c;  //  Carry condition flag
+  bool v;  //  Overflow condition flag
+
+  bool ixc;  // Inexact (cumulative).
+  bool ofc;  // Overflow (cumulative).
+  bool ufc;  // Underflow (cumulative).
+  bool idc;  // Input denormal (cumulative).
+} __attribute__((packed));
+
+static_assert((3 * 8) == sizeof(SR), "Invalid packing of `struct SR`.");
+
+#else
+
 struct alignas(8) SR final {
   uint64_t _0;
   Reg tpidr_el0;  // Thread pointer for EL0.
@@ -266,6 +331,8 @@ struct alignas(8) SR final {
 
 static_assert((6 * 8) == sizeof(SR), "Invalid packing of `struct SR`.");
 
+#endif  // DENSE_STATE
+
 enum : size_t {
   kNumVecRegisters = 32
 };
@@ -276,6 +343,29 @@ struct alignas(16) SIMD {
 
 static_assert(512 == sizeof(SIMD), "Invalid packing of `struct SIMD`.");
 
+#if DENSE_STATE
+
+// The general purpose registers, flags, and system registers are packed into
+// the first five cache lines, and the vector registers start on a cache line
+// boundary.
+struct alignas(16) State final : public ArchState {
+  GPR gpr;  // 264 bytes.
+  NZCV nzcv;  // 8 bytes (high 4 are unused).
+  FPCR fpcr;  // 8 bytes (high 4 are unused).
+  FPSR fpsr;  // 8 bytes (high 4 are unused).
+  SR sr;  // 24 bytes.
+  uint8_t _0[56];  // Pad to a 64-byte boundary.
+
+  SIMD simd;  // 512 bytes.
+} __attribute__((packed));
+
+static_assert(896 == sizeof(State), "Invalid packing of `struct State`");
+
+static_assert(0 == (__builtin_offsetof(State, simd) % 64),
+              "Invalid packing of `struct State`");
+
+#else
+
 struct alignas(16) State final : public ArchState {
   SIMD simd;  // 512 bytes.
 
@@ -298,6 +388,8 @@ struct alignas(16) State final : public ArchState {
 static_assert((1136 + 16) == sizeof(State),
               "Invalid packing of `struct State`");
 
+#endif  // DENSE_STATE
+
 using AArch64State = State;
 
 #pragma clang diagnostic pop
@@ -100,9 +100,10 @@ namespace {
 
 template <typename D, typename S>
 DEF_SEM(CLZ, D dst, S src) {
-    auto count = CountLeadingZeros(Read(src));
-    WriteZExt(dst, count);
-    return memory;
+  auto val = Read(src);
+  auto count = CountLeadingZeros(val);
+  WriteZExt(dst, Select(UCmpEq(val, 0), BitSizeOf(src), count));
+  return memory;
 }
 }  // namespace
 
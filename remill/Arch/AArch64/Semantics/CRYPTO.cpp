@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace {
+
+// `AESE` and `AESD` add the round key before substitution, whereas x86 adds
+// it at the end of the round.
+DEF_SEM(AESE, V128W dst, V128 src1, V128 src2) {
+  auto block = AESAddRoundKey(UReadV8(src1), UReadV8(src2));
+  UWriteV8(dst, AESEncryptLastRound(block, UClearV8(block)));
+  return memory;
+}
+
+DEF_SEM(AESD, V128W dst, V128 src1, V128 src2) {
+  auto block = AESAddRoundKey(UReadV8(src1), UReadV8(src2));
+  UWriteV8(dst, AESDecryptLastRound(block, UClearV8(block)));
+  return memory;
+}
+
+DEF_SEM(AESMC, V128W dst, V128 src) {
+  UWriteV8(dst, AESMixColumns(UReadV8(src)));
+  return memory;
+}
+
+DEF_SEM(AESIMC, V128W dst, V128 src) {
+  UWriteV8(dst, AESInvMixColumns(UReadV8(src)));
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(AESE_B_CRYPTOAES) = AESE;
+DEF_ISEL(AESD_B_CRYPTOAES) = AESD;
+DEF_ISEL(AESMC_B_CRYPTOAES) = AESMC;
+DEF_ISEL(AESIMC_B_CRYPTOAES) = AESIMC;
+
+namespace {
+
+template <typename S, typename T>
+DEF_SEM(DoCRC32, R32W dst, R32 src1, S src2) {
+  WriteZExt(dst, CRC32(Read(src1), TruncTo<T>(Read(src2))));
+  return memory;
+}
+
+template <typename S, typename T>
+DEF_SEM(DoCRC32C, R32W dst, R32 src1, S src2) {
+  WriteZExt(dst, CRC32C(Read(src1), TruncTo<T>(Read(src2))));
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(CRC32B_32C_DP_2SRC) = DoCRC32<R32, uint8_t>;
+DEF_ISEL(CRC32H_32C_DP_2SRC) = DoCRC32<R32, uint16_t>;
+DEF_ISEL(CRC32W_32C_DP_2SRC) = DoCRC32<R32, uint32_t>;
+DEF_ISEL(CRC32X_64C_DP_2SRC) = DoCRC32<R64, uint64_t>;
+
+DEF_ISEL(CRC32CB_32C_DP_2SRC) = DoCRC32C<R32, uint8_t>;
+DEF_ISEL(CRC32CH_32C_DP_2SRC) = DoCRC32C<R32, uint16_t>;
+DEF_ISEL(CRC32CW_32C_DP_2SRC) = DoCRC32C<R32, uint32_t>;
+DEF_ISEL(CRC32CX_64C_DP_2SRC) = DoCRC32C<R64, uint64_t>;
@@ -654,6 +654,41 @@ DEF_ISEL(LDAR_LR64_LDSTEXCL) = LoadAcquire<R64W, M64>;
 
 namespace {
 
+// The compare-and-swap intrinsics are sequentially consistent, so the acquire
+// and release variants share this implementation.
+template <typename D, typename S, typename M>
+DEF_SEM(CAS, D dst, S cmp_val, S new_val, M addr) {
+  auto expected = TruncTo<M>(Read(cmp_val));
+  auto desired = TruncTo<M>(Read(new_val));
+  (void) CompareAndSwap(addr, expected, desired);
+  WriteZExt(dst, expected);
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(CASB_C32_LDSTEXCL) = CAS<R32W, R32, M8W>;
+DEF_ISEL(CASAB_C32_LDSTEXCL) = CAS<R32W, R32, M8W>;
+DEF_ISEL(CASALB_C32_LDSTEXCL) = CAS<R32W, R32, M8W>;
+DEF_ISEL(CASLB_C32_LDSTEXCL) = CAS<R32W, R32, M8W>;
+
+DEF_ISEL(CASH_C32_LDSTEXCL) = CAS<R32W, R32, M16W>;
+DEF_ISEL(CASAH_C32_LDSTEXCL) = CAS<R32W, R32, M16W>;
+DEF_ISEL(CASALH_C32_LDSTEXCL) = CAS<R32W, R32, M16W>;
+DEF_ISEL(CASLH_C32_LDSTEXCL) = CAS<R32W, R32, M16W>;
+
+DEF_ISEL(CAS_C32_LDSTEXCL) = CAS<R32W, R32, M32W>;
+DEF_ISEL(CASA_C32_LDSTEXCL) = CAS<R32W, R32, M32W>;
+DEF_ISEL(CASAL_C32_LDSTEXCL) = CAS<R32W, R32, M32W>;
+DEF_ISEL(CASL_C32_LDSTEXCL) = CAS<R32W, R32, M32W>;
+
+DEF_ISEL(CAS_C64_LDSTEXCL) = CAS<R64W, R64, M64W>;
+DEF_ISEL(CASA_C64_LDSTEXCL) = CAS<R64W, R64, M64W>;
+DEF_ISEL(CASAL_C64_LDSTEXCL) = CAS<R64W, R64, M64W>;
+DEF_ISEL(CASL_C64_LDSTEXCL) = CAS<R64W, R64, M64W>;
+
+namespace {
+
 #define MAKE_LD1_POSTINDEX(esize) \
     template <typename S> \
     DEF_SEM(LD1_SINGLE_POSTINDEX_ ## esize, V128W dst1, S src, \
@@ -464,3 +464,50 @@ DEF_ISEL(SMAXP_ASIMDSAME_ONLY_4H) = SMAXP_16<V64, int16v4_t>;
 DEF_ISEL(SMAXP_ASIMDSAME_ONLY_8H) = SMAXP_16<V128, int16v8_t>;
 DEF_ISEL(SMAXP_ASIMDSAME_ONLY_2S) = SMAXP_32<V64, int32v2_t>;
 DEF_ISEL(SMAXP_ASIMDSAME_ONLY_4S) = SMAXP_32<V128, int32v4_t>;
+
+namespace {
+
+template <typename S, typename V>
+DEF_SEM(CNT, V128W dst, S src) {
+  auto vec = UReadV8(src);
+  V res = {};
+  _Pragma("unroll")
+  for (size_t i = 0, max_i = NumVectorElems(res); i < max_i; ++i) {
+    res.elems[i] = PopulationCount(UExtractV8(vec, i));
+  }
+  UWriteV8(dst, res);
+  return memory;
+}
+
+#define MAKE_CLZ(size) \
+    template <typename S, typename V> \
+    DEF_SEM(CLZ_ ## size, V128W dst, S src) { \
+      auto vec = UReadV ## size(src); \
+      V res = {}; \
+      _Pragma("unroll") \
+      for (size_t i = 0, max_i = NumVectorElems(res); i < max_i; ++i) { \
+        auto elem = UExtractV ## size(vec, i); \
+        res.elems[i] = Select(UCmpEq(elem, 0), BitSizeOf(elem), \
+                              CountLeadingZeros(elem)); \
+      } \
+      UWriteV ## size(dst, res); \
+      return memory; \
+    }
+
+MAKE_CLZ(8)
+MAKE_CLZ(16)
+MAKE_CLZ(32)
+
+#undef MAKE_CLZ
+
+}  // namespace
+
+DEF_ISEL(CNT_ASIMDMISC_R_8B) = CNT<V64, uint8v8_t>;
+DEF_ISEL(CNT_ASIMDMISC_R_16B) = CNT<V128, uint8v16_t>;
+
+DEF_ISEL(CLZ_ASIMDMISC_R_8B) = CLZ_8<V64, uint8v8_t>;
+DEF_ISEL(CLZ_ASIMDMISC_R_16B) = CLZ_8<V128, uint8v16_t>;
+DEF_ISEL(CLZ_ASIMDMISC_R_4H) = CLZ_16<V64, uint16v4_t>;
+DEF_ISEL(CLZ_ASIMDMISC_R_8H) = CLZ_16<V128, uint16v8_t>;
+DEF_ISEL(CLZ_ASIMDMISC_R_2S) = CLZ_32<V64, uint32v2_t>;
+DEF_ISEL(CLZ_ASIMDMISC_R_4S) = CLZ_32<V128, uint32v4_t>;
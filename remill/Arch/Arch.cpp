@@ -17,7 +17,9 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <memory>
+#include <string>
 #include <unordered_map>
 
 #include <llvm/ADT/SmallVector.h>
@@ -31,6 +33,7 @@
 #include <llvm/IR/Module.h>
 
 #include "remill/Arch/Arch.h"
+#include "remill/Arch/Instruction.h"
 #include "remill/Arch/Name.h"
 
 #include "remill/BC/ABI.h"
@@ -40,6 +43,7 @@
 #include "remill/BC/Util.h"
 #include "remill/BC/Version.h"
 
+#include "remill/OS/Image.h"
 #include "remill/OS/OS.h"
 
 DEFINE_string(arch, "",
@@ -53,6 +57,11 @@ DECLARE_string(os);
 namespace remill {
 namespace {
 
+// Upper bound on the size of an instruction on any architecture.
+enum : uint64_t {
+  kMaxInstructionSize = 16
+};
+
 static unsigned AddressSize(ArchName arch_name) {
   switch (arch_name) {
     case kArchInvalid:
@@ -88,6 +97,67 @@ Arch::Arch(OSName os_name_, ArchName arch_name_)
 
 Arch::~Arch(void) {}
 
+// Architectures without a faster way of finding instruction boundaries fall
+// back on fully decoding the instruction.
+bool Arch::DecodeInstructionBoundary(
+    uint64_t address, const uint8_t *bytes, size_t num_bytes,
+    InstructionBoundary &boundary) const {
+  Instruction inst;
+  std::string inst_bytes(
+      reinterpret_cast<const char *>(bytes),
+      std::min<uint64_t>(num_bytes, MaxInstructionSize()));
+  if (!DecodeInstruction(address, inst_bytes, inst)) {
+    return false;
+  }
+  boundary.pc = inst.pc;
+  boundary.next_pc = inst.next_pc;
+  boundary.branch_taken_pc = inst.branch_taken_pc;
+  boundary.category = inst.category;
+  return true;
+}
+
+// Instructions that are entirely backed by the file are decoded in place.
+// Otherwise, e.g. near the end of a segment, the bytes are copied out first.
+bool Arch::DecodeInstructionBoundary(
+    uint64_t address, const MappedImage &image,
+    InstructionBoundary &boundary) const {
+  if (!image.IsExecutable(address)) {
+    return false;
+  }
+
+  const auto max_size = MaxInstructionSize();
+  size_t num_bytes = 0;
+  auto bytes = image.ToPointer(address, &num_bytes);
+  if (bytes && num_bytes >= max_size) {
+    return DecodeInstructionBoundary(address, bytes, num_bytes, boundary);
+  }
+
+  uint8_t buff[kMaxInstructionSize];
+  num_bytes = image.Read(
+      address, buff, std::min<uint64_t>(max_size, kMaxInstructionSize));
+  return DecodeInstructionBoundary(address, buff, num_bytes, boundary);
+}
+
+bool Arch::DecodeInstruction(uint64_t address, const MappedImage &image,
+                             Instruction &inst) const {
+  if (!image.IsExecutable(address)) {
+    return false;
+  }
+
+  const auto max_size = MaxInstructionSize();
+  size_t num_bytes = 0;
+  auto bytes = image.ToPointer(address, &num_bytes);
+  if (bytes && num_bytes >= max_size) {
+    return DecodeInstruction(
+        address, std::string(reinterpret_cast<const char *>(bytes), max_size),
+        inst);
+  }
+
+  std::string inst_bytes(max_size, '\0');
+  inst_bytes.resize(image.Read(address, &(inst_bytes[0]), max_size));
+  return DecodeInstruction(address, inst_bytes, inst);
+}
+
 llvm::Triple Arch::BasicTriple(void) const {
   llvm::Triple triple;
   switch (os_name) {
@@ -17,6 +17,8 @@
 #ifndef REMILL_ARCH_ARCH_H_
 #define REMILL_ARCH_ARCH_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -38,6 +40,8 @@ enum OSName : uint32_t;
 enum ArchName : uint32_t;
 
 class Instruction;
+class MappedImage;
+struct InstructionBoundary;
 
 class Arch {
  public:
@@ -60,6 +64,25 @@ class Arch {
       uint64_t address, const std::string &instr_bytes,
       Instruction &inst) const = 0;
 
+  // Decode only the length and category of the instruction at `address`, and
+  // the target of a direct jump, call or conditional branch. This is meant for
+  // passes that only need instruction boundaries and control flow (e.g. linear
+  // sweeps), and skips building operands. If `DecodeInstruction` succeeds on
+  // the same bytes, then this succeeds and agrees with it, but this may also
+  // succeed on some bytes that `DecodeInstruction` rejects.
+  virtual bool DecodeInstructionBoundary(
+      uint64_t address, const uint8_t *bytes, size_t num_bytes,
+      InstructionBoundary &boundary) const;
+
+  // Decode the instruction at `address` in `image`. The instruction's bytes
+  // are read directly out of the mapped image. Returns `false` if `address`
+  // isn't executable, or if the instruction doesn't decode.
+  bool DecodeInstruction(uint64_t address, const MappedImage &image,
+                         Instruction &inst) const;
+
+  bool DecodeInstructionBoundary(uint64_t address, const MappedImage &image,
+                                 InstructionBoundary &boundary) const;
+
   // Maximum number of bytes in an instruction for this particular architecture.
   virtual uint64_t MaxInstructionSize(void) const = 0;
 
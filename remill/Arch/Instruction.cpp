@@ -242,23 +242,23 @@ std::string Operand::Serialize(void) const {
 }
 
 Instruction::Instruction(void)
-    : pc(0),
+    : isel_id(kInvalidISelID),
+      pc(0),
       next_pc(0),
       branch_taken_pc(0),
       branch_not_taken_pc(0),
       arch_name(kArchInvalid),
       operand_size(0),
-      is_atomic_read_modify_write(false),
       category(Instruction::kCategoryInvalid) {}
 
 void Instruction::Reset(void) {
+  isel_id = kInvalidISelID;
   pc = 0;
   next_pc = 0;
   branch_taken_pc = 0;
   branch_not_taken_pc = 0;
   arch_name = kArchInvalid;
   operand_size = 0;
-  is_atomic_read_modify_write = false;
   category = Instruction::kCategoryInvalid;
   operands.clear();
 }
@@ -301,10 +301,6 @@ std::string Instruction::Serialize(void) const {
          << std::hex << static_cast<unsigned>(static_cast<uint8_t>(byte));
     }
     ss << ") ";
-
-    if (is_atomic_read_modify_write) {
-      ss << "ATOMIC ";
-    }
   } else {
     ss << " ";
   }
@@ -143,6 +143,15 @@ class Instruction {
   // Name of semantics function that implements this instruction.
   std::string function;
 
+  // Architecture-specific numeric ID of `function`, or `kInvalidISelID`. IDs
+  // are small and dense, so they can index tables of semantics functions.
+  // Code that changes `function` after decoding must reset this.
+  uint32_t isel_id;
+
+  enum : uint32_t {
+    kInvalidISelID = ~0U
+  };
+
   // The decoded bytes of the instruction.
   std::string bytes;
 
@@ -161,10 +170,6 @@ class Instruction {
   // The effective size of the operand, in bits.
   uint64_t operand_size;
 
-  // Does the instruction require the use of the `__remill_atomic_begin` and
-  // `__remill_atomic_end`?
-  bool is_atomic_read_modify_write;
-
   enum Category {
     kCategoryInvalid,
     kCategoryNormal,
@@ -252,6 +257,23 @@ class Instruction {
   }
 };
 
+// The length and control-flow category of an instruction, without any of its
+// operands. See `Arch::DecodeInstructionBoundary`.
+struct InstructionBoundary {
+  uint64_t pc;
+  uint64_t next_pc;
+
+  // Target of a direct jump, direct function call, or conditional branch.
+  uint64_t branch_taken_pc;
+
+  Instruction::Category category;
+
+  // Length, in bytes, of the instruction.
+  inline uint64_t NumBytes(void) const {
+    return next_pc - pc;
+  }
+};
+
 }  // namespace remill
 
 #endif  // REMILL_ARCH_INSTRUCTION_H_
@@ -0,0 +1,708 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <cctype>
+#include <ios>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "remill/Arch/Arch.h"
+#include "remill/Arch/Instruction.h"
+#include "remill/Arch/JumpTable.h"
+#include "remill/OS/Image.h"
+
+namespace remill {
+namespace {
+
+// Tables without a bounds check are scanned up to this many entries.
+static constexpr uint64_t kMaxJumpTableEntries = 1024;
+
+// What is known about the value of a register at some point along the path.
+struct Value {
+  enum Kind {
+    kUnknown,
+    kConstant,
+
+    // `(Load(table + index * scale) << shift) + addend`, where the loaded
+    // entry is `entry_size` bytes, and is sign-extended if `is_signed`.
+    kTableEntry
+  } kind;
+
+  // `kUnknown` values are identified by where they were defined, so that a
+  // bounds check on a register can be matched with the use of that same
+  // value as a table index.
+  std::string origin;
+
+  uint64_t constant;
+
+  uint64_t table;
+  std::string index;
+  uint64_t scale;
+  uint64_t entry_size;
+  bool is_signed;
+  uint64_t shift;
+  uint64_t addend;
+
+  Value(void)
+      : kind(kUnknown),
+        constant(0),
+        table(0),
+        scale(0),
+        entry_size(0),
+        is_signed(false),
+        shift(0),
+        addend(0) {}
+};
+
+static Value Constant(uint64_t constant) {
+  Value val;
+  val.kind = Value::kConstant;
+  val.constant = constant;
+  return val;
+}
+
+static bool StartsWith(const std::string &str, const char *prefix) {
+  return 0 == str.compare(0, std::char_traits<char>::length(prefix), prefix);
+}
+
+// Name of the full-width register that contains `name`, e.g. `RAX` for `AL`,
+// or `X3` for `W3`.
+static std::string RegisterFamily(const Arch *arch, const std::string &name) {
+  if (arch->IsAArch64()) {
+    if (name == "WZR") {
+      return "XZR";
+    } else if (name == "WSP") {
+      return "SP";
+    } else if (name.size() > 1 && 'W' == name[0] && isdigit(name[1])) {
+      return "X" + name.substr(1);
+    }
+    return name;
+  }
+
+  static const std::unordered_map<std::string, std::string> kX86Families = {
+    {"EAX", "RAX"}, {"AX", "RAX"}, {"AL", "RAX"}, {"AH", "RAX"},
+    {"EBX", "RBX"}, {"BX", "RBX"}, {"BL", "RBX"}, {"BH", "RBX"},
+    {"ECX", "RCX"}, {"CX", "RCX"}, {"CL", "RCX"}, {"CH", "RCX"},
+    {"EDX", "RDX"}, {"DX", "RDX"}, {"DL", "RDX"}, {"DH", "RDX"},
+    {"ESI", "RSI"}, {"SI", "RSI"}, {"SIL", "RSI"},
+    {"EDI", "RDI"}, {"DI", "RDI"}, {"DIL", "RDI"},
+    {"EBP", "RBP"}, {"BP", "RBP"}, {"BPL", "RBP"},
+    {"ESP", "RSP"}, {"SP", "RSP"}, {"SPL", "RSP"},
+  };
+  auto family_it = kX86Families.find(name);
+  if (family_it != kX86Families.end()) {
+    return family_it->second;
+  }
+
+  // `R8D`, `R8W` and `R8B` are all part of `R8`.
+  if (name.size() > 2 && 'R' == name[0] && isdigit(name[1])) {
+    auto last = name.back();
+    if ('D' == last || 'W' == last || 'B' == last) {
+      return name.substr(0, name.size() - 1);
+    }
+  }
+  return name;
+}
+
+// Tracks register values along the path to an indirect jump, as well as the
+// bounds checks that guard table indices.
+class PathState {
+ public:
+  explicit PathState(const Arch *arch_)
+      : arch(arch_),
+        has_compare(false),
+        compare_imm(0),
+        has_bound(false),
+        bound(0),
+        num_origins(0) {}
+
+  Value Get(const std::string &name) {
+    auto family = RegisterFamily(arch, name);
+    if (family == "XZR") {
+      return Constant(0);
+    }
+    auto &val = regs[family];
+    if (val.kind == Value::kUnknown && val.origin.empty()) {
+      val.origin = NewOrigin(family);
+    }
+    return val;
+  }
+
+  void Set(const std::string &name, const Value &val) {
+    auto family = RegisterFamily(arch, name);
+    auto &reg_val = regs[family];
+    reg_val = val;
+    if (reg_val.kind == Value::kUnknown && reg_val.origin.empty()) {
+      reg_val.origin = NewOrigin(family);
+    }
+  }
+
+  void Clobber(const std::string &name) {
+    Set(name, Value());
+  }
+
+  // Evaluate a register, shifted register, or immediate operand.
+  bool Evaluate(const Operand &op, Value *val) {
+    switch (op.type) {
+      case Operand::kTypeImmediate:
+        *val = Constant(op.imm.val);
+        return true;
+
+      case Operand::kTypeRegister:
+        *val = Get(op.reg.name);
+        return true;
+
+      case Operand::kTypeShiftRegister:
+        return EvaluateShift(op.shift_reg, val);
+
+      default:
+        return false;
+    }
+  }
+
+  // Evaluate the address of a memory operand, as `base + index * scale`. If
+  // the index isn't constant, then `index` is the origin of its value.
+  bool EvaluateAddress(const Instruction &inst, const Operand::Address &addr,
+                       uint64_t *base, std::string *index, uint64_t *scale) {
+    if (!addr.segment_base_reg.name.empty()) {
+      return false;
+    }
+
+    *base = static_cast<uint64_t>(addr.displacement);
+    if (addr.base_reg.name == "PC") {
+      *base += inst.pc;
+    } else if (!addr.base_reg.name.empty()) {
+      auto base_val = Get(addr.base_reg.name);
+      if (base_val.kind != Value::kConstant) {
+        return false;
+      }
+      *base += base_val.constant;
+    }
+
+    index->clear();
+    *scale = 0;
+    if (!addr.index_reg.name.empty()) {
+      auto index_val = Get(addr.index_reg.name);
+      if (index_val.kind == Value::kConstant) {
+        *base += index_val.constant * static_cast<uint64_t>(addr.scale);
+      } else if (index_val.kind == Value::kUnknown) {
+        *index = index_val.origin;
+        *scale = static_cast<uint64_t>(addr.scale);
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Evaluate a load of a table entry.
+  bool EvaluateLoad(const Instruction &inst, const Operand::Address &addr,
+                    uint64_t entry_size, bool is_signed, Value *val) {
+    Value entry;
+    if (!EvaluateAddress(inst, addr, &(entry.table), &(entry.index),
+                         &(entry.scale)) ||
+        entry.index.empty()) {
+      return false;
+    }
+    entry.kind = Value::kTableEntry;
+    entry.entry_size = entry_size;
+    entry.is_signed = is_signed;
+    *val = entry;
+    return true;
+  }
+
+  // Remember a comparison of a register against an immediate, in case the
+  // next instruction branches on it.
+  void Compare(const Operand &reg, const Operand &imm) {
+    if (reg.type != Operand::kTypeRegister ||
+        imm.type != Operand::kTypeImmediate) {
+      return;
+    }
+    auto val = Get(reg.reg.name);
+    if (val.kind == Value::kUnknown) {
+      has_compare = true;
+      compare_origin = val.origin;
+      compare_imm = imm.imm.val;
+    }
+  }
+
+  void ForgetCompare(void) {
+    has_compare = false;
+  }
+
+  // Record the bound implied by branching on the last comparison. `num_below`
+  // is the number of values that go on to the jump table, in terms of the
+  // compared immediate.
+  void Bound(uint64_t num_below) {
+    if (has_compare) {
+      has_bound = true;
+      bound_origin = compare_origin;
+      bound = num_below;
+    }
+    has_compare = false;
+  }
+
+  const Arch * const arch;
+
+  bool has_compare;
+  std::string compare_origin;
+  uint64_t compare_imm;
+
+  bool has_bound;
+  std::string bound_origin;
+  uint64_t bound;
+
+ private:
+  PathState(void) = delete;
+
+  std::string NewOrigin(const std::string &family) {
+    std::stringstream ss;
+    ss << family << "#" << num_origins++;
+    return ss.str();
+  }
+
+  bool EvaluateShift(const Operand::ShiftRegister &shift_reg, Value *val) {
+    *val = Get(shift_reg.reg.name);
+    if (shift_reg.shift_op != Operand::ShiftRegister::kShiftInvalid &&
+        shift_reg.shift_op != Operand::ShiftRegister::kShiftLeftWithZeroes) {
+      return false;
+    }
+
+    auto extended =
+        shift_reg.extend_op != Operand::ShiftRegister::kExtendInvalid;
+    if (val->kind == Value::kTableEntry) {
+      if (extended) {
+        if (shift_reg.extract_size != val->entry_size * 8) {
+          return false;
+        }
+        val->is_signed = val->is_signed ||
+            shift_reg.extend_op == Operand::ShiftRegister::kExtendSigned;
+      }
+      val->shift += shift_reg.shift_size;
+      val->addend <<= shift_reg.shift_size;
+      return true;
+
+    } else if (val->kind == Value::kConstant && !extended) {
+      val->constant <<= shift_reg.shift_size;
+      return true;
+
+    } else {
+      return false;
+    }
+  }
+
+  std::unordered_map<std::string, Value> regs;
+  unsigned num_origins;
+};
+
+// Add two values. Table entries can only be offset by constants.
+static Value Add(const Value &a, const Value &b) {
+  if (a.kind == Value::kConstant && b.kind == Value::kConstant) {
+    return Constant(a.constant + b.constant);
+  } else if (a.kind == Value::kTableEntry && b.kind == Value::kConstant) {
+    auto sum = a;
+    sum.addend += b.constant;
+    return sum;
+  } else if (a.kind == Value::kConstant && b.kind == Value::kTableEntry) {
+    return Add(b, a);
+  } else {
+    return Value();
+  }
+}
+
+static const Operand *FindOperand(const Instruction &inst, Operand::Type type,
+                                  Operand::Action action) {
+  for (const auto &op : inst.operands) {
+    if (op.type == type && op.action == action) {
+      return &op;
+    }
+  }
+  return nullptr;
+}
+
+static const Operand *WrittenRegister(const Instruction &inst) {
+  return FindOperand(inst, Operand::kTypeRegister, Operand::kActionWrite);
+}
+
+static const Operand *Memory(const Instruction &inst) {
+  return FindOperand(inst, Operand::kTypeAddress, Operand::kActionRead);
+}
+
+// Forget the values of every register that `inst` writes.
+static void ClobberWrites(PathState &state, const Instruction &inst) {
+  for (const auto &op : inst.operands) {
+    if (op.action == Operand::kActionWrite &&
+        op.type == Operand::kTypeRegister) {
+      state.Clobber(op.reg.name);
+    }
+  }
+}
+
+// Describe how the x86 conditional branch `inst` bounds the compared value,
+// if execution continues to `next_pc`.
+static void BoundX86(PathState &state, const Instruction &inst,
+                     uint64_t next_pc) {
+  auto taken = next_pc == inst.branch_taken_pc;
+  const auto &name = inst.function;
+  auto imm = state.compare_imm;
+  if (StartsWith(name, "JNBE_") && !taken) {  // `ja default`.
+    state.Bound(imm + 1);
+  } else if (StartsWith(name, "JNB_") && !taken) {  // `jae default`.
+    state.Bound(imm);
+  } else if (StartsWith(name, "JBE_") && taken) {  // `jbe table`.
+    state.Bound(imm + 1);
+  } else if (StartsWith(name, "JB_") && taken) {  // `jb table`.
+    state.Bound(imm);
+  } else {
+    state.ForgetCompare();
+  }
+}
+
+// Like `BoundX86`, but for AArch64 `b.cond`.
+static void BoundAArch64(PathState &state, const Instruction &inst,
+                         uint64_t next_pc) {
+  auto taken = next_pc == inst.branch_taken_pc;
+  const auto &name = inst.function;
+  auto imm = state.compare_imm;
+  if (name == "B_ONLY_CONDBRANCH_HI" && !taken) {
+    state.Bound(imm + 1);
+  } else if (name == "B_ONLY_CONDBRANCH_CS" && !taken) {
+    state.Bound(imm);
+  } else if (name == "B_ONLY_CONDBRANCH_LS" && taken) {
+    state.Bound(imm + 1);
+  } else if (name == "B_ONLY_CONDBRANCH_CC" && taken) {
+    state.Bound(imm);
+  } else {
+    state.ForgetCompare();
+  }
+}
+
+// Evaluate the x86 instruction `inst`. Returns the jump target if `inst` is
+// the indirect jump.
+static void StepX86(PathState &state, const Instruction &inst,
+                    Value *target) {
+  const auto &name = inst.function;
+  auto dest = WrittenRegister(inst);
+  auto mem = Memory(inst);
+  auto &ops = inst.operands;
+  Value val;
+
+  if (StartsWith(name, "CMP_GPRv_IMM") || StartsWith(name, "CMP_OrAX_IMM")) {
+    if (2 == ops.size()) {
+      state.Compare(ops[0], ops[1]);
+    }
+    return;
+  }
+
+  state.ForgetCompare();
+
+  if (StartsWith(name, "JMP_GPRv")) {
+    if (1 == ops.size()) {
+      state.Evaluate(ops[0], target);
+    }
+    return;
+
+  } else if (StartsWith(name, "JMP_MEMv")) {
+    if (mem) {
+      state.EvaluateLoad(inst, mem->addr, mem->size / 8, false, target);
+    }
+    return;
+
+  } else if (!dest) {
+    return;
+
+  } else if (StartsWith(name, "LEA_GPRv_AGEN")) {
+    auto addr = FindOperand(inst, Operand::kTypeAddress, Operand::kActionRead);
+    uint64_t base = 0;
+    std::string index;
+    uint64_t scale = 0;
+    if (addr && state.EvaluateAddress(inst, addr->addr, &base, &index,
+                                      &scale) && index.empty()) {
+      val = Constant(base);
+    }
+
+  } else if (StartsWith(name, "MOV_GPRv_IMMv") ||
+             StartsWith(name, "MOV_GPRv_IMMz")) {
+    state.Evaluate(ops.back(), &val);
+
+  } else if (StartsWith(name, "MOV_GPRv_GPRv") && 2 == ops.size()) {
+    state.Evaluate(ops[1], &val);
+
+    // A 32-bit move zero-extends, which doesn't change a bounded index.
+    if (ops[1].size == 32) {
+      if (val.kind == Value::kConstant) {
+        val.constant &= 0xFFFFFFFFULL;
+      } else if (val.kind == Value::kTableEntry) {
+        val = Value();
+      }
+    }
+
+  } else if (StartsWith(name, "MOVSXD_GPRv_MEMd") && mem) {
+    state.EvaluateLoad(inst, mem->addr, 4, true, &val);
+
+  } else if (StartsWith(name, "MOV_GPRv_MEMv") && mem) {
+    state.EvaluateLoad(inst, mem->addr, mem->size / 8, false, &val);
+
+  } else if (StartsWith(name, "MOVZX_GPRv_MEMb") && mem) {
+    state.EvaluateLoad(inst, mem->addr, 1, false, &val);
+
+  } else if (StartsWith(name, "MOVZX_GPRv_MEMw") && mem) {
+    state.EvaluateLoad(inst, mem->addr, 2, false, &val);
+
+  } else if (StartsWith(name, "MOVSX_GPRv_MEMb") && mem) {
+    state.EvaluateLoad(inst, mem->addr, 1, true, &val);
+
+  } else if (StartsWith(name, "MOVSX_GPRv_MEMw") && mem) {
+    state.EvaluateLoad(inst, mem->addr, 2, true, &val);
+
+  } else if ((StartsWith(name, "ADD_GPRv_GPRv") ||
+              StartsWith(name, "ADD_GPRv_IMM")) && 3 == ops.size()) {
+    Value lhs;
+    Value rhs;
+    if (state.Evaluate(ops[1], &lhs) && state.Evaluate(ops[2], &rhs)) {
+      val = Add(lhs, rhs);
+    }
+  }
+
+  ClobberWrites(state, inst);
+  state.Set(dest->reg.name, val);
+}
+
+// Evaluate the AArch64 instruction `inst`. Returns the jump target if `inst`
+// is the indirect jump.
+static void StepAArch64(PathState &state, const Instruction &inst,
+                        Value *target) {
+  const auto &name = inst.function;
+  auto dest = WrittenRegister(inst);
+  auto &ops = inst.operands;
+  Value val;
+
+  // `cmp` is `subs` that discards its result.
+  if (name == "SUBS_32S_ADDSUB_IMM" || name == "SUBS_64S_ADDSUB_IMM") {
+    ClobberWrites(state, inst);
+    if (3 == ops.size()) {
+      state.Compare(ops[1], ops[2]);
+    }
+    return;
+  }
+
+  state.ForgetCompare();
+
+  if (name == "BR_64_BRANCH_REG") {
+    if (1 == ops.size()) {
+      state.Evaluate(ops[0], target);
+    }
+    return;
+
+  } else if (!dest) {
+    return;
+
+  } else if (name == "ADR_ONLY_PCRELADDR" || name == "ADRP_ONLY_PCRELADDR") {
+    uint64_t base = 0;
+    std::string index;
+    uint64_t scale = 0;
+    if (2 == ops.size() && ops[1].type == Operand::kTypeAddress &&
+        state.EvaluateAddress(inst, ops[1].addr, &base, &index, &scale)) {
+      val = Constant(name == "ADRP_ONLY_PCRELADDR" ? base & ~0xFFFULL : base);
+    }
+
+  } else if (name == "ADD_64_ADDSUB_IMM" || name == "ADD_64_ADDSUB_SHIFT" ||
+             name == "ADD_64_ADDSUB_EXT") {
+    Value lhs;
+    Value rhs;
+    if (3 == ops.size() && state.Evaluate(ops[1], &lhs) &&
+        state.Evaluate(ops[2], &rhs)) {
+      val = Add(lhs, rhs);
+    }
+
+  } else if (3 == ops.size()) {
+    uint64_t entry_size = 0;
+    auto is_signed = false;
+    if (name == "LDRB_32B_LDST_REGOFF" || name == "LDRB_32BL_LDST_REGOFF") {
+      entry_size = 1;
+    } else if (name == "LDRH_32_LDST_REGOFF") {
+      entry_size = 2;
+    } else if (name == "LDR_32_LDST_REGOFF") {
+      entry_size = 4;
+    } else if (name == "LDRSW_64_LDST_REGOFF") {
+      entry_size = 4;
+      is_signed = true;
+    } else if (name == "LDR_64_LDST_REGOFF") {
+      entry_size = 8;
+    }
+
+    // Register-offset loads are `[Rt, Xn, Rm{, extend {#amount}}]`, where the
+    // base is either a register or a memory operand.
+    Value base;
+    const auto &base_op = ops[1];
+    if (base_op.type == Operand::kTypeRegister) {
+      base = state.Get(base_op.reg.name);
+    } else if (base_op.type == Operand::kTypeAddress) {
+      base = Add(state.Get(base_op.addr.base_reg.name),
+                 Constant(static_cast<uint64_t>(base_op.addr.displacement)));
+    }
+
+    Value index;
+    uint64_t scale = 1;
+    const auto &index_op = ops[2];
+    if (index_op.type == Operand::kTypeRegister) {
+      index = state.Get(index_op.reg.name);
+    } else if (index_op.type == Operand::kTypeShiftRegister &&
+               index_op.shift_reg.shift_op !=
+                   Operand::ShiftRegister::kShiftUnsignedRight &&
+               index_op.shift_reg.shift_op !=
+                   Operand::ShiftRegister::kShiftSignedRight) {
+      index = state.Get(index_op.shift_reg.reg.name);
+      scale = 1ULL << index_op.shift_reg.shift_size;
+    }
+
+    if (entry_size && base.kind == Value::kConstant &&
+        index.kind == Value::kUnknown && !index.origin.empty()) {
+      val.kind = Value::kTableEntry;
+      val.table = base.constant;
+      val.index = index.origin;
+      val.scale = scale;
+      val.entry_size = entry_size;
+      val.is_signed = is_signed;
+    }
+  }
+
+  ClobberWrites(state, inst);
+  state.Set(dest->reg.name, val);
+}
+
+// Read the `index`th entry of `table` out of `image`.
+static bool ReadEntry(const Arch *arch, const MappedImage &image,
+                      const Value &entry, uint64_t index, uint64_t *target) {
+  uint8_t bytes[8] = {};
+  auto addr = entry.table + index * entry.scale;
+  if (entry.entry_size > sizeof(bytes) ||
+      image.Read(addr, bytes, entry.entry_size) != entry.entry_size) {
+    return false;
+  }
+
+  // Entries are little-endian on every supported architecture.
+  uint64_t val = 0;
+  for (auto i = entry.entry_size; i > 0; --i) {
+    val = (val << 8) | bytes[i - 1];
+  }
+  auto entry_bits = entry.entry_size * 8;
+  if (entry.is_signed && entry_bits < 64 &&
+      (val >> (entry_bits - 1)) & 1) {
+    val |= ~0ULL << entry_bits;
+  }
+
+  *target = (val << entry.shift) + entry.addend;
+  if (arch->address_size < 64) {
+    *target &= (1ULL << arch->address_size) - 1;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool RecoverJumpTable(const Arch *arch, const MappedImage &image,
+                      const std::vector<Instruction> &path, JumpTable *table) {
+  if (path.empty() ||
+      path.back().category != Instruction::kCategoryIndirectJump) {
+    return false;
+  }
+
+  PathState state(arch);
+  Value target;
+  for (size_t i = 0; i < path.size(); ++i) {
+    const auto &inst = path[i];
+    auto next_pc = i + 1 < path.size() ? path[i + 1].pc : inst.next_pc;
+
+    if (inst.IsConditionalBranch()) {
+      if (next_pc != inst.branch_taken_pc &&
+          next_pc != inst.branch_not_taken_pc) {
+        return false;
+      }
+      if (arch->IsAArch64()) {
+        BoundAArch64(state, inst, next_pc);
+      } else {
+        BoundX86(state, inst, next_pc);
+      }
+      continue;
+    }
+
+    if (i + 1 < path.size() && next_pc != inst.next_pc &&
+        (inst.category != Instruction::kCategoryDirectJump ||
+         next_pc != inst.branch_taken_pc)) {
+      return false;  // Not a path that can execute.
+    }
+
+    if (arch->IsAArch64()) {
+      StepAArch64(state, inst, &target);
+    } else {
+      StepX86(state, inst, &target);
+    }
+  }
+
+  if (target.kind != Value::kTableEntry) {
+    return false;
+  }
+
+  // The table must not change at runtime.
+  auto seg = image.FindSegment(target.table);
+  if (!seg || seg->is_writable) {
+    return false;
+  }
+
+  table->jump_pc = path.back().pc;
+  table->table_address = target.table;
+  table->is_bounded = state.has_bound && state.bound_origin == target.index;
+  table->num_entries = 0;
+  table->targets.clear();
+
+  if (table->is_bounded &&
+      (!state.bound || state.bound > kMaxJumpTableEntries)) {
+    return false;
+  }
+
+  auto max_entries = table->is_bounded ? state.bound : kMaxJumpTableEntries;
+  std::unordered_set<uint64_t> seen;
+  for (uint64_t i = 0; i < max_entries; ++i) {
+    uint64_t entry_target = 0;
+    auto entry_addr = target.table + i * target.scale;
+    if (!seg->Contains(entry_addr) ||
+        !ReadEntry(arch, image, target, i, &entry_target) ||
+        !image.IsExecutable(entry_target)) {
+      if (table->is_bounded) {
+        LOG(WARNING)
+            << "Entry " << i << " of the jump table at " << std::hex
+            << target.table << " used by the jump at " << table->jump_pc
+            << std::dec << " is not a code address";
+        return false;
+      }
+      break;
+    }
+
+    table->num_entries++;
+    if (seen.insert(entry_target).second) {
+      table->targets.push_back(entry_target);
+    }
+  }
+
+  return !table->targets.empty();
+}
+
+}  // namespace remill
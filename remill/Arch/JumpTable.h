@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_ARCH_JUMPTABLE_H_
+#define REMILL_ARCH_JUMPTABLE_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace remill {
+
+class Arch;
+class Instruction;
+class MappedImage;
+
+// An indirect jump through a table of code addresses.
+struct JumpTable {
+  // Address of the indirect jump.
+  uint64_t jump_pc;
+
+  // Address of the first entry of the table.
+  uint64_t table_address;
+
+  // Number of entries in the table. If `is_bounded` is `true`, then this
+  // comes from the bounds check that guards the jump. Otherwise, the table
+  // was scanned up to the first entry that isn't a code address.
+  uint64_t num_entries;
+  bool is_bounded;
+
+  // The distinct targets of the jump, in order of first appearance in the
+  // table.
+  std::vector<uint64_t> targets;
+};
+
+// Recognize the jump table that the indirect jump at the end of `path` jumps
+// through. `path` is a sequence of decoded instructions that execute one after
+// the other, e.g. the block that ends with the jump, preceded by the block
+// that branches to it. The table is read out of `image`, and must be in a
+// segment that isn't writable.
+//
+// These are the patterns that compilers commonly emit for `switch`
+// statements:
+//
+//    x86 and amd64 (absolute entries):
+//        cmp   eax, N
+//        ja    default
+//        jmp   [table + rax * 8]
+//
+//    amd64 (entries relative to the table, e.g. with `-fPIC`):
+//        cmp    eax, N
+//        ja     default
+//        lea    rdx, [rip + table]
+//        movsxd rax, dword ptr [rdx + rax * 4]
+//        add    rax, rdx
+//        jmp    rax
+//
+//    AArch64 (scaled entries relative to a label):
+//        cmp   w8, #N
+//        b.hi  default
+//        adrp  x9, table
+//        add   x9, x9, :lo12:table
+//        adr   x10, label
+//        ldrb  w11, [x9, x8]            ; Or `ldrh`, `ldr` and `ldrsw`.
+//        add   x10, x10, x11, lsl #2
+//        br    x10
+//
+// The bounds check is optional. Without one, the table is scanned, which may
+// find extra targets. That is safe if the targets are only used as the cases
+// of a dispatch on the computed target address, with a fallback for other
+// addresses.
+bool RecoverJumpTable(const Arch *arch, const MappedImage &image,
+                      const std::vector<Instruction> &path, JumpTable *table);
+
+}  // namespace remill
+
+#endif  // REMILL_ARCH_JUMPTABLE_H_
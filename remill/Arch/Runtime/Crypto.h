@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_ARCH_RUNTIME_CRYPTO_H_
+#define REMILL_ARCH_RUNTIME_CRYPTO_H_
+
+// Helpers for the semantics of CRC, AES, and carry-less multiplication
+// instructions. If the semantics are compiled for a host that has these
+// instructions (e.g. with `-msse4.2 -maes -mpclmul`, or `-march=armv8-a+crc`,
+// which the build passes if the host has them and the non-default
+// `REMILL_SEMANTICS_USE_HOST_FEATURES` option is on), then the helpers use the
+// host's builtins, which show up as the corresponding target intrinsics in the
+// semantics bitcode. Otherwise, they fall back to portable code.
+
+namespace {
+
+#if defined(__AES__) || defined(__PCLMUL__)
+typedef long long HostV2DI __attribute__((__vector_size__(16)));
+
+template <typename T>
+ALWAYS_INLINE static HostV2DI ToHostV2DI(T vec) {
+  static_assert(sizeof(T) == sizeof(HostV2DI), "Invalid host vector.");
+  HostV2DI host_vec;
+  __builtin_memcpy(&host_vec, &vec, sizeof(host_vec));
+  return host_vec;
+}
+
+template <typename T>
+ALWAYS_INLINE static T FromHostV2DI(HostV2DI host_vec) {
+  static_assert(sizeof(T) == sizeof(HostV2DI), "Invalid host vector.");
+  T vec;
+  __builtin_memcpy(&vec, &host_vec, sizeof(vec));
+  return vec;
+}
+#endif  // defined(__AES__) || defined(__PCLMUL__)
+
+// Bit-reflected CRC-32 polynomials. `kCRC32Polynomial` is the ISO-HDLC (zlib)
+// polynomial, used by AArch64 `CRC32*`. `kCRC32CPolynomial` is the Castagnoli
+// polynomial, used by x86 `CRC32` and AArch64 `CRC32C*`.
+static constexpr uint32_t kCRC32Polynomial = 0xEDB88320U;
+static constexpr uint32_t kCRC32CPolynomial = 0x82F63B78U;
+
+// Accumulate the bits of `val` into `crc`, least significant bit first. There
+// is no pre- or post-inversion of `crc`.
+template <uint32_t kPolynomial, typename T>
+ALWAYS_INLINE static uint32_t PortableCRC32(uint32_t crc, T val) {
+  _Pragma("unroll")
+  for (size_t i = 0; i < sizeof(T) * 8; ++i) {
+    auto bit = (crc ^ static_cast<uint32_t>(val >> i)) & 1U;
+    crc = (crc >> 1) ^ (kPolynomial & (0U - bit));
+  }
+  return crc;
+}
+
+#define MAKE_CRC32(name, size, builtin) \
+    ALWAYS_INLINE static uint32_t name( \
+        uint32_t crc, uint ## size ## _t val) { \
+      return static_cast<uint32_t>(builtin(crc, val)); \
+    }
+
+#if defined(__ARM_FEATURE_CRC32)
+MAKE_CRC32(CRC32, 8, __builtin_arm_crc32b)
+MAKE_CRC32(CRC32, 16, __builtin_arm_crc32h)
+MAKE_CRC32(CRC32, 32, __builtin_arm_crc32w)
+MAKE_CRC32(CRC32, 64, __builtin_arm_crc32d)
+#else
+MAKE_CRC32(CRC32, 8, PortableCRC32<kCRC32Polynomial>)
+MAKE_CRC32(CRC32, 16, PortableCRC32<kCRC32Polynomial>)
+MAKE_CRC32(CRC32, 32, PortableCRC32<kCRC32Polynomial>)
+MAKE_CRC32(CRC32, 64, PortableCRC32<kCRC32Polynomial>)
+#endif  // defined(__ARM_FEATURE_CRC32)
+
+#if defined(__ARM_FEATURE_CRC32)
+MAKE_CRC32(CRC32C, 8, __builtin_arm_crc32cb)
+MAKE_CRC32(CRC32C, 16, __builtin_arm_crc32ch)
+MAKE_CRC32(CRC32C, 32, __builtin_arm_crc32cw)
+MAKE_CRC32(CRC32C, 64, __builtin_arm_crc32cd)
+#elif defined(__SSE4_2__) && defined(__x86_64__)
+MAKE_CRC32(CRC32C, 8, __builtin_ia32_crc32qi)
+MAKE_CRC32(CRC32C, 16, __builtin_ia32_crc32hi)
+MAKE_CRC32(CRC32C, 32, __builtin_ia32_crc32si)
+MAKE_CRC32(CRC32C, 64, __builtin_ia32_crc32di)
+#else
+MAKE_CRC32(CRC32C, 8, PortableCRC32<kCRC32CPolynomial>)
+MAKE_CRC32(CRC32C, 16, PortableCRC32<kCRC32CPolynomial>)
+MAKE_CRC32(CRC32C, 32, PortableCRC32<kCRC32CPolynomial>)
+MAKE_CRC32(CRC32C, 64, PortableCRC32<kCRC32CPolynomial>)
+#endif  // defined(__ARM_FEATURE_CRC32)
+
+#undef MAKE_CRC32
+
+// Multiply `lhs` and `rhs` as polynomials over GF(2).
+ALWAYS_INLINE static uint128_t CarrylessMultiply(uint64_t lhs, uint64_t rhs) {
+#if defined(__PCLMUL__)
+  HostV2DI host_lhs = {static_cast<long long>(lhs), 0};
+  HostV2DI host_rhs = {static_cast<long long>(rhs), 0};
+  return FromHostV2DI<uint128_t>(
+      __builtin_ia32_pclmulqdq128(host_lhs, host_rhs, 0));
+#else
+  uint128_t res = 0;
+  _Pragma("unroll")
+  for (size_t i = 0; i < 64; ++i) {
+    if ((rhs >> i) & 1) {
+      res ^= static_cast<uint128_t>(lhs) << i;
+    }
+  }
+  return res;
+#endif  // defined(__PCLMUL__)
+}
+
+// The AES state is a 4x4 matrix of bytes, stored in column-major order, i.e.
+// byte `4 * c + r` of a vector is in row `r` and column `c`. x86 and AArch64
+// both use this layout.
+
+static const uint8_t kAESSubBytes[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5,
+    0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0,
+    0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc,
+    0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a,
+    0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0,
+    0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b,
+    0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85,
+    0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5,
+    0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17,
+    0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88,
+    0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c,
+    0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9,
+    0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6,
+    0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e,
+    0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94,
+    0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68,
+    0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+static const uint8_t kAESInvSubBytes[256] = {
+    0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38,
+    0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
+    0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87,
+    0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
+    0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d,
+    0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
+    0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2,
+    0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
+    0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16,
+    0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
+    0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda,
+    0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
+    0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a,
+    0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
+    0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02,
+    0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
+    0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea,
+    0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
+    0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85,
+    0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
+    0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89,
+    0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
+    0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20,
+    0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
+    0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31,
+    0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
+    0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d,
+    0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
+    0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0,
+    0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
+    0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26,
+    0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
+};
+
+// Look up `index` in `table` by reading every entry, so that the memory
+// accesses don't depend on `index`, which is derived from the (secret) AES
+// state or key.
+ALWAYS_INLINE static uint8_t AESLookup(const uint8_t (&table)[256],
+                                       uint32_t index) {
+  uint8_t res = 0;
+  for (uint32_t i = 0; i < 256; ++i) {
+    // All ones if `i == index`, and zero otherwise.
+    auto mask = static_cast<uint8_t>(((i ^ index) - 1U) >> 8);
+    res = static_cast<uint8_t>(res | (table[i] & mask));
+  }
+  return res;
+}
+
+ALWAYS_INLINE static uint32_t AESSubWord(uint32_t word) {
+  return static_cast<uint32_t>(AESLookup(kAESSubBytes, word & 0xFF)) |
+         (static_cast<uint32_t>(
+             AESLookup(kAESSubBytes, (word >> 8) & 0xFF)) << 8) |
+         (static_cast<uint32_t>(
+             AESLookup(kAESSubBytes, (word >> 16) & 0xFF)) << 16) |
+         (static_cast<uint32_t>(AESLookup(kAESSubBytes, word >> 24)) << 24);
+}
+
+// Multiply `val` by `x` in GF(2^8).
+ALWAYS_INLINE static uint8_t AESTimesX(uint8_t val) {
+  return static_cast<uint8_t>((val << 1) ^ ((val >> 7) * 0x1B));
+}
+
+// Multiply `val` by `mul` in GF(2^8).
+ALWAYS_INLINE static uint8_t AESMultiply(uint8_t val, uint8_t mul) {
+  uint8_t res = 0;
+  _Pragma("unroll")
+  for (size_t i = 0; i < 4; ++i) {
+    if ((mul >> i) & 1) {
+      res ^= val;
+    }
+    val = AESTimesX(val);
+  }
+  return res;
+}
+
+ALWAYS_INLINE static uint8v16_t AESAddRoundKey(uint8v16_t state,
+                                               uint8v16_t key) {
+  _Pragma("unroll")
+  for (size_t i = 0; i < 16; ++i) {
+    state.elems[i] ^= key.elems[i];
+  }
+  return state;
+}
+
+// `ShiftRows` followed by `SubBytes`. These two steps commute.
+ALWAYS_INLINE static uint8v16_t AESSubShift(uint8v16_t state) {
+  uint8v16_t res = {};
+  _Pragma("unroll")
+  for (size_t c = 0; c < 4; ++c) {
+    _Pragma("unroll")
+    for (size_t r = 0; r < 4; ++r) {
+      res.elems[4 * c + r] = AESLookup(
+          kAESSubBytes, state.elems[4 * ((c + r) % 4) + r]);
+    }
+  }
+  return res;
+}
+
+// `InvShiftRows` followed by `InvSubBytes`. These two steps commute.
+ALWAYS_INLINE static uint8v16_t AESInvSubShift(uint8v16_t state) {
+  uint8v16_t res = {};
+  _Pragma("unroll")
+  for (size_t c = 0; c < 4; ++c) {
+    _Pragma("unroll")
+    for (size_t r = 0; r < 4; ++r) {
+      res.elems[4 * c + r] = AESLookup(
+          kAESInvSubBytes, state.elems[4 * ((c + 4 - r) % 4) + r]);
+    }
+  }
+  return res;
+}
+
+ALWAYS_INLINE static uint8v16_t PortableAESMixColumns(uint8v16_t state) {
+  uint8v16_t res = {};
+  _Pragma("unroll")
+  for (size_t c = 0; c < 4; ++c) {
+    _Pragma("unroll")
+    for (size_t r = 0; r < 4; ++r) {
+      auto s0 = state.elems[4 * c + r];
+      auto s1 = state.elems[4 * c + (r + 1) % 4];
+      auto s2 = state.elems[4 * c + (r + 2) % 4];
+      auto s3 = state.elems[4 * c + (r + 3) % 4];
+      res.elems[4 * c + r] = static_cast<uint8_t>(
+          AESTimesX(s0) ^ AESTimesX(s1) ^ s1 ^ s2 ^ s3);
+    }
+  }
+  return res;
+}
+
+ALWAYS_INLINE static uint8v16_t PortableAESInvMixColumns(uint8v16_t state) {
+  uint8v16_t res = {};
+  _Pragma("unroll")
+  for (size_t c = 0; c < 4; ++c) {
+    _Pragma("unroll")
+    for (size_t r = 0; r < 4; ++r) {
+      auto s0 = state.elems[4 * c + r];
+      auto s1 = state.elems[4 * c + (r + 1) % 4];
+      auto s2 = state.elems[4 * c + (r + 2) % 4];
+      auto s3 = state.elems[4 * c + (r + 3) % 4];
+      res.elems[4 * c + r] = static_cast<uint8_t>(
+          AESMultiply(s0, 0x0E) ^ AESMultiply(s1, 0x0B) ^
+          AESMultiply(s2, 0x0D) ^ AESMultiply(s3, 0x09));
+    }
+  }
+  return res;
+}
+
+#if defined(__AES__)
+
+# define MAKE_AES_ROUND(name, builtin) \
+    ALWAYS_INLINE static uint8v16_t name(uint8v16_t state, uint8v16_t key) { \
+      return FromHostV2DI<uint8v16_t>( \
+          builtin(ToHostV2DI(state), ToHostV2DI(key))); \
+    }
+
+MAKE_AES_ROUND(AESEncryptRound, __builtin_ia32_aesenc128)
+MAKE_AES_ROUND(AESEncryptLastRound, __builtin_ia32_aesenclast128)
+MAKE_AES_ROUND(AESDecryptRound, __builtin_ia32_aesdec128)
+MAKE_AES_ROUND(AESDecryptLastRound, __builtin_ia32_aesdeclast128)
+
+# undef MAKE_AES_ROUND
+
+ALWAYS_INLINE static uint8v16_t AESInvMixColumns(uint8v16_t state) {
+  return FromHostV2DI<uint8v16_t>(
+      __builtin_ia32_aesimc128(ToHostV2DI(state)));
+}
+
+// There is no x86 instruction for only `MixColumns`, but undoing the other
+// steps of an encryption round leaves just `MixColumns`.
+ALWAYS_INLINE static uint8v16_t AESMixColumns(uint8v16_t state) {
+  HostV2DI zero = {0, 0};
+  return FromHostV2DI<uint8v16_t>(__builtin_ia32_aesenc128(
+      __builtin_ia32_aesdeclast128(ToHostV2DI(state), zero), zero));
+}
+
+#else
+
+ALWAYS_INLINE static uint8v16_t AESEncryptRound(uint8v16_t state,
+                                                uint8v16_t key) {
+  return AESAddRoundKey(PortableAESMixColumns(AESSubShift(state)), key);
+}
+
+ALWAYS_INLINE static uint8v16_t AESEncryptLastRound(uint8v16_t state,
+                                                    uint8v16_t key) {
+  return AESAddRoundKey(AESSubShift(state), key);
+}
+
+ALWAYS_INLINE static uint8v16_t AESDecryptRound(uint8v16_t state,
+                                                uint8v16_t key) {
+  return AESAddRoundKey(PortableAESInvMixColumns(AESInvSubShift(state)), key);
+}
+
+ALWAYS_INLINE static uint8v16_t AESDecryptLastRound(uint8v16_t state,
+                                                    uint8v16_t key) {
+  return AESAddRoundKey(AESInvSubShift(state), key);
+}
+
+ALWAYS_INLINE static uint8v16_t AESInvMixColumns(uint8v16_t state) {
+  return PortableAESInvMixColumns(state);
+}
+
+ALWAYS_INLINE static uint8v16_t AESMixColumns(uint8v16_t state) {
+  return PortableAESMixColumns(state);
+}
+
+#endif  // defined(__AES__)
+
+}  // namespace
+
+#endif  // REMILL_ARCH_RUNTIME_CRYPTO_H_
@@ -63,6 +63,42 @@ extern "C" void __remill_intrinsics(void) {
   USED(__remill_atomic_begin);
   USED(__remill_atomic_end);
 
+  USED(__remill_compare_exchange_memory_8);
+  USED(__remill_compare_exchange_memory_16);
+  USED(__remill_compare_exchange_memory_32);
+  USED(__remill_compare_exchange_memory_64);
+  USED(__remill_compare_exchange_memory_128);
+
+  USED(__remill_exchange_memory_8);
+  USED(__remill_exchange_memory_16);
+  USED(__remill_exchange_memory_32);
+  USED(__remill_exchange_memory_64);
+
+  USED(__remill_fetch_and_add_memory_8);
+  USED(__remill_fetch_and_add_memory_16);
+  USED(__remill_fetch_and_add_memory_32);
+  USED(__remill_fetch_and_add_memory_64);
+
+  USED(__remill_fetch_and_sub_memory_8);
+  USED(__remill_fetch_and_sub_memory_16);
+  USED(__remill_fetch_and_sub_memory_32);
+  USED(__remill_fetch_and_sub_memory_64);
+
+  USED(__remill_fetch_and_and_memory_8);
+  USED(__remill_fetch_and_and_memory_16);
+  USED(__remill_fetch_and_and_memory_32);
+  USED(__remill_fetch_and_and_memory_64);
+
+  USED(__remill_fetch_and_or_memory_8);
+  USED(__remill_fetch_and_or_memory_16);
+  USED(__remill_fetch_and_or_memory_32);
+  USED(__remill_fetch_and_or_memory_64);
+
+  USED(__remill_fetch_and_xor_memory_8);
+  USED(__remill_fetch_and_xor_memory_16);
+  USED(__remill_fetch_and_xor_memory_32);
+  USED(__remill_fetch_and_xor_memory_64);
+
 //  USED(__remill_defer_inlining);
 
   USED(__remill_error);
@@ -71,6 +107,7 @@ extern "C" void __remill_intrinsics(void) {
   USED(__remill_function_return);
   USED(__remill_jump);
   USED(__remill_missing_block);
+  USED(__remill_resume_after_call);
 
   USED(__remill_async_hyper_call);
   USED(__remill_sync_hyper_call);
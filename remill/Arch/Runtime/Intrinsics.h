@@ -108,6 +108,14 @@ extern Memory *__remill_missing_block(State &, addr_t addr, Memory *);
 [[gnu::used]]
 extern Memory *__remill_async_hyper_call(State &, addr_t ret_addr, Memory *);
 
+// Lifted code that calls other lifted code natively asks this, once the
+// callee has returned to `ret_addr`, whether it can keep running at
+// `ret_addr`. A runtime returns `false` if something during the call, e.g.
+// an error or a hyper call, needs the runtime to take over, in which case
+// the lifted code tail-calls `__remill_jump` instead.
+[[gnu::used]]
+extern bool __remill_resume_after_call(State &, addr_t ret_addr, Memory *);
+
 [[gnu::used]]
 extern Memory *__remill_sync_hyper_call(State &, Memory *, SyncHyperCall::Name);
 
@@ -135,6 +143,72 @@ extern Memory *__remill_atomic_begin(Memory *);
 [[gnu::used, gnu::const]]
 extern Memory *__remill_atomic_end(Memory *);
 
+// Typed atomic memory operations. Each of these is a single, indivisible
+// read-modify-write of the `N`-bit value at `addr`, and is a full memory
+// barrier. On return, `expected` (or `value`) holds the value that was in
+// memory before the operation. A compare-exchange only writes `desired` to
+// memory if the value in memory was equal to `expected`.
+[[gnu::used]]
+extern Memory *__remill_compare_exchange_memory_8(
+    Memory *, addr_t addr, uint8_t &expected, uint8_t desired);
+
+[[gnu::used]]
+extern Memory *__remill_compare_exchange_memory_16(
+    Memory *, addr_t addr, uint16_t &expected, uint16_t desired);
+
+[[gnu::used]]
+extern Memory *__remill_compare_exchange_memory_32(
+    Memory *, addr_t addr, uint32_t &expected, uint32_t desired);
+
+[[gnu::used]]
+extern Memory *__remill_compare_exchange_memory_64(
+    Memory *, addr_t addr, uint64_t &expected, uint64_t desired);
+
+[[gnu::used]]
+extern Memory *__remill_compare_exchange_memory_128(
+    Memory *, addr_t addr, uint128_t &expected, uint128_t desired);
+
+[[gnu::used]]
+extern Memory *__remill_exchange_memory_8(
+    Memory *, addr_t addr, uint8_t &value);
+
+[[gnu::used]]
+extern Memory *__remill_exchange_memory_16(
+    Memory *, addr_t addr, uint16_t &value);
+
+[[gnu::used]]
+extern Memory *__remill_exchange_memory_32(
+    Memory *, addr_t addr, uint32_t &value);
+
+[[gnu::used]]
+extern Memory *__remill_exchange_memory_64(
+    Memory *, addr_t addr, uint64_t &value);
+
+#define MAKE_ATOMIC_FETCH_OP(name) \
+    [[gnu::used]] \
+    extern Memory *__remill_fetch_and_ ## name ## _memory_8( \
+        Memory *, addr_t addr, uint8_t &value); \
+    \
+    [[gnu::used]] \
+    extern Memory *__remill_fetch_and_ ## name ## _memory_16( \
+        Memory *, addr_t addr, uint16_t &value); \
+    \
+    [[gnu::used]] \
+    extern Memory *__remill_fetch_and_ ## name ## _memory_32( \
+        Memory *, addr_t addr, uint32_t &value); \
+    \
+    [[gnu::used]] \
+    extern Memory *__remill_fetch_and_ ## name ## _memory_64( \
+        Memory *, addr_t addr, uint64_t &value);
+
+MAKE_ATOMIC_FETCH_OP(add)
+MAKE_ATOMIC_FETCH_OP(sub)
+MAKE_ATOMIC_FETCH_OP(and)
+MAKE_ATOMIC_FETCH_OP(or)
+MAKE_ATOMIC_FETCH_OP(xor)
+
+#undef MAKE_ATOMIC_FETCH_OP
+
 }  // extern C
 
 #endif  // REMILL_ARCH_RUNTIME_INTRINSICS_H_
@@ -217,6 +217,56 @@ MAKE_MWRITE(80, 64, float, float, f80)
 
 #undef MAKE_MWRITE
 
+// Make atomic compare-and-swap operators for memory operands. These return
+// `true` if `desired` was written to memory, and update `expected` with the
+// value that was in memory before the operation.
+#define MAKE_MCMPXCHG(size) \
+    ALWAYS_INLINE static \
+    bool _CompareAndSwap( \
+        Memory *&memory, MnW<uint ## size ## _t> op, \
+        uint ## size ## _t &expected, uint ## size ## _t desired) { \
+      const auto prev = expected; \
+      memory = __remill_compare_exchange_memory_ ## size( \
+          memory, op.addr, expected, desired); \
+      return prev == expected; \
+    }
+
+MAKE_MCMPXCHG(8)
+MAKE_MCMPXCHG(16)
+MAKE_MCMPXCHG(32)
+MAKE_MCMPXCHG(64)
+MAKE_MCMPXCHG(128)
+
+#undef MAKE_MCMPXCHG
+
+// Make atomic read-modify-write operators for memory operands. These return
+// the value that was in memory before the operation.
+#define MAKE_MRMW(name, intrinsic, size) \
+    ALWAYS_INLINE static \
+    uint ## size ## _t _ ## name( \
+        Memory *&memory, MnW<uint ## size ## _t> op, \
+        uint ## size ## _t val) { \
+      memory = __remill_ ## intrinsic ## _memory_ ## size( \
+          memory, op.addr, val); \
+      return val; \
+    }
+
+#define MAKE_MRMWS(name, intrinsic) \
+    MAKE_MRMW(name, intrinsic, 8) \
+    MAKE_MRMW(name, intrinsic, 16) \
+    MAKE_MRMW(name, intrinsic, 32) \
+    MAKE_MRMW(name, intrinsic, 64)
+
+MAKE_MRMWS(AtomicExchange, exchange)
+MAKE_MRMWS(FetchAndAdd, fetch_and_add)
+MAKE_MRMWS(FetchAndSub, fetch_and_sub)
+MAKE_MRMWS(FetchAndAnd, fetch_and_and)
+MAKE_MRMWS(FetchAndOr, fetch_and_or)
+MAKE_MRMWS(FetchAndXor, fetch_and_xor)
+
+#undef MAKE_MRMWS
+#undef MAKE_MRMW
+
 #define MAKE_READRV(prefix, size, accessor, base_type) \
     template <typename T> \
     ALWAYS_INLINE static \
@@ -470,6 +520,18 @@ MAKE_WRITE_REF(float64_t)
 // which we know will be defined in semantics functions.
 #define Read(op) _Read(memory, op)
 
+// Atomic read-modify-write operations on memory operands. Unlike a `Read`
+// followed by a `Write`, these are indivisible with respect to other threads.
+#define CompareAndSwap(op, expected, desired) \
+    _CompareAndSwap(memory, op, expected, desired)
+
+#define AtomicExchange(op, val) _AtomicExchange(memory, op, val)
+#define FetchAndAdd(op, val) _FetchAndAdd(memory, op, val)
+#define FetchAndSub(op, val) _FetchAndSub(memory, op, val)
+#define FetchAndAnd(op, val) _FetchAndAnd(memory, op, val)
+#define FetchAndOr(op, val) _FetchAndOr(memory, op, val)
+#define FetchAndXor(op, val) _FetchAndXor(memory, op, val)
+
 // Write a source value to a destination operand, where the sizes of the
 // values must match.
 #define Write(op, val) \
@@ -809,7 +871,7 @@ ALWAYS_INLINE static T Rol(T val_, T amount_) {
     return val_;
   }
   UT low_bits = val >> (width - amount);
-  UT high_bits = val << width;
+  UT high_bits = val << amount;
   return static_cast<T>(low_bits | high_bits);
 }
 
@@ -1314,6 +1376,11 @@ MAKE_BUILTIN(CountTrailingZeros, 16, 32, __builtin_ctz, 0)
 MAKE_BUILTIN(CountTrailingZeros, 32, 32, __builtin_ctz, 0)
 MAKE_BUILTIN(CountTrailingZeros, 64, 64, __builtin_ctzll, 0)
 
+MAKE_BUILTIN(PopulationCount, 8, 32, __builtin_popcount, 0)
+MAKE_BUILTIN(PopulationCount, 16, 32, __builtin_popcount, 0)
+MAKE_BUILTIN(PopulationCount, 32, 32, __builtin_popcount, 0)
+MAKE_BUILTIN(PopulationCount, 64, 64, __builtin_popcountll, 0)
+
 #undef MAKE_BUILTIN
 
 ALWAYS_INLINE static
@@ -19,6 +19,17 @@
 
 #include "remill/Arch/Runtime/HyperCall.h"
 
+// By default, the architecture-specific `State` structures interleave
+// `volatile` padding between registers. This stops LLVM from merging or
+// eliminating accesses to neighbouring registers, which keeps lifted bitcode
+// easy to analyze. Semantics compiled with `DENSE_STATE=1` instead use a
+// packed, cache-line-aware layout with the same field names, which is better
+// for executing lifted code. The two layouts are converted between using
+// `remill/Runtime/DenseState.h`.
+#ifndef DENSE_STATE
+# define DENSE_STATE 0
+#endif
+
 struct ArchState {
  public:
   AsyncHyperCall::Name hyper_call;
@@ -14,12 +14,12 @@
  * limitations under the License.
  */
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
-#include <map>
 #include <memory>
-#include <sstream>
 #include <string>
+#include <vector>
 
 #include <llvm/ADT/Triple.h>
 #include <llvm/IR/Attributes.h>
@@ -29,10 +29,14 @@
 #include "remill/Arch/Arch.h"
 #include "remill/Arch/Instruction.h"
 #include "remill/Arch/Name.h"
+#include "remill/Arch/X86/Decode.h"
 #include "remill/Arch/X86/XED.h"
 #include "remill/BC/Version.h"
 #include "remill/OS/OS.h"
 
+DEFINE_bool(x86_fast_decode, true,
+            "Decode the most common x86 instructions without using XED.");
+
 namespace remill {
 namespace {
 
@@ -189,107 +193,108 @@ static Instruction::Category CreateCategory(const xed_decoded_inst_t *xedd) {
   }
 }
 
-std::map<xed_iform_enum_t, xed_iform_enum_t> kUnlockedIform = {
-    {XED_IFORM_ADC_LOCK_MEMb_IMMb_80r2, XED_IFORM_ADC_MEMb_IMMb_80r2},
-    {XED_IFORM_ADC_LOCK_MEMv_IMMz, XED_IFORM_ADC_MEMv_IMMz},
-    {XED_IFORM_ADC_LOCK_MEMb_IMMb_82r2, XED_IFORM_ADC_MEMb_IMMb_82r2},
-    {XED_IFORM_ADC_LOCK_MEMv_IMMb, XED_IFORM_ADC_MEMv_IMMb},
-    {XED_IFORM_ADC_LOCK_MEMb_GPR8, XED_IFORM_ADC_MEMb_GPR8},
-    {XED_IFORM_ADC_LOCK_MEMv_GPRv, XED_IFORM_ADC_MEMv_GPRv},
-    {XED_IFORM_DEC_LOCK_MEMb, XED_IFORM_DEC_MEMb},
-    {XED_IFORM_DEC_LOCK_MEMv, XED_IFORM_DEC_MEMv},
-    {XED_IFORM_NOT_LOCK_MEMb, XED_IFORM_NOT_MEMb},
-    {XED_IFORM_NOT_LOCK_MEMv, XED_IFORM_NOT_MEMv},
-    {XED_IFORM_SUB_LOCK_MEMb_IMMb_80r5, XED_IFORM_SUB_MEMb_IMMb_80r5},
-    {XED_IFORM_SUB_LOCK_MEMv_IMMz, XED_IFORM_SUB_MEMv_IMMz},
-    {XED_IFORM_SUB_LOCK_MEMb_IMMb_82r5, XED_IFORM_SUB_MEMb_IMMb_82r5},
-    {XED_IFORM_SUB_LOCK_MEMv_IMMb, XED_IFORM_SUB_MEMv_IMMb},
-    {XED_IFORM_SUB_LOCK_MEMb_GPR8, XED_IFORM_SUB_MEMb_GPR8},
-    {XED_IFORM_SUB_LOCK_MEMv_GPRv, XED_IFORM_SUB_MEMv_GPRv},
-    {XED_IFORM_BTC_LOCK_MEMv_IMMb, XED_IFORM_BTC_MEMv_IMMb},
-    {XED_IFORM_BTC_LOCK_MEMv_GPRv, XED_IFORM_BTC_MEMv_GPRv},
-    {XED_IFORM_AND_LOCK_MEMb_IMMb_80r4, XED_IFORM_AND_MEMb_IMMb_80r4},
-    {XED_IFORM_AND_LOCK_MEMv_IMMz, XED_IFORM_AND_MEMv_IMMz},
-    {XED_IFORM_AND_LOCK_MEMb_IMMb_82r4, XED_IFORM_AND_MEMb_IMMb_82r4},
-    {XED_IFORM_AND_LOCK_MEMv_IMMb, XED_IFORM_AND_MEMv_IMMb},
-    {XED_IFORM_AND_LOCK_MEMb_GPR8, XED_IFORM_AND_MEMb_GPR8},
-    {XED_IFORM_AND_LOCK_MEMv_GPRv, XED_IFORM_AND_MEMv_GPRv},
-    {XED_IFORM_CMPXCHG_LOCK_MEMb_GPR8, XED_IFORM_CMPXCHG_MEMb_GPR8},
-    {XED_IFORM_CMPXCHG_LOCK_MEMv_GPRv, XED_IFORM_CMPXCHG_MEMv_GPRv},
-    {XED_IFORM_INC_LOCK_MEMb, XED_IFORM_INC_MEMb},
-    {XED_IFORM_INC_LOCK_MEMv, XED_IFORM_INC_MEMv},
-    {XED_IFORM_OR_LOCK_MEMb_IMMb_80r1, XED_IFORM_OR_MEMb_IMMb_80r1},
-    {XED_IFORM_OR_LOCK_MEMv_IMMz, XED_IFORM_OR_MEMv_IMMz},
-    {XED_IFORM_OR_LOCK_MEMb_IMMb_82r1, XED_IFORM_OR_MEMb_IMMb_82r1},
-    {XED_IFORM_OR_LOCK_MEMv_IMMb, XED_IFORM_OR_MEMv_IMMb},
-    {XED_IFORM_OR_LOCK_MEMb_GPR8, XED_IFORM_OR_MEMb_GPR8},
-    {XED_IFORM_OR_LOCK_MEMv_GPRv, XED_IFORM_OR_MEMv_GPRv},
-    {XED_IFORM_XADD_LOCK_MEMb_GPR8, XED_IFORM_XADD_MEMb_GPR8},
-    {XED_IFORM_XADD_LOCK_MEMv_GPRv, XED_IFORM_XADD_MEMv_GPRv},
-    {XED_IFORM_ADD_LOCK_MEMb_IMMb_80r0, XED_IFORM_ADD_MEMb_IMMb_80r0},
-    {XED_IFORM_ADD_LOCK_MEMv_IMMz, XED_IFORM_ADD_MEMv_IMMz},
-    {XED_IFORM_ADD_LOCK_MEMb_IMMb_82r0, XED_IFORM_ADD_MEMb_IMMb_82r0},
-    {XED_IFORM_ADD_LOCK_MEMv_IMMb, XED_IFORM_ADD_MEMv_IMMb},
-    {XED_IFORM_ADD_LOCK_MEMb_GPR8, XED_IFORM_ADD_MEMb_GPR8},
-    {XED_IFORM_ADD_LOCK_MEMv_GPRv, XED_IFORM_ADD_MEMv_GPRv},
-    {XED_IFORM_SBB_LOCK_MEMb_IMMb_80r3, XED_IFORM_SBB_MEMb_IMMb_80r3},
-    {XED_IFORM_SBB_LOCK_MEMv_IMMz, XED_IFORM_SBB_MEMv_IMMz},
-    {XED_IFORM_SBB_LOCK_MEMb_IMMb_82r3, XED_IFORM_SBB_MEMb_IMMb_82r3},
-    {XED_IFORM_SBB_LOCK_MEMv_IMMb, XED_IFORM_SBB_MEMv_IMMb},
-    {XED_IFORM_SBB_LOCK_MEMb_GPR8, XED_IFORM_SBB_MEMb_GPR8},
-    {XED_IFORM_SBB_LOCK_MEMv_GPRv, XED_IFORM_SBB_MEMv_GPRv},
-    {XED_IFORM_BTS_LOCK_MEMv_IMMb, XED_IFORM_BTS_MEMv_IMMb},
-    {XED_IFORM_BTS_LOCK_MEMv_GPRv, XED_IFORM_BTS_MEMv_GPRv},
-    {XED_IFORM_XOR_LOCK_MEMb_IMMb_80r6, XED_IFORM_XOR_MEMb_IMMb_80r6},
-    {XED_IFORM_XOR_LOCK_MEMv_IMMz, XED_IFORM_XOR_MEMv_IMMz},
-    {XED_IFORM_XOR_LOCK_MEMb_IMMb_82r6, XED_IFORM_XOR_MEMb_IMMb_82r6},
-    {XED_IFORM_XOR_LOCK_MEMv_IMMb, XED_IFORM_XOR_MEMv_IMMb},
-    {XED_IFORM_XOR_LOCK_MEMb_GPR8, XED_IFORM_XOR_MEMb_GPR8},
-    {XED_IFORM_XOR_LOCK_MEMv_GPRv, XED_IFORM_XOR_MEMv_GPRv},
-    {XED_IFORM_BTR_LOCK_MEMv_IMMb, XED_IFORM_BTR_MEMv_IMMb},
-    {XED_IFORM_BTR_LOCK_MEMv_GPRv, XED_IFORM_BTR_MEMv_GPRv},
-    {XED_IFORM_CMPXCHG8B_LOCK_MEMq, XED_IFORM_CMPXCHG8B_MEMq},
-    {XED_IFORM_CMPXCHG8B_LOCK_MEMq, XED_IFORM_CMPXCHG8B_MEMq},
-    {XED_IFORM_CMPXCHG16B_LOCK_MEMdq, XED_IFORM_CMPXCHG16B_MEMdq},
-    {XED_IFORM_NEG_LOCK_MEMb, XED_IFORM_NEG_MEMb},
-    {XED_IFORM_NEG_LOCK_MEMv, XED_IFORM_NEG_MEMv},
+// Variants of the ISEL name of an iform. Scalable instructions are suffixed
+// with their effective operand width, and segment register moves are suffixed
+// with the segment register name. No iform is both scalable and a segment
+// register move, so these share slots.
+enum ISelVariant : uint32_t {
+  kISelVariantNone,
+  kISelVariantWidth8,
+  kISelVariantWidth16,
+  kISelVariantWidth32,
+  kISelVariantWidth64,
+  kISelVariantSegES = 1,
+  kISelVariantSegCS,
+  kISelVariantSegSS,
+  kISelVariantSegDS,
+  kISelVariantSegFS,
+  kISelVariantSegGS,
+  kNumISelVariants
 };
 
-// Name of this instuction function.
-static std::string InstructionFunctionName(const xed_decoded_inst_t *xedd) {
+static const xed_reg_enum_t kSegRegs[] = {
+    XED_REG_ES, XED_REG_CS, XED_REG_SS, XED_REG_DS, XED_REG_FS, XED_REG_GS};
 
-  // If this instuction is marked as atomic via the `LOCK` prefix then we want
-  // to remove it because we will already be surrounding the call to the
-  // semantics function with the atomic begin/end intrinsics.
-  auto iform = xed_decoded_inst_get_iform_enum(xedd);
-  if (xed_operand_values_has_lock_prefix(xedd)) {
-    CHECK(kUnlockedIform.count(iform))
-        << xed_iform_enum_t2str(iform) << " has no unlocked iform mapping.";
-    iform = kUnlockedIform[iform];
+// Flat table indexed by iform. This is filled in once, when the first
+// `X86Arch` is created, so that decoding never builds strings or searches
+// maps. The ISEL ID of an instruction is its index into `gISelNames`.
+static std::vector<std::string> gISelNames;
+
+static bool IsSegmentMove(xed_iform_enum_t iform) {
+  return XED_IFORM_MOV_SEG_MEMw == iform || XED_IFORM_MOV_SEG_GPR16 == iform;
+}
+
+static void InitISelTables(void) {
+  gISelNames.resize(XED_IFORM_LAST * kNumISelVariants);
+  for (auto i = 0U; i < XED_IFORM_LAST; ++i) {
+    auto iform = static_cast<xed_iform_enum_t>(i);
+    std::string name = xed_iform_enum_t2str(iform);
+    auto names = &(gISelNames[i * kNumISelVariants]);
+    names[kISelVariantNone] = name;
+
+    // Suffix the ISEL function name with the segment register name for these
+    // two iforms so that we know which hypercall to use.
+    if (IsSegmentMove(iform)) {
+      for (auto seg = 0U; seg < 6; ++seg) {
+        names[kISelVariantSegES + seg] =
+            name + "_" + xed_reg_enum_t2str(kSegRegs[seg]);
+      }
+    } else {
+      names[kISelVariantWidth8] = name + "_8";
+      names[kISelVariantWidth16] = name + "_16";
+      names[kISelVariantWidth32] = name + "_32";
+      names[kISelVariantWidth64] = name + "_64";
+    }
   }
+}
+
+// Variant of a scalable iform for the effective operand width `width`.
+static ISelVariant ScalableVariant(xed_iform_enum_t iform, uint32_t width) {
+  switch (width) {
+    case 8: return kISelVariantWidth8;
+    case 16: return kISelVariantWidth16;
+    case 32: return kISelVariantWidth32;
+    case 64: return kISelVariantWidth64;
+    default:
+      LOG(ERROR)
+          << "Unexpected operand width for scalable instruction "
+          << xed_iform_enum_t2str(iform);
+      return kISelVariantNone;
+  }
+}
+
+static uint32_t ISelID(xed_iform_enum_t iform, ISelVariant variant) {
+  return static_cast<uint32_t>(iform) * kNumISelVariants + variant;
+}
+
+// Numeric ID of the semantics function for this instruction.
+static uint32_t InstructionFunctionID(const xed_decoded_inst_t *xedd) {
+
+  // `LOCK`-prefixed instructions have their own iforms (e.g.
+  // `ADD_LOCK_MEMv_GPRv`), whose semantics use the atomic memory intrinsics.
+  auto iform = xed_decoded_inst_get_iform_enum(xedd);
 
-  std::stringstream ss;
-  std::string iform_name = xed_iform_enum_t2str(iform);
-  ss << iform_name;
+  auto variant = kISelVariantNone;
 
   // Some instuctions are "scalable", i.e. there are variants of the
   // instuction for each effective operand size. We represent these in
   // the semantics files with `_<size>`, so we need to look up the correct
   // selection.
   if (xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_SCALABLE)) {
-    ss << "_";
-    ss << xed_decoded_inst_get_operand_width(xedd);
-  }
-
-  // Suffix the ISEL function name with the segment register name for these two
-  // iforms so that we know which hypercall to use.
-  if (XED_IFORM_MOV_SEG_MEMw == iform ||
-      XED_IFORM_MOV_SEG_GPR16 == iform) {
-    ss << "_";
-    ss << xed_reg_enum_t2str(xed_decoded_inst_get_reg(xedd, XED_OPERAND_REG0));
+    variant = ScalableVariant(
+        iform, xed_decoded_inst_get_operand_width(xedd));
+
+  } else if (IsSegmentMove(iform)) {
+    auto seg = xed_decoded_inst_get_reg(xedd, XED_OPERAND_REG0);
+    for (auto i = 0U; i < 6; ++i) {
+      if (kSegRegs[i] == seg) {
+        variant = static_cast<ISelVariant>(kISelVariantSegES + i);
+        break;
+      }
+    }
   }
 
-  return ss.str();
+  return ISelID(iform, variant);
 }
 
 // Decode an instuction into the XED instuction format.
@@ -365,29 +370,17 @@ static Operand::Register SegBaseRegOp(xed_reg_enum_t reg,
   return op;
 }
 
-// Decode a memory operand.
-static void DecodeMemory(Instruction &inst,
-                         const xed_decoded_inst_t *xedd,
-                         const xed_operand_t *xedo,
-                         int mem_index) {
-
-  auto iform = xed_decoded_inst_get_iform_enum(xedd);
-  auto iclass = xed_decoded_inst_get_iclass(xedd);
-  auto op_name = xed_operand_name(xedo);
-  auto segment = xed_decoded_inst_get_seg_reg(xedd, mem_index);
-  auto base = xed_decoded_inst_get_base_reg(xedd, mem_index);
-  auto index = xed_decoded_inst_get_index_reg(xedd, mem_index);
-  auto disp = xed_decoded_inst_get_memory_displacement(xedd, mem_index);
-  auto scale = xed_decoded_inst_get_scale(xedd, mem_index);
+// Add a memory operand. `segment` is `XED_REG_INVALID` if the operand has no
+// explicit segment.
+static void AddMemoryOperand(Instruction &inst, xed_iform_enum_t iform,
+                             bool is_agen, bool is_read, bool is_written,
+                             xed_reg_enum_t segment, xed_reg_enum_t base,
+                             xed_reg_enum_t index, uint32_t scale,
+                             int64_t disp, uint32_t size,
+                             uint32_t address_size) {
+  auto iclass = xed_iform_to_iclass(iform);
   auto base_wide = xed_get_largest_enclosing_register(base);
-  auto inst_size = static_cast<int64_t>(xed_decoded_inst_get_length(xedd));
-
-  // NOTE(pag): This isn't quite right (eg. it's for SCALABALE only), but works
-  // mostly right most of the time.
-  auto size = xed_decoded_inst_get_operand_width(xedd);
-  if (XED_IFORM_MOV_MEMw_SEG == iform) {
-    size = 16;
-  }
+  auto inst_size = static_cast<int64_t>(inst.NumBytes());
 
   // PC-relative memory accesses are relative to the next PC.
   if (XED_REG_RIP == base_wide) {
@@ -410,7 +403,7 @@ static void DecodeMemory(Instruction &inst,
 
   // AGEN operands, e.g. for the `LEA` instuction, can be marked with an
   // explicit segment, but it is ignored.
-  } else if (XED_OPERAND_AGEN == op_name) {
+  } else if (is_agen) {
     segment = XED_REG_INVALID;
   }
 
@@ -424,8 +417,7 @@ static void DecodeMemory(Instruction &inst,
   op.size = size;
 
   op.type = Operand::kTypeAddress;
-  op.addr.address_size = xed_decoded_inst_get_memop_address_width(
-      xedd, mem_index);
+  op.addr.address_size = address_size;
 
   op.addr.segment_base_reg = SegBaseRegOp(segment, op.addr.address_size);
   op.addr.base_reg = RegOp(base);
@@ -436,21 +428,20 @@ static void DecodeMemory(Instruction &inst,
   // Rename the base register to use `PC` as the register name.
   if (XED_REG_RIP == base_wide) {
     op.addr.base_reg.name = "PC";
-    op.addr.displacement += static_cast<int64_t>(inst.NumBytes());
   }
 
   // We always pass destination operands first, then sources. Memory operands
   // are represented by their addresses, and in the instuction implementations,
   // accessed via intrinsics.
-  if (xed_operand_written(xedo)) {
+  if (is_written) {
     op.action = Operand::kActionWrite;
     op.addr.kind = Operand::Address::kMemoryWrite;
     inst.operands.push_back(op);
   }
 
-  if (xed_operand_read(xedo)) {
+  if (is_read) {
     op.action = Operand::kActionRead;
-    if (XED_OPERAND_AGEN == op_name) {
+    if (is_agen) {
       op.addr.kind = Operand::Address::kAddressCalculation;
     } else {
       op.addr.kind = Operand::Address::kMemoryRead;
@@ -459,6 +450,48 @@ static void DecodeMemory(Instruction &inst,
   }
 }
 
+// Decode a memory operand.
+static void DecodeMemory(Instruction &inst,
+                         const xed_decoded_inst_t *xedd,
+                         const xed_operand_t *xedo,
+                         int mem_index) {
+
+  auto iform = xed_decoded_inst_get_iform_enum(xedd);
+
+  // NOTE(pag): This isn't quite right (eg. it's for SCALABALE only), but works
+  // mostly right most of the time.
+  auto size = xed_decoded_inst_get_operand_width(xedd);
+  if (XED_IFORM_MOV_MEMw_SEG == iform) {
+    size = 16;
+  }
+
+  AddMemoryOperand(
+      inst, iform, XED_OPERAND_AGEN == xed_operand_name(xedo),
+      xed_operand_read(xedo), xed_operand_written(xedo),
+      xed_decoded_inst_get_seg_reg(xedd, mem_index),
+      xed_decoded_inst_get_base_reg(xedd, mem_index),
+      xed_decoded_inst_get_index_reg(xedd, mem_index),
+      xed_decoded_inst_get_scale(xedd, mem_index),
+      xed_decoded_inst_get_memory_displacement(xedd, mem_index),
+      size, xed_decoded_inst_get_memop_address_width(xedd, mem_index));
+}
+
+// Add an immediate operand. `val` is already sign- or zero-extended.
+static void AddImmediateOperand(Instruction &inst, uint64_t val,
+                                bool is_signed, uint32_t imm_size) {
+  CHECK(imm_size <= inst.operand_size)
+      << "Immediate size is greater than effective operand size at "
+      << std::hex << inst.pc << ".";
+
+  Operand op = {};
+  op.type = Operand::kTypeImmediate;
+  op.action = Operand::kActionRead;
+  op.size = imm_size;
+  op.imm.is_signed = is_signed;
+  op.imm.val = val;
+  inst.operands.push_back(op);
+}
+
 // Decode an immediate constant.
 static void DecodeImmediate(Instruction &inst,
                             const xed_decoded_inst_t *xedd,
@@ -467,10 +500,6 @@ static void DecodeImmediate(Instruction &inst,
   auto is_signed = false;
   auto imm_size = xed_decoded_inst_get_immediate_width_bits(xedd);
 
-  CHECK(imm_size <= inst.operand_size)
-      << "Immediate size is greater than effective operand size at "
-      << std::hex << inst.pc << ".";
-
   if (XED_OPERAND_IMM0SIGNED == op_name ||
       xed_operand_values_get_immediate_is_signed(xedd)) {
     val = static_cast<uint64_t>(
@@ -489,21 +518,12 @@ static void DecodeImmediate(Instruction &inst,
         << xed_operand_enum_t2str(op_name) << ".";
   }
 
-  Operand op = {};
-  op.type = Operand::kTypeImmediate;
-  op.action = Operand::kActionRead;
-  op.size = imm_size;
-  op.imm.is_signed = is_signed;
-  op.imm.val = val;
-  inst.operands.push_back(op);
+  AddImmediateOperand(inst, val, is_signed, imm_size);
 }
 
-// Decode a register operand.
-static void DecodeRegister(Instruction &inst,
-                           const xed_decoded_inst_t *xedd,
-                           const xed_operand_t *xedo,
-                           xed_operand_enum_t op_name) {
-  auto reg = xed_decoded_inst_get_reg(xedd, op_name);
+// Add a register operand.
+static void AddRegisterOperand(Instruction &inst, xed_reg_enum_t reg,
+                               bool is_read, bool is_written) {
   CHECK(XED_REG_INVALID != reg)
       << "Cannot get name of invalid register.";
 
@@ -513,7 +533,7 @@ static void DecodeRegister(Instruction &inst,
   op.size = op.reg.size;
 
   // Pass the register by reference.
-  if (xed_operand_written(xedo)) {
+  if (is_written) {
     op.action = Operand::kActionWrite;
     if (Is64Bit(inst.arch_name)) {
       if (XED_REG_GPR32_FIRST <= reg && XED_REG_GPR32_LAST > reg) {
@@ -537,12 +557,21 @@ static void DecodeRegister(Instruction &inst,
     inst.operands.push_back(op);
   }
 
-  if (xed_operand_read(xedo)) {
+  if (is_read) {
     op.action = Operand::kActionRead;
     inst.operands.push_back(op);
   }
 }
 
+// Decode a register operand.
+static void DecodeRegister(Instruction &inst,
+                           const xed_decoded_inst_t *xedd,
+                           const xed_operand_t *xedo,
+                           xed_operand_enum_t op_name) {
+  AddRegisterOperand(inst, xed_decoded_inst_get_reg(xedd, op_name),
+                     xed_operand_read(xedo), xed_operand_written(xedo));
+}
+
 static void DecodeConditionalInterrupt(Instruction &inst) {
   // Condition variable.
   Operand cond_op = {};
@@ -556,8 +585,7 @@ static void DecodeConditionalInterrupt(Instruction &inst) {
 
 // Operand representing the fall-through PC, which is the not-taken branch of
 // a conditional jump, or the return address for a function call.
-static void DecodeFallThroughPC(Instruction &inst,
-                                const xed_decoded_inst_t *xedd) {
+static void DecodeFallThroughPC(Instruction &inst) {
   auto pc_reg = Is64Bit(inst.arch_name) ? XED_REG_RIP : XED_REG_EIP;
   auto pc_width = xed_get_register_width_bits64(pc_reg);
 
@@ -576,12 +604,9 @@ static void DecodeFallThroughPC(Instruction &inst,
 }
 
 // Decode a relative branch target.
-static void DecodeConditionalBranch(Instruction &inst,
-                                    const xed_decoded_inst_t *xedd) {
+static void DecodeConditionalBranch(Instruction &inst, int64_t disp) {
   auto pc_reg = Is64Bit(inst.arch_name) ? XED_REG_RIP : XED_REG_EIP;
   auto pc_width = xed_get_register_width_bits64(pc_reg);
-  auto disp = static_cast<int64_t>(
-      xed_decoded_inst_get_branch_displacement(xedd));
 
   // Condition variable.
   Operand cond_op = {};
@@ -607,16 +632,13 @@ static void DecodeConditionalBranch(Instruction &inst,
   inst.branch_taken_pc = static_cast<uint64_t>(
       static_cast<int64_t>(inst.next_pc) + disp);
 
-  DecodeFallThroughPC(inst, xedd);
+  DecodeFallThroughPC(inst);
 }
 
 // Decode a relative branch target.
-static void DecodeRelativeBranch(Instruction &inst,
-                                 const xed_decoded_inst_t *xedd) {
+static void DecodeRelativeBranch(Instruction &inst, int64_t disp) {
   auto pc_reg = Is64Bit(inst.arch_name) ? XED_REG_RIP : XED_REG_EIP;
   auto pc_width = xed_get_register_width_bits64(pc_reg);
-  auto disp = static_cast<int64_t>(
-      xed_decoded_inst_get_branch_displacement(xedd));
 
   // Taken branch.
   Operand taken_op = {};
@@ -674,13 +696,16 @@ static void DecodeOperand(Instruction &inst,
       DecodeRegister(inst, xedd, xedo, op_name);
       break;
 
-    case XED_OPERAND_RELBR:
+    case XED_OPERAND_RELBR: {
+      auto disp = static_cast<int64_t>(
+          xed_decoded_inst_get_branch_displacement(xedd));
       if (Instruction::kCategoryConditionalBranch == inst.category) {
-        DecodeConditionalBranch(inst, xedd);
+        DecodeConditionalBranch(inst, disp);
       } else {
-        DecodeRelativeBranch(inst, xedd);
+        DecodeRelativeBranch(inst, disp);
       }
       break;
+    }
 
     default:
       LOG(FATAL)
@@ -690,6 +715,72 @@ static void DecodeOperand(Instruction &inst,
   }
 }
 
+// Decode one of the common instructions handled by `x86::FastDecode`. This
+// produces the same `Instruction` as decoding it with XED.
+static bool DecodeFast(Instruction &inst, const std::string &inst_bytes,
+                       bool is_64bit) {
+  x86::FastInstruction finst;
+  if (!x86::FastDecode(reinterpret_cast<const uint8_t *>(inst_bytes.data()),
+                       inst_bytes.size(), is_64bit, &finst)) {
+    return false;
+  }
+
+  auto variant = kISelVariantNone;
+  if (finst.is_scalable) {
+    variant = ScalableVariant(finst.iform, finst.operand_width);
+  }
+
+  inst.operand_size = finst.operand_width;
+  inst.isel_id = ISelID(finst.iform, variant);
+  inst.function = gISelNames[inst.isel_id];
+  inst.bytes = inst_bytes.substr(0, finst.num_bytes);
+  inst.category = finst.category;
+  inst.next_pc = inst.pc + finst.num_bytes;
+
+  for (auto i = 0U; i < finst.num_operands; ++i) {
+    const auto &fop = finst.operands[i];
+    switch (fop.kind) {
+      case x86::FastOperand::kKindRegister:
+        AddRegisterOperand(inst, fop.reg, fop.is_read, fop.is_written);
+        break;
+
+      case x86::FastOperand::kKindMemory:
+      case x86::FastOperand::kKindAddress:
+        AddMemoryOperand(
+            inst, finst.iform, x86::FastOperand::kKindAddress == fop.kind,
+            fop.is_read, fop.is_written, XED_REG_INVALID, finst.base_reg,
+            finst.index_reg, finst.scale, finst.displacement,
+            finst.operand_width, finst.address_width);
+        break;
+
+      case x86::FastOperand::kKindImmediate:
+        AddImmediateOperand(inst, finst.immediate, finst.immediate_is_signed,
+                            finst.immediate_width);
+        break;
+
+      case x86::FastOperand::kKindRelativeBranch:
+        if (Instruction::kCategoryConditionalBranch == inst.category) {
+          DecodeConditionalBranch(inst, finst.branch_displacement);
+        } else {
+          DecodeRelativeBranch(inst, finst.branch_displacement);
+        }
+        break;
+
+      case x86::FastOperand::kKindInvalid:
+        LOG(FATAL)
+            << "Invalid operand of fast-decoded instruction at "
+            << std::hex << inst.pc;
+        break;
+    }
+  }
+
+  if (inst.IsFunctionCall()) {
+    DecodeFallThroughPC(inst);
+  }
+
+  return true;
+}
+
 class X86Arch : public Arch {
  public:
   X86Arch(OSName os_name_, ArchName arch_name_);
@@ -701,6 +792,11 @@ class X86Arch : public Arch {
       uint64_t address, const std::string &inst_bytes,
       Instruction &inst) const override;
 
+  // Decode only the length, category and branch target of an instruction.
+  bool DecodeInstructionBoundary(
+      uint64_t address, const uint8_t *bytes, size_t num_bytes,
+      InstructionBoundary &boundary) const override;
+
   // Maximum number of bytes in an instruction.
   uint64_t MaxInstructionSize(void) const override;
 
@@ -722,6 +818,7 @@ X86Arch::X86Arch(OSName os_name_, ArchName arch_name_)
   if (!xed_is_initialized) {
     DLOG(INFO) << "Initializing XED tables";
     xed_tables_init();
+    InitISelTables();
     xed_is_initialized = true;
   }
 }
@@ -859,6 +956,14 @@ bool X86Arch::DecodeInstruction(
   inst.pc = address;
   inst.arch_name = arch_name;
   inst.category = Instruction::kCategoryInvalid;
+  inst.isel_id = Instruction::kInvalidISelID;
+
+  // The fast path only handles instructions that are valid for every x86
+  // and AMD64 architecture variant.
+  if (FLAGS_x86_fast_decode &&
+      DecodeFast(inst, inst_bytes, 64 == address_size)) {
+    return true;
+  }
 
   xed_decoded_inst_t xedd_;
   xed_decoded_inst_t *xedd = &xedd_;
@@ -869,18 +974,12 @@ bool X86Arch::DecodeInstruction(
   }
 
   inst.operand_size = xed_decoded_inst_get_operand_width(xedd);
-  inst.function = InstructionFunctionName(xedd);
+  inst.isel_id = InstructionFunctionID(xedd);
+  inst.function = gISelNames[inst.isel_id];
   inst.bytes = inst_bytes.substr(0, xed_decoded_inst_get_length(xedd));
   inst.category = CreateCategory(xedd);
   inst.next_pc = address + xed_decoded_inst_get_length(xedd);
 
-  // Wrap an instuction in atomic begin/end if it accesses memory with RMW
-  // semantics or with a LOCK prefix.
-  if (xed_operand_values_get_atomic(xedd) ||
-      xed_operand_values_has_lock_prefix(xedd)) {
-    inst.is_atomic_read_modify_write = true;
-  }
-
   if (Instruction::kCategoryConditionalAsyncHyperCall == inst.category) {
     DecodeConditionalInterrupt(inst);
   }
@@ -897,7 +996,7 @@ bool X86Arch::DecodeInstruction(
   }
 
   if (inst.IsFunctionCall()) {
-    DecodeFallThroughPC(inst, xedd);
+    DecodeFallThroughPC(inst);
   }
 
   // Make sure we disallow decoding of AVX instructions when running with non-
@@ -927,6 +1026,48 @@ bool X86Arch::DecodeInstruction(
   return true;
 }
 
+bool X86Arch::DecodeInstructionBoundary(
+    uint64_t address, const uint8_t *bytes, size_t num_bytes,
+    InstructionBoundary &boundary) const {
+
+  x86::PreDecodedInstruction pinst;
+  if (!x86::PreDecode(bytes, num_bytes, 64 == address_size, &pinst)) {
+    return Arch::DecodeInstructionBoundary(
+        address, bytes, num_bytes, boundary);
+  }
+
+  // Whether or not a `VEX`- or `EVEX`-encoded instruction can be decoded
+  // depends on its XED category, and on the architecture.
+  if (pinst.is_evex) {
+    if (kArchAMD64_AVX512 != arch_name && kArchX86_AVX512 != arch_name) {
+      return Arch::DecodeInstructionBoundary(
+          address, bytes, num_bytes, boundary);
+    }
+  } else if (pinst.is_vex) {
+    if (kArchAMD64 == arch_name || kArchX86 == arch_name) {
+      return Arch::DecodeInstructionBoundary(
+          address, bytes, num_bytes, boundary);
+    }
+  }
+
+  boundary.pc = address;
+  boundary.next_pc = address + pinst.num_bytes;
+  boundary.category = pinst.category;
+  boundary.branch_taken_pc = 0;
+
+  switch (pinst.category) {
+    case Instruction::kCategoryDirectJump:
+    case Instruction::kCategoryDirectFunctionCall:
+    case Instruction::kCategoryConditionalBranch:
+      boundary.branch_taken_pc = static_cast<uint64_t>(
+          static_cast<int64_t>(boundary.next_pc) + pinst.branch_displacement);
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
 }  // namespace
 
 // TODO(pag): We pretend that these are singletons, but they aren't really!
@@ -0,0 +1,1151 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "remill/Arch/X86/Decode.h"
+
+namespace remill {
+namespace x86 {
+namespace {
+
+// How the operands of an opcode are encoded.
+enum FormKind : uint8_t {
+  kFormInvalid,
+  kFormRmReg,  // `E, G`: ModRM.rm, then ModRM.reg.
+  kFormRegRm,  // `G, E`: ModRM.reg, then ModRM.rm.
+  kFormRegAddr,  // `G, M`: ModRM.reg, then an address calculation.
+  kFormRmImm,  // `E, I`: ModRM.rm, then an immediate.
+  kFormGroup,  // ModRM.reg selects one of the forms of a group.
+  kFormAccImm,  // `rAX, I`.
+  kFormOpcodeReg,  // Register in the low three bits of the opcode.
+  kFormOpcodeRegImm,  // Same as above, then an immediate.
+  kFormImm,
+  kFormRelBr,
+  kFormNoOperands
+};
+
+enum ImmKind : uint8_t {
+  kImmNone,
+  kImmSignedByte,  // `Ib`, sign-extended.
+  kImmSignedZ,  // `Iz`, i.e. 32 bits, sign-extended.
+  kImmUnsignedV  // `Iv`, i.e. 32 or 64 bits.
+};
+
+enum Access : uint8_t {
+  kAccessRead = 1,
+  kAccessWrite = 2,
+  kAccessReadWrite = 3
+};
+
+enum GroupName : uint8_t {
+  kGroup81,
+  kGroup83,
+  kGroupC7,
+  kGroupF7,
+  kNumGroups
+};
+
+struct Form {
+  FormKind kind;
+  ImmKind imm;
+  Access first_access;
+  GroupName group;  // Only valid for `kFormGroup`.
+  uint8_t rel_size;  // Size of the branch displacement, in bytes.
+  bool is_byte_op;
+  bool is_default_64;  // 64-bit effective operand size in 64-bit mode.
+  bool is_scalable;
+  bool allows_rex;
+  Instruction::Category category;
+  xed_iform_enum_t reg_iform;  // ModRM.mod is `3`, or there is no ModRM.
+  xed_iform_enum_t mem_iform;  // ModRM.mod is not `3`.
+};
+
+static const xed_reg_enum_t kGPR64[] = {
+  XED_REG_RAX, XED_REG_RCX, XED_REG_RDX, XED_REG_RBX,
+  XED_REG_RSP, XED_REG_RBP, XED_REG_RSI, XED_REG_RDI,
+  XED_REG_R8, XED_REG_R9, XED_REG_R10, XED_REG_R11,
+  XED_REG_R12, XED_REG_R13, XED_REG_R14, XED_REG_R15
+};
+
+static const xed_reg_enum_t kGPR32[] = {
+  XED_REG_EAX, XED_REG_ECX, XED_REG_EDX, XED_REG_EBX,
+  XED_REG_ESP, XED_REG_EBP, XED_REG_ESI, XED_REG_EDI,
+  XED_REG_R8D, XED_REG_R9D, XED_REG_R10D, XED_REG_R11D,
+  XED_REG_R12D, XED_REG_R13D, XED_REG_R14D, XED_REG_R15D
+};
+
+// Byte registers when there is a REX prefix.
+static const xed_reg_enum_t kGPR8Rex[] = {
+  XED_REG_AL, XED_REG_CL, XED_REG_DL, XED_REG_BL,
+  XED_REG_SPL, XED_REG_BPL, XED_REG_SIL, XED_REG_DIL,
+  XED_REG_R8B, XED_REG_R9B, XED_REG_R10B, XED_REG_R11B,
+  XED_REG_R12B, XED_REG_R13B, XED_REG_R14B, XED_REG_R15B
+};
+
+// Byte registers when there is no REX prefix.
+static const xed_reg_enum_t kGPR8[] = {
+  XED_REG_AL, XED_REG_CL, XED_REG_DL, XED_REG_BL,
+  XED_REG_AH, XED_REG_CH, XED_REG_DH, XED_REG_BH
+};
+
+static const xed_iform_enum_t kJccRel8[] = {
+  XED_IFORM_JO_RELBRb, XED_IFORM_JNO_RELBRb,
+  XED_IFORM_JB_RELBRb, XED_IFORM_JNB_RELBRb,
+  XED_IFORM_JZ_RELBRb, XED_IFORM_JNZ_RELBRb,
+  XED_IFORM_JBE_RELBRb, XED_IFORM_JNBE_RELBRb,
+  XED_IFORM_JS_RELBRb, XED_IFORM_JNS_RELBRb,
+  XED_IFORM_JP_RELBRb, XED_IFORM_JNP_RELBRb,
+  XED_IFORM_JL_RELBRb, XED_IFORM_JNL_RELBRb,
+  XED_IFORM_JLE_RELBRb, XED_IFORM_JNLE_RELBRb
+};
+
+// In 64-bit mode, near branches always have 32-bit displacements.
+static const xed_iform_enum_t kJccRel32In64[] = {
+  XED_IFORM_JO_RELBRd, XED_IFORM_JNO_RELBRd,
+  XED_IFORM_JB_RELBRd, XED_IFORM_JNB_RELBRd,
+  XED_IFORM_JZ_RELBRd, XED_IFORM_JNZ_RELBRd,
+  XED_IFORM_JBE_RELBRd, XED_IFORM_JNBE_RELBRd,
+  XED_IFORM_JS_RELBRd, XED_IFORM_JNS_RELBRd,
+  XED_IFORM_JP_RELBRd, XED_IFORM_JNP_RELBRd,
+  XED_IFORM_JL_RELBRd, XED_IFORM_JNL_RELBRd,
+  XED_IFORM_JLE_RELBRd, XED_IFORM_JNLE_RELBRd
+};
+
+static const xed_iform_enum_t kJccRel32In32[] = {
+  XED_IFORM_JO_RELBRz, XED_IFORM_JNO_RELBRz,
+  XED_IFORM_JB_RELBRz, XED_IFORM_JNB_RELBRz,
+  XED_IFORM_JZ_RELBRz, XED_IFORM_JNZ_RELBRz,
+  XED_IFORM_JBE_RELBRz, XED_IFORM_JNBE_RELBRz,
+  XED_IFORM_JS_RELBRz, XED_IFORM_JNS_RELBRz,
+  XED_IFORM_JP_RELBRz, XED_IFORM_JNP_RELBRz,
+  XED_IFORM_JL_RELBRz, XED_IFORM_JNL_RELBRz,
+  XED_IFORM_JLE_RELBRz, XED_IFORM_JNLE_RELBRz
+};
+
+// Adds the forms of the eight classic ALU operations, whose opcodes all
+// follow the same pattern. `digit` is the ModRM.reg value of the operation
+// in the `0x81` and `0x83` groups.
+#define ADD_ALU_FORMS(name, digit, rm8, rm, reg8, reg, access) \
+    AddModRM((digit) * 8, kFormRmReg, true, access, \
+             XED_IFORM_ ## name ## _GPR8_GPR8_ ## rm8, \
+             XED_IFORM_ ## name ## _MEMb_GPR8); \
+    AddModRM((digit) * 8 + 1, kFormRmReg, false, access, \
+             XED_IFORM_ ## name ## _GPRv_GPRv_ ## rm, \
+             XED_IFORM_ ## name ## _MEMv_GPRv); \
+    AddModRM((digit) * 8 + 2, kFormRegRm, true, access, \
+             XED_IFORM_ ## name ## _GPR8_GPR8_ ## reg8, \
+             XED_IFORM_ ## name ## _GPR8_MEMb); \
+    AddModRM((digit) * 8 + 3, kFormRegRm, false, access, \
+             XED_IFORM_ ## name ## _GPRv_GPRv_ ## reg, \
+             XED_IFORM_ ## name ## _GPRv_MEMv); \
+    AddAccImm((digit) * 8 + 5, access, XED_IFORM_ ## name ## _OrAX_IMMz); \
+    AddGroupImm(kGroup81, digit, access, kImmSignedZ, \
+                XED_IFORM_ ## name ## _GPRv_IMMz, \
+                XED_IFORM_ ## name ## _MEMv_IMMz); \
+    AddGroupImm(kGroup83, digit, access, kImmSignedByte, \
+                XED_IFORM_ ## name ## _GPRv_IMMb, \
+                XED_IFORM_ ## name ## _MEMv_IMMb)
+
+// Opcode tables for one machine mode. Encodings that aren't handled here
+// have invalid forms.
+class FormTable {
+ public:
+  explicit FormTable(bool is_64bit);
+
+  Form one_byte[256];
+  Form jcc_rel32[16];
+  Form groups[kNumGroups][8];
+
+ private:
+  FormTable(void) = delete;
+
+  void AddModRM(unsigned opcode, FormKind kind, bool is_byte_op,
+                Access first_access, xed_iform_enum_t reg_iform,
+                xed_iform_enum_t mem_iform);
+
+  void AddAccImm(unsigned opcode, Access first_access,
+                 xed_iform_enum_t iform);
+
+  void AddGroupImm(GroupName group, unsigned digit, Access first_access,
+                   ImmKind imm, xed_iform_enum_t reg_iform,
+                   xed_iform_enum_t mem_iform);
+
+  void AddBranch(Form *form, Instruction::Category category,
+                 uint8_t rel_size, bool is_scalable, xed_iform_enum_t iform);
+};
+
+FormTable::FormTable(bool is_64bit)
+    : one_byte(),
+      jcc_rel32(),
+      groups() {
+
+  ADD_ALU_FORMS(ADD, 0, 00, 01, 02, 03, kAccessReadWrite);
+  ADD_ALU_FORMS(OR, 1, 08, 09, 0A, 0B, kAccessReadWrite);
+  ADD_ALU_FORMS(ADC, 2, 10, 11, 12, 13, kAccessReadWrite);
+  ADD_ALU_FORMS(SBB, 3, 18, 19, 1A, 1B, kAccessReadWrite);
+  ADD_ALU_FORMS(AND, 4, 20, 21, 22, 23, kAccessReadWrite);
+  ADD_ALU_FORMS(SUB, 5, 28, 29, 2A, 2B, kAccessReadWrite);
+  ADD_ALU_FORMS(XOR, 6, 30, 31, 32, 33, kAccessReadWrite);
+  ADD_ALU_FORMS(CMP, 7, 38, 39, 3A, 3B, kAccessRead);
+
+  AddModRM(0x84, kFormRmReg, true, kAccessRead,
+           XED_IFORM_TEST_GPR8_GPR8, XED_IFORM_TEST_MEMb_GPR8);
+  AddModRM(0x85, kFormRmReg, false, kAccessRead,
+           XED_IFORM_TEST_GPRv_GPRv, XED_IFORM_TEST_MEMv_GPRv);
+  AddAccImm(0xA9, kAccessRead, XED_IFORM_TEST_OrAX_IMMz);
+  AddGroupImm(kGroupF7, 0, kAccessRead, kImmSignedZ,
+              XED_IFORM_TEST_GPRv_IMMz_F7r0, XED_IFORM_TEST_MEMv_IMMz_F7r0);
+
+  AddModRM(0x88, kFormRmReg, true, kAccessWrite,
+           XED_IFORM_MOV_GPR8_GPR8_88, XED_IFORM_MOV_MEMb_GPR8);
+  AddModRM(0x89, kFormRmReg, false, kAccessWrite,
+           XED_IFORM_MOV_GPRv_GPRv_89, XED_IFORM_MOV_MEMv_GPRv);
+  AddModRM(0x8A, kFormRegRm, true, kAccessWrite,
+           XED_IFORM_MOV_GPR8_GPR8_8A, XED_IFORM_MOV_GPR8_MEMb);
+  AddModRM(0x8B, kFormRegRm, false, kAccessWrite,
+           XED_IFORM_MOV_GPRv_GPRv_8B, XED_IFORM_MOV_GPRv_MEMv);
+  AddModRM(0x8D, kFormRegAddr, false, kAccessWrite,
+           XED_IFORM_INVALID, XED_IFORM_LEA_GPRv_AGEN);
+  AddGroupImm(kGroupC7, 0, kAccessWrite, kImmSignedZ,
+              XED_IFORM_MOV_GPRv_IMMz, XED_IFORM_MOV_MEMv_IMMz);
+
+  for (auto reg = 0U; reg < 8; ++reg) {
+    auto &mov = one_byte[0xB8 + reg];
+    mov.kind = kFormOpcodeRegImm;
+    mov.imm = kImmUnsignedV;
+    mov.first_access = kAccessWrite;
+    mov.is_scalable = true;
+    mov.allows_rex = true;
+    mov.category = Instruction::kCategoryNormal;
+    mov.reg_iform = XED_IFORM_MOV_GPRv_IMMv;
+
+    auto &push = one_byte[0x50 + reg];
+    push.kind = kFormOpcodeReg;
+    push.first_access = kAccessRead;
+    push.is_default_64 = true;
+    push.is_scalable = true;
+    push.allows_rex = true;
+    push.category = Instruction::kCategoryNormal;
+    push.reg_iform = XED_IFORM_PUSH_GPRv_50;
+
+    auto &pop = one_byte[0x58 + reg];
+    pop = push;
+    pop.first_access = kAccessWrite;
+    pop.reg_iform = XED_IFORM_POP_GPRv_51;
+  }
+
+  auto &push_imm = one_byte[0x68];
+  push_imm.kind = kFormImm;
+  push_imm.imm = kImmSignedZ;
+  push_imm.is_default_64 = true;
+  push_imm.is_scalable = true;
+  push_imm.category = Instruction::kCategoryNormal;
+  push_imm.reg_iform = XED_IFORM_PUSH_IMMz;
+
+  auto &push_imm8 = one_byte[0x6A];
+  push_imm8 = push_imm;
+  push_imm8.imm = kImmSignedByte;
+  push_imm8.reg_iform = XED_IFORM_PUSH_IMMb;
+
+  for (auto cond = 0U; cond < 16; ++cond) {
+    AddBranch(&(one_byte[0x70 + cond]),
+              Instruction::kCategoryConditionalBranch, 1, false,
+              kJccRel8[cond]);
+    if (is_64bit) {
+      AddBranch(&(jcc_rel32[cond]), Instruction::kCategoryConditionalBranch,
+                4, false, kJccRel32In64[cond]);
+    } else {
+      AddBranch(&(jcc_rel32[cond]), Instruction::kCategoryConditionalBranch,
+                4, true, kJccRel32In32[cond]);
+    }
+  }
+
+  AddBranch(&(one_byte[0xEB]), Instruction::kCategoryDirectJump, 1, false,
+            XED_IFORM_JMP_RELBRb);
+  if (is_64bit) {
+    AddBranch(&(one_byte[0xE9]), Instruction::kCategoryDirectJump, 4, false,
+              XED_IFORM_JMP_RELBRd);
+    AddBranch(&(one_byte[0xE8]), Instruction::kCategoryDirectFunctionCall, 4,
+              true, XED_IFORM_CALL_NEAR_RELBRd);
+  } else {
+    AddBranch(&(one_byte[0xE9]), Instruction::kCategoryDirectJump, 4, true,
+              XED_IFORM_JMP_RELBRz);
+    AddBranch(&(one_byte[0xE8]), Instruction::kCategoryDirectFunctionCall, 4,
+              true, XED_IFORM_CALL_NEAR_RELBRz);
+  }
+
+  auto &ret = one_byte[0xC3];
+  ret.kind = kFormNoOperands;
+  ret.is_default_64 = true;
+  ret.is_scalable = true;
+  ret.category = Instruction::kCategoryFunctionReturn;
+  ret.reg_iform = XED_IFORM_RET_NEAR;
+
+  // With a `REX.B` prefix, this is `XCHG R8, RAX`.
+  auto &nop = one_byte[0x90];
+  nop.kind = kFormNoOperands;
+  nop.category = Instruction::kCategoryNoOp;
+  nop.reg_iform = XED_IFORM_NOP_90;
+}
+
+#undef ADD_ALU_FORMS
+
+void FormTable::AddModRM(unsigned opcode, FormKind kind, bool is_byte_op,
+                         Access first_access, xed_iform_enum_t reg_iform,
+                         xed_iform_enum_t mem_iform) {
+  auto &form = one_byte[opcode];
+  form.kind = kind;
+  form.first_access = first_access;
+  form.is_byte_op = is_byte_op;
+  form.is_scalable = !is_byte_op;
+  form.allows_rex = true;
+  form.category = Instruction::kCategoryNormal;
+  form.reg_iform = reg_iform;
+  form.mem_iform = mem_iform;
+}
+
+void FormTable::AddAccImm(unsigned opcode, Access first_access,
+                          xed_iform_enum_t iform) {
+  auto &form = one_byte[opcode];
+  form.kind = kFormAccImm;
+  form.imm = kImmSignedZ;
+  form.first_access = first_access;
+  form.is_scalable = true;
+  form.allows_rex = true;
+  form.category = Instruction::kCategoryNormal;
+  form.reg_iform = iform;
+}
+
+void FormTable::AddGroupImm(GroupName group, unsigned digit,
+                            Access first_access, ImmKind imm,
+                            xed_iform_enum_t reg_iform,
+                            xed_iform_enum_t mem_iform) {
+  static const uint8_t kGroupOpcodes[kNumGroups] = {0x81, 0x83, 0xC7, 0xF7};
+
+  auto &group_form = one_byte[kGroupOpcodes[group]];
+  group_form.kind = kFormGroup;
+  group_form.group = group;
+
+  auto &form = groups[group][digit];
+  form.kind = kFormRmImm;
+  form.imm = imm;
+  form.first_access = first_access;
+  form.is_scalable = true;
+  form.allows_rex = true;
+  form.category = Instruction::kCategoryNormal;
+  form.reg_iform = reg_iform;
+  form.mem_iform = mem_iform;
+}
+
+void FormTable::AddBranch(Form *form, Instruction::Category category,
+                          uint8_t rel_size, bool is_scalable,
+                          xed_iform_enum_t iform) {
+  form->kind = kFormRelBr;
+  form->rel_size = rel_size;
+  form->is_default_64 = true;
+  form->is_scalable = is_scalable;
+  form->category = category;
+  form->reg_iform = iform;
+}
+
+static const FormTable &GetFormTable(bool is_64bit) {
+  static const FormTable kFormTable32(false);
+  static const FormTable kFormTable64(true);
+  return is_64bit ? kFormTable64 : kFormTable32;
+}
+
+// Reads a little-endian value and sign-extends it.
+static int64_t ReadSigned(const uint8_t *bytes, size_t size) {
+  uint64_t val = 0;
+  for (auto i = size; i-- > 0; ) {
+    val = (val << 8) | bytes[i];
+  }
+  auto shift = 64 - (size * 8);
+  return static_cast<int64_t>(val << shift) >> shift;
+}
+
+static uint64_t ReadUnsigned(const uint8_t *bytes, size_t size) {
+  uint64_t val = 0;
+  for (auto i = size; i-- > 0; ) {
+    val = (val << 8) | bytes[i];
+  }
+  return val;
+}
+
+static xed_reg_enum_t GPR(unsigned num, uint32_t width, bool has_rex) {
+  switch (width) {
+    case 8: return has_rex ? kGPR8Rex[num] : kGPR8[num];
+    case 32: return kGPR32[num];
+    default: return kGPR64[num];
+  }
+}
+
+// Decode the memory operand described by a ModRM byte, and by the SIB byte
+// and displacement that follow it.
+static bool DecodeModRMMemory(const uint8_t *bytes, size_t num_bytes,
+                              size_t *pos, uint8_t modrm, uint8_t rex,
+                              bool is_64bit, FastInstruction *inst) {
+  const auto gprs = is_64bit ? kGPR64 : kGPR32;
+  const unsigned mod = modrm >> 6;
+  const unsigned rm = modrm & 7u;
+  const unsigned rex_x = (rex >> 1) & 1u;
+  const unsigned rex_b = rex & 1u;
+
+  inst->base_reg = XED_REG_INVALID;
+  inst->index_reg = XED_REG_INVALID;
+  inst->scale = 1;
+  inst->address_width = is_64bit ? 64 : 32;
+
+  size_t disp_size = 1 == mod ? 1 : (2 == mod ? 4 : 0);
+
+  if (4 == rm) {
+    if (*pos >= num_bytes) {
+      return false;
+    }
+    const auto sib = bytes[(*pos)++];
+    const auto index = ((sib >> 3) & 7u) | (rex_x << 3);
+    const auto base = sib & 7u;
+    inst->scale = 1u << (sib >> 6);
+    if (4 != index) {
+      inst->index_reg = gprs[index];
+    }
+    if (5 == base && 0 == mod) {
+      disp_size = 4;
+    } else {
+      inst->base_reg = gprs[base | (rex_b << 3)];
+    }
+
+  } else if (5 == rm && 0 == mod) {
+    disp_size = 4;
+    if (is_64bit) {
+      inst->base_reg = XED_REG_RIP;
+    }
+
+  } else {
+    inst->base_reg = gprs[rm | (rex_b << 3)];
+  }
+
+  if ((*pos + disp_size) > num_bytes) {
+    return false;
+  }
+  inst->displacement = ReadSigned(&(bytes[*pos]), disp_size);
+  *pos += disp_size;
+  return true;
+}
+
+static bool DecodeImmediate(const uint8_t *bytes, size_t num_bytes,
+                            size_t *pos, ImmKind imm, uint32_t eosz,
+                            FastInstruction *inst) {
+  size_t size = 0;
+  switch (imm) {
+    case kImmNone:
+      return true;
+    case kImmSignedByte:
+      size = 1;
+      break;
+    case kImmSignedZ:
+      size = 4;
+      break;
+    case kImmUnsignedV:
+      size = eosz / 8;
+      break;
+  }
+
+  if ((*pos + size) > num_bytes) {
+    return false;
+  }
+
+  if (kImmUnsignedV == imm) {
+    inst->immediate = ReadUnsigned(&(bytes[*pos]), size);
+    inst->immediate_is_signed = false;
+  } else {
+    inst->immediate = static_cast<uint64_t>(ReadSigned(&(bytes[*pos]), size));
+    inst->immediate_is_signed = true;
+  }
+  inst->immediate_width = static_cast<uint32_t>(size * 8);
+  *pos += size;
+  return true;
+}
+
+static void AddOperand(FastInstruction *inst, FastOperand::Kind kind,
+                       Access access, xed_reg_enum_t reg=XED_REG_INVALID) {
+  auto &op = inst->operands[inst->num_operands++];
+  op.kind = kind;
+  op.is_read = 0 != (access & kAccessRead);
+  op.is_written = 0 != (access & kAccessWrite);
+  op.reg = reg;
+}
+
+// What follows an opcode, and what the opcode means, for `PreDecode`.
+enum OpcodeFlags : uint16_t {
+  kOpcodeHasModRM = 1 << 0,
+  kOpcodeModRMIsRegister = 1 << 1,  // ModRM.mod is ignored, e.g. `MOV CRn`.
+  kOpcodeImm8 = 1 << 2,
+  kOpcodeImm16 = 1 << 3,
+  kOpcodeImmZ = 1 << 4,  // 16 or 32 bits.
+  kOpcodeImmV = 1 << 5,  // 16, 32 or 64 bits.
+  kOpcodeImmAddr = 1 << 6,  // Absolute address, i.e. `moffs`.
+  kOpcodeImmFarPtr = 1 << 7,  // Far pointer, i.e. `ptr16:32`.
+  kOpcodeImmOnlyForTest = 1 << 8,  // `F6` and `F7`: only `TEST` has one.
+  kOpcodeRel8 = 1 << 9,
+  kOpcodeRelZ = 1 << 10,
+  kOpcodeInvalid64 = 1 << 11,
+  kOpcodeUseXED = 1 << 12  // Rare, or needs more than the tables.
+};
+
+struct OpcodeInfo {
+  uint16_t flags;
+  Instruction::Category category;
+};
+
+// Opcode tables of the one- and two-byte opcode maps, shared by 32- and
+// 64-bit modes. The `0F 38` and `0F 3A` maps are regular enough to be
+// handled without tables.
+class OpcodeTable {
+ public:
+  OpcodeTable(void);
+
+  OpcodeInfo one_byte[256];
+  OpcodeInfo two_byte[256];
+
+ private:
+  static void Set(OpcodeInfo *table, unsigned first, unsigned last,
+                  uint16_t flags,
+                  Instruction::Category category=
+                      Instruction::kCategoryNormal);
+};
+
+OpcodeTable::OpcodeTable(void)
+    : one_byte(),
+      two_byte() {
+
+  // Anything not described below is left to XED.
+  Set(one_byte, 0x00, 0xFF, kOpcodeUseXED);
+  Set(two_byte, 0x00, 0xFF, kOpcodeUseXED);
+
+  // One-byte opcode map. Prefixes, and the `VEX` and `EVEX` escapes, are
+  // handled before looking up the opcode.
+  for (auto op = 0x00U; op < 0x40U; op += 8) {
+    Set(one_byte, op, op + 3, kOpcodeHasModRM);
+    Set(one_byte, op + 4, op + 4, kOpcodeImm8);
+    Set(one_byte, op + 5, op + 5, kOpcodeImmZ);
+  }
+  Set(one_byte, 0x06, 0x07, kOpcodeInvalid64);  // `PUSH ES`, `POP ES`.
+  Set(one_byte, 0x0E, 0x0E, kOpcodeInvalid64);  // `PUSH CS`.
+  Set(one_byte, 0x16, 0x17, kOpcodeInvalid64);  // `PUSH SS`, `POP SS`.
+  Set(one_byte, 0x1E, 0x1F, kOpcodeInvalid64);  // `PUSH DS`, `POP DS`.
+  Set(one_byte, 0x27, 0x27, kOpcodeInvalid64);  // `DAA`.
+  Set(one_byte, 0x2F, 0x2F, kOpcodeInvalid64);  // `DAS`.
+  Set(one_byte, 0x37, 0x37, kOpcodeInvalid64);  // `AAA`.
+  Set(one_byte, 0x3F, 0x3F, kOpcodeInvalid64);  // `AAS`.
+  Set(one_byte, 0x40, 0x5F, 0);  // `INC`, `DEC`, `PUSH`, `POP`.
+  Set(one_byte, 0x60, 0x61, kOpcodeInvalid64);  // `PUSHA`, `POPA`.
+  Set(one_byte, 0x62, 0x62, kOpcodeHasModRM | kOpcodeInvalid64,
+      Instruction::kCategoryConditionalAsyncHyperCall);  // `BOUND`.
+  Set(one_byte, 0x63, 0x63, kOpcodeHasModRM);
+  Set(one_byte, 0x68, 0x68, kOpcodeImmZ);
+  Set(one_byte, 0x69, 0x69, kOpcodeHasModRM | kOpcodeImmZ);
+  Set(one_byte, 0x6A, 0x6A, kOpcodeImm8);
+  Set(one_byte, 0x6B, 0x6B, kOpcodeHasModRM | kOpcodeImm8);
+  Set(one_byte, 0x6C, 0x6F, 0);
+  Set(one_byte, 0x70, 0x7F, kOpcodeRel8,
+      Instruction::kCategoryConditionalBranch);
+  Set(one_byte, 0x80, 0x80, kOpcodeHasModRM | kOpcodeImm8);
+  Set(one_byte, 0x81, 0x81, kOpcodeHasModRM | kOpcodeImmZ);
+  Set(one_byte, 0x82, 0x82,
+      kOpcodeHasModRM | kOpcodeImm8 | kOpcodeInvalid64);
+  Set(one_byte, 0x83, 0x83, kOpcodeHasModRM | kOpcodeImm8);
+  Set(one_byte, 0x84, 0x8F, kOpcodeHasModRM);
+  Set(one_byte, 0x90, 0x90, 0, Instruction::kCategoryNoOp);
+  Set(one_byte, 0x91, 0x99, 0);
+  Set(one_byte, 0x9A, 0x9A, kOpcodeImmFarPtr | kOpcodeInvalid64,
+      Instruction::kCategoryIndirectFunctionCall);  // `CALL ptr16:32`.
+  Set(one_byte, 0x9B, 0x9F, 0);
+  Set(one_byte, 0xA0, 0xA3, kOpcodeImmAddr);
+  Set(one_byte, 0xA4, 0xA7, 0);
+  Set(one_byte, 0xA8, 0xA8, kOpcodeImm8);
+  Set(one_byte, 0xA9, 0xA9, kOpcodeImmZ);
+  Set(one_byte, 0xAA, 0xAF, 0);
+  Set(one_byte, 0xB0, 0xB7, kOpcodeImm8);
+  Set(one_byte, 0xB8, 0xBF, kOpcodeImmV);
+  Set(one_byte, 0xC0, 0xC1, kOpcodeHasModRM | kOpcodeImm8);
+  Set(one_byte, 0xC2, 0xC2, kOpcodeImm16,
+      Instruction::kCategoryFunctionReturn);
+  Set(one_byte, 0xC3, 0xC3, 0, Instruction::kCategoryFunctionReturn);
+  Set(one_byte, 0xC4, 0xC5, kOpcodeHasModRM | kOpcodeInvalid64);
+  Set(one_byte, 0xC6, 0xC6, kOpcodeHasModRM | kOpcodeImm8);
+  Set(one_byte, 0xC7, 0xC7, kOpcodeHasModRM | kOpcodeImmZ);
+  Set(one_byte, 0xC8, 0xC8, kOpcodeImm16 | kOpcodeImm8);  // `ENTER`.
+  Set(one_byte, 0xC9, 0xC9, 0);
+  Set(one_byte, 0xCA, 0xCA, kOpcodeImm16,
+      Instruction::kCategoryFunctionReturn);
+  Set(one_byte, 0xCB, 0xCB, 0, Instruction::kCategoryFunctionReturn);
+  Set(one_byte, 0xCC, 0xCC, 0, Instruction::kCategoryAsyncHyperCall);
+  Set(one_byte, 0xCD, 0xCD, kOpcodeImm8,
+      Instruction::kCategoryAsyncHyperCall);
+  Set(one_byte, 0xCE, 0xCE, kOpcodeInvalid64,
+      Instruction::kCategoryConditionalAsyncHyperCall);  // `INTO`.
+  Set(one_byte, 0xCF, 0xCF, 0, Instruction::kCategoryAsyncHyperCall);
+  Set(one_byte, 0xD0, 0xD3, kOpcodeHasModRM);
+  Set(one_byte, 0xD4, 0xD5, kOpcodeImm8 | kOpcodeInvalid64);
+  Set(one_byte, 0xD7, 0xD7, 0);
+  Set(one_byte, 0xD8, 0xDF, kOpcodeHasModRM);  // x87.
+  Set(one_byte, 0xE0, 0xE3, kOpcodeRel8,
+      Instruction::kCategoryConditionalBranch);  // `LOOPcc`, `JrCXZ`.
+  Set(one_byte, 0xE4, 0xE7, kOpcodeImm8);
+  Set(one_byte, 0xE8, 0xE8, kOpcodeRelZ,
+      Instruction::kCategoryDirectFunctionCall);
+  Set(one_byte, 0xE9, 0xE9, kOpcodeRelZ, Instruction::kCategoryDirectJump);
+  Set(one_byte, 0xEA, 0xEA, kOpcodeImmFarPtr | kOpcodeInvalid64,
+      Instruction::kCategoryIndirectJump);  // `JMP ptr16:32`.
+  Set(one_byte, 0xEB, 0xEB, kOpcodeRel8, Instruction::kCategoryDirectJump);
+  Set(one_byte, 0xEC, 0xEF, 0);
+  Set(one_byte, 0xF1, 0xF1, 0, Instruction::kCategoryAsyncHyperCall);
+  Set(one_byte, 0xF4, 0xF4, 0, Instruction::kCategoryError);  // `HLT`.
+  Set(one_byte, 0xF5, 0xF5, 0);
+  Set(one_byte, 0xF6, 0xF6,
+      kOpcodeHasModRM | kOpcodeImm8 | kOpcodeImmOnlyForTest);
+  Set(one_byte, 0xF7, 0xF7,
+      kOpcodeHasModRM | kOpcodeImmZ | kOpcodeImmOnlyForTest);
+  Set(one_byte, 0xF8, 0xFD, 0);
+  Set(one_byte, 0xFE, 0xFF, kOpcodeHasModRM);
+
+  // Two-byte opcode map, i.e. opcodes following `0F`.
+  Set(two_byte, 0x00, 0x03, kOpcodeHasModRM);
+  Set(two_byte, 0x05, 0x05, 0,
+      Instruction::kCategoryAsyncHyperCall);  // `SYSCALL`.
+  Set(two_byte, 0x06, 0x06, 0);
+  Set(two_byte, 0x07, 0x07, 0,
+      Instruction::kCategoryAsyncHyperCall);  // `SYSRET`.
+  Set(two_byte, 0x08, 0x09, 0);
+  Set(two_byte, 0x0B, 0x0B, 0, Instruction::kCategoryError);  // `UD2`.
+  Set(two_byte, 0x10, 0x17, kOpcodeHasModRM);
+  Set(two_byte, 0x1F, 0x1F, kOpcodeHasModRM, Instruction::kCategoryNoOp);
+  Set(two_byte, 0x20, 0x23, kOpcodeHasModRM | kOpcodeModRMIsRegister);
+  Set(two_byte, 0x28, 0x2F, kOpcodeHasModRM);
+  Set(two_byte, 0x30, 0x33, 0);
+  Set(two_byte, 0x34, 0x35, 0,
+      Instruction::kCategoryAsyncHyperCall);  // `SYSENTER`, `SYSEXIT`.
+  Set(two_byte, 0x40, 0x6F, kOpcodeHasModRM);
+  Set(two_byte, 0x70, 0x73, kOpcodeHasModRM | kOpcodeImm8);
+  Set(two_byte, 0x74, 0x76, kOpcodeHasModRM);
+  Set(two_byte, 0x77, 0x77, 0);
+  Set(two_byte, 0x78, 0x79, kOpcodeHasModRM);
+  Set(two_byte, 0x7C, 0x7F, kOpcodeHasModRM);
+  Set(two_byte, 0x80, 0x8F, kOpcodeRelZ,
+      Instruction::kCategoryConditionalBranch);
+  Set(two_byte, 0x90, 0x9F, kOpcodeHasModRM);
+  Set(two_byte, 0xA0, 0xA2, 0);
+  Set(two_byte, 0xA3, 0xA3, kOpcodeHasModRM);
+  Set(two_byte, 0xA4, 0xA4, kOpcodeHasModRM | kOpcodeImm8);
+  Set(two_byte, 0xA5, 0xA5, kOpcodeHasModRM);
+  Set(two_byte, 0xA8, 0xAA, 0);
+  Set(two_byte, 0xAB, 0xAB, kOpcodeHasModRM);
+  Set(two_byte, 0xAC, 0xAC, kOpcodeHasModRM | kOpcodeImm8);
+  Set(two_byte, 0xAD, 0xB8, kOpcodeHasModRM);
+  Set(two_byte, 0xBA, 0xBA, kOpcodeHasModRM | kOpcodeImm8);
+  Set(two_byte, 0xBB, 0xC1, kOpcodeHasModRM);
+  Set(two_byte, 0xC2, 0xC2, kOpcodeHasModRM | kOpcodeImm8);
+  Set(two_byte, 0xC3, 0xC3, kOpcodeHasModRM);
+  Set(two_byte, 0xC4, 0xC6, kOpcodeHasModRM | kOpcodeImm8);
+  Set(two_byte, 0xC7, 0xC7, kOpcodeHasModRM);
+  Set(two_byte, 0xC8, 0xCF, 0);  // `BSWAP`.
+  Set(two_byte, 0xD0, 0xFE, kOpcodeHasModRM);
+}
+
+void OpcodeTable::Set(OpcodeInfo *table, unsigned first, unsigned last,
+                      uint16_t flags, Instruction::Category category) {
+  for (auto op = first; op <= last; ++op) {
+    table[op].flags = flags;
+    table[op].category = category;
+  }
+}
+
+static const OpcodeTable &GetOpcodeTable(void) {
+  static const OpcodeTable kOpcodeTable;
+  return kOpcodeTable;
+}
+
+// Skip over a ModRM byte, and the SIB byte and displacement that follow it.
+static bool SkipModRM(const uint8_t *bytes, size_t num_bytes, size_t *pos,
+                      bool is_16bit_addr) {
+  if (*pos >= num_bytes) {
+    return false;
+  }
+
+  const auto modrm = bytes[(*pos)++];
+  const unsigned mod = modrm >> 6;
+  const unsigned rm = modrm & 7u;
+  size_t disp_size = 0;
+
+  if (3 == mod) {
+    return true;
+
+  } else if (is_16bit_addr) {
+    if (1 == mod) {
+      disp_size = 1;
+    } else if (2 == mod || 6 == rm) {
+      disp_size = 2;
+    }
+
+  } else {
+    if (4 == rm) {
+      if (*pos >= num_bytes) {
+        return false;
+      }
+      const auto sib = bytes[(*pos)++];
+      if (0 == mod && 5 == (sib & 7u)) {
+        disp_size = 4;
+      }
+    }
+    if (1 == mod) {
+      disp_size = 1;
+    } else if (2 == mod || (0 == mod && 5 == rm)) {
+      disp_size = 4;
+    }
+  }
+
+  *pos += disp_size;
+  return *pos <= num_bytes;
+}
+
+// Find the length of a `VEX`- or `EVEX`-encoded instruction, starting with
+// the byte after the `C4`, `C5` or `62` escape byte.
+static bool PreDecodeVEX(const uint8_t *bytes, size_t num_bytes, size_t pos,
+                         uint8_t escape, bool is_16bit_addr,
+                         PreDecodedInstruction *inst) {
+  size_t payload_size = 1;
+  unsigned map = 1;
+  if (0xC4 == escape) {
+    payload_size = 2;
+    map = bytes[pos] & 0x1Fu;
+  } else if (0x62 == escape) {
+    payload_size = 3;
+    map = bytes[pos] & 0x7u;
+    inst->is_evex = true;
+  }
+  inst->is_vex = true;
+
+  pos += payload_size;
+  if (pos >= num_bytes || 1 > map || 3 < map) {
+    return false;
+  }
+
+  const auto opcode = bytes[pos++];
+
+  // `VZEROUPPER` and `VZEROALL` have no ModRM byte.
+  if (1 == map && 0x77 == opcode && !inst->is_evex) {
+    inst->num_bytes = static_cast<uint32_t>(pos);
+    return true;
+  }
+
+  if (!SkipModRM(bytes, num_bytes, &pos, is_16bit_addr)) {
+    return false;
+  }
+
+  if (3 == map ||
+      (1 == map && ((0x70 <= opcode && 0x73 >= opcode) ||
+                    0xC2 == opcode ||
+                    (0xC4 <= opcode && 0xC6 >= opcode)))) {
+    pos += 1;
+  }
+
+  if (pos > num_bytes) {
+    return false;
+  }
+  inst->num_bytes = static_cast<uint32_t>(pos);
+  return true;
+}
+
+}  // namespace
+
+bool FastDecode(const uint8_t *bytes, size_t num_bytes, bool is_64bit,
+                FastInstruction *inst) {
+  const auto &table = GetFormTable(is_64bit);
+  size_t pos = 0;
+  uint8_t rex = 0;
+
+  if (!num_bytes) {
+    return false;
+  }
+
+  if (is_64bit && 0x40 == (bytes[0] & 0xF0)) {
+    rex = bytes[0];
+    pos = 1;
+  }
+
+  if (pos >= num_bytes) {
+    return false;
+  }
+
+  const Form *form = nullptr;
+  const auto opcode = bytes[pos++];
+  if (0x0F == opcode) {
+    if (pos >= num_bytes || 0x80 != (bytes[pos] & 0xF0)) {
+      return false;
+    }
+    form = &(table.jcc_rel32[bytes[pos++] & 0xF]);
+  } else {
+    form = &(table.one_byte[opcode]);
+  }
+
+  // Peek at ModRM.reg to find the form of a group opcode.
+  if (kFormGroup == form->kind) {
+    if (pos >= num_bytes) {
+      return false;
+    }
+    form = &(table.groups[form->group][(bytes[pos] >> 3) & 7u]);
+  }
+
+  if (kFormInvalid == form->kind || (rex && !form->allows_rex)) {
+    return false;
+  }
+
+  const bool has_rex = 0 != rex;
+  const bool rex_w = 0 != (rex & 8u);
+  const unsigned rex_r = (rex >> 2) & 1u;
+  const unsigned rex_b = rex & 1u;
+
+  uint32_t eosz = 32;
+  if (is_64bit && (rex_w || form->is_default_64)) {
+    eosz = 64;
+  }
+
+  inst->iform = form->reg_iform;
+  inst->category = form->category;
+  inst->is_scalable = form->is_scalable;
+  inst->operand_width = form->is_byte_op ? 8 : eosz;
+  inst->base_reg = XED_REG_INVALID;
+  inst->index_reg = XED_REG_INVALID;
+  inst->scale = 0;
+  inst->displacement = 0;
+  inst->address_width = 0;
+  inst->immediate = 0;
+  inst->immediate_is_signed = false;
+  inst->immediate_width = 0;
+  inst->branch_displacement = 0;
+  inst->num_operands = 0;
+
+  const auto reg_width = inst->operand_width;
+
+  switch (form->kind) {
+    case kFormRmReg:
+    case kFormRegRm:
+    case kFormRegAddr:
+    case kFormRmImm: {
+      if (pos >= num_bytes) {
+        return false;
+      }
+      const auto modrm = bytes[pos++];
+      const auto reg = GPR(((modrm >> 3) & 7u) | (rex_r << 3), reg_width,
+                           has_rex);
+      const auto is_mem = 3 != (modrm >> 6);
+      auto rm_kind = FastOperand::kKindRegister;
+      auto rm_reg = XED_REG_INVALID;
+
+      if (is_mem) {
+        if (!DecodeModRMMemory(bytes, num_bytes, &pos, modrm, rex, is_64bit,
+                               inst)) {
+          return false;
+        }
+        inst->iform = form->mem_iform;
+        rm_kind = FastOperand::kKindMemory;
+        if (kFormRegAddr == form->kind) {
+          rm_kind = FastOperand::kKindAddress;
+        }
+
+      // `LEA` requires a memory operand.
+      } else if (kFormRegAddr == form->kind) {
+        return false;
+
+      } else {
+        rm_reg = GPR((modrm & 7u) | (rex_b << 3), reg_width, has_rex);
+      }
+
+      if (kFormRmReg == form->kind) {
+        AddOperand(inst, rm_kind, form->first_access, rm_reg);
+        AddOperand(inst, FastOperand::kKindRegister, kAccessRead, reg);
+
+      } else if (kFormRmImm == form->kind) {
+        AddOperand(inst, rm_kind, form->first_access, rm_reg);
+        AddOperand(inst, FastOperand::kKindImmediate, kAccessRead);
+
+      } else {
+        AddOperand(inst, FastOperand::kKindRegister, form->first_access, reg);
+        AddOperand(inst, rm_kind, kAccessRead, rm_reg);
+      }
+      break;
+    }
+
+    case kFormAccImm:
+      AddOperand(inst, FastOperand::kKindRegister, form->first_access,
+                 GPR(0, reg_width, has_rex));
+      AddOperand(inst, FastOperand::kKindImmediate, kAccessRead);
+      break;
+
+    case kFormOpcodeReg:
+    case kFormOpcodeRegImm:
+      AddOperand(inst, FastOperand::kKindRegister, form->first_access,
+                 GPR((opcode & 7u) | (rex_b << 3), reg_width, has_rex));
+      if (kFormOpcodeRegImm == form->kind) {
+        AddOperand(inst, FastOperand::kKindImmediate, kAccessRead);
+      }
+      break;
+
+    case kFormImm:
+      AddOperand(inst, FastOperand::kKindImmediate, kAccessRead);
+      break;
+
+    case kFormRelBr:
+      if ((pos + form->rel_size) > num_bytes) {
+        return false;
+      }
+      inst->branch_displacement = ReadSigned(&(bytes[pos]), form->rel_size);
+      pos += form->rel_size;
+      AddOperand(inst, FastOperand::kKindRelativeBranch, kAccessRead);
+      break;
+
+    case kFormNoOperands:
+      break;
+
+    case kFormInvalid:
+    case kFormGroup:
+      return false;
+  }
+
+  if (!DecodeImmediate(bytes, num_bytes, &pos, form->imm, eosz, inst)) {
+    return false;
+  }
+
+  inst->num_bytes = static_cast<uint32_t>(pos);
+  return true;
+}
+
+bool PreDecode(const uint8_t *bytes, size_t num_bytes, bool is_64bit,
+               PreDecodedInstruction *inst) {
+  num_bytes = std::min<size_t>(num_bytes, 15);
+
+  inst->category = Instruction::kCategoryNormal;
+  inst->num_bytes = 0;
+  inst->branch_displacement = 0;
+  inst->is_vex = false;
+  inst->is_evex = false;
+
+  size_t pos = 0;
+  bool has_prefix = false;
+  bool has_osz = false;  // `66` operand size override.
+  bool has_asz = false;  // `67` address size override.
+  bool has_rep = false;  // `F2` or `F3`.
+  uint8_t rex = 0;
+
+  // Legacy prefixes can come in any order. A REX prefix only counts if it
+  // comes right before the opcode.
+  for (; pos < num_bytes; ++pos) {
+    const auto byte = bytes[pos];
+    if (0x66 == byte) {
+      has_osz = true;
+    } else if (0x67 == byte) {
+      has_asz = true;
+    } else if (0xF2 == byte || 0xF3 == byte) {
+      has_rep = true;
+    } else if (0x26 == byte || 0x2E == byte || 0x36 == byte ||
+               0x3E == byte || 0x64 == byte || 0x65 == byte) {
+      // Segment overrides and branch hints don't change the length.
+    } else if (is_64bit && 0x40 == (byte & 0xF0)) {
+      rex = byte;
+      has_prefix = true;
+      continue;
+
+    // Whether or not a `LOCK` prefix is allowed depends on the instruction
+    // and on its operands.
+    } else if (0xF0 == byte) {
+      return false;
+    } else {
+      break;
+    }
+    rex = 0;
+    has_prefix = true;
+  }
+
+  if (pos >= num_bytes) {
+    return false;
+  }
+
+  const bool rex_w = 0 != (rex & 8u);
+  const bool is_16bit_addr = !is_64bit && has_asz;
+  const auto &table = GetOpcodeTable();
+  const auto opcode = bytes[pos++];
+  const OpcodeInfo *info = &(table.one_byte[opcode]);
+  auto category = info->category;
+
+  // `VEX` and `EVEX` escapes. In 32-bit mode, these are `LES`, `LDS` and
+  // `BOUND` unless the next byte looks like a register ModRM.
+  if (0xC4 == opcode || 0xC5 == opcode || 0x62 == opcode) {
+    if (pos >= num_bytes) {
+      return false;
+    }
+    if (is_64bit || 0xC0 == (bytes[pos] & 0xC0)) {
+      if (has_osz || has_rep || rex) {
+        return false;
+      }
+      return PreDecodeVEX(bytes, num_bytes, pos, opcode, is_16bit_addr, inst);
+    }
+
+  } else if (0x0F == opcode) {
+    if (pos >= num_bytes) {
+      return false;
+    }
+    const auto opcode2 = bytes[pos++];
+
+    // Three-byte opcode maps. All of these have a ModRM byte, and those in
+    // the `0F 3A` map also have an 8-bit immediate.
+    if (0x38 == opcode2 || 0x3A == opcode2) {
+      pos += 1;
+      if (!SkipModRM(bytes, num_bytes, &pos, is_16bit_addr)) {
+        return false;
+      }
+      if (0x3A == opcode2) {
+        pos += 1;
+      }
+      if (pos > num_bytes) {
+        return false;
+      }
+      inst->num_bytes = static_cast<uint32_t>(pos);
+      return true;
+    }
+
+    // `VMREAD` and `VMWRITE` become `EXTRQ` and `INSERTQ` with a prefix, and
+    // `0F B8` is only `POPCNT` with an `F3` prefix.
+    if (((0x78 == opcode2 || 0x79 == opcode2) && (has_osz || has_rep)) ||
+        (0xB8 == opcode2 && !has_rep)) {
+      return false;
+    }
+
+    info = &(table.two_byte[opcode2]);
+    category = info->category;
+
+  // With a prefix, this could be `PAUSE`, or `XCHG R8, RAX`.
+  } else if (0x90 == opcode && has_prefix) {
+    return false;
+  }
+
+  const auto flags = info->flags;
+  if ((kOpcodeUseXED & flags) || (is_64bit && (kOpcodeInvalid64 & flags))) {
+    return false;
+  }
+
+  // The operand size override changes the size of relative branch
+  // displacements, and truncates the target.
+  if (((kOpcodeRel8 | kOpcodeRelZ) & flags) && has_osz) {
+    return false;
+  }
+
+  auto has_imm = true;
+  if (kOpcodeHasModRM & flags) {
+    if (pos >= num_bytes) {
+      return false;
+    }
+    const auto modrm = bytes[pos];
+    const unsigned reg = (modrm >> 3) & 7u;
+
+    if (kOpcodeModRMIsRegister & flags) {
+      pos += 1;
+    } else if (!SkipModRM(bytes, num_bytes, &pos, is_16bit_addr)) {
+      return false;
+    }
+
+    if (kOpcodeImmOnlyForTest & flags) {
+      has_imm = 2 > reg;
+    }
+
+    if (0x8F == opcode && 0 != reg) {
+      return false;  // XOP.
+
+    } else if (0xC7 == opcode && 0xF8 == modrm) {
+      return false;  // `XBEGIN`.
+
+    } else if (0xC6 == opcode && 0xF8 == modrm) {
+      category = Instruction::kCategoryIndirectJump;  // `XABORT`.
+
+    } else if (0xFF == opcode) {
+      switch (reg) {
+        case 2:
+        case 3:
+          category = Instruction::kCategoryIndirectFunctionCall;
+          break;
+        case 4:
+        case 5:
+          category = Instruction::kCategoryIndirectJump;
+          break;
+        case 7:
+          return false;
+        default:
+          break;
+      }
+    }
+  }
+
+  size_t imm_size = 0;
+  if (has_imm) {
+    if (kOpcodeImm8 & flags) {
+      imm_size += 1;
+    }
+    if (kOpcodeImm16 & flags) {
+      imm_size += 2;
+    }
+    if (kOpcodeImmZ & flags) {
+      imm_size += (has_osz && !rex_w) ? 2 : 4;
+    }
+    if (kOpcodeImmV & flags) {
+      imm_size += rex_w ? 8 : (has_osz ? 2 : 4);
+    }
+  }
+  if (kOpcodeImmAddr & flags) {
+    if (is_64bit) {
+      imm_size += has_asz ? 4 : 8;
+    } else {
+      imm_size += has_asz ? 2 : 4;
+    }
+  }
+  if (kOpcodeImmFarPtr & flags) {
+    imm_size += (has_osz ? 2 : 4) + 2;
+  }
+
+  size_t rel_size = 0;
+  if (kOpcodeRel8 & flags) {
+    rel_size = 1;
+  } else if (kOpcodeRelZ & flags) {
+    rel_size = 4;
+  }
+
+  if ((pos + imm_size + rel_size) > num_bytes) {
+    return false;
+  }
+
+  pos += imm_size;
+  if (rel_size) {
+    inst->branch_displacement = ReadSigned(&(bytes[pos]), rel_size);
+    pos += rel_size;
+  }
+
+  inst->category = category;
+  inst->num_bytes = static_cast<uint32_t>(pos);
+  return true;
+}
+
+}  // namespace x86
+}  // namespace remill
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_ARCH_X86_DECODE_H_
+#define REMILL_ARCH_X86_DECODE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "remill/Arch/Instruction.h"
+#include "remill/Arch/X86/XED.h"
+
+namespace remill {
+namespace x86 {
+
+// One visible operand of an instruction decoded by `FastDecode`. Operands
+// are in the same order as XED's visible operands of the same iform.
+struct FastOperand {
+  enum Kind : uint8_t {
+    kKindInvalid,
+    kKindRegister,
+    kKindMemory,
+    kKindAddress,  // Address calculation, i.e. the `AGEN` operand of `LEA`.
+    kKindImmediate,
+    kKindRelativeBranch
+  };
+
+  Kind kind;
+  bool is_read;
+  bool is_written;
+  xed_reg_enum_t reg;  // Only valid for `kKindRegister`.
+};
+
+// The parts of a decoded instruction that are needed to build an
+// `Instruction`. An instruction has at most one memory, immediate, or
+// relative branch operand.
+struct FastInstruction {
+  xed_iform_enum_t iform;
+  Instruction::Category category;
+  bool is_scalable;
+  uint32_t num_bytes;
+  uint32_t operand_width;  // In bits.
+
+  // Memory operand.
+  xed_reg_enum_t base_reg;
+  xed_reg_enum_t index_reg;
+  uint32_t scale;
+  int64_t displacement;
+  uint32_t address_width;  // In bits.
+
+  // Immediate operand. `immediate` is already sign- or zero-extended.
+  uint64_t immediate;
+  bool immediate_is_signed;
+  uint32_t immediate_width;  // In bits.
+
+  // Relative branch operand.
+  int64_t branch_displacement;
+
+  uint32_t num_operands;
+  FastOperand operands[2];
+};
+
+// Decode one of the most common encodings of `MOV`, `LEA`, the ALU
+// instructions (`ADD`, `SUB`, `CMP`, `TEST`, etc.), `PUSH`, `POP`, `Jcc`,
+// `JMP`, `CALL` and `RET`, without going through XED. Encodings with legacy
+// prefixes are not handled. Returns `false` if `bytes` doesn't start with an
+// encoding that is handled here, in which case the instruction should be
+// decoded by XED.
+bool FastDecode(const uint8_t *bytes, size_t num_bytes, bool is_64bit,
+                FastInstruction *inst);
+
+// The length and category of an instruction, found by `PreDecode`.
+struct PreDecodedInstruction {
+  Instruction::Category category;
+  uint32_t num_bytes;
+
+  // Only valid for direct jumps, direct calls and conditional branches.
+  int64_t branch_displacement;
+
+  bool is_vex;  // VEX- or EVEX-encoded.
+  bool is_evex;
+};
+
+// Find the length and control-flow category of the instruction at the
+// beginning of `bytes` by looking only at its prefixes, opcode, ModRM and SIB
+// bytes. Returns `false` for encodings that are rare or that need more than
+// the opcode tables to tell apart (e.g. `LOCK`-prefixed instructions, XOP and
+// 3DNow! instructions), in which case the instruction should be decoded by
+// XED.
+bool PreDecode(const uint8_t *bytes, size_t num_bytes, bool is_64bit,
+               PreDecodedInstruction *inst);
+
+}  // namespace x86
+}  // namespace remill
+
+#endif  // REMILL_ARCH_X86_DECODE_H_
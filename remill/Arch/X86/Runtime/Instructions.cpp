@@ -16,6 +16,7 @@
 
 #include "remill/Arch/Runtime/Intrinsics.h"
 #include "remill/Arch/Runtime/Operators.h"
+#include "remill/Arch/Runtime/Crypto.h"
 
 #include "remill/Arch/X86/Runtime/State.h"
 #include "remill/Arch/X86/Runtime/Types.h"
@@ -96,6 +97,8 @@
 # define REG_XBX REG_EBX
 #endif  // 64 == ADDRESS_SIZE_BITS
 
+#define REG_XMM0 state.vec[0].xmm
+
 #define FLAG_CF state.aflag.cf
 #define FLAG_PF state.aflag.pf
 #define FLAG_AF state.aflag.af
@@ -131,7 +134,8 @@
 #define INTERRUPT_VECTOR state.hyper_call_vector
 
 namespace {
-// Takes the place of an unsupported instruction.
+// Takes the place of an unsupported instruction. On x86-64 hosts, the hyper
+// call can be handled with `remill::ExecuteInstructionNatively`.
 DEF_SEM(HandleUnsupported) {
   return __remill_sync_hyper_call(
       state, memory, IF_64BIT_ELSE(SyncHyperCall::kAMD64EmulateInstruction,
@@ -151,6 +155,7 @@ DEF_ISEL(UNSUPPORTED_INSTRUCTION) = HandleUnsupported;
 DEF_ISEL(INVALID_INSTRUCTION) = HandleInvalidInstruction;
 
 #include "remill/Arch/X86/Semantics/FLAGS.cpp"
+#include "remill/Arch/X86/Semantics/AES.cpp"
 #include "remill/Arch/X86/Semantics/BINARY.cpp"
 #include "remill/Arch/X86/Semantics/BITBYTE.cpp"
 #include "remill/Arch/X86/Semantics/CALL_RET.cpp"
@@ -165,12 +170,14 @@ DEF_ISEL(INVALID_INSTRUCTION) = HandleInvalidInstruction;
 #include "remill/Arch/X86/Semantics/MISC.cpp"
 #include "remill/Arch/X86/Semantics/MMX.cpp"
 #include "remill/Arch/X86/Semantics/NOP.cpp"
+#include "remill/Arch/X86/Semantics/PCLMULQDQ.cpp"
 #include "remill/Arch/X86/Semantics/POP.cpp"
 #include "remill/Arch/X86/Semantics/PREFETCH.cpp"
 #include "remill/Arch/X86/Semantics/PUSH.cpp"
 #include "remill/Arch/X86/Semantics/ROTATE.cpp"
 #include "remill/Arch/X86/Semantics/RTM.cpp"
 #include "remill/Arch/X86/Semantics/SEMAPHORE.cpp"
+#include "remill/Arch/X86/Semantics/SHA.cpp"
 #include "remill/Arch/X86/Semantics/SHIFT.cpp"
 #include "remill/Arch/X86/Semantics/SSE.cpp"
 #include "remill/Arch/X86/Semantics/STRINGOP.cpp"
@@ -323,6 +323,23 @@ union alignas(8) Flags final {
 
 static_assert(8 == sizeof(Flags), "Invalid structure packing of `Flags`.");
 
+#if DENSE_STATE
+
+struct alignas(8) ArithFlags final {
+  uint8_t cf;
+  uint8_t pf;
+  uint8_t af;
+  uint8_t zf;
+  uint8_t sf;
+  uint8_t df;
+  uint8_t of;
+  uint8_t _0;
+} __attribute__((packed));
+
+static_assert(8 == sizeof(ArithFlags), "Invalid packing of `ArithFlags`.");
+
+#else
+
 struct alignas(8) ArithFlags final {
   // Prevents LLVM from casting and `ArithFlags` into an `i8` to access `cf`.
   volatile bool _0;
@@ -345,6 +362,8 @@ struct alignas(8) ArithFlags final {
 
 static_assert(16 == sizeof(ArithFlags), "Invalid packing of `ArithFlags`.");
 
+#endif  // DENSE_STATE
+
 union XCR0 {
   uint64_t flat;
 
@@ -401,6 +420,21 @@ union SegmentSelector final {
 static_assert(sizeof(SegmentSelector) == 2,
               "Invalid packing of `union SegmentSelector`.");
 
+#if DENSE_STATE
+
+struct alignas(4) Segments final {
+  SegmentSelector ss;
+  SegmentSelector es;
+  SegmentSelector gs;
+  SegmentSelector fs;
+  SegmentSelector ds;
+  SegmentSelector cs;
+} __attribute__((packed));
+
+static_assert(12 == sizeof(Segments), "Invalid packing of `struct Segments`.");
+
+#else
+
 struct alignas(8) Segments final {
   volatile uint16_t _0;
   SegmentSelector ss;
@@ -418,6 +452,8 @@ struct alignas(8) Segments final {
 
 static_assert(24 == sizeof(Segments), "Invalid packing of `struct Segments`.");
 
+#endif  // DENSE_STATE
+
 // For remill-opt's register alias analysis, we don't want 32-bit lifted
 // code to look like operations on 64-bit registers, because then every
 // (bitcasted from 64 bit) store of a 32-bit value will look like a false-
@@ -466,6 +502,18 @@ static_assert(0 == __builtin_offsetof(VectorReg, zmm),
 static_assert(64 == sizeof(VectorReg),
               "Invalid packing of `struct VectorReg`.");
 
+#if DENSE_STATE
+
+struct alignas(8) AddressSpace final {
+  Reg fs_base;
+  Reg gs_base;
+} __attribute__((packed));
+
+static_assert(16 == sizeof(AddressSpace),
+              "Invalid packing of `struct AddressSpace`.");
+
+#else
+
 struct alignas(8) AddressSpace final {
   volatile uint64_t _0;
   Reg fs_base;
@@ -476,11 +524,41 @@ struct alignas(8) AddressSpace final {
 static_assert(32 == sizeof(AddressSpace),
               "Invalid packing of `struct AddressSpace`.");
 
+#endif  // DENSE_STATE
+
 // Named the same way as the 64-bit version to keep names the same
 // across architectures. All registers are here, even the 64-bit ones. The
 // 64-bit ones are inaccessible in lifted 32-bit code because they will
 // not be referenced by named variables in the `__remill_basic_block`
 // function.
+#if DENSE_STATE
+
+struct alignas(8) GPR final {
+  Reg rax;
+  Reg rbx;
+  Reg rcx;
+  Reg rdx;
+  Reg rsi;
+  Reg rdi;
+  Reg rsp;
+  Reg rbp;
+  Reg r8;
+  Reg r9;
+  Reg r10;
+  Reg r11;
+  Reg r12;
+  Reg r13;
+  Reg r14;
+  Reg r15;
+
+  // Program counter of the CURRENT instruction!
+  Reg rip;
+} __attribute__((packed));
+
+static_assert(136 == sizeof(GPR), "Invalid structure packing of `GPR`.");
+
+#else
+
 struct alignas(8) GPR final {
   // Prevents LLVM from casting a `GPR` into an `i64` to access `rax`.
   volatile uint64_t _0;
@@ -523,6 +601,8 @@ struct alignas(8) GPR final {
 
 static_assert(272 == sizeof(GPR), "Invalid structure packing of `GPR`.");
 
+#endif  // DENSE_STATE
+
 struct alignas(8) X87Stack final {
   struct alignas(8) {
     uint64_t _0;
@@ -542,10 +622,52 @@ struct alignas(8) MMX final {
 
 static_assert(128 == sizeof(MMX), "Invalid structure packing of `MMX`.");
 
+// AVX512 opmask registers, `K0` through `K7`.
+struct alignas(8) K_REG final {
+  struct alignas(8) {
+    uint64_t _0;
+    uint64_t val;
+  } __attribute__((packed)) elems[8];
+};
+
+static_assert(128 == sizeof(K_REG), "Invalid structure packing of `K_REG`.");
+
 enum : size_t {
   kNumVecRegisters = 32
 };
 
+#if DENSE_STATE
+
+// Everything that a typical lifted block reads or writes is packed into the
+// first four cache lines, and the vector registers start on a cache line
+// boundary.
+struct alignas(16) State final : public ArchState {
+  // ArchState occupies 16 bytes.
+
+  GPR gpr;  // 136 bytes.
+  ArithFlags aflag;  // 8 bytes.
+  Flags rflag;  // 8 bytes.
+  AddressSpace addr;  // 16 bytes.
+  Segments seg;  // 12 bytes.
+  FPUControlWord fpu_control;  // 2 bytes.
+  uint8_t _0[2];
+  FPUStatusFlags sw;  // 8 bytes.
+  XCR0 xcr0;  // 8 bytes.
+  uint8_t _1[40];  // Pad to a 64-byte boundary.
+
+  VectorReg vec[kNumVecRegisters];  // 2048 bytes.
+  X87Stack st;  // 128 bytes.
+  MMX mmx;  // 128 bytes.
+  K_REG k_reg;  // 128 bytes.
+} __attribute__((packed));
+
+static_assert(2688 == sizeof(State), "Invalid packing of `struct State`");
+
+static_assert(0 == (__builtin_offsetof(State, vec) % 64),
+              "Invalid packing of `struct State`");
+
+#else
+
 struct alignas(16) State final : public ArchState {
   // ArchState occupies 16 bytes.
 
@@ -566,11 +688,14 @@ struct alignas(16) State final : public ArchState {
   XCR0 xcr0;  // 8 bytes.
   FPUControlWord fpu_control;  // 2 bytes;
   uint8_t _padding[14];  // Pad to a 16-byte boundary.
+  K_REG k_reg;  // 128 bytes.
 } __attribute__((packed));
 
-static_assert((2688 + 16) == sizeof(State),
+static_assert((2816 + 16) == sizeof(State),
               "Invalid packing of `struct State`");
 
+#endif  // DENSE_STATE
+
 using X86State = State;
 
 #pragma clang diagnostic pop
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace {
+
+template <typename S2>
+DEF_SEM(AESENC, V128W dst, V128 src1, S2 src2) {
+  UWriteV8(dst, AESEncryptRound(UReadV8(src1), UReadV8(src2)));
+  return memory;
+}
+
+template <typename S2>
+DEF_SEM(AESENCLAST, V128W dst, V128 src1, S2 src2) {
+  UWriteV8(dst, AESEncryptLastRound(UReadV8(src1), UReadV8(src2)));
+  return memory;
+}
+
+template <typename S2>
+DEF_SEM(AESDEC, V128W dst, V128 src1, S2 src2) {
+  UWriteV8(dst, AESDecryptRound(UReadV8(src1), UReadV8(src2)));
+  return memory;
+}
+
+template <typename S2>
+DEF_SEM(AESDECLAST, V128W dst, V128 src1, S2 src2) {
+  UWriteV8(dst, AESDecryptLastRound(UReadV8(src1), UReadV8(src2)));
+  return memory;
+}
+
+template <typename S1>
+DEF_SEM(AESIMC, V128W dst, S1 src1) {
+  UWriteV8(dst, AESInvMixColumns(UReadV8(src1)));
+  return memory;
+}
+
+template <typename S1>
+DEF_SEM(AESKEYGENASSIST, V128W dst, S1 src1, I8 src2) {
+  auto src_vec = UReadV32(src1);
+  auto rcon = ZExtTo<uint32_t>(Read(src2));
+  auto x1 = AESSubWord(UExtractV32(src_vec, 1));
+  auto x3 = AESSubWord(UExtractV32(src_vec, 3));
+  auto dst_vec = UClearV32(src_vec);
+  dst_vec = UInsertV32(dst_vec, 0, x1);
+  dst_vec = UInsertV32(dst_vec, 1, UXor(Ror(x1, 8_u32), rcon));
+  dst_vec = UInsertV32(dst_vec, 2, x3);
+  dst_vec = UInsertV32(dst_vec, 3, UXor(Ror(x3, 8_u32), rcon));
+  UWriteV32(dst, dst_vec);
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(AESENC_XMMdq_XMMdq) = AESENC<V128>;
+DEF_ISEL(AESENC_XMMdq_MEMdq) = AESENC<MV128>;
+DEF_ISEL(AESENCLAST_XMMdq_XMMdq) = AESENCLAST<V128>;
+DEF_ISEL(AESENCLAST_XMMdq_MEMdq) = AESENCLAST<MV128>;
+DEF_ISEL(AESDEC_XMMdq_XMMdq) = AESDEC<V128>;
+DEF_ISEL(AESDEC_XMMdq_MEMdq) = AESDEC<MV128>;
+DEF_ISEL(AESDECLAST_XMMdq_XMMdq) = AESDECLAST<V128>;
+DEF_ISEL(AESDECLAST_XMMdq_MEMdq) = AESDECLAST<MV128>;
+DEF_ISEL(AESIMC_XMMdq_XMMdq) = AESIMC<V128>;
+DEF_ISEL(AESIMC_XMMdq_MEMdq) = AESIMC<MV128>;
+DEF_ISEL(AESKEYGENASSIST_XMMdq_XMMdq_IMMb) = AESKEYGENASSIST<V128>;
+DEF_ISEL(AESKEYGENASSIST_XMMdq_MEMdq_IMMb) = AESKEYGENASSIST<MV128>;
@@ -97,6 +97,26 @@ DEF_ISEL_RnW_Rn_Rn(ADD_GPRv_GPRv_03, ADD);
 DEF_ISEL(ADD_AL_IMMb) = ADD<R8W, R8, I8>;
 DEF_ISEL_RnW_Rn_In(ADD_OrAX_IMMz, ADD);
 
+namespace {
+
+template <typename D, typename S1, typename S2>
+DEF_SEM(LOCK_ADD, D dst, S1, S2 src2) {
+  auto rhs = Read(src2);
+  auto lhs = FetchAndAdd(dst, rhs);
+  auto sum = UAdd(lhs, rhs);
+  WriteFlagsAddSub<tag_add>(state, lhs, rhs, sum);
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(ADD_LOCK_MEMb_IMMb_80r0) = LOCK_ADD<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(ADD_LOCK_MEMv_IMMz, LOCK_ADD);
+DEF_ISEL(ADD_LOCK_MEMb_IMMb_82r0) = LOCK_ADD<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(ADD_LOCK_MEMv_IMMb, LOCK_ADD);
+DEF_ISEL(ADD_LOCK_MEMb_GPR8) = LOCK_ADD<M8W, M8, R8>;
+DEF_ISEL_MnW_Mn_Rn(ADD_LOCK_MEMv_GPRv, LOCK_ADD);
+
 DEF_ISEL(ADDPS_XMMps_MEMps) = ADDPS<V128W, V128, MV128>;
 DEF_ISEL(ADDPS_XMMps_XMMps) = ADDPS<V128W, V128, V128>;
 IF_AVX(DEF_ISEL(VADDPS_XMMdq_XMMdq_MEMdq) = ADDPS<VV128W, VV128, MV128>;)
@@ -186,6 +206,26 @@ DEF_ISEL_RnW_Rn_Mn(SUB_GPRv_MEMv, SUB);
 DEF_ISEL(SUB_AL_IMMb) = SUB<R8W, R8, I8>;
 DEF_ISEL_RnW_Rn_In(SUB_OrAX_IMMz, SUB);
 
+namespace {
+
+template <typename D, typename S1, typename S2>
+DEF_SEM(LOCK_SUB, D dst, S1, S2 src2) {
+  auto rhs = Read(src2);
+  auto lhs = FetchAndSub(dst, rhs);
+  auto sum = USub(lhs, rhs);
+  WriteFlagsAddSub<tag_sub>(state, lhs, rhs, sum);
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(SUB_LOCK_MEMb_IMMb_80r5) = LOCK_SUB<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(SUB_LOCK_MEMv_IMMz, LOCK_SUB);
+DEF_ISEL(SUB_LOCK_MEMb_IMMb_82r5) = LOCK_SUB<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(SUB_LOCK_MEMv_IMMb, LOCK_SUB);
+DEF_ISEL(SUB_LOCK_MEMb_GPR8) = LOCK_SUB<M8W, M8, R8>;
+DEF_ISEL_MnW_Mn_Rn(SUB_LOCK_MEMv_GPRv, LOCK_SUB);
+
 DEF_ISEL(SUBPS_XMMps_MEMps) = SUBPS<V128W, V128, MV128>;
 DEF_ISEL(SUBPS_XMMps_XMMps) = SUBPS<V128W, V128, V128>;
 IF_AVX(DEF_ISEL(VSUBPS_XMMdq_XMMdq_MEMdq) = SUBPS<VV128W, VV128, MV128>;)
@@ -634,6 +674,51 @@ DEF_ISEL_RnW_Rn(NEG_GPRv, NEG);
 
 namespace {
 
+template <typename D, typename S1>
+DEF_SEM(LOCK_INC, D dst, S1) {
+  auto_t(S1) rhs = 1;
+  auto lhs = FetchAndAdd(dst, rhs);
+  auto sum = UAdd(lhs, rhs);
+  WriteFlagsIncDec<tag_add>(state, lhs, rhs, sum);
+  return memory;
+}
+
+template <typename D, typename S1>
+DEF_SEM(LOCK_DEC, D dst, S1) {
+  auto_t(S1) rhs = 1;
+  auto lhs = FetchAndSub(dst, rhs);
+  auto sum = USub(lhs, rhs);
+  WriteFlagsIncDec<tag_sub>(state, lhs, rhs, sum);
+  return memory;
+}
+
+// There is no atomic negate, so retry until the value in memory doesn't
+// change between the read and the compare-and-swap.
+template <typename D, typename S1>
+DEF_SEM(LOCK_NEG, D dst, S1 src) {
+  auto_t(S1) lhs = 0;
+  auto rhs = Read(src);
+  auto neg = UNeg(rhs);
+  while (!CompareAndSwap(dst, rhs, neg)) {
+    neg = UNeg(rhs);
+  }
+  WriteFlagsAddSub<tag_sub>(state, lhs, rhs, neg);
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(INC_LOCK_MEMb) = LOCK_INC<M8W, M8>;
+DEF_ISEL_MnW_Mn(INC_LOCK_MEMv, LOCK_INC);
+
+DEF_ISEL(DEC_LOCK_MEMb) = LOCK_DEC<M8W, M8>;
+DEF_ISEL_MnW_Mn(DEC_LOCK_MEMv, LOCK_DEC);
+
+DEF_ISEL(NEG_LOCK_MEMb) = LOCK_NEG<M8W, M8>;
+DEF_ISEL_MnW_Mn(NEG_LOCK_MEMv, LOCK_NEG);
+
+namespace {
+
 template <typename TagT, typename T>
 ALWAYS_INLINE static bool CarryFlag(T a, T b, T ab, T c, T abc) {
   static_assert(std::is_unsigned<T>::value,
@@ -707,4 +792,56 @@ DEF_ISEL_RnW_Rn_Rn(ADC_GPRv_GPRv_13, ADC);
 DEF_ISEL(ADC_AL_IMMb) = ADC<R8W, R8, I8>;
 DEF_ISEL_RnW_Rn_In(ADC_OrAX_IMMz, ADC);
 
+namespace {
+
+// There is no atomic add-with-carry, so retry until the value in memory
+// doesn't change between the read and the compare-and-swap.
+template <typename D, typename S1, typename S2>
+DEF_SEM(LOCK_ADC, D dst, S1 src1, S2 src2) {
+  auto lhs = Read(src1);
+  auto rhs = Read(src2);
+  auto carry = ZExtTo<S1>(Unsigned(Read(FLAG_CF)));
+  auto sum = UAdd(lhs, rhs);
+  auto res = UAdd(sum, carry);
+  while (!CompareAndSwap(dst, lhs, res)) {
+    sum = UAdd(lhs, rhs);
+    res = UAdd(sum, carry);
+  }
+  Write(FLAG_CF, CarryFlag<tag_add>(lhs, rhs, sum, carry, res));
+  WriteFlagsIncDec<tag_add>(state, lhs, rhs, res);
+  return memory;
+}
+
+template <typename D, typename S1, typename S2>
+DEF_SEM(LOCK_SBB, D dst, S1 src1, S2 src2) {
+  auto lhs = Read(src1);
+  auto rhs = Read(src2);
+  auto borrow = ZExtTo<S1>(Unsigned(Read(FLAG_CF)));
+  auto sum = USub(lhs, rhs);
+  auto res = USub(sum, borrow);
+  while (!CompareAndSwap(dst, lhs, res)) {
+    sum = USub(lhs, rhs);
+    res = USub(sum, borrow);
+  }
+  Write(FLAG_CF, CarryFlag<tag_sub>(lhs, rhs, sum, borrow, res));
+  WriteFlagsIncDec<tag_sub>(state, lhs, rhs, res);
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(SBB_LOCK_MEMb_IMMb_80r3) = LOCK_SBB<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(SBB_LOCK_MEMv_IMMz, LOCK_SBB);
+DEF_ISEL(SBB_LOCK_MEMb_IMMb_82r3) = LOCK_SBB<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(SBB_LOCK_MEMv_IMMb, LOCK_SBB);
+DEF_ISEL(SBB_LOCK_MEMb_GPR8) = LOCK_SBB<M8W, M8, R8>;
+DEF_ISEL_MnW_Mn_Rn(SBB_LOCK_MEMv_GPRv, LOCK_SBB);
+
+DEF_ISEL(ADC_LOCK_MEMb_IMMb_80r2) = LOCK_ADC<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(ADC_LOCK_MEMv_IMMz, LOCK_ADC);
+DEF_ISEL(ADC_LOCK_MEMb_IMMb_82r2) = LOCK_ADC<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(ADC_LOCK_MEMv_IMMb, LOCK_ADC);
+DEF_ISEL(ADC_LOCK_MEMb_GPR8) = LOCK_ADC<M8W, M8, R8>;
+DEF_ISEL_MnW_Mn_Rn(ADC_LOCK_MEMv_GPRv, LOCK_ADC);
+
 #endif  // REMILL_ARCH_X86_SEMANTICS_BINARY_H_
@@ -252,6 +252,49 @@ DEF_ISEL_RnW_Rn_In(BTC_GPRv_IMMb, BTCreg);
 DEF_ISEL_MnW_Mn_Rn(BTC_MEMv_GPRv, BTCmem);
 DEF_ISEL_RnW_Rn_Rn(BTC_GPRv_GPRv, BTCreg);
 
+namespace {
+
+template <typename D, typename S1, typename S2>
+DEF_SEM(LOCK_BTSmem, D dst, S1 src1, S2 src2) {
+  auto bit = ZExtTo<S1>(Read(src2));
+  auto bit_mask = UShl(Literal<S1>(1), URem(bit, BitSizeOf(src1)));
+  auto index = UDiv(bit, BitSizeOf(src1));
+  auto val = FetchAndOr(GetElementPtr(dst, index), bit_mask);
+  Write(FLAG_CF, UCmpNeq(UAnd(val, bit_mask), Literal<S1>(0)));
+  return memory;
+}
+
+template <typename D, typename S1, typename S2>
+DEF_SEM(LOCK_BTRmem, D dst, S1 src1, S2 src2) {
+  auto bit = ZExtTo<S1>(Read(src2));
+  auto bit_mask = UShl(Literal<S1>(1), URem(bit, BitSizeOf(src1)));
+  auto index = UDiv(bit, BitSizeOf(src1));
+  auto val = FetchAndAnd(GetElementPtr(dst, index), UNot(bit_mask));
+  Write(FLAG_CF, UCmpNeq(UAnd(val, bit_mask), Literal<S1>(0)));
+  return memory;
+}
+
+template <typename D, typename S1, typename S2>
+DEF_SEM(LOCK_BTCmem, D dst, S1 src1, S2 src2) {
+  auto bit = ZExtTo<S1>(Read(src2));
+  auto bit_mask = UShl(Literal<S1>(1), URem(bit, BitSizeOf(src1)));
+  auto index = UDiv(bit, BitSizeOf(src1));
+  auto val = FetchAndXor(GetElementPtr(dst, index), bit_mask);
+  Write(FLAG_CF, UCmpNeq(UAnd(val, bit_mask), Literal<S1>(0)));
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL_MnW_Mn_In(BTS_LOCK_MEMv_IMMb, LOCK_BTSmem);
+DEF_ISEL_MnW_Mn_Rn(BTS_LOCK_MEMv_GPRv, LOCK_BTSmem);
+
+DEF_ISEL_MnW_Mn_In(BTR_LOCK_MEMv_IMMb, LOCK_BTRmem);
+DEF_ISEL_MnW_Mn_Rn(BTR_LOCK_MEMv_GPRv, LOCK_BTRmem);
+
+DEF_ISEL_MnW_Mn_In(BTC_LOCK_MEMv_IMMb, LOCK_BTCmem);
+DEF_ISEL_MnW_Mn_Rn(BTC_LOCK_MEMv_GPRv, LOCK_BTCmem);
+
 namespace {
 DEF_SEM(BSWAP_32, R32W dst, R32 src) {
 //  auto val = Read(src);
@@ -308,6 +351,96 @@ DEF_ISEL_RnW_Rn(TZCNT_GPRv_GPRv, TZCNT);
 DEF_ISEL_RnW_Mn(LZCNT_GPRv_MEMv, LZCNT);
 DEF_ISEL_RnW_Rn(LZCNT_GPRv_GPRv, LZCNT);
 
+namespace {
+
+template <typename D, typename S>
+DEF_SEM(POPCNT, D dst, S src) {
+  auto val = Read(src);
+  ClearArithFlags();
+  Write(FLAG_ZF, ZeroFlag(val));
+  WriteZExt(dst, PopulationCount(val));
+  return memory;
+}
+
+// Deposit the low-order bits of `val` into the bits of the result that are
+// set in `mask`, from least to most significant.
+template <typename T>
+ALWAYS_INLINE static T PortableParallelBitsDeposit(T val, T mask) {
+  T res = 0;
+  for (T bit = 1; mask; bit += bit) {
+    if (val & bit) {
+      res |= mask & (0 - mask);
+    }
+    mask &= mask - 1;
+  }
+  return res;
+}
+
+// Extract the bits of `val` that are set in `mask` into the low-order bits
+// of the result.
+template <typename T>
+ALWAYS_INLINE static T PortableParallelBitsExtract(T val, T mask) {
+  T res = 0;
+  for (T bit = 1; mask; bit += bit) {
+    if (val & mask & (0 - mask)) {
+      res |= bit;
+    }
+    mask &= mask - 1;
+  }
+  return res;
+}
+
+#define MAKE_PARALLEL_BITS(name, size, builtin) \
+    ALWAYS_INLINE static uint ## size ## _t name( \
+        uint ## size ## _t val, uint ## size ## _t mask) { \
+      return builtin(val, mask); \
+    }
+
+#if defined(__BMI2__)
+MAKE_PARALLEL_BITS(ParallelBitsDeposit, 32, __builtin_ia32_pdep_si)
+MAKE_PARALLEL_BITS(ParallelBitsExtract, 32, __builtin_ia32_pext_si)
+#else
+MAKE_PARALLEL_BITS(ParallelBitsDeposit, 32, PortableParallelBitsDeposit)
+MAKE_PARALLEL_BITS(ParallelBitsExtract, 32, PortableParallelBitsExtract)
+#endif  // defined(__BMI2__)
+
+#if defined(__BMI2__) && defined(__x86_64__)
+MAKE_PARALLEL_BITS(ParallelBitsDeposit, 64, __builtin_ia32_pdep_di)
+MAKE_PARALLEL_BITS(ParallelBitsExtract, 64, __builtin_ia32_pext_di)
+#else
+MAKE_PARALLEL_BITS(ParallelBitsDeposit, 64, PortableParallelBitsDeposit)
+MAKE_PARALLEL_BITS(ParallelBitsExtract, 64, PortableParallelBitsExtract)
+#endif  // defined(__BMI2__) && defined(__x86_64__)
+
+#undef MAKE_PARALLEL_BITS
+
+template <typename D, typename S1, typename S2>
+DEF_SEM(PDEP, D dst, S1 src1, S2 src2) {
+  WriteZExt(dst, ParallelBitsDeposit(Read(src1), Read(src2)));
+  return memory;
+}
+
+template <typename D, typename S1, typename S2>
+DEF_SEM(PEXT, D dst, S1 src1, S2 src2) {
+  WriteZExt(dst, ParallelBitsExtract(Read(src1), Read(src2)));
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL_RnW_Mn(POPCNT_GPRv_MEMv, POPCNT);
+DEF_ISEL_RnW_Rn(POPCNT_GPRv_GPRv, POPCNT);
+
+DEF_ISEL(PDEP_VGPR32d_VGPR32d_VGPR32d) = PDEP<R32W, R32, R32>;
+DEF_ISEL(PDEP_VGPR32d_VGPR32d_MEMd) = PDEP<R32W, R32, M32>;
+IF_64BIT(DEF_ISEL(PDEP_VGPR64q_VGPR64q_VGPR64q) = PDEP<R64W, R64, R64>;)
+IF_64BIT(DEF_ISEL(PDEP_VGPR64q_VGPR64q_MEMq) = PDEP<R64W, R64, M64>;)
+
+DEF_ISEL(PEXT_VGPR32d_VGPR32d_VGPR32d) = PEXT<R32W, R32, R32>;
+DEF_ISEL(PEXT_VGPR32d_VGPR32d_MEMd) = PEXT<R32W, R32, M32>;
+IF_64BIT(DEF_ISEL(PEXT_VGPR64q_VGPR64q_VGPR64q) = PEXT<R64W, R64, R64>;)
+IF_64BIT(DEF_ISEL(PEXT_VGPR64q_VGPR64q_MEMq) = PEXT<R64W, R64, M64>;)
+
 namespace {
 template <typename D, typename S>
 DEF_SEM(BSR, D dst, S src) {
@@ -34,6 +34,13 @@ DEF_SEM(XCHG, D1 dst, S1 dst_val, D2 src, S2 src_val) {
   return memory;
 }
 
+// An `XCHG` with a memory operand is implicitly locked.
+template <typename D1, typename S1, typename D2, typename S2>
+DEF_SEM(XCHG_MEM, D1 dst, S1, D2 src, S2 src_val) {
+  WriteZExt(src, AtomicExchange(dst, Read(src_val)));
+  return memory;
+}
+
 template <typename D, typename S>
 DEF_SEM(MOVQ, D dst, S src) {
   UWriteV64(dst, UExtractV64(UReadV64(src), 0));
@@ -163,9 +170,9 @@ DEF_ISEL_RnW_In(MOV_GPRv_IMMv, MOV);
 DEF_ISEL(MOVNTI_MEMd_GPR32) = MOV<M32W, R32>;
 IF_64BIT(DEF_ISEL(MOVNTI_MEMq_GPR64) = MOV<M64W, R64>;)
 
-DEF_ISEL(XCHG_MEMb_GPR8) = XCHG<M8W, M8, R8W, R8>;
+DEF_ISEL(XCHG_MEMb_GPR8) = XCHG_MEM<M8W, M8, R8W, R8>;
 DEF_ISEL(XCHG_GPR8_GPR8) = XCHG<R8W, R8, R8W, R8>;
-DEF_ISEL_MnW_Mn_RnW_Rn(XCHG_MEMv_GPRv, XCHG);
+DEF_ISEL_MnW_Mn_RnW_Rn(XCHG_MEMv_GPRv, XCHG_MEM);
 DEF_ISEL_RnW_Rn_RnW_Rn(XCHG_GPRv_GPRv, XCHG);
 DEF_ISEL_RnW_Rn_RnW_Rn(XCHG_GPRv_OrAX, XCHG);
 
@@ -138,6 +138,64 @@ DEF_ISEL(NOT_GPR8) = NOT<R8W, R8>;
 DEF_ISEL_MnW_Mn(NOT_MEMv, NOT);
 DEF_ISEL_RnW_Rn(NOT_GPRv, NOT);
 
+namespace {
+
+template <typename D, typename S1, typename S2>
+DEF_SEM(LOCK_AND, D dst, S1, S2 src2) {
+  auto rhs = Read(src2);
+  auto lhs = FetchAndAnd(dst, rhs);
+  SetFlagsLogical(state, lhs, rhs, UAnd(lhs, rhs));
+  return memory;
+}
+
+template <typename D, typename S1, typename S2>
+DEF_SEM(LOCK_OR, D dst, S1, S2 src2) {
+  auto rhs = Read(src2);
+  auto lhs = FetchAndOr(dst, rhs);
+  SetFlagsLogical(state, lhs, rhs, UOr(lhs, rhs));
+  return memory;
+}
+
+template <typename D, typename S1, typename S2>
+DEF_SEM(LOCK_XOR, D dst, S1, S2 src2) {
+  auto rhs = Read(src2);
+  auto lhs = FetchAndXor(dst, rhs);
+  SetFlagsLogical(state, lhs, rhs, UXor(lhs, rhs));
+  return memory;
+}
+
+template <typename D, typename S1>
+DEF_SEM(LOCK_NOT, D dst, S1) {
+  FetchAndXor(dst, UNot(Literal<S1>(0)));
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(AND_LOCK_MEMb_IMMb_80r4) = LOCK_AND<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(AND_LOCK_MEMv_IMMz, LOCK_AND);
+DEF_ISEL(AND_LOCK_MEMb_IMMb_82r4) = LOCK_AND<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(AND_LOCK_MEMv_IMMb, LOCK_AND);
+DEF_ISEL(AND_LOCK_MEMb_GPR8) = LOCK_AND<M8W, M8, R8>;
+DEF_ISEL_MnW_Mn_Rn(AND_LOCK_MEMv_GPRv, LOCK_AND);
+
+DEF_ISEL(OR_LOCK_MEMb_IMMb_80r1) = LOCK_OR<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(OR_LOCK_MEMv_IMMz, LOCK_OR);
+DEF_ISEL(OR_LOCK_MEMb_IMMb_82r1) = LOCK_OR<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(OR_LOCK_MEMv_IMMb, LOCK_OR);
+DEF_ISEL(OR_LOCK_MEMb_GPR8) = LOCK_OR<M8W, M8, R8>;
+DEF_ISEL_MnW_Mn_Rn(OR_LOCK_MEMv_GPRv, LOCK_OR);
+
+DEF_ISEL(XOR_LOCK_MEMb_IMMb_80r6) = LOCK_XOR<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(XOR_LOCK_MEMv_IMMz, LOCK_XOR);
+DEF_ISEL(XOR_LOCK_MEMb_IMMb_82r6) = LOCK_XOR<M8W, M8, I8>;
+DEF_ISEL_MnW_Mn_In(XOR_LOCK_MEMv_IMMb, LOCK_XOR);
+DEF_ISEL(XOR_LOCK_MEMb_GPR8) = LOCK_XOR<M8W, M8, R8>;
+DEF_ISEL_MnW_Mn_Rn(XOR_LOCK_MEMv_GPRv, LOCK_XOR);
+
+DEF_ISEL(NOT_LOCK_MEMb) = LOCK_NOT<M8W, M8>;
+DEF_ISEL_MnW_Mn(NOT_LOCK_MEMv, LOCK_NOT);
+
 DEF_ISEL(TEST_MEMb_IMMb_F6r0) = TEST<M8, I8>;
 DEF_ISEL(TEST_MEMb_IMMb_F6r1) = TEST<M8, I8>;
 DEF_ISEL(TEST_GPR8_IMMb_F6r0) = TEST<R8, I8>;
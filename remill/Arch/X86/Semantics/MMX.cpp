@@ -1650,7 +1650,7 @@ DEF_SEM(PSHUFB, D dst, S1 src1, S2 src2) {
   _Pragma("unroll")
   for (size_t i = 0; i < vec_count; i++) {
     uint8_t v1 = UExtractV8(src2_vec, i);
-    uint8_t index = UAnd(v1, 7_u8);
+    uint8_t index = UAnd(v1, static_cast<uint8_t>(vec_count - 1));
     uint8_t v2 = UExtractV8(src1_vec, index);
     uint8_t value = Select(SignFlag(v1), 0_u8, v2);
     dst_vec = UInsertV8(dst_vec, i, value);
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace {
+
+// Bit 0 of the immediate selects the quadword of `src1`, and bit 4 selects
+// the quadword of `src2`.
+template <typename S2>
+DEF_SEM(PCLMULQDQ, V128W dst, V128 src1, S2 src2, I8 src3) {
+  auto sel = Read(src3);
+  auto lhs = UExtractV64(UReadV64(src1), UAnd(sel, 1_u8));
+  auto rhs = UExtractV64(UReadV64(src2), UAnd(UShr(sel, 4_u8), 1_u8));
+  auto dst_vec = UClearV128(UReadV128(src1));
+  UWriteV128(dst, UInsertV128(dst_vec, 0, CarrylessMultiply(lhs, rhs)));
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(PCLMULQDQ_XMMdq_XMMdq_IMMb) = PCLMULQDQ<V128>;
+DEF_ISEL(PCLMULQDQ_XMMdq_MEMdq_IMMb) = PCLMULQDQ<MV128>;
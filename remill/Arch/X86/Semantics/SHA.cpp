@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace {
+
+// The SHA-1 round function and constant for the group of rounds selected by
+// `func`.
+ALWAYS_INLINE static uint32_t SHA1Function(uint8_t func, uint32_t b,
+                                           uint32_t c, uint32_t d) {
+  switch (func) {
+    case 0: return (b & c) ^ (~b & d);
+    case 2: return (b & c) ^ (b & d) ^ (c & d);
+    default: return b ^ c ^ d;
+  }
+}
+
+ALWAYS_INLINE static uint32_t SHA1Constant(uint8_t func) {
+  switch (func) {
+    case 0: return 0x5A827999U;
+    case 1: return 0x6ED9EBA1U;
+    case 2: return 0x8F1BBCDCU;
+    default: return 0xCA62C1D6U;
+  }
+}
+
+ALWAYS_INLINE static uint32_t SHA256Sigma0(uint32_t val) {
+  return Ror(val, 2_u32) ^ Ror(val, 13_u32) ^ Ror(val, 22_u32);
+}
+
+ALWAYS_INLINE static uint32_t SHA256Sigma1(uint32_t val) {
+  return Ror(val, 6_u32) ^ Ror(val, 11_u32) ^ Ror(val, 25_u32);
+}
+
+ALWAYS_INLINE static uint32_t SHA256MessageSigma0(uint32_t val) {
+  return Ror(val, 7_u32) ^ Ror(val, 18_u32) ^ (val >> 3);
+}
+
+ALWAYS_INLINE static uint32_t SHA256MessageSigma1(uint32_t val) {
+  return Ror(val, 17_u32) ^ Ror(val, 19_u32) ^ (val >> 10);
+}
+
+// Four rounds of SHA-1. `src1` holds the state variables `A` through `D`,
+// and `src2` holds the message words, the first of which already includes
+// `E`.
+template <typename S2>
+DEF_SEM(SHA1RNDS4, V128W dst, V128 src1, S2 src2, I8 src3) {
+  auto state_vec = UReadV32(src1);
+  auto msg_vec = UReadV32(src2);
+  auto func = UAnd(Read(src3), 3_u8);
+  auto k = SHA1Constant(func);
+  auto a = UExtractV32(state_vec, 3);
+  auto b = UExtractV32(state_vec, 2);
+  auto c = UExtractV32(state_vec, 1);
+  auto d = UExtractV32(state_vec, 0);
+  auto e = 0_u32;
+
+  _Pragma("unroll")
+  for (size_t i = 0; i < 4; ++i) {
+    auto t = SHA1Function(func, b, c, d) + Rol(a, 5_u32) +
+             UExtractV32(msg_vec, 3 - i) + e + k;
+    e = d;
+    d = c;
+    c = Rol(b, 30_u32);
+    b = a;
+    a = t;
+  }
+
+  state_vec = UInsertV32(state_vec, 3, a);
+  state_vec = UInsertV32(state_vec, 2, b);
+  state_vec = UInsertV32(state_vec, 1, c);
+  state_vec = UInsertV32(state_vec, 0, d);
+  UWriteV32(dst, state_vec);
+  return memory;
+}
+
+template <typename S2>
+DEF_SEM(SHA1NEXTE, V128W dst, V128 src1, S2 src2) {
+  auto e = Rol(UExtractV32(UReadV32(src1), 3), 30_u32);
+  auto msg_vec = UReadV32(src2);
+  msg_vec = UInsertV32(msg_vec, 3, UAdd(UExtractV32(msg_vec, 3), e));
+  UWriteV32(dst, msg_vec);
+  return memory;
+}
+
+template <typename S2>
+DEF_SEM(SHA1MSG1, V128W dst, V128 src1, S2 src2) {
+  auto vec1 = UReadV32(src1);
+  auto vec2 = UReadV32(src2);
+  auto dst_vec = UClearV32(vec1);
+  dst_vec = UInsertV32(
+      dst_vec, 3, UXor(UExtractV32(vec1, 1), UExtractV32(vec1, 3)));
+  dst_vec = UInsertV32(
+      dst_vec, 2, UXor(UExtractV32(vec1, 0), UExtractV32(vec1, 2)));
+  dst_vec = UInsertV32(
+      dst_vec, 1, UXor(UExtractV32(vec2, 3), UExtractV32(vec1, 1)));
+  dst_vec = UInsertV32(
+      dst_vec, 0, UXor(UExtractV32(vec2, 2), UExtractV32(vec1, 0)));
+  UWriteV32(dst, dst_vec);
+  return memory;
+}
+
+template <typename S2>
+DEF_SEM(SHA1MSG2, V128W dst, V128 src1, S2 src2) {
+  auto vec1 = UReadV32(src1);
+  auto vec2 = UReadV32(src2);
+  auto w16 = Rol(UXor(UExtractV32(vec1, 3), UExtractV32(vec2, 2)), 1_u32);
+  auto w17 = Rol(UXor(UExtractV32(vec1, 2), UExtractV32(vec2, 1)), 1_u32);
+  auto w18 = Rol(UXor(UExtractV32(vec1, 1), UExtractV32(vec2, 0)), 1_u32);
+  auto w19 = Rol(UXor(UExtractV32(vec1, 0), w16), 1_u32);
+  auto dst_vec = UClearV32(vec1);
+  dst_vec = UInsertV32(dst_vec, 3, w16);
+  dst_vec = UInsertV32(dst_vec, 2, w17);
+  dst_vec = UInsertV32(dst_vec, 1, w18);
+  dst_vec = UInsertV32(dst_vec, 0, w19);
+  UWriteV32(dst, dst_vec);
+  return memory;
+}
+
+// Two rounds of SHA-256. `src1` holds the state variables `C`, `D`, `G`, and
+// `H`, `src2` holds `A`, `B`, `E`, and `F`, and the low two dwords of the
+// implicit `XMM0` operand hold the message words plus round constants.
+template <typename S2>
+DEF_SEM(SHA256RNDS2, V128W dst, V128 src1, S2 src2) {
+  auto vec1 = UReadV32(src1);
+  auto vec2 = UReadV32(src2);
+  auto wk_vec = REG_XMM0.dwords;
+  auto a = UExtractV32(vec2, 3);
+  auto b = UExtractV32(vec2, 2);
+  auto c = UExtractV32(vec1, 3);
+  auto d = UExtractV32(vec1, 2);
+  auto e = UExtractV32(vec2, 1);
+  auto f = UExtractV32(vec2, 0);
+  auto g = UExtractV32(vec1, 1);
+  auto h = UExtractV32(vec1, 0);
+
+  _Pragma("unroll")
+  for (size_t i = 0; i < 2; ++i) {
+    auto t1 = ((e & f) ^ (~e & g)) + SHA256Sigma1(e) +
+              UExtractV32(wk_vec, i) + h;
+    auto t2 = ((a & b) ^ (a & c) ^ (b & c)) + SHA256Sigma0(a);
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  auto dst_vec = UClearV32(vec1);
+  dst_vec = UInsertV32(dst_vec, 3, a);
+  dst_vec = UInsertV32(dst_vec, 2, b);
+  dst_vec = UInsertV32(dst_vec, 1, e);
+  dst_vec = UInsertV32(dst_vec, 0, f);
+  UWriteV32(dst, dst_vec);
+  return memory;
+}
+
+template <typename S2>
+DEF_SEM(SHA256MSG1, V128W dst, V128 src1, S2 src2) {
+  auto vec1 = UReadV32(src1);
+  auto w4 = UExtractV32(UReadV32(src2), 0);
+  auto dst_vec = UClearV32(vec1);
+  _Pragma("unroll")
+  for (size_t i = 0; i < 4; ++i) {
+    auto next = i < 3 ? UExtractV32(vec1, i + 1) : w4;
+    dst_vec = UInsertV32(
+        dst_vec, i, UAdd(UExtractV32(vec1, i), SHA256MessageSigma0(next)));
+  }
+  UWriteV32(dst, dst_vec);
+  return memory;
+}
+
+template <typename S2>
+DEF_SEM(SHA256MSG2, V128W dst, V128 src1, S2 src2) {
+  auto vec1 = UReadV32(src1);
+  auto vec2 = UReadV32(src2);
+  auto w16 = UAdd(UExtractV32(vec1, 0),
+                  SHA256MessageSigma1(UExtractV32(vec2, 2)));
+  auto w17 = UAdd(UExtractV32(vec1, 1),
+                  SHA256MessageSigma1(UExtractV32(vec2, 3)));
+  auto w18 = UAdd(UExtractV32(vec1, 2), SHA256MessageSigma1(w16));
+  auto w19 = UAdd(UExtractV32(vec1, 3), SHA256MessageSigma1(w17));
+  auto dst_vec = UClearV32(vec1);
+  dst_vec = UInsertV32(dst_vec, 0, w16);
+  dst_vec = UInsertV32(dst_vec, 1, w17);
+  dst_vec = UInsertV32(dst_vec, 2, w18);
+  dst_vec = UInsertV32(dst_vec, 3, w19);
+  UWriteV32(dst, dst_vec);
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(SHA1RNDS4_XMMi32_XMMi32_IMM8_SHA) = SHA1RNDS4<V128>;
+DEF_ISEL(SHA1RNDS4_XMMi32_MEMi32_IMM8_SHA) = SHA1RNDS4<MV128>;
+DEF_ISEL(SHA1NEXTE_XMMi32_XMMi32_SHA) = SHA1NEXTE<V128>;
+DEF_ISEL(SHA1NEXTE_XMMi32_MEMi32_SHA) = SHA1NEXTE<MV128>;
+DEF_ISEL(SHA1MSG1_XMMi32_XMMi32_SHA) = SHA1MSG1<V128>;
+DEF_ISEL(SHA1MSG1_XMMi32_MEMi32_SHA) = SHA1MSG1<MV128>;
+DEF_ISEL(SHA1MSG2_XMMi32_XMMi32_SHA) = SHA1MSG2<V128>;
+DEF_ISEL(SHA1MSG2_XMMi32_MEMi32_SHA) = SHA1MSG2<MV128>;
+DEF_ISEL(SHA256RNDS2_XMMi32_XMMi32_SHA) = SHA256RNDS2<V128>;
+DEF_ISEL(SHA256RNDS2_XMMi32_MEMi32_SHA) = SHA256RNDS2<MV128>;
+DEF_ISEL(SHA256MSG1_XMMi32_XMMi32_SHA) = SHA256MSG1<V128>;
+DEF_ISEL(SHA256MSG1_XMMi32_MEMi32_SHA) = SHA256MSG1<MV128>;
+DEF_ISEL(SHA256MSG2_XMMi32_XMMi32_SHA) = SHA256MSG2<V128>;
+DEF_ISEL(SHA256MSG2_XMMi32_MEMi32_SHA) = SHA256MSG2<MV128>;
@@ -1569,4 +1569,31 @@ IF_AVX(DEF_ISEL(VSQRTSS_XMMdq_XMMdq_XMMd) = VSQRTSS<VV128W, V128, V128>;)
 4318 VSQRTSS VSQRTSS_XMMf32_MASKmskw_XMMf32_MEMf32_AVX512 AVX512 AVX512EVEX AVX512F_SCALAR ATTRIBUTES: DISP8_SCALAR MASKOP_EVEX MEMORY_FAULT_SUPPRESSION MXCSR SIMD_SCALAR
 */
 
+
+namespace {
+
+// The `CRC32` instruction uses the Castagnoli polynomial, i.e. it computes
+// CRC-32C, not the CRC-32 used by zlib.
+template <typename D, typename S1, typename S2>
+DEF_SEM(DoCRC32, D dst, S1 src1, S2 src2) {
+  auto crc = TruncTo<uint32_t>(Read(src1));
+  WriteZExt(dst, CRC32C(crc, Read(src2)));
+  return memory;
+}
+
+}  // namespace
+
+DEF_ISEL(CRC32_GPRyy_GPR8b_16) = DoCRC32<R32W, R32, R8>;
+DEF_ISEL(CRC32_GPRyy_GPR8b_32) = DoCRC32<R32W, R32, R8>;
+IF_64BIT(DEF_ISEL(CRC32_GPRyy_GPR8b_64) = DoCRC32<R64W, R64, R8>;)
+DEF_ISEL(CRC32_GPRyy_MEMb_16) = DoCRC32<R32W, R32, M8>;
+DEF_ISEL(CRC32_GPRyy_MEMb_32) = DoCRC32<R32W, R32, M8>;
+IF_64BIT(DEF_ISEL(CRC32_GPRyy_MEMb_64) = DoCRC32<R64W, R64, M8>;)
+DEF_ISEL(CRC32_GPRyy_GPRv_16) = DoCRC32<R32W, R32, R16>;
+DEF_ISEL(CRC32_GPRyy_GPRv_32) = DoCRC32<R32W, R32, R32>;
+IF_64BIT(DEF_ISEL(CRC32_GPRyy_GPRv_64) = DoCRC32<R64W, R64, R64>;)
+DEF_ISEL(CRC32_GPRyy_MEMv_16) = DoCRC32<R32W, R32, M16>;
+DEF_ISEL(CRC32_GPRyy_MEMv_32) = DoCRC32<R32W, R32, M32>;
+IF_64BIT(DEF_ISEL(CRC32_GPRyy_MEMv_64) = DoCRC32<R64W, R64, M64>;)
+
 #endif  // REMILL_ARCH_X86_SEMANTICS_SSE_H_
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "remill/BC/Codegen.h"
+#include "remill/BC/Version.h"
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(3, 9)
+
+#include <llvm/ADT/Triple.h>
+
+#include <llvm/Analysis/TargetTransformInfo.h>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/TargetRegistry.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+
+#include <llvm/Transforms/IPO.h>
+#include <llvm/Transforms/IPO/PassManagerBuilder.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+
+#include "remill/BC/Compat/BitcodeReaderWriter.h"
+#include "remill/BC/Compat/IRReader.h"
+#include "remill/BC/Compat/TargetLibraryInfo.h"
+#include "remill/BC/Compat/Verifier.h"
+#include "remill/BC/RemillAA.h"
+#include "remill/OS/FileSystem.h"
+
+namespace remill {
+namespace {
+
+static llvm::CodeGenOpt::Level CodeGenOptLevel(unsigned opt_level) {
+  switch (opt_level) {
+    case 0: return llvm::CodeGenOpt::None;
+    case 1: return llvm::CodeGenOpt::Less;
+    case 2: return llvm::CodeGenOpt::Default;
+    default: return llvm::CodeGenOpt::Aggressive;
+  }
+}
+
+// Run the standard optimization pipeline for `opt_level` over `module`.
+static void OptimizePartition(llvm::Module *module, llvm::TargetMachine *tm,
+                              unsigned opt_level) {
+  llvm::legacy::FunctionPassManager func_manager(module);
+  llvm::legacy::PassManager module_manager;
+  llvm::PassManagerBuilder builder;
+  builder.OptLevel = opt_level;
+  builder.SizeLevel = 0;
+  builder.LibraryInfo = new llvm::TargetLibraryInfoImpl(
+      llvm::Triple(module->getTargetTriple()));
+  if (1 < opt_level) {
+    builder.Inliner = llvm::createFunctionInliningPass(opt_level, 0);
+  }
+
+  func_manager.add(llvm::createTargetTransformInfoWrapperPass(
+      tm->getTargetIRAnalysis()));
+  module_manager.add(llvm::createTargetTransformInfoWrapperPass(
+      tm->getTargetIRAnalysis()));
+  AddRemillAliasAnalysis(func_manager);
+  AddRemillAliasAnalysis(module_manager);
+
+  builder.populateFunctionPassManager(func_manager);
+  builder.populateModulePassManager(module_manager);
+
+  func_manager.doInitialization();
+  for (auto &func : *module) {
+    func_manager.run(func);
+  }
+  func_manager.doFinalization();
+  module_manager.run(*module);
+}
+
+// Parse one partition into its own context, optimize it, and compile it to
+// `object_file`. This runs concurrently with other partitions, so it can't
+// touch anything that's shared with them, including their `LLVMContext`.
+static bool CompilePartition(const std::string &bitcode,
+                             const std::string &object_file,
+                             const ParallelCodegenOptions &options,
+                             std::string *error) {
+  llvm::LLVMContext context;
+  llvm::SMDiagnostic diag;
+  auto module = llvm::parseIR(
+      llvm::MemoryBufferRef(bitcode, object_file), diag, context);
+  if (!module) {
+    *error = "Unable to parse partition: " + diag.getMessage().str();
+    return false;
+  }
+
+  const auto &triple = module->getTargetTriple();
+  std::string target_error;
+  auto target = llvm::TargetRegistry::lookupTarget(triple, target_error);
+  if (!target) {
+    *error = "Unable to find target " + triple + ": " + target_error;
+    return false;
+  }
+
+  llvm::TargetOptions target_options;
+  std::unique_ptr<llvm::TargetMachine> tm(target->createTargetMachine(
+      triple, options.cpu, options.features, target_options,
+      llvm::Reloc::PIC_,
+#if LLVM_VERSION_NUMBER < LLVM_VERSION(6, 0)
+      llvm::CodeModel::Default,
+#else
+      llvm::None,
+#endif
+      CodeGenOptLevel(options.opt_level)));
+  if (!tm) {
+    *error = "Unable to create a target machine for " + triple;
+    return false;
+  }
+
+  module->setDataLayout(tm->createDataLayout());
+  if (options.opt_level) {
+    OptimizePartition(module.get(), tm.get(), options.opt_level);
+  }
+
+  std::error_code ec;
+  llvm::raw_fd_ostream os(object_file, ec, llvm::sys::fs::F_None);
+  if (ec) {
+    *error = "Unable to open " + object_file + ": " + ec.message();
+    return false;
+  }
+
+  llvm::legacy::PassManager codegen_manager;
+  if (tm->addPassesToEmitFile(
+          codegen_manager, os,
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(7, 0)
+          nullptr,
+#endif
+          llvm::TargetMachine::CGFT_ObjectFile)) {
+    *error = "Target " + triple + " can't emit object files";
+    return false;
+  }
+
+  codegen_manager.run(*module);
+  os.close();
+  if (os.has_error()) {
+    os.clear_error();
+    *error = "Unable to write " + object_file;
+    return false;
+  }
+  return true;
+}
+
+static unsigned NumHardwareThreads(void) {
+  return std::max(1U, std::thread::hardware_concurrency());
+}
+
+}  // namespace
+
+bool CompileModuleInParallel(std::unique_ptr<llvm::Module> module,
+                             const std::string &output_prefix,
+                             const ParallelCodegenOptions &options,
+                             std::vector<std::string> *object_files,
+                             bool allow_failure) {
+  std::string error;
+  llvm::raw_string_ostream error_stream(error);
+  if (llvm::verifyModule(*module, &error_stream)) {
+    error_stream.flush();
+    LOG_IF(FATAL, !allow_failure)
+        << "Unable to compile invalid module: " << error;
+    return false;
+  }
+
+  auto num_partitions = options.num_partitions;
+  if (!num_partitions) {
+    num_partitions = NumHardwareThreads();
+  }
+
+  auto num_threads = options.num_threads;
+  if (!num_threads) {
+    num_threads = NumHardwareThreads();
+  }
+  num_threads = std::min(num_threads, num_partitions);
+
+  // Partitions share `module`'s context, so they are serialized one at a
+  // time, and then each one is parsed back into a context of its own.
+  std::vector<std::string> partitions;
+  llvm::SplitModule(
+      std::move(module), num_partitions,
+      [&partitions] (std::unique_ptr<llvm::Module> part) {
+        std::string bitcode;
+        llvm::raw_string_ostream os(bitcode);
+        llvm::WriteBitcodeToFile(part.get(), os);
+        os.flush();
+        partitions.push_back(std::move(bitcode));
+      });
+
+  object_files->clear();
+  for (size_t i = 0; i < partitions.size(); ++i) {
+    std::stringstream ss;
+    ss << output_prefix << "." << i << ".o";
+    object_files->push_back(ss.str());
+  }
+
+  DLOG(INFO)
+      << "Compiling " << partitions.size() << " partitions on "
+      << num_threads << " threads";
+
+  std::vector<std::string> errors(partitions.size());
+  std::atomic<size_t> next_partition(0);
+  auto compile = [&] (void) {
+    for (auto i = next_partition++; i < partitions.size();
+         i = next_partition++) {
+      CompilePartition(partitions[i], (*object_files)[i], options,
+                       &(errors[i]));
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (auto i = 1U; i < num_threads; ++i) {
+    threads.emplace_back(compile);
+  }
+  compile();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  auto ok = true;
+  for (size_t i = 0; i < errors.size(); ++i) {
+    if (!errors[i].empty()) {
+      LOG(ERROR)
+          << "Error compiling partition " << i << ": " << errors[i];
+      ok = false;
+    }
+  }
+
+  if (!ok) {
+    for (const auto &object_file : *object_files) {
+      RemoveFile(object_file);
+    }
+    object_files->clear();
+    LOG_IF(FATAL, !allow_failure)
+        << "Unable to compile module to " << output_prefix << ".*.o";
+  }
+  return ok;
+}
+
+}  // namespace remill
+
+#else
+
+#include <llvm/IR/Module.h>
+
+namespace remill {
+
+bool CompileModuleInParallel(std::unique_ptr<llvm::Module>,
+                             const std::string &output_prefix,
+                             const ParallelCodegenOptions &,
+                             std::vector<std::string> *object_files,
+                             bool allow_failure) {
+  object_files->clear();
+  LOG_IF(FATAL, !allow_failure)
+      << "Unable to compile module to " << output_prefix << ".*.o: "
+      << "splitting modules requires LLVM 3.9 or newer";
+  return false;
+}
+
+}  // namespace remill
+
+#endif  // LLVM_VERSION_NUMBER >= LLVM_VERSION(3, 9)
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_BC_CODEGEN_H_
+#define REMILL_BC_CODEGEN_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class Module;
+}  // namespace llvm
+
+namespace remill {
+
+struct ParallelCodegenOptions {
+  // Number of partitions to split the module into, which is also the number
+  // of object files that are produced. Zero means one per hardware thread.
+  unsigned num_partitions;
+
+  // Number of partitions to compile at once. Zero means one per hardware
+  // thread.
+  unsigned num_threads;
+
+  // Optimization level (0 to 3) of each partition's optimization pipeline
+  // and code generator.
+  unsigned opt_level;
+
+  // Target CPU and features, e.g. `haswell` and `+avx2`. Empty means the
+  // generic CPU of the module's target triple.
+  std::string cpu;
+  std::string features;
+};
+
+// Split `module` into `options.num_partitions` partitions by function, then
+// optimize each partition and compile it to the object file
+// `<output_prefix>.<N>.o`, with up to `options.num_threads` partitions being
+// compiled at once. Functions and globals that are referenced across
+// partitions are given external linkage, so that linking all of the object
+// files together gives the same program as compiling `module` as a whole.
+// The partitioning only depends on `module` and the number of partitions, so
+// the same module always produces the same object files, regardless of how
+// many threads compile them. Pass an explicit number of partitions to get the
+// same output on machines with different numbers of cores.
+//
+// The targets that the module can be compiled for must have been registered
+// (e.g. with `llvm::InitializeAllTargets`) beforehand. On success, the paths
+// of the object files are stored in `object_files`, in partition order.
+bool CompileModuleInParallel(std::unique_ptr<llvm::Module> module,
+                             const std::string &output_prefix,
+                             const ParallelCodegenOptions &options,
+                             std::vector<std::string> *object_files,
+                             bool allow_failure=false);
+
+}  // namespace remill
+
+#endif  // REMILL_BC_CODEGEN_H_
@@ -0,0 +1,596 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <utility>
+
+#include <llvm/ADT/APInt.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DataLayout.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Operator.h>
+
+#include "remill/BC/ISelSummary.h"
+#include "remill/BC/Util.h"
+
+namespace remill {
+namespace {
+
+// `ArchState::hyper_call` is the first field of every `State` structure.
+static const StateRange kHyperCallRange = {0, 4};
+
+// Bytes accessed through a pointer argument, relative to that argument.
+struct PointerUses {
+  PointerUses(void)
+      : reads_all(false),
+        writes_all(false) {}
+
+  bool reads_all;
+  bool writes_all;
+  std::vector<StateRange> reads;
+  std::vector<StateRange> writes;
+};
+
+// Sort `ranges` and merge overlapping or adjacent ranges.
+static void MergeRanges(std::vector<StateRange> &ranges) {
+  std::sort(ranges.begin(), ranges.end(),
+            [] (const StateRange &a, const StateRange &b) {
+              return a.begin < b.begin;
+            });
+
+  std::vector<StateRange> merged;
+  for (const auto &range : ranges) {
+    if (!merged.empty() && range.begin <= merged.back().end) {
+      merged.back().end = std::max(merged.back().end, range.end);
+    } else {
+      merged.push_back(range);
+    }
+  }
+  ranges.swap(merged);
+}
+
+static bool Overlaps(const std::vector<StateRange> &ranges,
+                     const StateRange &range) {
+  for (const auto &r : ranges) {
+    if (r.begin < range.end && range.begin < r.end) {
+      return true;
+    }
+  }
+  return false;
+}
+
+class Summarizer {
+ public:
+  explicit Summarizer(llvm::Module *module)
+      : dl(module) {}
+
+  // Find the bytes accessed through the `arg_num`th argument of `func`.
+  // Accesses that can't be accounted for, e.g. passing the pointer to a
+  // function declaration, make the whole pointee readable and writable.
+  const PointerUses &SummarizeArgument(llvm::Function *func, unsigned arg_num);
+
+  // Find whether or not `func`, or any function it calls, accesses memory or
+  // makes a synchronous hyper call.
+  void SummarizeCalls(llvm::Function *func, ISelSummary &summary);
+
+ private:
+  // Add the uses of `ptr` to `uses`. `ptr` points `offset` bytes into the
+  // argument. If `extent` is non-zero, then `ptr` was computed with a
+  // variable index, and any access through it may touch any of the `extent`
+  // bytes at `offset`.
+  void VisitPointer(llvm::Value *ptr, uint64_t offset, uint64_t extent,
+                    PointerUses &uses);
+
+  void VisitCallArgument(llvm::CallInst *call, llvm::Value *ptr,
+                         uint64_t offset, uint64_t extent,
+                         PointerUses &uses);
+
+  bool GetVariableGEPRange(llvm::GEPOperator *gep, uint64_t &offset,
+                           uint64_t &extent);
+
+  const llvm::DataLayout dl;
+  std::map<std::pair<llvm::Function *, unsigned>, PointerUses> arg_uses;
+  std::set<std::pair<llvm::Function *, unsigned>> in_progress;
+  std::set<std::pair<llvm::Value *, uint64_t>> visited;
+};
+
+const PointerUses &Summarizer::SummarizeArgument(llvm::Function *func,
+                                                 unsigned arg_num) {
+  auto key = std::make_pair(func, arg_num);
+  auto uses_it = arg_uses.find(key);
+  if (uses_it != arg_uses.end()) {
+    return uses_it->second;
+  }
+
+  PointerUses uses;
+  if (func->isDeclaration() || in_progress.count(key)) {
+    uses.reads_all = true;
+    uses.writes_all = true;
+  } else {
+    in_progress.insert(key);
+    VisitPointer(NthArgument(func, arg_num), 0, 0, uses);
+    in_progress.erase(key);
+    MergeRanges(uses.reads);
+    MergeRanges(uses.writes);
+  }
+
+  auto &cached_uses = arg_uses[key];
+  cached_uses = uses;
+  return cached_uses;
+}
+
+void Summarizer::VisitPointer(llvm::Value *ptr, uint64_t offset,
+                              uint64_t extent, PointerUses &uses) {
+  if (!visited.insert({ptr, offset}).second) {
+    return;
+  }
+
+  for (auto user : ptr->users()) {
+    if (uses.reads_all && uses.writes_all) {
+      return;
+    }
+
+    if (auto gep = llvm::dyn_cast<llvm::GEPOperator>(user)) {
+      if (gep->getPointerOperand() != ptr) {
+        uses.reads_all = true;  // Used as an index.
+        uses.writes_all = true;
+        continue;
+      }
+
+      llvm::APInt gep_offset(64, 0);
+      uint64_t var_offset = 0;
+      uint64_t var_extent = 0;
+      if (extent) {
+        VisitPointer(gep, offset, extent, uses);
+
+      } else if (gep->accumulateConstantOffset(dl, gep_offset)) {
+        VisitPointer(gep, offset + gep_offset.getZExtValue(), 0, uses);
+
+      } else if (GetVariableGEPRange(gep, var_offset, var_extent)) {
+        VisitPointer(gep, offset + var_offset, var_extent, uses);
+
+      } else {
+        uses.reads_all = true;
+        uses.writes_all = true;
+      }
+
+    } else if (llvm::isa<llvm::BitCastOperator>(user) ||
+               llvm::isa<llvm::PHINode>(user) ||
+               llvm::isa<llvm::SelectInst>(user)) {
+      VisitPointer(user, offset, extent, uses);
+
+    } else if (auto load = llvm::dyn_cast<llvm::LoadInst>(user)) {
+      auto size = extent ? extent : dl.getTypeStoreSize(load->getType());
+      uses.reads.push_back({offset, offset + size});
+
+    } else if (auto store = llvm::dyn_cast<llvm::StoreInst>(user)) {
+      if (store->getPointerOperand() != ptr) {
+        uses.reads_all = true;  // The pointer escapes.
+        uses.writes_all = true;
+        continue;
+      }
+      auto val_type = store->getValueOperand()->getType();
+      auto size = extent ? extent : dl.getTypeStoreSize(val_type);
+      uses.writes.push_back({offset, offset + size});
+
+    } else if (auto call = llvm::dyn_cast<llvm::CallInst>(user)) {
+      VisitCallArgument(call, ptr, offset, extent, uses);
+
+    } else if (llvm::isa<llvm::ICmpInst>(user)) {
+      continue;
+
+    } else {
+      uses.reads_all = true;
+      uses.writes_all = true;
+    }
+  }
+}
+
+// Find the array that a GEP with a variable index indexes into, e.g.
+// `state.vec[i]`. Any access through the GEP may touch the `extent` bytes of
+// that array, which begins `offset` bytes into the GEP's pointer operand.
+bool Summarizer::GetVariableGEPRange(llvm::GEPOperator *gep, uint64_t &offset,
+                                     uint64_t &extent) {
+  auto ptr_type = llvm::dyn_cast<llvm::PointerType>(
+      gep->getPointerOperand()->getType());
+
+  // The first index steps over whole objects, so it must be constant.
+  auto first_index = llvm::dyn_cast<llvm::ConstantInt>(gep->getOperand(1));
+  if (!ptr_type || !first_index) {
+    return false;
+  }
+
+  auto type = ptr_type->getElementType();
+  offset = first_index->getZExtValue() * dl.getTypeAllocSize(type);
+
+  for (unsigned i = 2; i < gep->getNumOperands(); ++i) {
+    auto index = llvm::dyn_cast<llvm::ConstantInt>(gep->getOperand(i));
+    if (auto struct_type = llvm::dyn_cast<llvm::StructType>(type)) {
+      if (!index) {
+        return false;
+      }
+      auto field = static_cast<unsigned>(index->getZExtValue());
+      offset += dl.getStructLayout(struct_type)->getElementOffset(field);
+      type = struct_type->getElementType(field);
+      continue;
+    }
+
+    llvm::Type *elem_type = nullptr;
+    if (auto array_type = llvm::dyn_cast<llvm::ArrayType>(type)) {
+      elem_type = array_type->getElementType();
+    } else if (auto vec_type = llvm::dyn_cast<llvm::VectorType>(type)) {
+      elem_type = vec_type->getElementType();
+    } else {
+      return false;
+    }
+
+    if (!index) {
+      extent = dl.getTypeAllocSize(type);
+      return true;
+    }
+
+    offset += index->getZExtValue() * dl.getTypeAllocSize(elem_type);
+    type = elem_type;
+  }
+  return false;
+}
+
+void Summarizer::VisitCallArgument(llvm::CallInst *call, llvm::Value *ptr,
+                                   uint64_t offset, uint64_t extent,
+                                   PointerUses &uses) {
+  if (auto mem_intrin = llvm::dyn_cast<llvm::MemIntrinsic>(call)) {
+    auto len = llvm::dyn_cast<llvm::ConstantInt>(mem_intrin->getLength());
+    if (!len) {
+      uses.reads_all = true;
+      uses.writes_all = true;
+      return;
+    }
+
+    auto size = extent ? extent : len->getZExtValue();
+    if (mem_intrin->getRawDest() == ptr) {
+      uses.writes.push_back({offset, offset + size});
+    }
+    if (auto transfer = llvm::dyn_cast<llvm::MemTransferInst>(call)) {
+      if (transfer->getRawSource() == ptr) {
+        uses.reads.push_back({offset, offset + size});
+      }
+    }
+    return;
+  }
+
+  if (auto intrin = llvm::dyn_cast<llvm::IntrinsicInst>(call)) {
+    switch (intrin->getIntrinsicID()) {
+      case llvm::Intrinsic::lifetime_start:
+      case llvm::Intrinsic::lifetime_end:
+        return;
+      default:
+        break;
+    }
+  }
+
+  auto callee = call->getCalledFunction();
+  if (!callee) {
+    uses.reads_all = true;
+    uses.writes_all = true;
+    return;
+  }
+
+  for (unsigned i = 0; i < call->getNumArgOperands(); ++i) {
+    if (call->getArgOperand(i) != ptr) {
+      continue;
+    }
+
+    if (i >= callee->arg_size()) {  // Variadic argument.
+      uses.reads_all = true;
+      uses.writes_all = true;
+      return;
+    }
+
+    // Make a copy, as summarizing the argument can add to `arg_uses`.
+    auto callee_uses = SummarizeArgument(callee, i);
+    uses.reads_all = uses.reads_all || callee_uses.reads_all;
+    uses.writes_all = uses.writes_all || callee_uses.writes_all;
+    for (const auto &range : callee_uses.reads) {
+      if (extent) {
+        uses.reads.push_back({offset, offset + extent});
+      } else {
+        uses.reads.push_back({offset + range.begin, offset + range.end});
+      }
+    }
+    for (const auto &range : callee_uses.writes) {
+      if (extent) {
+        uses.writes.push_back({offset, offset + extent});
+      } else {
+        uses.writes.push_back({offset + range.begin, offset + range.end});
+      }
+    }
+  }
+}
+
+void Summarizer::SummarizeCalls(llvm::Function *func, ISelSummary &summary) {
+  std::set<llvm::Function *> seen;
+  std::vector<llvm::Function *> work_list;
+  work_list.push_back(func);
+
+  while (!work_list.empty()) {
+    auto caller = work_list.back();
+    work_list.pop_back();
+    if (!seen.insert(caller).second) {
+      continue;
+    }
+
+    for (auto &block : *caller) {
+      for (auto &inst : block) {
+        auto call = llvm::dyn_cast<llvm::CallInst>(&inst);
+        if (!call) {
+          continue;
+        }
+
+        auto callee = call->getCalledFunction();
+        if (!callee) {
+          summary.reads_memory = true;
+          summary.writes_memory = true;
+          summary.may_hyper_call = true;
+          continue;
+        }
+
+        if (!callee->isDeclaration()) {
+          work_list.push_back(callee);
+          continue;
+        }
+
+        auto name = callee->getName();
+        if (name.startswith("__remill_read_memory_")) {
+          summary.reads_memory = true;
+
+        } else if (name.startswith("__remill_write_memory_")) {
+          summary.writes_memory = true;
+
+        } else if (name.startswith("__remill_compare_exchange_memory_") ||
+                   name.startswith("__remill_exchange_memory_") ||
+                   name.startswith("__remill_fetch_and_")) {
+          summary.reads_memory = true;
+          summary.writes_memory = true;
+
+        } else if (name == "__remill_sync_hyper_call") {
+          summary.may_hyper_call = true;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+ISelSummary::ISelSummary(void)
+    : reads_memory(false),
+      writes_memory(false),
+      may_hyper_call(false) {}
+
+ISelSummary SummarizeISel(llvm::Function *sem) {
+  auto module = sem->getParent();
+  Summarizer summarizer(module);
+  ISelSummary summary;
+
+  const llvm::DataLayout dl(module);
+  auto state_type = StatePointerType(module)->getElementType();
+  const StateRange whole_state = {0, dl.getTypeAllocSize(state_type)};
+
+  if (sem->isDeclaration() || 2 > sem->arg_size()) {
+    summary.reads.push_back(whole_state);
+    summary.writes.push_back(whole_state);
+    summary.reads_memory = true;
+    summary.writes_memory = true;
+    summary.may_hyper_call = true;
+    return summary;
+  }
+
+  // The first two arguments are the memory and state pointers.
+  const auto &state_uses = summarizer.SummarizeArgument(sem, 1);
+  if (state_uses.reads_all) {
+    summary.reads.push_back(whole_state);
+  } else {
+    summary.reads = state_uses.reads;
+  }
+  if (state_uses.writes_all) {
+    summary.writes.push_back(whole_state);
+  } else {
+    summary.writes = state_uses.writes;
+  }
+
+  summarizer.SummarizeCalls(sem, summary);
+  if (Overlaps(summary.writes, kHyperCallRange)) {
+    summary.may_hyper_call = true;
+  }
+
+  for (unsigned i = 2; i < sem->arg_size(); ++i) {
+    auto arg = NthArgument(sem, i);
+    if (!arg->getType()->isPointerTy()) {
+      summary.operands.push_back(kOperandRead);
+      continue;
+    }
+
+    const auto &uses = summarizer.SummarizeArgument(sem, i);
+    uint8_t access = kOperandNotAccessed;
+    if (uses.reads_all || !uses.reads.empty()) {
+      access |= kOperandRead;
+    }
+    if (uses.writes_all || !uses.writes.empty()) {
+      access |= kOperandWritten;
+    }
+    summary.operands.push_back(static_cast<ISelOperandAccess>(access));
+  }
+
+  return summary;
+}
+
+ISelSummaryMap SummarizeISels(llvm::Module *module) {
+  ISelSummaryMap summaries;
+  ForEachISel(module, [&] (llvm::GlobalVariable *isel, llvm::Function *sem) {
+    if (sem) {
+      summaries[isel->getName().str()] = SummarizeISel(sem);
+    }
+  });
+  return summaries;
+}
+
+namespace {
+
+static void WriteRanges(std::ostream &os,
+                        const std::vector<StateRange> &ranges) {
+  if (ranges.empty()) {
+    os << '-';
+    return;
+  }
+  auto sep = "";
+  for (const auto &range : ranges) {
+    os << sep << range.begin << ':' << range.end;
+    sep = ",";
+  }
+}
+
+static bool ReadRanges(const std::string &str,
+                       std::vector<StateRange> &ranges) {
+  if ("-" == str) {
+    return true;
+  }
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    StateRange range;
+    char colon = '\0';
+    std::stringstream item_ss(item);
+    if (!(item_ss >> range.begin >> colon >> range.end) || ':' != colon ||
+        range.end < range.begin) {
+      return false;
+    }
+    ranges.push_back(range);
+  }
+  return true;
+}
+
+}  // namespace
+
+void WriteISelSummaries(std::ostream &os, const ISelSummaryMap &summaries) {
+
+  // Sort by name so that the output is deterministic.
+  std::map<std::string, const ISelSummary *> sorted;
+  for (const auto &entry : summaries) {
+    sorted[entry.first] = &(entry.second);
+  }
+
+  for (const auto &entry : sorted) {
+    const auto &summary = *(entry.second);
+    os << entry.first << ' ';
+
+    if (!summary.reads_memory && !summary.writes_memory &&
+        !summary.may_hyper_call) {
+      os << '-';
+    } else {
+      if (summary.reads_memory) os << 'R';
+      if (summary.writes_memory) os << 'W';
+      if (summary.may_hyper_call) os << 'H';
+    }
+
+    os << ' ';
+    WriteRanges(os, summary.reads);
+    os << ' ';
+    WriteRanges(os, summary.writes);
+    os << ' ';
+
+    if (summary.operands.empty()) {
+      os << '-';
+    }
+    auto sep = "";
+    for (auto access : summary.operands) {
+      os << sep;
+      switch (access) {
+        case kOperandNotAccessed: os << 'n'; break;
+        case kOperandRead: os << 'r'; break;
+        case kOperandWritten: os << 'w'; break;
+        case kOperandReadWritten: os << "rw"; break;
+      }
+      sep = ",";
+    }
+    os << std::endl;
+  }
+}
+
+bool ReadISelSummaries(std::istream &is, ISelSummaryMap *summaries) {
+  std::string line;
+  while (std::getline(is, line)) {
+    if (line.empty()) {
+      continue;
+    }
+
+    std::stringstream ss(line);
+    std::string name, flags, reads, writes, operands;
+    if (!(ss >> name >> flags >> reads >> writes >> operands)) {
+      LOG(ERROR)
+          << "Malformed ISEL summary: " << line;
+      return false;
+    }
+
+    ISelSummary summary;
+    if ("-" != flags) {
+      summary.reads_memory = std::string::npos != flags.find('R');
+      summary.writes_memory = std::string::npos != flags.find('W');
+      summary.may_hyper_call = std::string::npos != flags.find('H');
+    }
+
+    if (!ReadRanges(reads, summary.reads) ||
+        !ReadRanges(writes, summary.writes)) {
+      LOG(ERROR)
+          << "Malformed State ranges in ISEL summary: " << line;
+      return false;
+    }
+
+    if ("-" != operands) {
+      std::stringstream op_ss(operands);
+      std::string op;
+      while (std::getline(op_ss, op, ',')) {
+        if ("n" == op) {
+          summary.operands.push_back(kOperandNotAccessed);
+        } else if ("r" == op) {
+          summary.operands.push_back(kOperandRead);
+        } else if ("w" == op) {
+          summary.operands.push_back(kOperandWritten);
+        } else if ("rw" == op) {
+          summary.operands.push_back(kOperandReadWritten);
+        } else {
+          LOG(ERROR)
+              << "Malformed operand access in ISEL summary: " << line;
+          return false;
+        }
+      }
+    }
+
+    (*summaries)[name] = summary;
+  }
+  return true;
+}
+
+}  // namespace remill
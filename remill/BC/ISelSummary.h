@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_BC_ISELSUMMARY_H_
+#define REMILL_BC_ISELSUMMARY_H_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace llvm {
+class Function;
+class Module;
+}  // namespace llvm
+
+namespace remill {
+
+// A byte range `[begin, end)` within the `State` structure.
+struct StateRange {
+  uint64_t begin;
+  uint64_t end;
+};
+
+// How a semantics function uses one of its explicit operands. Register
+// operands are passed as pointers into the `State` structure, so which bytes
+// they cover is only known once an instruction is decoded.
+enum ISelOperandAccess : uint8_t {
+  kOperandNotAccessed = 0,
+  kOperandRead = 1,
+  kOperandWritten = 2,
+  kOperandReadWritten = kOperandRead | kOperandWritten
+};
+
+// Conservative summary of the side-effects of one semantics function.
+struct ISelSummary {
+  ISelSummary(void);
+
+  // Sorted, non-overlapping ranges of `State` bytes that may be read or
+  // written through the `state` argument, i.e. implicit operands such as
+  // flags.
+  std::vector<StateRange> reads;
+  std::vector<StateRange> writes;
+
+  // Whether or not the function calls any memory read or write intrinsic.
+  bool reads_memory;
+  bool writes_memory;
+
+  // Whether or not the function calls `__remill_sync_hyper_call`, or sets
+  // `State::hyper_call` to request an asynchronous hyper call. A synchronous
+  // hyper call is treated as reading and writing the whole `State`.
+  bool may_hyper_call;
+
+  // Access mode of each explicit operand, in order. Operands passed by value
+  // (e.g. immediates and memory addresses) are `kOperandRead`.
+  std::vector<ISelOperandAccess> operands;
+};
+
+// Maps the name of an `ISEL_` or `COND_` variable to its summary.
+using ISelSummaryMap = std::unordered_map<std::string, ISelSummary>;
+
+// Summarize the semantics function `sem` of `module`.
+ISelSummary SummarizeISel(llvm::Function *sem);
+
+// Summarize every semantics function in `module` (see `ForEachISel`).
+ISelSummaryMap SummarizeISels(llvm::Module *module);
+
+// Read and write summaries in the format that is generated alongside each
+// semantics bitcode file, e.g. `amd64_avx.isel`. Each line describes one
+// ISEL:
+//
+//    <name> <flags> <reads> <writes> <operands>
+//
+// where `<flags>` is made of `R` (reads memory), `W` (writes memory) and `H`
+// (may hyper call); `<reads>` and `<writes>` are comma-separated lists of
+// `<begin>:<end>` byte ranges; and `<operands>` is a comma-separated list of
+// `r`, `w`, `rw`, or `n`. Empty fields are written as `-`.
+void WriteISelSummaries(std::ostream &os, const ISelSummaryMap &summaries);
+bool ReadISelSummaries(std::istream &is, ISelSummaryMap *summaries);
+
+}  // namespace remill
+
+#endif  // REMILL_BC_ISELSUMMARY_H_
@@ -25,6 +25,7 @@
 
 #include "remill/BC/IntrinsicTable.h"
 #include "remill/BC/Util.h"
+#include "remill/BC/Version.h"
 
 namespace remill {
 namespace {
@@ -56,13 +57,73 @@ static llvm::Function *FindIntrinsic(llvm::Module *module,
 static llvm::Function *FindPureIntrinsic(llvm::Module *module,
                                          const char *name) {
   auto function = FindIntrinsic(module, name);
+  function->addFnAttr(llvm::Attribute::ReadNone);
+  return function;
+}
 
-  // We want memory intrinsics to be marked as not accessing memory so that
-  // they don't interfere with dead store elimination.
+// Find a memory access or memory barrier intrinsic. Guest memory is only
+// reachable through these intrinsics, so they don't touch anything that
+// lifted code can otherwise name. `RemillAA` uses this to let dead store
+// elimination and GVN look past calls to them.
+static llvm::Function *FindMemoryIntrinsic(llvm::Module *module,
+                                           const char *name) {
+  auto function = FindIntrinsic(module, name);
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+  function->addFnAttr(llvm::Attribute::InaccessibleMemOnly);
+#else
+  // Without `RemillAA`, we want memory intrinsics to be marked as not
+  // accessing memory so that they don't interfere with dead store
+  // elimination.
   function->addFnAttr(llvm::Attribute::ReadNone);
+#endif
+  return function;
+}
+
+// Find a memory read intrinsic.
+static llvm::Function *FindReadIntrinsic(llvm::Module *module,
+                                         const char *name) {
+  auto function = FindMemoryIntrinsic(module, name);
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+  function->addFnAttr(llvm::Attribute::ReadOnly);
+#endif
   return function;
 }
 
+// Typed atomic memory intrinsics. These are never called directly by the
+// lifter, only by semantics functions. Unlike the plain memory intrinsics,
+// they write through their reference argument, and so are not pure.
+static const char * const kAtomicIntrinsics[] = {
+  "__remill_compare_exchange_memory_8",
+  "__remill_compare_exchange_memory_16",
+  "__remill_compare_exchange_memory_32",
+  "__remill_compare_exchange_memory_64",
+  "__remill_compare_exchange_memory_128",
+  "__remill_exchange_memory_8",
+  "__remill_exchange_memory_16",
+  "__remill_exchange_memory_32",
+  "__remill_exchange_memory_64",
+  "__remill_fetch_and_add_memory_8",
+  "__remill_fetch_and_add_memory_16",
+  "__remill_fetch_and_add_memory_32",
+  "__remill_fetch_and_add_memory_64",
+  "__remill_fetch_and_sub_memory_8",
+  "__remill_fetch_and_sub_memory_16",
+  "__remill_fetch_and_sub_memory_32",
+  "__remill_fetch_and_sub_memory_64",
+  "__remill_fetch_and_and_memory_8",
+  "__remill_fetch_and_and_memory_16",
+  "__remill_fetch_and_and_memory_32",
+  "__remill_fetch_and_and_memory_64",
+  "__remill_fetch_and_or_memory_8",
+  "__remill_fetch_and_or_memory_16",
+  "__remill_fetch_and_or_memory_32",
+  "__remill_fetch_and_or_memory_64",
+  "__remill_fetch_and_xor_memory_8",
+  "__remill_fetch_and_xor_memory_16",
+  "__remill_fetch_and_xor_memory_32",
+  "__remill_fetch_and_xor_memory_64",
+};
+
 }  // namespace
 
 IntrinsicTable::IntrinsicTable(llvm::Module *module)
@@ -74,42 +135,46 @@ IntrinsicTable::IntrinsicTable(llvm::Module *module)
           module, "__remill_function_return")),
       jump(FindIntrinsic(module, "__remill_jump")),
       missing_block(FindIntrinsic(module, "__remill_missing_block")),
+      resume_after_call(FindIntrinsic(
+          module, "__remill_resume_after_call")),
 
       // OS interaction.
       async_hyper_call(FindIntrinsic(
           module, "__remill_async_hyper_call")),
 
       // Memory access.
-      read_memory_8(FindPureIntrinsic(module, "__remill_read_memory_8")),
-      read_memory_16(FindPureIntrinsic(module, "__remill_read_memory_16")),
-      read_memory_32(FindPureIntrinsic(module, "__remill_read_memory_32")),
-      read_memory_64(FindPureIntrinsic(module, "__remill_read_memory_64")),
-
-      write_memory_8(FindPureIntrinsic(module, "__remill_write_memory_8")),
-      write_memory_16(FindPureIntrinsic(module, "__remill_write_memory_16")),
-      write_memory_32(FindPureIntrinsic(module, "__remill_write_memory_32")),
-      write_memory_64(FindPureIntrinsic(module, "__remill_write_memory_64")),
-
-      read_memory_f32(FindPureIntrinsic(module, "__remill_read_memory_f32")),
-      read_memory_f64(FindPureIntrinsic(module, "__remill_read_memory_f64")),
-      read_memory_f80(FindPureIntrinsic(module, "__remill_read_memory_f80")),
-
-      write_memory_f32(FindPureIntrinsic(module, "__remill_write_memory_f32")),
-      write_memory_f64(FindPureIntrinsic(module, "__remill_write_memory_f64")),
-      write_memory_f80(FindPureIntrinsic(
+      read_memory_8(FindReadIntrinsic(module, "__remill_read_memory_8")),
+      read_memory_16(FindReadIntrinsic(module, "__remill_read_memory_16")),
+      read_memory_32(FindReadIntrinsic(module, "__remill_read_memory_32")),
+      read_memory_64(FindReadIntrinsic(module, "__remill_read_memory_64")),
+
+      write_memory_8(FindMemoryIntrinsic(module, "__remill_write_memory_8")),
+      write_memory_16(FindMemoryIntrinsic(module, "__remill_write_memory_16")),
+      write_memory_32(FindMemoryIntrinsic(module, "__remill_write_memory_32")),
+      write_memory_64(FindMemoryIntrinsic(module, "__remill_write_memory_64")),
+
+      read_memory_f32(FindReadIntrinsic(module, "__remill_read_memory_f32")),
+      read_memory_f64(FindReadIntrinsic(module, "__remill_read_memory_f64")),
+      read_memory_f80(FindReadIntrinsic(module, "__remill_read_memory_f80")),
+
+      write_memory_f32(FindMemoryIntrinsic(
+          module, "__remill_write_memory_f32")),
+      write_memory_f64(FindMemoryIntrinsic(
+          module, "__remill_write_memory_f64")),
+      write_memory_f80(FindMemoryIntrinsic(
           module, "__remill_write_memory_f80")),
 
       // Memory barriers.
-      barrier_load_load(FindPureIntrinsic(
+      barrier_load_load(FindMemoryIntrinsic(
           module, "__remill_barrier_load_load")),
-      barrier_load_store(FindPureIntrinsic(
+      barrier_load_store(FindMemoryIntrinsic(
           module, "__remill_barrier_load_store")),
-      barrier_store_load(FindPureIntrinsic(
+      barrier_store_load(FindMemoryIntrinsic(
           module, "__remill_barrier_store_load")),
-      barrier_store_store(FindPureIntrinsic(
+      barrier_store_store(FindMemoryIntrinsic(
           module, "__remill_barrier_store_store")),
-      atomic_begin(FindPureIntrinsic(module, "__remill_atomic_begin")),
-      atomic_end(FindPureIntrinsic(module, "__remill_atomic_end")),
+      atomic_begin(FindMemoryIntrinsic(module, "__remill_atomic_begin")),
+      atomic_end(FindMemoryIntrinsic(module, "__remill_atomic_end")),
 
 //      // Optimization guides.
 //      //
@@ -128,6 +193,10 @@ IntrinsicTable::IntrinsicTable(llvm::Module *module)
   // Make sure to set the correct attributes on this to make sure that
   // it's never optimized away.
   (void) FindIntrinsic(module, "__remill_intrinsics");
+
+  for (auto name : kAtomicIntrinsics) {
+    (void) FindIntrinsic(module, name);
+  }
 }
 
 }  // namespace remill
@@ -36,6 +36,7 @@ class IntrinsicTable {
   llvm::Function * const function_return;
   llvm::Function * const jump;
   llvm::Function * const missing_block;
+  llvm::Function * const resume_after_call;
 
   // OS interaction.
   llvm::Function * const async_hyper_call;
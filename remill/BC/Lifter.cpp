@@ -16,20 +16,28 @@
 
 #include <glog/logging.h>
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <ios>
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <sstream>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <llvm/ADT/APInt.h>
 #include <llvm/ADT/SmallVector.h>
 
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/DataLayout.h>
+#include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/IntrinsicInst.h>
@@ -39,6 +47,7 @@
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Operator.h>
 #include <llvm/IR/Type.h>
+#include <llvm/IR/ValueHandle.h>
 
 #include <llvm/Support/raw_ostream.h>
 
@@ -50,15 +59,27 @@
 #include "remill/Arch/Instruction.h"
 
 #include "remill/BC/ABI.h"
+#include "remill/BC/Compat/DebugInfo.h"
 #include "remill/BC/IntrinsicTable.h"
 #include "remill/BC/Lifter.h"
+#include "remill/BC/Profile.h"
+#include "remill/BC/RemillAA.h"
 #include "remill/BC/Util.h"
+#include "remill/BC/Version.h"
 
 #include "remill/OS/OS.h"
 
 namespace remill {
 namespace {
 
+// Name of the metadata kind that holds the guest `PC` of lifted code.
+static const char * const kGuestPCMetadataName = "remill.pc";
+
+// Prefix of the directory names of the debug info files that hold guest code.
+// The rest of the name is the hex address of the 4 GiB region of guest code
+// that the lines of the files are relative to.
+static const char * const kGuestDirectoryPrefix = "guest_";
+
 // Try to find the function that implements this semantics.
 llvm::Function *GetInstructionFunction(llvm::Module *module,
                                        const std::string &function) {
@@ -82,14 +103,502 @@ llvm::Function *GetInstructionFunction(llvm::Module *module,
   return llvm::dyn_cast_or_null<llvm::Function>(sem);
 }
 
+// Try to compute `ptr` as a constant byte offset from `state_ptr`. This looks
+// through constant GEPs, bitcasts, and loads from singly-stored allocas (e.g.
+// the unoptimized spill of the state pointer in `__remill_basic_block`).
+static bool GetStateOffset(const llvm::DataLayout &dl, llvm::Value *state_ptr,
+                           llvm::Value *ptr, uint64_t &offset) {
+  llvm::APInt total(64, 0);
+  while (ptr != state_ptr) {
+    if (auto gep = llvm::dyn_cast<llvm::GEPOperator>(ptr)) {
+      llvm::APInt gep_offset(64, 0);
+      if (!gep->accumulateConstantOffset(dl, gep_offset)) {
+        return false;
+      }
+      total += gep_offset;
+      ptr = gep->getPointerOperand();
+
+    } else if (auto cast = llvm::dyn_cast<llvm::BitCastOperator>(ptr)) {
+      ptr = cast->getOperand(0);
+
+    } else if (auto load = llvm::dyn_cast<llvm::LoadInst>(ptr)) {
+      auto alloca = llvm::dyn_cast<llvm::AllocaInst>(load->getPointerOperand());
+      if (!alloca) {
+        return false;
+      }
+      auto store = FindUniqueStore(alloca);
+      if (!store) {
+        return false;
+      }
+      ptr = store->getValueOperand();
+
+    } else {
+      return false;
+    }
+  }
+  offset = total.getZExtValue();
+  return true;
+}
+
+// Identifies the computation of an address operand. `PC`-relative addresses
+// are folded into constants, so they also depend on the instruction's `PC`.
+using AddressKey = std::tuple<std::string, std::string, int64_t, int64_t,
+                              std::string, int64_t, uint64_t>;
+
+// A register value loaded in the current block, along with the bytes of the
+// `State` structure that back the register.
+struct CachedRegister {
+  llvm::Value *val;
+  bool in_state;
+  StateRange range;
+};
+
 }  // namespace
 
-InstructionLifter::~InstructionLifter(void) {}
+// Register loads and address computations in the block currently being
+// lifted. These are reused by later instructions in the same block, up until
+// the semantics of an instruction might write to the registers involved.
+class LifterCache {
+ public:
+  LifterCache(void)
+      : block(nullptr),
+        last_block(nullptr),
+        last_inst(nullptr),
+        func(nullptr),
+        isel_module(nullptr),
+        spec_module(nullptr),
+        debug_module(nullptr) {}
+
+  // Find the semantics function for `inst`, using its ISEL ID to avoid
+  // looking up the function by name more than once per module.
+  llvm::Function *GetInstructionFunction(llvm::Module *module,
+                                         const Instruction &inst) {
+    if (Instruction::kInvalidISelID == inst.isel_id) {
+      return ::remill::GetInstructionFunction(module, inst.function);
+    }
+
+    if (module != isel_module) {
+      isel_module = module;
+      isel_funcs.clear();
+    }
+
+    if (inst.isel_id >= isel_funcs.size()) {
+      isel_funcs.resize(inst.isel_id + 1, {false, nullptr});
+    }
+
+    auto &entry = isel_funcs[inst.isel_id];
+    if (!entry.first) {
+      entry.first = true;
+      entry.second = ::remill::GetInstructionFunction(module, inst.function);
+    }
+    return entry.second;
+  }
+
+  ~LifterCache(void) {
+    EraseUnusedSpecializations();
+    FinalizeDebugInfo();
+  }
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+  // Get the debug location of the instruction at `pc`, whose ISEL is named
+  // `isel_name`, in the lifted function `func`. The line of the location is
+  // the low 32 bits of `pc`, and its file is named after the ISEL, in a
+  // directory named after the rest of `pc`, e.g. `guest_100000000`.
+  llvm::DILocation *GetGuestLocation(llvm::Function *func, uint64_t pc,
+                                     const std::string &isel_name) {
+    auto module = func->getParent();
+    if (module != debug_module) {
+      FinalizeDebugInfo();
+      debug_module = module;
+      debug_builder.reset(new llvm::DIBuilder(*module));
+      debug_builder->createCompileUnit(
+          llvm::dwarf::DW_LANG_C99,
+          debug_builder->createFile(module->getModuleIdentifier(), "."),
+          "remill", true, "", 0, "", llvm::DICompileUnit::LineTablesOnly);
+      if (!module->getModuleFlag("Debug Info Version")) {
+        module->addModuleFlag(llvm::Module::Warning, "Debug Info Version",
+                              llvm::DEBUG_METADATA_VERSION);
+      }
+    }
+
+    std::stringstream ss;
+    ss << kGuestDirectoryPrefix << std::hex << (pc & ~0xFFFFFFFFULL);
+    auto &file = debug_files[{isel_name, ss.str()}];
+    if (!file) {
+      file = debug_builder->createFile(isel_name, ss.str());
+    }
+
+    auto line = static_cast<unsigned>(pc);
+    auto sp = func->getSubprogram();
+    if (!sp) {
+      auto func_type = debug_builder->createSubroutineType(
+          debug_builder->getOrCreateTypeArray(llvm::None));
+# if LLVM_VERSION_NUMBER >= LLVM_VERSION(8, 0)
+      sp = debug_builder->createFunction(
+          file, func->getName(), func->getName(), file, line, func_type,
+          line, llvm::DINode::FlagZero,
+          llvm::DISubprogram::SPFlagDefinition |
+          llvm::DISubprogram::SPFlagOptimized);
+# else
+      sp = debug_builder->createFunction(
+          file, func->getName(), func->getName(), file, line, func_type,
+          false, true, line, llvm::DINode::FlagZero, true);
+# endif
+      func->setSubprogram(sp);
+      debug_subprograms.insert(sp);
+    }
+
+    auto &scope = debug_scopes[{sp, file}];
+    if (!scope) {
+      scope = debug_builder->createLexicalBlockFile(sp, file);
+    }
+    return llvm::DILocation::get(func->getContext(), line, 0, scope);
+  }
+#endif  // LLVM_VERSION_NUMBER
+
+  // Finish the debug info of `debug_module`. Debug info that the lifter is
+  // still adding to isn't valid, so the module can't be compiled until this
+  // is done.
+  //
+  // Calls without a debug location can't be inlined into functions with debug
+  // info, so calls that were added to lifted functions outside of the lifter,
+  // e.g. calls to other lifted functions, get a line 0 location.
+  void FinalizeDebugInfo(void) {
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+    if (!debug_builder) {
+      return;
+    }
+    for (auto &func : *debug_module) {
+      auto sp = func.getSubprogram();
+      if (!sp || !debug_subprograms.count(sp)) {
+        continue;
+      }
+      for (auto &block : func) {
+        for (auto &inst : block) {
+          if (llvm::isa<llvm::CallInst>(inst) && !inst.getDebugLoc()) {
+            inst.setDebugLoc(llvm::DebugLoc(
+                llvm::DILocation::get(func.getContext(), 0, 0, sp)));
+          }
+        }
+      }
+    }
+    debug_builder->finalize();
+    debug_builder.reset();
+    debug_module = nullptr;
+    debug_files.clear();
+    debug_scopes.clear();
+    debug_subprograms.clear();
+#endif
+  }
+
+  // Find or create a clone of `sem` in which the constant `args` of `inst`
+  // are substituted for the corresponding parameters, and then folded. The
+  // clone has the same type as `sem`, so it can be called with `args`.
+  // Returns `sem` if none of the operands are constant.
+  //
+  // Operands derived from the `PC` of `inst`, i.e. branch targets and
+  // `PC`-relative addresses, stay parameters of the clone even if they are
+  // constants, so that the clone can be shared by instructions at different
+  // addresses.
+  llvm::Function *GetSpecializedFunction(
+      llvm::Function *sem, const Instruction &inst,
+      const std::vector<llvm::Value *> &args) {
+    if (sem->isDeclaration()) {
+      return sem;
+    }
+
+    auto module = sem->getParent();
+    if (module != spec_module) {
+      EraseUnusedSpecializations();
+      spec_module = module;
+      spec_fpm.reset(new llvm::legacy::FunctionPassManager(module));
+      AddRemillAliasAnalysis(*spec_fpm);
+      spec_fpm->add(llvm::createEarlyCSEPass());
+      spec_fpm->add(llvm::createDeadStoreEliminationPass());
+      spec_fpm->add(llvm::createCFGSimplificationPass());
+      spec_fpm->doInitialization();
+    }
+
+    // The first two arguments are the memory and state pointers.
+    SpecializationKey key;
+    key.first = sem;
+    key.second.reserve(args.size());
+    auto has_constant = false;
+    for (size_t i = 2; i < args.size(); ++i) {
+      const auto &op = inst.operands[i - 2];
+      llvm::Constant *const_arg = nullptr;
+      if (Operand::kTypeAddress != op.type || "PC" != op.addr.base_reg.name) {
+        const_arg = llvm::dyn_cast<llvm::Constant>(args[i]);
+      }
+      has_constant = has_constant || const_arg;
+      key.second.push_back(const_arg);
+    }
+
+    if (!has_constant) {
+      return sem;
+    }
+
+    auto &spec_handle = spec_funcs[key];
+    if (llvm::Value *existing_spec = spec_handle) {
+      return llvm::cast<llvm::Function>(existing_spec);
+    }
+
+    auto spec = llvm::Function::Create(
+        sem->getFunctionType(), llvm::GlobalValue::InternalLinkage,
+        sem->getName() + "_spec", module);
+    spec_handle = spec;
+
+    ValueMap value_map;
+    auto spec_arg = spec->arg_begin();
+    for (auto &sem_arg : sem->args()) {
+      auto arg_num = sem_arg.getArgNo();
+      spec_arg->setName(sem_arg.getName());
+      if (2 <= arg_num && key.second[arg_num - 2]) {
+        value_map[&sem_arg] = key.second[arg_num - 2];
+      } else {
+        value_map[&sem_arg] = &*spec_arg;
+      }
+      ++spec_arg;
+    }
+
+    CloneFunctionInto(sem, spec, value_map);
+    spec->setLinkage(llvm::GlobalValue::InternalLinkage);
+    spec_fpm->run(*spec);
+    return spec;
+  }
+
+  // Erase the specialized functions that are no longer called, e.g. because
+  // every call to them was inlined. These are kept until now so that later
+  // instructions can reuse them.
+  void EraseUnusedSpecializations(void) {
+    for (auto &entry : spec_funcs) {
+      llvm::Value *spec = entry.second;
+      if (spec && spec->use_empty()) {
+        llvm::cast<llvm::Function>(spec)->eraseFromParent();
+      }
+    }
+    spec_funcs.clear();
+  }
+
+  // Start or continue caching values for `block`. The cache is cleared when
+  // we move to a new block, or when someone else has added instructions to
+  // the block since we last lifted into it.
+  void Begin(llvm::BasicBlock *block_) {
+    auto block_last_inst = block_->empty() ? nullptr : &(block_->back());
+    if (block_ != last_block || block_last_inst != last_inst) {
+      reg_addrs.clear();
+      reg_vals.clear();
+      addrs.clear();
+    }
+    if (func != block_->getParent()) {
+      func = block_->getParent();
+      reg_ranges.clear();
+    }
+    block = block_;
+  }
+
+  // Remember where we stopped adding instructions to `block`, so that the
+  // next `Begin` can tell whether the cached values are still usable.
+  void End(void) {
+    last_block = block;
+    last_inst = block->empty() ? nullptr : &(block->back());
+    block = nullptr;
+  }
+
+  // Returns `true` if values for `block_` are being cached.
+  bool IsActive(llvm::BasicBlock *block_) const {
+    return block_ == block;
+  }
+
+  // Find the bytes of `State` that back the register variable `reg_name`.
+  bool GetRegisterRange(const std::string &reg_name, StateRange &range) {
+    auto range_it = reg_ranges.find(reg_name);
+    if (range_it != reg_ranges.end()) {
+      range = range_it->second.second;
+      return range_it->second.first;
+    }
+
+    auto &entry = reg_ranges[reg_name];
+    entry.first = false;
+
+    auto var = llvm::dyn_cast<llvm::AllocaInst>(
+        FindVarInFunction(func, reg_name));
+    llvm::StoreInst *store = var ? FindUniqueStore(var) : nullptr;
+    if (store) {
+      const llvm::DataLayout dl(func->getParent());
+      auto reg_ptr = store->getValueOperand();
+      auto reg_type = llvm::dyn_cast<llvm::PointerType>(reg_ptr->getType());
+      uint64_t offset = 0;
+      if (reg_type && GetStateOffset(dl, NthArgument(func, 0), reg_ptr,
+                                     offset)) {
+        auto size = dl.getTypeStoreSize(reg_type->getElementType());
+        entry.first = true;
+        entry.second = {offset, offset + size};
+      }
+    }
+
+    range = entry.second;
+    return entry.first;
+  }
+
+  // Get the summary of the semantics function `sem`, whose ISEL is named
+  // `isel_name`. Summaries that aren't in `summaries`, e.g. because there is
+  // no summary file for the semantics, are computed on demand.
+  const ISelSummary &GetSummary(const ISelSummaryMap *summaries,
+                                const std::string &isel_name,
+                                llvm::Function *sem) {
+    if (summaries) {
+      auto summary_it = summaries->find("ISEL_" + isel_name);
+      if (summary_it != summaries->end()) {
+        return summary_it->second;
+      }
+    }
+
+    auto summary_it = isel_summaries.find(sem);
+    if (summary_it == isel_summaries.end()) {
+      summary_it = isel_summaries.emplace(sem, SummarizeISel(sem)).first;
+    }
+    return summary_it->second;
+  }
+
+  // Forget the loaded values of registers that a semantics function with the
+  // summary `summary`, or the register write operands of `inst`, might modify.
+  void Invalidate(const ISelSummary &summary, const Instruction &inst) {
+    if (summary.may_hyper_call) {
+      reg_vals.clear();
+      addrs.clear();
+      return;
+    }
+
+    std::vector<StateRange> write_ranges = summary.writes;
+    std::set<std::string> written_regs;
+    for (const auto &op : inst.operands) {
+      if (Operand::kTypeRegister == op.type &&
+          Operand::kActionWrite == op.action) {
+        StateRange range;
+        written_regs.insert(op.reg.name);
+        if (GetRegisterRange(op.reg.name, range)) {
+          write_ranges.push_back(range);
+        }
+      }
+    }
+
+    std::set<std::string> invalid_regs;
+    for (const auto &entry : reg_vals) {
+      const auto &reg = entry.second;
+      auto is_written = written_regs.count(entry.first);
+      if (reg.in_state) {
+        for (const auto &range : write_ranges) {
+          if (range.begin < reg.range.end && reg.range.begin < range.end) {
+            is_written = true;
+            break;
+          }
+        }
+      }
+      if (is_written) {
+        invalid_regs.insert(entry.first);
+      }
+    }
+
+    for (const auto &reg_name : invalid_regs) {
+      reg_vals.erase(reg_name);
+    }
+
+    for (auto addr_it = addrs.begin(); addr_it != addrs.end(); ) {
+      const auto &key = addr_it->first;
+      if (invalid_regs.count(std::get<0>(key)) ||
+          invalid_regs.count(std::get<1>(key)) ||
+          invalid_regs.count(std::get<4>(key))) {
+        addr_it = addrs.erase(addr_it);
+      } else {
+        ++addr_it;
+      }
+    }
+  }
+
+  // The block being lifted into, if any, and where the last lifted
+  // instruction ended.
+  llvm::BasicBlock *block;
+  llvm::BasicBlock *last_block;
+  llvm::Instruction *last_inst;
+  llvm::Function *func;
+
+  std::unordered_map<std::string, llvm::Value *> reg_addrs;
+  std::unordered_map<std::string, CachedRegister> reg_vals;
+  std::map<AddressKey, llvm::Value *> addrs;
+
+  // Per-function cache of the `State` bytes backing each register variable.
+  std::unordered_map<std::string, std::pair<bool, StateRange>> reg_ranges;
+
+  // Summaries of semantics functions that were computed on demand.
+  std::unordered_map<llvm::Function *, ISelSummary> isel_summaries;
+
+  // Returns `true` if we have already added a block execution counter to
+  // `block`. Blocks can be freed, or emptied and reused, after being counted,
+  // so the counter's increment must still be in `block`.
+  bool IsCounted(llvm::BasicBlock *block) {
+    auto it = counted_blocks.find(block);
+    if (it == counted_blocks.end()) {
+      return false;
+    }
+    llvm::Value *inc = it->second;
+    if (inc && llvm::cast<llvm::Instruction>(inc)->getParent() == block) {
+      return true;
+    }
+    counted_blocks.erase(it);
+    return false;
+  }
+
+  // Blocks into which we have added a block execution counter, mapped to the
+  // store that increments the counter. The handle is nulled if the store is
+  // deleted.
+  std::unordered_map<llvm::BasicBlock *, llvm::WeakVH> counted_blocks;
+
+  // Semantics functions in `isel_module`, indexed by ISEL ID. The first
+  // element of each entry tells us if the function has been looked up.
+  llvm::Module *isel_module;
+  std::vector<std::pair<bool, llvm::Function *>> isel_funcs;
+
+  // Semantics functions specialized to constant operands, and the passes that
+  // fold the constants, for the module `spec_module`.
+  using SpecializationKey = std::pair<llvm::Function *,
+                                      std::vector<llvm::Constant *>>;
+  llvm::Module *spec_module;
+  std::map<SpecializationKey, llvm::WeakVH> spec_funcs;
+  std::unique_ptr<llvm::legacy::FunctionPassManager> spec_fpm;
+
+  // Debug info that maps lifted code back to guest `PC`s, for the module
+  // `debug_module`. Files are indexed by name and directory, and the scopes
+  // of locations by function and file.
+  llvm::Module *debug_module;
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+  std::unique_ptr<llvm::DIBuilder> debug_builder;
+  std::map<std::pair<std::string, std::string>, llvm::DIFile *> debug_files;
+  std::map<std::pair<llvm::DISubprogram *, llvm::DIFile *>,
+           llvm::DIScope *> debug_scopes;
+  std::set<llvm::DISubprogram *> debug_subprograms;
+#endif
+};
+
+LifterOptions::LifterOptions(void)
+    : reuse_addresses(false),
+      specialize_semantics(false),
+      annotate_pcs(false),
+      isel_summaries(nullptr),
+      profile(nullptr),
+      execution_counters(kNoExecutionCounters) {}
+
+InstructionLifter::~InstructionLifter(void) {
+  delete cache;
+}
 
 InstructionLifter::InstructionLifter(llvm::IntegerType *word_type_,
-                                     const IntrinsicTable *intrinsics_)
+                                     const IntrinsicTable *intrinsics_,
+                                     const LifterOptions &options_)
     : word_type(word_type_),
-      intrinsics(intrinsics_) {}
+      intrinsics(intrinsics_),
+      options(options_),
+      cache(new LifterCache) {}
 
 // Lift a single instruction into a basic block.
 bool InstructionLifter::LiftIntoBlock(
@@ -99,14 +608,32 @@ bool InstructionLifter::LiftIntoBlock(
   llvm::Module *module = func->getParent();
   llvm::Function *isel_func = nullptr;
 
+  std::chrono::steady_clock::time_point start_time;
+  if (options.profile) {
+    start_time = std::chrono::steady_clock::now();
+  }
+
+  // The last instruction in `block` before this instruction is lifted. Every
+  // LLVM instruction after it belongs to this instruction.
+  llvm::Instruction *prev_inst = nullptr;
+  if (options.profile || options.annotate_pcs) {
+    prev_inst = block->empty() ? nullptr : &(block->back());
+  }
+
+  // The name under which this instruction is profiled and counted.
+  static const std::string kInvalidISelName = "INVALID_INSTRUCTION";
+  static const std::string kUnsupportedISelName = "UNSUPPORTED_INSTRUCTION";
+  const std::string *isel_name = &(arch_inst.function);
+
   if (arch_inst.IsValid()) {
-    isel_func = GetInstructionFunction(module, arch_inst.function);
+    isel_func = cache->GetInstructionFunction(module, arch_inst);
   } else {
     DLOG(ERROR)
         << "Cannot decode instruction bytes at "
         << std::hex << arch_inst.pc;
 
-    isel_func = GetInstructionFunction(module, "INVALID_INSTRUCTION");
+    isel_func = GetInstructionFunction(module, kInvalidISelName);
+    isel_name = &kInvalidISelName;
     arch_inst.operands.clear();
     if (!isel_func) {
       LOG(ERROR)
@@ -120,7 +647,8 @@ bool InstructionLifter::LiftIntoBlock(
         << "Cannot lift instruction at " << std::hex << arch_inst.pc << ", "
         << arch_inst.function << " doesn't exist: " << arch_inst.Serialize();
 
-    isel_func = GetInstructionFunction(module, "UNSUPPORTED_INSTRUCTION");
+    isel_func = GetInstructionFunction(module, kUnsupportedISelName);
+    isel_name = &kUnsupportedISelName;
     if (!isel_func) {
       LOG(ERROR)
           << "UNSUPPORTED_INSTRUCTION doesn't exist; not using it in place of "
@@ -130,19 +658,35 @@ bool InstructionLifter::LiftIntoBlock(
     arch_inst.operands.clear();
   }
 
+  if (options.reuse_addresses) {
+    cache->Begin(block);
+  }
+
+  switch (options.execution_counters) {
+    case LifterOptions::kNoExecutionCounters:
+      break;
+
+    case LifterOptions::kCountBlockExecutions:
+      if (!cache->IsCounted(block)) {
+        std::stringstream ss;
+        ss << "block_" << std::hex << arch_inst.pc;
+        AddExecutionCounterIncrement(
+            block, GetOrCreateExecutionCounter(module, ss.str()));
+        cache->counted_blocks[block] = &(block->back());
+      }
+      break;
+
+    case LifterOptions::kCountISelExecutions:
+      AddExecutionCounterIncrement(
+          block, GetOrCreateExecutionCounter(module, "isel_" + *isel_name));
+      break;
+  }
+
   llvm::IRBuilder<> ir(block);
   auto mem_ptr = LoadMemoryPointerRef(block);
   auto state_ptr = LoadStatePointer(block);
   auto pc_ptr = LoadProgramCounterRef(block);
 
-  // Begin an atomic block.
-  if (arch_inst.is_atomic_read_modify_write) {
-    std::vector<llvm::Value *> args = {ir.CreateLoad(mem_ptr)};
-    ir.CreateStore(
-        ir.CreateCall(intrinsics->atomic_begin, args),
-        mem_ptr);
-  }
-
   std::vector<llvm::Value *> args;
   args.reserve(arch_inst.operands.size() + 2);
 
@@ -175,26 +719,84 @@ bool InstructionLifter::LiftIntoBlock(
     args.push_back(operand);
   }
 
+  auto call_func = isel_func;
+  if (options.specialize_semantics) {
+    call_func = cache->GetSpecializedFunction(isel_func, arch_inst, args);
+  }
+
   // Update the current program counter. Control-flow instructions may update
   // the program counter in the semantics code.
-  ir.CreateStore(
-      ir.CreateAdd(
-          ir.CreateLoad(pc_ptr),
-          llvm::ConstantInt::get(word_type, arch_inst.NumBytes())),
-      pc_ptr);
+  if (options.reuse_addresses || options.specialize_semantics) {
+    ir.CreateStore(llvm::ConstantInt::get(word_type, arch_inst.next_pc),
+                   pc_ptr);
+  } else {
+    ir.CreateStore(
+        ir.CreateAdd(
+            ir.CreateLoad(pc_ptr),
+            llvm::ConstantInt::get(word_type, arch_inst.NumBytes())),
+        pc_ptr);
+  }
 
   // Pass in current value of the memory pointer.
   args[0] = ir.CreateLoad(mem_ptr);
 
   // Call the function that implements the instruction semantics.
-  ir.CreateStore(ir.CreateCall(isel_func, args), mem_ptr);
+  auto call = ir.CreateCall(call_func, args);
+  ir.CreateStore(call, mem_ptr);
+
+  // Inline straight-line semantics. Inlining a single-block function doesn't
+  // split `block`, so later instructions can still be lifted into it.
+  if (options.specialize_semantics && 1 == call_func->size()) {
+    llvm::InlineFunctionInfo info;
+#if LLVM_VERSION_NUMBER < LLVM_VERSION(11, 0)
+    llvm::InlineFunction(call, info);
+#else
+    llvm::InlineFunction(*call, info);
+#endif
+  }
 
-  // End an atomic block.
-  if (arch_inst.is_atomic_read_modify_write) {
-    std::vector<llvm::Value *> args = {ir.CreateLoad(mem_ptr)};
-    ir.CreateStore(
-        ir.CreateCall(intrinsics->atomic_end, args),
-        mem_ptr);
+  if (options.reuse_addresses) {
+    cache->Invalidate(
+        cache->GetSummary(options.isel_summaries, *isel_name, isel_func),
+        arch_inst);
+    cache->End();
+  }
+
+  if (options.annotate_pcs) {
+    auto &context = block->getContext();
+    auto pc_md = llvm::MDNode::get(context, {
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(3, 6)
+        llvm::ConstantAsMetadata::get(
+            llvm::ConstantInt::get(ir.getInt64Ty(), arch_inst.pc)),
+#else
+        llvm::ConstantInt::get(ir.getInt64Ty(), arch_inst.pc),
+#endif
+        llvm::MDString::get(context, *isel_name)});
+
+    auto pc_md_kind = context.getMDKindID(kGuestPCMetadataName);
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+    llvm::DebugLoc pc_loc(
+        cache->GetGuestLocation(func, arch_inst.pc, *isel_name));
+#endif
+    for (auto inst_it = block->rbegin(); inst_it != block->rend() &&
+                                         &*inst_it != prev_inst; ++inst_it) {
+      inst_it->setMetadata(pc_md_kind, pc_md);
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+      inst_it->setDebugLoc(pc_loc);
+#endif
+    }
+  }
+
+  if (options.profile) {
+    uint64_t num_ir_insts = 0;
+    for (auto inst_it = block->rbegin(); inst_it != block->rend() &&
+                                         &*inst_it != prev_inst; ++inst_it) {
+      ++num_ir_insts;
+    }
+    auto lift_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    options.profile->Record(*isel_name, num_ir_insts,
+                            static_cast<uint64_t>(lift_time.count()));
   }
 
   return true;
@@ -202,6 +804,69 @@ bool InstructionLifter::LiftIntoBlock(
 
 namespace {
 
+// Get the guest `PC` and ISEL name from the debug location of `inst`. This
+// is the location of the guest instruction even if `inst` was inlined.
+static bool GetGuestPCFromDebugLoc(const llvm::Instruction *inst,
+                                   uint64_t *pc, std::string *isel_name) {
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+  auto loc = inst->getDebugLoc().get();
+  if (!loc) {
+    return false;
+  }
+
+  auto dir = loc->getDirectory().str();
+  auto prefix_len = strlen(kGuestDirectoryPrefix);
+  if (dir.size() <= prefix_len ||
+      0 != dir.compare(0, prefix_len, kGuestDirectoryPrefix)) {
+    return false;
+  }
+
+  char *end = nullptr;
+  auto base = strtoull(dir.c_str() + prefix_len, &end, 16);
+  if (*end) {
+    return false;
+  }
+
+  *pc = base + loc->getLine();
+  if (isel_name) {
+    *isel_name = loc->getFilename().str();
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace
+
+bool GetGuestPC(const llvm::Instruction *inst, uint64_t *pc,
+                std::string *isel_name) {
+  auto pc_md = inst->getMetadata(kGuestPCMetadataName);
+  if (!pc_md || 2 != pc_md->getNumOperands()) {
+    return GetGuestPCFromDebugLoc(inst, pc, isel_name);
+  }
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(3, 6)
+  auto pc_val = llvm::mdconst::dyn_extract_or_null<llvm::ConstantInt>(
+      pc_md->getOperand(0));
+#else
+  auto pc_val = llvm::dyn_cast_or_null<llvm::ConstantInt>(
+      pc_md->getOperand(0));
+#endif
+  auto name = llvm::dyn_cast_or_null<llvm::MDString>(pc_md->getOperand(1));
+  if (!pc_val || !name) {
+    return false;
+  }
+
+  *pc = pc_val->getZExtValue();
+  if (isel_name) {
+    *isel_name = name->getString().str();
+  }
+  return true;
+}
+
+namespace {
+
 // Load the address of a register.
 static llvm::Value *LoadRegAddress(llvm::BasicBlock *block,
                                    std::string reg_name) {
@@ -215,17 +880,41 @@ static llvm::Value *LoadRegValue(llvm::BasicBlock *block,
   return new llvm::LoadInst(LoadRegAddress(block, reg_name), "", block);
 }
 
+}  // namespace
+
+// Load the address of a register. Register variables never change, so their
+// addresses can always be reused within a block.
+llvm::Value *InstructionLifter::LoadRegAddress(llvm::BasicBlock *block,
+                                               const std::string &reg_name) {
+  if (!cache->IsActive(block)) {
+    return ::remill::LoadRegAddress(block, reg_name);
+  }
+
+  auto &addr = cache->reg_addrs[reg_name];
+  if (!addr) {
+    addr = ::remill::LoadRegAddress(block, reg_name);
+  }
+  return addr;
+}
+
 // Return a register value, or zero.
-static llvm::Value *LoadWordRegValOrZero(llvm::BasicBlock *block,
-                                         const std::string &reg_name,
-                                         llvm::ConstantInt *zero) {
+llvm::Value *InstructionLifter::LoadWordRegValOrZero(
+    llvm::BasicBlock *block, const std::string &reg_name) {
   if (reg_name.empty()) {
-    return zero;
+    return llvm::ConstantInt::get(word_type, 0, false);
   }
 
-  auto val = LoadRegValue(block, reg_name);
+  auto use_cache = cache->IsActive(block);
+  if (use_cache) {
+    auto reg_it = cache->reg_vals.find(reg_name);
+    if (reg_it != cache->reg_vals.end()) {
+      return reg_it->second.val;
+    }
+  }
+
+  llvm::Value *val = new llvm::LoadInst(
+      LoadRegAddress(block, reg_name), "", block);
   auto val_type = llvm::dyn_cast_or_null<llvm::IntegerType>(val->getType());
-  auto word_type = zero->getType();
 
   CHECK(val_type)
       << "Register " << reg_name << " expected to be an integer.";
@@ -240,11 +929,15 @@ static llvm::Value *LoadWordRegValOrZero(llvm::BasicBlock *block,
     val = new llvm::ZExtInst(val, word_type, "", block);
   }
 
+  if (use_cache) {
+    auto &reg = cache->reg_vals[reg_name];
+    reg.val = val;
+    reg.in_state = cache->GetRegisterRange(reg_name, reg.range);
+  }
+
   return val;
 }
 
-}  // namespace
-
 llvm::Value *InstructionLifter::LiftShiftRegisterOperand(
     Instruction &inst, llvm::BasicBlock *block,
     llvm::Argument *arg, Operand &op) {
@@ -558,12 +1251,35 @@ llvm::Value *InstructionLifter::LiftAddressOperand(
       << "for instruction at " << std::hex << inst.pc
       << " is wider than the machine word size.";
 
-  auto addr = LoadWordRegValOrZero(block, arch_addr.base_reg.name, zero);
-  auto index = LoadWordRegValOrZero(block, arch_addr.index_reg.name, zero);
+  // Reuse an identical address computed earlier in the block.
+  llvm::Value **cached_addr = nullptr;
+  if (cache->IsActive(block)) {
+    auto pc = "PC" == arch_addr.base_reg.name ? inst.pc : 0;
+    AddressKey key{arch_addr.base_reg.name, arch_addr.index_reg.name,
+                   arch_addr.scale, arch_addr.displacement,
+                   arch_addr.segment_base_reg.name,
+                   static_cast<int64_t>(arch_addr.address_size), pc};
+    cached_addr = &(cache->addrs[key]);
+    if (*cached_addr) {
+      return *cached_addr;
+    }
+  }
+
+  llvm::Value *addr = nullptr;
+
+  // The program counter is known at lift time, so fold it into a constant.
+  if ((cached_addr || options.specialize_semantics) &&
+      "PC" == arch_addr.base_reg.name) {
+    addr = llvm::ConstantInt::get(word_type, inst.pc);
+  } else {
+    addr = LoadWordRegValOrZero(block, arch_addr.base_reg.name);
+  }
+
+  auto index = LoadWordRegValOrZero(block, arch_addr.index_reg.name);
   auto scale = llvm::ConstantInt::get(
       word_type, static_cast<uint64_t>(arch_addr.scale), true);
   auto segment = LoadWordRegValOrZero(
-      block, arch_addr.segment_base_reg.name, zero);
+      block, arch_addr.segment_base_reg.name);
 
   llvm::IRBuilder<> ir(block);
 
@@ -597,6 +1313,10 @@ llvm::Value *InstructionLifter::LiftAddressOperand(
         word_type);
   }
 
+  if (cached_addr) {
+    *cached_addr = addr;
+  }
+
   return addr;
 }
 
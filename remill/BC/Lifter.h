@@ -17,20 +17,103 @@
 #ifndef REMILL_BC_LIFTER_H_
 #define REMILL_BC_LIFTER_H_
 
+#include <cstdint>
+#include <string>
+
+#include "remill/BC/ISelSummary.h"
+
 namespace llvm {
 class Argument;
+class BasicBlock;
 class Function;
+class Instruction;
 class Module;
 class GlobalVariable;
 class IntegerType;
+class Value;
 }  // namespace llvm
 
 namespace remill {
 
 class Instruction;
 class IntrinsicTable;
+class LiftingProfile;
 class Operand;
 
+// Options that control how instructions are lifted.
+struct LifterOptions {
+  LifterOptions(void);
+
+  // Reuse the register loads and address computations of memory operands
+  // across the instructions lifted into a block, for as long as the registers
+  // involved are not written, and fold `PC`-relative addresses into constants.
+  //
+  // This assumes that `PC` holds the address of each instruction when it is
+  // lifted, i.e. that the instructions of a block are lifted in program order,
+  // and that code added to a block between lifted instructions doesn't write
+  // to registers.
+  bool reuse_addresses;
+
+  // Specialize semantics functions to the constant operands (e.g. immediates)
+  // of each instruction, and inline the specialized body into the block if it
+  // is straight-line code. Specialized bodies are shared by instructions with
+  // the same ISEL and constant operands, e.g. every `add rsp, 8`. Branch
+  // targets and `PC`-relative addresses are passed to the specialized bodies
+  // as arguments, so that they don't prevent sharing. Bodies that are no
+  // longer called are erased when the lifter is destroyed.
+  //
+  // Like `reuse_addresses`, this assumes that `PC` holds the address of each
+  // instruction when it is lifted.
+  bool specialize_semantics;
+
+  // Attach `!remill.pc` metadata to the LLVM instructions emitted for each
+  // lifted instruction. The metadata holds the instruction's guest `PC` and
+  // ISEL name, e.g. `!{i64 4198400, !"ADD_GPRv_IMMz_64"}`, and is read back
+  // with `GetGuestPC`. It lets profilers attribute native code that is
+  // compiled from the lifted code back to guest instructions (see
+  // `remill/Runtime/PerfMap.h`).
+  //
+  // Metadata is dropped by inlining and by code generation, so on LLVM 4.0
+  // and up, the instructions also get a debug location whose line is the low
+  // 32 bits of the guest `PC`, and whose file is named after the ISEL, in a
+  // directory named after the high bits of the `PC`, e.g. `guest_0`. Debug
+  // locations survive inlining, and end up in the line table of the native
+  // code. The debug info of a module is finished when the lifter is
+  // destroyed, or starts lifting into another module, and the module should
+  // not be compiled before then.
+  bool annotate_pcs;
+
+  // Summaries of the semantics functions, e.g. from `LoadISelSummaries`.
+  // `reuse_addresses` uses them to find the registers that an instruction
+  // might write. Semantics functions without a summary are summarized when
+  // they are first lifted.
+  const ISelSummaryMap *isel_summaries;
+
+  // If non-null, then the number of instructions lifted, the number of LLVM
+  // instructions emitted, and the time taken are recorded for each ISEL.
+  LiftingProfile *profile;
+
+  // Add code to lifted blocks that counts how many times each block, or each
+  // ISEL, executes. Counters are created by `GetOrCreateExecutionCounter`,
+  // and are gathered into a table by `EmitExecutionCounterTable`.
+  enum ExecutionCounters {
+    kNoExecutionCounters,
+    kCountBlockExecutions,
+    kCountISelExecutions
+  } execution_counters;
+};
+
+// Get the guest program counter, and optionally the ISEL name, of the lifted
+// instruction from which `inst` was produced. This uses the `!remill.pc`
+// metadata of `inst` if it has any, and otherwise its debug location, e.g.
+// if `inst` was inlined. Returns `false` if `inst` has neither, e.g. because
+// it wasn't lifted with `LifterOptions::annotate_pcs`, or because an
+// optimization replaced it.
+bool GetGuestPC(const llvm::Instruction *inst, uint64_t *pc,
+                std::string *isel_name=nullptr);
+
+class LifterCache;
+
 // Wraps the process of lifting an instruction into a block. This resolves
 // the intended instruction target to a function, and ensures that the function
 // is called with the appropriate arguments.
@@ -39,7 +122,8 @@ class InstructionLifter {
   virtual ~InstructionLifter(void);
 
   InstructionLifter(llvm::IntegerType *word_type_,
-                    const IntrinsicTable *intrinsics_);
+                    const IntrinsicTable *intrinsics_,
+                    const LifterOptions &options_=LifterOptions());
 
   // Lift a single instruction into a basic block.
   virtual bool LiftIntoBlock(
@@ -51,6 +135,9 @@ class InstructionLifter {
   // Set of intrinsics.
   const IntrinsicTable * const intrinsics;
 
+  // Options that control lifting.
+  const LifterOptions options;
+
  protected:
   // Lift an operand to an instruction.
   virtual llvm::Value *LiftOperand(Instruction &inst,
@@ -82,8 +169,22 @@ class InstructionLifter {
                                           llvm::Argument *arg,
                                           Operand &mem);
 
+  // Load the address of the register variable `reg_name`.
+  llvm::Value *LoadRegAddress(llvm::BasicBlock *block,
+                              const std::string &reg_name);
+
+  // Load the value of a register, zero-extended to the machine word size, or
+  // return zero if `reg_name` is empty.
+  llvm::Value *LoadWordRegValOrZero(llvm::BasicBlock *block,
+                                    const std::string &reg_name);
+
  private:
   InstructionLifter(void) = delete;
+  InstructionLifter(const InstructionLifter &) = delete;
+  InstructionLifter &operator=(const InstructionLifter &) = delete;
+
+  // Register loads and addresses that are reused within a block.
+  LifterCache * const cache;
 };
 
 }  // namespace remill
@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <llvm/ADT/Triple.h>
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <llvm/Transforms/IPO.h>
+#include <llvm/Transforms/InstCombine/InstCombine.h>
+#include <llvm/Transforms/Scalar.h>
+
+#include "remill/BC/Compat/TargetLibraryInfo.h"
+#include "remill/BC/Optimizer.h"
+#include "remill/BC/Profile.h"
+#include "remill/BC/RemillAA.h"
+#include "remill/BC/Util.h"
+#include "remill/BC/Version.h"
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+# include <llvm/Transforms/IPO/AlwaysInliner.h>
+# include <llvm/Transforms/Scalar/GVN.h>
+#endif
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(3, 9)
+# include <llvm/Linker/Linker.h>
+# include <llvm/Transforms/Utils/Cloning.h>
+# include "remill/BC/Compat/BitcodeReaderWriter.h"
+# include "remill/BC/Compat/IRReader.h"
+# define REMILL_PARALLEL_OPTIMIZER 1
+#else
+# define REMILL_PARALLEL_OPTIMIZER 0
+#endif
+
+namespace remill {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t NanosecondsSince(Clock::time_point start) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now() - start).count());
+}
+
+static llvm::FunctionPass *CreateSROAPass(void) {
+  return llvm::createSROAPass();
+}
+
+static llvm::FunctionPass *CreateEarlyCSEPass(void) {
+  return llvm::createEarlyCSEPass();
+}
+
+static llvm::FunctionPass *CreateInstCombinePass(void) {
+  return llvm::createInstructionCombiningPass();
+}
+
+static llvm::FunctionPass *CreateSimplifyCFGPass(void) {
+  return llvm::createCFGSimplificationPass();
+}
+
+static llvm::FunctionPass *CreateGVNPass(void) {
+  return llvm::createGVNPass();
+}
+
+static llvm::FunctionPass *CreateDSEPass(void) {
+  return llvm::createDeadStoreEliminationPass();
+}
+
+static llvm::FunctionPass *CreateADCEPass(void) {
+  return llvm::createAggressiveDCEPass();
+}
+
+struct FunctionPassInfo {
+  const char *name;
+  llvm::FunctionPass *(*create)(void);
+};
+
+// The function pipeline. SROA first promotes the lifted function's local
+// variables (e.g. `BRANCH_TAKEN`) and the temporaries of the inlined
+// semantics. GVN and DSE then forward and remove redundant `State` loads and
+// stores, which remill's alias analysis lets them see across the memory
+// intrinsics.
+static const FunctionPassInfo kFunctionPipeline[] = {
+  {"sroa", CreateSROAPass},
+  {"early-cse", CreateEarlyCSEPass},
+  {"instcombine", CreateInstCombinePass},
+  {"simplifycfg", CreateSimplifyCFGPass},
+  {"gvn", CreateGVNPass},
+  {"dse", CreateDSEPass},
+  {"adce", CreateADCEPass},
+  {"simplifycfg", CreateSimplifyCFGPass},
+};
+
+static llvm::Pass *CreateAlwaysInlinerPass(void) {
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+  return llvm::createAlwaysInlinerLegacyPass();
+#else
+  return llvm::createAlwaysInlinerPass();
+#endif
+}
+
+// Run the function pipeline over `funcs`. Each pass runs in its own pass
+// manager, so that it can be timed on its own.
+static void RunFunctionPipeline(llvm::Module *module,
+                                const std::vector<llvm::Function *> &funcs,
+                                OptimizationProfile *profile) {
+  const llvm::Triple triple(module->getTargetTriple());
+  for (const auto &pass_info : kFunctionPipeline) {
+    auto start = Clock::now();
+    llvm::legacy::FunctionPassManager func_manager(module);
+    func_manager.add(new llvm::TargetLibraryInfoWrapperPass(triple));
+    AddRemillAliasAnalysis(func_manager);
+    func_manager.add(pass_info.create());
+    func_manager.doInitialization();
+    for (auto func : funcs) {
+      func_manager.run(*func);
+    }
+    func_manager.doFinalization();
+    if (profile) {
+      profile->Record(pass_info.name, NanosecondsSince(start));
+    }
+  }
+}
+
+// Returns the functions whose code was produced by the lifter, in module
+// order. These are all of the defined functions except for the semantics
+// functions and remill's own helpers (e.g. `__remill_basic_block`).
+static std::vector<llvm::Function *> LiftedFunctions(llvm::Module *module) {
+  std::unordered_set<llvm::Function *> sems;
+  ForEachISel(module, [&sems] (llvm::GlobalVariable *, llvm::Function *sem) {
+    if (sem) {
+      sems.insert(sem);
+    }
+  });
+
+  std::vector<llvm::Function *> funcs;
+  for (auto &func : *module) {
+    if (!func.isDeclaration() && !sems.count(&func) &&
+        !func.getName().startswith("__remill")) {
+      funcs.push_back(&func);
+    }
+  }
+  return funcs;
+}
+
+// Inline every semantics function into the lifted code.
+static void InlineSemantics(llvm::Module *module) {
+  ForEachISel(module, [] (llvm::GlobalVariable *, llvm::Function *sem) {
+    if (sem) {
+      sem->removeFnAttr(llvm::Attribute::NoInline);
+      sem->addFnAttr(llvm::Attribute::AlwaysInline);
+    }
+  });
+
+  llvm::legacy::PassManager module_manager;
+  module_manager.add(CreateAlwaysInlinerPass());
+  module_manager.run(*module);
+}
+
+// Replace calls to the `__remill_undefined_*` intrinsics in `funcs` with
+// `undef`. Calls elsewhere (e.g. in `__remill_intrinsics`, which keeps the
+// intrinsics alive) are left alone.
+static void RemoveUndefinedIntrinsics(
+    llvm::Module *module, const std::vector<llvm::Function *> &funcs) {
+  static const char * const kUndefinedIntrinsics[] = {
+    "__remill_undefined_8",
+    "__remill_undefined_16",
+    "__remill_undefined_32",
+    "__remill_undefined_64",
+    "__remill_undefined_f32",
+    "__remill_undefined_f64",
+  };
+
+  std::unordered_set<llvm::Function *> lifted_funcs(funcs.begin(),
+                                                    funcs.end());
+  for (auto name : kUndefinedIntrinsics) {
+    for (auto call : CallersOf(module->getFunction(name))) {
+      if (lifted_funcs.count(call->getParent()->getParent())) {
+        call->replaceAllUsesWith(llvm::UndefValue::get(call->getType()));
+        call->eraseFromParent();
+      }
+    }
+  }
+}
+
+#if REMILL_PARALLEL_OPTIMIZER
+
+// The original linkage of a global value that was made external so that it
+// could be referenced by name from a partition.
+struct LocalValue {
+  std::string name;
+  llvm::GlobalValue::LinkageTypes linkage;
+  llvm::GlobalValue::VisibilityTypes visibility;
+  bool was_unnamed;
+};
+
+static void ExternalizeLocal(llvm::GlobalValue &gv,
+                             std::vector<LocalValue> &locals) {
+  if (!gv.hasLocalLinkage()) {
+    return;
+  }
+  auto was_unnamed = !gv.hasName();
+  if (was_unnamed) {
+    gv.setName("__remill_unnamed");
+  }
+  locals.push_back({gv.getName().str(), gv.getLinkage(), gv.getVisibility(),
+                    was_unnamed});
+  gv.setLinkage(llvm::GlobalValue::ExternalLinkage);
+  gv.setVisibility(llvm::GlobalValue::HiddenVisibility);
+}
+
+// Give every local global value external linkage. Values are recorded by name
+// because linking a partition back in replaces the functions that it defines.
+static std::vector<LocalValue> ExternalizeLocals(llvm::Module *module) {
+  std::vector<LocalValue> locals;
+  for (auto &func : *module) {
+    ExternalizeLocal(func, locals);
+  }
+  for (auto &var : module->globals()) {
+    ExternalizeLocal(var, locals);
+  }
+  for (auto &alias : module->aliases()) {
+    ExternalizeLocal(alias, locals);
+  }
+  return locals;
+}
+
+static void RestoreLocals(llvm::Module *module,
+                          const std::vector<LocalValue> &locals) {
+  for (const auto &local : locals) {
+    auto gv = module->getNamedValue(local.name);
+    CHECK(gv != nullptr)
+        << "Lost global value " << local.name << " while optimizing";
+    gv->setLinkage(local.linkage);
+    gv->setVisibility(local.visibility);
+    if (local.was_unnamed) {
+      gv->setName("");
+    }
+  }
+}
+
+static uint64_t NumInstructions(llvm::Function *func) {
+  uint64_t num_insts = 0;
+  for (auto &block : *func) {
+    num_insts += block.size();
+  }
+  return num_insts;
+}
+
+// Divide `funcs` into `num_partitions` partitions of roughly equal numbers of
+// instructions. Ties are broken by module order, so this is deterministic.
+static std::vector<std::vector<llvm::Function *>> PartitionFunctions(
+    const std::vector<llvm::Function *> &funcs, size_t num_partitions) {
+  std::vector<std::pair<uint64_t, size_t>> sizes;
+  for (size_t i = 0; i < funcs.size(); ++i) {
+    sizes.emplace_back(NumInstructions(funcs[i]), i);
+  }
+  std::stable_sort(sizes.begin(), sizes.end(),
+                   [] (const std::pair<uint64_t, size_t> &a,
+                       const std::pair<uint64_t, size_t> &b) {
+                     return a.first > b.first;
+                   });
+
+  std::vector<std::vector<llvm::Function *>> partitions(num_partitions);
+  std::vector<uint64_t> partition_sizes(num_partitions, 0);
+  for (const auto &size : sizes) {
+    auto smallest = std::min_element(partition_sizes.begin(),
+                                     partition_sizes.end());
+    *smallest += size.first;
+    partitions[smallest - partition_sizes.begin()].push_back(
+        funcs[size.second]);
+  }
+  return partitions;
+}
+
+// Copy the definitions of `funcs` into a new module, and serialize it.
+// Everything else that they reference is declared.
+static std::string ExtractPartition(
+    llvm::Module *module, const std::vector<llvm::Function *> &funcs) {
+  std::unordered_set<const llvm::GlobalValue *> defs(funcs.begin(),
+                                                     funcs.end());
+  llvm::ValueToValueMapTy value_map;
+  auto part = llvm::CloneModule(
+      module, value_map, [&defs] (const llvm::GlobalValue *gv) {
+        return 0 != defs.count(gv);
+      });
+
+  // Appending globals (e.g. `llvm.global_ctors`) can't be declared, and
+  // would be duplicated if they were defined in every partition.
+  std::vector<llvm::GlobalVariable *> appending_vars;
+  for (auto &var : part->globals()) {
+    if (var.hasAppendingLinkage()) {
+      appending_vars.push_back(&var);
+    }
+  }
+  for (auto var : appending_vars) {
+    var->eraseFromParent();
+  }
+
+  std::string bitcode;
+  llvm::raw_string_ostream os(bitcode);
+  llvm::WriteBitcodeToFile(part.get(), os);
+  os.flush();
+  return bitcode;
+}
+
+// Optimize a serialized partition in a context of its own.
+static void OptimizePartition(std::string &bitcode,
+                              OptimizationProfile *profile) {
+  llvm::LLVMContext context;
+  llvm::SMDiagnostic diag;
+  auto module = llvm::parseIR(
+      llvm::MemoryBufferRef(bitcode, "partition"), diag, context);
+  CHECK(module != nullptr)
+      << "Unable to parse partition: " << diag.getMessage().str();
+
+  std::vector<llvm::Function *> funcs;
+  for (auto &func : *module) {
+    if (!func.isDeclaration()) {
+      funcs.push_back(&func);
+    }
+  }
+
+  RunFunctionPipeline(module.get(), funcs, profile);
+
+  bitcode.clear();
+  llvm::raw_string_ostream os(bitcode);
+  llvm::WriteBitcodeToFile(module.get(), os);
+  os.flush();
+}
+
+static void RunFunctionPipelineInParallel(
+    llvm::Module *module, const std::vector<llvm::Function *> &funcs,
+    unsigned num_threads, OptimizationProfile *profile) {
+  auto start = Clock::now();
+  auto locals = ExternalizeLocals(module);
+  std::vector<std::string> partitions;
+  for (const auto &part_funcs : PartitionFunctions(funcs, num_threads)) {
+    partitions.push_back(ExtractPartition(module, part_funcs));
+  }
+  if (profile) {
+    profile->Record("extract-partitions", NanosecondsSince(start));
+  }
+
+  std::vector<OptimizationProfile> thread_profiles(num_threads);
+  std::atomic<size_t> next_partition(0);
+  auto optimize = [&] (OptimizationProfile *thread_profile) {
+    for (auto i = next_partition++; i < partitions.size();
+         i = next_partition++) {
+      OptimizePartition(partitions[i], thread_profile);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (auto i = 1U; i < num_threads; ++i) {
+    threads.emplace_back(optimize, &(thread_profiles[i]));
+  }
+  optimize(&(thread_profiles[0]));
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  if (profile) {
+    for (const auto &thread_profile : thread_profiles) {
+      profile->Merge(thread_profile);
+    }
+  }
+
+  // Link the partitions back in, in order. Their definitions replace the
+  // unoptimized ones.
+  start = Clock::now();
+  for (const auto &bitcode : partitions) {
+    llvm::SMDiagnostic diag;
+    auto part = llvm::parseIR(
+        llvm::MemoryBufferRef(bitcode, "partition"), diag,
+        module->getContext());
+    CHECK(part != nullptr)
+        << "Unable to parse optimized partition: "
+        << diag.getMessage().str();
+    CHECK(!llvm::Linker::linkModules(*module, std::move(part),
+                                     llvm::Linker::OverrideFromSrc))
+        << "Unable to link optimized partition back into module";
+  }
+  RestoreLocals(module, locals);
+  if (profile) {
+    profile->Record("link-partitions", NanosecondsSince(start));
+  }
+}
+
+#endif  // REMILL_PARALLEL_OPTIMIZER
+
+}  // namespace
+
+OptimizationOptions::OptimizationOptions(void)
+    : num_threads(0),
+      remove_undefined_intrinsics(true),
+      profile(nullptr) {}
+
+void OptimizeLiftedModule(llvm::Module *module,
+                          const OptimizationOptions &options) {
+  auto profile = options.profile;
+  auto start = Clock::now();
+  InlineSemantics(module);
+  if (profile) {
+    profile->Record("always-inline", NanosecondsSince(start));
+  }
+
+  auto funcs = LiftedFunctions(module);
+  if (options.remove_undefined_intrinsics) {
+    start = Clock::now();
+    RemoveUndefinedIntrinsics(module, funcs);
+    if (profile) {
+      profile->Record("remove-undefined-intrinsics", NanosecondsSince(start));
+    }
+  }
+
+  auto num_threads = options.num_threads;
+  if (!num_threads) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  num_threads = static_cast<unsigned>(
+      std::min<size_t>(num_threads, funcs.size()));
+
+#if REMILL_PARALLEL_OPTIMIZER
+  if (1 < num_threads) {
+    RunFunctionPipelineInParallel(module, funcs, num_threads, profile);
+    return;
+  }
+#endif
+
+  RunFunctionPipeline(module, funcs, profile);
+}
+
+}  // namespace remill
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_BC_OPTIMIZER_H_
+#define REMILL_BC_OPTIMIZER_H_
+
+namespace llvm {
+class Module;
+}  // namespace llvm
+
+namespace remill {
+
+class OptimizationProfile;
+
+struct OptimizationOptions {
+  OptimizationOptions(void);
+
+  // Number of threads to run the function passes on. Zero means one per
+  // hardware thread.
+  unsigned num_threads;
+
+  // Replace calls to the `__remill_undefined_*` intrinsics with `undef`.
+  bool remove_undefined_intrinsics;
+
+  // If non-null, then the time spent in each pass is added to this profile.
+  OptimizationProfile *profile;
+};
+
+// Optimize the lifted code in `module` with a pipeline that is tuned for the
+// code that remill produces:
+//
+//  1)  Every semantics function is inlined into the lifted code that uses it.
+//  2)  Calls to `__remill_undefined_*` are replaced with `undef` values, so
+//      that later passes can fold them away.
+//  3)  A short function pipeline (SROA, early CSE, instcombine, GVN, DSE,
+//      ADCE and CFG simplification) runs over every lifted function, with
+//      remill's alias analysis (see `remill/BC/RemillAA.h`) so that accesses
+//      to `State` aren't clobbered by the memory intrinsics.
+//
+// The function pipeline of step 3 runs on `options.num_threads` threads. An
+// `LLVMContext` can't be used from multiple threads, so the lifted functions
+// are divided into one partition per thread, and each partition is optimized
+// as a separate module in its own context and then linked back into `module`.
+// The partitioning is deterministic, so the optimized module doesn't depend
+// on how the threads are scheduled.
+//
+// The semantics functions themselves are left in `module`, but aren't
+// optimized.
+void OptimizeLiftedModule(llvm::Module *module,
+                          const OptimizationOptions &options);
+
+}  // namespace remill
+
+#endif  // REMILL_BC_OPTIMIZER_H_
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <vector>
+
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+
+#include "remill/BC/Profile.h"
+
+namespace remill {
+namespace {
+
+// Write `str` as a JSON string.
+static void WriteJSONString(std::ostream &os, const std::string &str) {
+  os << '"';
+  for (auto c : str) {
+    if ('"' == c || '\\' == c) {
+      os << '\\';
+    }
+    os << c;
+  }
+  os << '"';
+}
+
+// Write `str` as a quoted CSV field. Quotes are escaped by doubling them.
+static void WriteCSVString(std::ostream &os, const std::string &str) {
+  os << '"';
+  for (auto c : str) {
+    if ('"' == c) {
+      os << '"';
+    }
+    os << c;
+  }
+  os << '"';
+}
+
+// Parse all of `str` as an unsigned number in base `base`.
+static bool ParseNumber(const std::string &str, int base, uint64_t *num) {
+  if (str.empty() || !isxdigit(str[0])) {
+    return false;
+  }
+  char *end = nullptr;
+  errno = 0;
+  *num = strtoull(str.c_str(), &end, base);
+  return !errno && end == &(str[0]) + str.size();
+}
+
+}  // namespace
+
+const char * const kExecutionCounterPrefix = "__remill_count_";
+
+ISelLiftStats::ISelLiftStats(void)
+    : num_lifted(0),
+      num_ir_insts(0),
+      lift_time_ns(0) {}
+
+void LiftingProfile::Record(const std::string &isel_name,
+                            uint64_t num_ir_insts, uint64_t lift_time_ns) {
+  auto &stats = isels[isel_name];
+  stats.num_lifted += 1;
+  stats.num_ir_insts += num_ir_insts;
+  stats.lift_time_ns += lift_time_ns;
+}
+
+void LiftingProfile::WriteJSON(std::ostream &os) const {
+  os << "{\"isels\": [";
+  auto sep = "";
+  for (const auto &entry : isels) {
+    const auto &stats = entry.second;
+    os << sep << "{\"name\": ";
+    WriteJSONString(os, entry.first);
+    os << ", \"num_lifted\": " << stats.num_lifted
+       << ", \"num_ir_insts\": " << stats.num_ir_insts
+       << ", \"lift_time_ns\": " << stats.lift_time_ns << "}";
+    sep = ", ";
+  }
+  os << "]}" << std::endl;
+}
+
+void LiftingProfile::WriteCSV(std::ostream &os) const {
+  os << "name,num_lifted,num_ir_insts,lift_time_ns" << std::endl;
+  for (const auto &entry : isels) {
+    const auto &stats = entry.second;
+    os << entry.first << "," << stats.num_lifted << ","
+       << stats.num_ir_insts << "," << stats.lift_time_ns << std::endl;
+  }
+}
+
+PassStats::PassStats(void)
+    : num_runs(0),
+      time_ns(0) {}
+
+void OptimizationProfile::Record(const std::string &pass_name,
+                                 uint64_t time_ns) {
+  auto &stats = passes[pass_name];
+  stats.num_runs += 1;
+  stats.time_ns += time_ns;
+}
+
+void OptimizationProfile::Merge(const OptimizationProfile &that) {
+  for (const auto &entry : that.passes) {
+    auto &stats = passes[entry.first];
+    stats.num_runs += entry.second.num_runs;
+    stats.time_ns += entry.second.time_ns;
+  }
+}
+
+void OptimizationProfile::WriteJSON(std::ostream &os) const {
+  os << "{\"passes\": [";
+  auto sep = "";
+  for (const auto &entry : passes) {
+    const auto &stats = entry.second;
+    os << sep << "{\"name\": ";
+    WriteJSONString(os, entry.first);
+    os << ", \"num_runs\": " << stats.num_runs
+       << ", \"time_ns\": " << stats.time_ns << "}";
+    sep = ", ";
+  }
+  os << "]}" << std::endl;
+}
+
+void OptimizationProfile::WriteCSV(std::ostream &os) const {
+  os << "name,num_runs,time_ns" << std::endl;
+  for (const auto &entry : passes) {
+    const auto &stats = entry.second;
+    WriteCSVString(os, entry.first);
+    os << "," << stats.num_runs << "," << stats.time_ns << std::endl;
+  }
+}
+
+bool BlockProfile::Parse(std::istream &is) {
+  std::string line;
+  while (std::getline(is, line)) {
+    if (!line.empty() && '\r' == line.back()) {
+      line.pop_back();
+    }
+
+    auto comma = line.find(',');
+    if (std::string::npos == comma) {
+      continue;
+    }
+
+    auto name = line.substr(0, comma);
+    auto is_block = 0 == name.find("block_");
+    auto is_edge = 0 == name.find("edge_");
+    if (!is_block && !is_edge) {
+      continue;
+    }
+
+    uint64_t count = 0;
+    if (!ParseNumber(line.substr(comma + 1), 10, &count)) {
+      LOG(ERROR)
+          << "Invalid count in block profile line: " << line;
+      return false;
+    }
+
+    if (is_block) {
+      uint64_t pc = 0;
+      if (!ParseNumber(name.substr(6), 16, &pc)) {
+        LOG(ERROR)
+            << "Invalid block address in block profile line: " << line;
+        return false;
+      }
+      blocks[pc] += count;
+
+    } else {
+      auto sep = name.find('_', 5);
+      uint64_t from_pc = 0;
+      uint64_t to_pc = 0;
+      if (std::string::npos == sep ||
+          !ParseNumber(name.substr(5, sep - 5), 16, &from_pc) ||
+          !ParseNumber(name.substr(sep + 1), 16, &to_pc)) {
+        LOG(ERROR)
+            << "Invalid edge addresses in block profile line: " << line;
+        return false;
+      }
+      edges[{from_pc, to_pc}] += count;
+    }
+  }
+  return true;
+}
+
+uint64_t BlockProfile::BlockCount(uint64_t pc) const {
+  auto it = blocks.find(pc);
+  return it == blocks.end() ? 0 : it->second;
+}
+
+uint64_t BlockProfile::EdgeCount(uint64_t from_pc, uint64_t to_pc) const {
+  auto it = edges.find({from_pc, to_pc});
+  return it == edges.end() ? 0 : it->second;
+}
+
+bool BlockProfile::HasEdgesFrom(uint64_t pc) const {
+  auto it = edges.lower_bound({pc, 0});
+  return it != edges.end() && it->first.first == pc;
+}
+
+// Get or create the 64-bit execution counter named `name`.
+llvm::GlobalVariable *GetOrCreateExecutionCounter(llvm::Module *module,
+                                                  const std::string &name) {
+  auto counter_name = kExecutionCounterPrefix + name;
+  if (auto counter = module->getGlobalVariable(counter_name, true)) {
+    return counter;
+  }
+
+  auto count_type = llvm::Type::getInt64Ty(module->getContext());
+  return new llvm::GlobalVariable(
+      *module, count_type, false, llvm::GlobalValue::InternalLinkage,
+      llvm::ConstantInt::get(count_type, 0), counter_name);
+}
+
+// Add code to the end of `block` that increments `counter`. The increment is
+// not atomic; counts from concurrently running lifted code are approximate.
+void AddExecutionCounterIncrement(llvm::BasicBlock *block,
+                                  llvm::GlobalVariable *counter) {
+  llvm::IRBuilder<> ir(block);
+  auto count = ir.CreateLoad(counter);
+  ir.CreateStore(
+      ir.CreateAdd(count, llvm::ConstantInt::get(count->getType(), 1)),
+      counter);
+}
+
+// Create the side table of all execution counters in `module`.
+void EmitExecutionCounterTable(llvm::Module *module) {
+  auto &context = module->getContext();
+  auto name_type = llvm::Type::getInt8PtrTy(context);
+  auto count_ptr_type = llvm::Type::getInt64PtrTy(context);
+  std::vector<llvm::Type *> entry_fields = {name_type, count_ptr_type};
+  auto entry_type = llvm::StructType::get(context, entry_fields);
+
+  std::vector<llvm::GlobalVariable *> counters;
+  for (auto &global : module->globals()) {
+    if (global.getName().startswith(kExecutionCounterPrefix)) {
+      counters.push_back(&global);
+    }
+  }
+
+  std::vector<llvm::Constant *> entries;
+  for (auto counter : counters) {
+    auto name = counter->getName().substr(
+        std::string(kExecutionCounterPrefix).size());
+    auto name_data = llvm::ConstantDataArray::getString(context, name);
+    auto name_var = new llvm::GlobalVariable(
+        *module, name_data->getType(), true,
+        llvm::GlobalValue::PrivateLinkage, name_data);
+
+    std::vector<llvm::Constant *> fields = {
+        llvm::ConstantExpr::getPointerCast(name_var, name_type),
+        counter};
+    entries.push_back(llvm::ConstantStruct::get(entry_type, fields));
+  }
+
+  // Replace any table from an earlier call.
+  if (auto old_table = module->getGlobalVariable(
+          "__remill_execution_counters")) {
+    old_table->eraseFromParent();
+  }
+  if (auto old_size = module->getGlobalVariable(
+          "__remill_num_execution_counters")) {
+    old_size->eraseFromParent();
+  }
+
+  auto table_type = llvm::ArrayType::get(entry_type, entries.size());
+  (void) new llvm::GlobalVariable(
+      *module, table_type, true, llvm::GlobalValue::ExternalLinkage,
+      llvm::ConstantArray::get(table_type, entries),
+      "__remill_execution_counters");
+
+  auto size_type = llvm::Type::getInt64Ty(context);
+  (void) new llvm::GlobalVariable(
+      *module, size_type, true, llvm::GlobalValue::ExternalLinkage,
+      llvm::ConstantInt::get(size_type, entries.size()),
+      "__remill_num_execution_counters");
+}
+
+}  // namespace remill
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_BC_PROFILE_H_
+#define REMILL_BC_PROFILE_H_
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace llvm {
+class BasicBlock;
+class GlobalVariable;
+class Module;
+}  // namespace llvm
+
+namespace remill {
+
+// Statistics about the lifting of all instructions that use one semantics
+// function.
+struct ISelLiftStats {
+  ISelLiftStats(void);
+
+  // Number of instructions lifted.
+  uint64_t num_lifted;
+
+  // Number of LLVM instructions emitted into the lifted blocks.
+  uint64_t num_ir_insts;
+
+  // Total time spent in `InstructionLifter::LiftIntoBlock`.
+  uint64_t lift_time_ns;
+};
+
+// Per-ISEL statistics, collected by an `InstructionLifter` whose options
+// point to an instance of this class.
+class LiftingProfile {
+ public:
+  void Record(const std::string &isel_name, uint64_t num_ir_insts,
+              uint64_t lift_time_ns);
+
+  // Write out the profile as a JSON object of the form:
+  //
+  //    {"isels": [{"name": "ADD_GPRv_GPRv_32", "num_lifted": 10,
+  //                "num_ir_insts": 70, "lift_time_ns": 4000}, ...]}
+  void WriteJSON(std::ostream &os) const;
+
+  // Write out the profile as CSV, with a header row.
+  void WriteCSV(std::ostream &os) const;
+
+  std::map<std::string, ISelLiftStats> isels;
+};
+
+// Statistics about one pass of an optimization pipeline.
+struct PassStats {
+  PassStats(void);
+
+  // Number of times the pass was run. Function passes that run in parallel
+  // are run once per partition of the module.
+  uint64_t num_runs;
+
+  // Total time spent running the pass, summed over all threads.
+  uint64_t time_ns;
+};
+
+// Per-pass statistics, collected by `OptimizeLiftedModule` when its options
+// point to an instance of this class.
+class OptimizationProfile {
+ public:
+  void Record(const std::string &pass_name, uint64_t time_ns);
+
+  // Add all of the statistics in `that` to this profile.
+  void Merge(const OptimizationProfile &that);
+
+  // Write out the profile as a JSON object of the form:
+  //
+  //    {"passes": [{"name": "gvn", "num_runs": 8, "time_ns": 4000}, ...]}
+  void WriteJSON(std::ostream &os) const;
+
+  // Write out the profile as CSV, with a header row. Pass names are quoted,
+  // because they can contain commas.
+  void WriteCSV(std::ostream &os) const;
+
+  std::map<std::string, PassStats> passes;
+};
+
+// Execution counts of lifted blocks, and optionally of the control-flow edges
+// between them, keyed by guest address. This reads the CSV that
+// `WriteExecutionCountersCSV` writes for code that was lifted with
+// `LifterOptions::kCountBlockExecutions`, i.e. lines of the form:
+//
+//    block_401000,120
+//
+// Edge counts, which can come from any other profiler, are lines of the form:
+//
+//    edge_401000_401020,100
+//
+// Other lines, e.g. the header row and ISEL counters, are ignored. Counts are
+// added up, so several profiles can be parsed into one.
+class BlockProfile {
+ public:
+  // Returns `false` if a line of `is` names a block or an edge, but doesn't
+  // have a valid address or count.
+  bool Parse(std::istream &is);
+
+  uint64_t BlockCount(uint64_t pc) const;
+  uint64_t EdgeCount(uint64_t from_pc, uint64_t to_pc) const;
+
+  // Returns `true` if any edges that leave the block at `pc` were counted.
+  bool HasEdgesFrom(uint64_t pc) const;
+
+  std::map<uint64_t, uint64_t> blocks;
+  std::map<std::pair<uint64_t, uint64_t>, uint64_t> edges;
+};
+
+// Prefix of the names of global variables that count executions of lifted
+// code.
+extern const char * const kExecutionCounterPrefix;
+
+// Get or create the 64-bit execution counter named `name`.
+llvm::GlobalVariable *GetOrCreateExecutionCounter(llvm::Module *module,
+                                                  const std::string &name);
+
+// Add code to the end of `block` that increments `counter`.
+void AddExecutionCounterIncrement(llvm::BasicBlock *block,
+                                  llvm::GlobalVariable *counter);
+
+// Create the side table of all execution counters in `module`. This defines
+// `__remill_execution_counters`, an array of `ExecutionCounter` structures (see
+// `remill/Runtime/ExecutionCounters.h`), and `__remill_num_execution_counters`.
+// This should be called once all code has been lifted into `module`.
+void EmitExecutionCounterTable(llvm::Module *module);
+
+}  // namespace remill
+
+#endif  // REMILL_BC_PROFILE_H_
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+
+#include <llvm/IR/LegacyPassManager.h>
+
+#include "remill/BC/RemillAA.h"
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DataLayout.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Pass.h>
+
+namespace remill {
+namespace {
+
+enum IntrinsicKind {
+  kNotAnIntrinsic,
+  kUndefinedIntrinsic,
+  kReadIntrinsic,
+  kWriteIntrinsic,
+  kBarrierIntrinsic,
+  kAtomicIntrinsic
+};
+
+// Classify a called function by what it can do to memory.
+static IntrinsicKind GetIntrinsicKind(const llvm::Function *func) {
+  if (!func || !func->hasName()) {
+    return kNotAnIntrinsic;
+  }
+
+  auto name = func->getName();
+  if (!name.startswith("__remill_")) {
+    return kNotAnIntrinsic;
+
+  } else if (name.startswith("__remill_undefined_")) {
+    return kUndefinedIntrinsic;
+
+  } else if (name.startswith("__remill_read_memory_")) {
+    return kReadIntrinsic;
+
+  } else if (name.startswith("__remill_write_memory_")) {
+    return kWriteIntrinsic;
+
+  } else if (name.startswith("__remill_barrier_") ||
+             name == "__remill_atomic_begin" ||
+             name == "__remill_atomic_end") {
+    return kBarrierIntrinsic;
+
+  } else if (name.startswith("__remill_compare_exchange_memory_") ||
+             name.startswith("__remill_exchange_memory_") ||
+             name.startswith("__remill_fetch_and_")) {
+    return kAtomicIntrinsic;
+
+  } else {
+    return kNotAnIntrinsic;
+  }
+}
+
+enum ObjectKind {
+  kUnknownObject,
+  kStateObject,
+  kLocalObject,
+  kGuestObject
+};
+
+// Returns true if `type` is a pointer to an architecture's `State` structure.
+// Linking modules together can rename the structure to e.g. `struct.State.1`.
+static bool IsStatePointerType(llvm::Type *type) {
+  auto ptr_type = llvm::dyn_cast<llvm::PointerType>(type);
+  if (!ptr_type) {
+    return false;
+  }
+  auto struct_type = llvm::dyn_cast<llvm::StructType>(
+      ptr_type->getElementType());
+  if (!struct_type || !struct_type->hasName()) {
+    return false;
+  }
+  auto name = struct_type->getName();
+  return name == "struct.State" || name.startswith("struct.State.");
+}
+
+// Classify the underlying object of a pointer. The `State` structure is only
+// ever reachable through the state pointer argument of a lifted block or of
+// a semantics function, and guest memory is only ever reachable through
+// integer addresses.
+static ObjectKind GetObjectKind(const llvm::Value *obj) {
+  if (llvm::isa<llvm::AllocaInst>(obj)) {
+    return kLocalObject;
+
+  } else if (auto arg = llvm::dyn_cast<llvm::Argument>(obj)) {
+    return IsStatePointerType(arg->getType()) ? kStateObject : kUnknownObject;
+
+  } else if (llvm::isa<llvm::IntToPtrInst>(obj)) {
+    return kGuestObject;
+
+  } else if (auto ce = llvm::dyn_cast<llvm::ConstantExpr>(obj)) {
+    if (llvm::Instruction::IntToPtr == ce->getOpcode()) {
+      return kGuestObject;
+    }
+  }
+  return kUnknownObject;
+}
+
+// Legacy pass manager wrapper around `RemillAAResult`.
+class RemillAAWrapperPass : public llvm::ImmutablePass {
+ public:
+  static char ID;
+
+  RemillAAWrapperPass(void)
+      : llvm::ImmutablePass(ID) {}
+
+  bool doInitialization(llvm::Module &module) override {
+    result.reset(new RemillAAResult(module.getDataLayout()));
+    return false;
+  }
+
+  bool doFinalization(llvm::Module &) override {
+    result.reset();
+    return false;
+  }
+
+  void getAnalysisUsage(llvm::AnalysisUsage &usage) const override {
+    usage.setPreservesAll();
+  }
+
+  RemillAAResult &GetResult(void) {
+    return *result;
+  }
+
+ private:
+  std::unique_ptr<RemillAAResult> result;
+};
+
+char RemillAAWrapperPass::ID = 0;
+
+// The legacy pass manager asserts that every immutable pass is registered.
+static llvm::RegisterPass<RemillAAWrapperPass> gRemillAA(
+    "remill-aa", "Remill-aware alias analysis", false, true);
+
+}  // namespace
+
+RemillAAResult::RemillAAResult(const llvm::DataLayout &dl_)
+    : dl(dl_) {}
+
+llvm::AliasResult RemillAAResult::alias(const llvm::MemoryLocation &loc_a,
+                                        const llvm::MemoryLocation &loc_b) {
+  int64_t offset_a = 0;
+  int64_t offset_b = 0;
+  auto base_a = llvm::GetPointerBaseWithConstantOffset(
+      loc_a.Ptr, offset_a, dl);
+  auto base_b = llvm::GetPointerBaseWithConstantOffset(
+      loc_b.Ptr, offset_b, dl);
+
+  // Two fields of the same `State` structure.
+  if (base_a == base_b && kStateObject == GetObjectKind(base_a) &&
+      llvm::MemoryLocation::UnknownSize != loc_a.Size &&
+      llvm::MemoryLocation::UnknownSize != loc_b.Size) {
+    auto size_a = static_cast<int64_t>(loc_a.Size);
+    auto size_b = static_cast<int64_t>(loc_b.Size);
+    if ((offset_a + size_a) <= offset_b || (offset_b + size_b) <= offset_a) {
+      return llvm::NoAlias;
+    }
+  }
+
+  // The `State` structure is disjoint from scratch space and guest memory.
+  auto kind_a = GetObjectKind(llvm::GetUnderlyingObject(loc_a.Ptr, dl));
+  auto kind_b = GetObjectKind(llvm::GetUnderlyingObject(loc_b.Ptr, dl));
+  if (kUnknownObject != kind_a && kUnknownObject != kind_b &&
+      (kStateObject == kind_a) != (kStateObject == kind_b)) {
+    return llvm::NoAlias;
+  }
+
+  return AAResultBase::alias(loc_a, loc_b);
+}
+
+llvm::ModRefInfo RemillAAResult::getModRefInfo(
+    llvm::ImmutableCallSite cs, const llvm::MemoryLocation &loc) {
+  auto intrinsic_kind = GetIntrinsicKind(cs.getCalledFunction());
+  if (kNotAnIntrinsic == intrinsic_kind) {
+    return AAResultBase::getModRefInfo(cs, loc);
+
+  } else if (kUndefinedIntrinsic == intrinsic_kind) {
+    return llvm::MRI_NoModRef;
+  }
+
+  // Guest memory is only reachable through the memory intrinsics, so they
+  // can only touch the `State` structure or scratch space if they are given
+  // a pointer to it.
+  auto object_kind = GetObjectKind(llvm::GetUnderlyingObject(loc.Ptr, dl));
+  if (kStateObject != object_kind && kLocalObject != object_kind) {
+    return AAResultBase::getModRefInfo(cs, loc);
+  }
+
+  if (kAtomicIntrinsic == intrinsic_kind) {
+    for (auto &arg : cs.args()) {
+      if (arg->getType()->isPointerTy() &&
+          llvm::NoAlias != getBestAAResults().alias(
+              llvm::MemoryLocation(arg), loc)) {
+        return AAResultBase::getModRefInfo(cs, loc);
+      }
+    }
+  }
+
+  return llvm::MRI_NoModRef;
+}
+
+llvm::FunctionModRefBehavior RemillAAResult::getModRefBehavior(
+    llvm::ImmutableCallSite cs) {
+  if (auto func = cs.getCalledFunction()) {
+    return getModRefBehavior(func);
+  }
+  return AAResultBase::getModRefBehavior(cs);
+}
+
+llvm::FunctionModRefBehavior RemillAAResult::getModRefBehavior(
+    const llvm::Function *func) {
+  switch (GetIntrinsicKind(func)) {
+    case kNotAnIntrinsic:
+      return AAResultBase::getModRefBehavior(func);
+
+    case kUndefinedIntrinsic:
+      return llvm::FMRB_DoesNotAccessMemory;
+
+    case kReadIntrinsic:
+      return static_cast<llvm::FunctionModRefBehavior>(
+          llvm::FMRL_InaccessibleMem | llvm::MRI_Ref);
+
+    case kWriteIntrinsic:
+    case kBarrierIntrinsic:
+      return llvm::FMRB_OnlyAccessesInaccessibleMem;
+
+    case kAtomicIntrinsic:
+      return llvm::FMRB_OnlyAccessesInaccessibleOrArgMem;
+  }
+  return AAResultBase::getModRefBehavior(func);
+}
+
+void AddRemillAliasAnalysis(llvm::legacy::PassManagerBase &pm) {
+  pm.add(new RemillAAWrapperPass);
+  pm.add(llvm::createExternalAAWrapperPass(
+      [] (llvm::Pass &pass, llvm::Function &, llvm::AAResults &results) {
+        if (auto wrapper = pass.getAnalysisIfAvailable<RemillAAWrapperPass>()) {
+          results.addAAResult(wrapper->GetResult());
+        }
+      }));
+}
+
+}  // namespace remill
+
+#else
+
+namespace remill {
+
+void AddRemillAliasAnalysis(llvm::legacy::PassManagerBase &) {}
+
+}  // namespace remill
+
+#endif  // LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_BC_REMILLAA_H_
+#define REMILL_BC_REMILLAA_H_
+
+#include "remill/BC/Version.h"
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+# include <llvm/Analysis/AliasAnalysis.h>
+#endif
+
+namespace llvm {
+class DataLayout;
+class Function;
+namespace legacy {
+class PassManagerBase;
+}  // namespace legacy
+}  // namespace llvm
+
+namespace remill {
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+
+// Alias analysis that knows remill's memory model:
+//
+//  1)  Accesses to the `State` structure at non-overlapping offsets from the
+//      same `State` pointer never alias.
+//  2)  The `State` structure never aliases an `alloca` or guest memory (i.e. a
+//      pointer made with an `inttoptr`).
+//  3)  Guest memory is only accessed through the memory intrinsics, and the
+//      order of those accesses is carried by the `Memory *` token. The memory
+//      intrinsics therefore never read or write the `State` structure or
+//      `alloca`d scratch space. The typed atomic intrinsics can additionally
+//      write through their reference arguments.
+class RemillAAResult : public llvm::AAResultBase<RemillAAResult> {
+ public:
+  explicit RemillAAResult(const llvm::DataLayout &dl_);
+
+  llvm::AliasResult alias(const llvm::MemoryLocation &loc_a,
+                          const llvm::MemoryLocation &loc_b);
+
+  llvm::ModRefInfo getModRefInfo(llvm::ImmutableCallSite cs,
+                                 const llvm::MemoryLocation &loc);
+
+  llvm::FunctionModRefBehavior getModRefBehavior(llvm::ImmutableCallSite cs);
+  llvm::FunctionModRefBehavior getModRefBehavior(const llvm::Function *func);
+
+ private:
+  friend class llvm::AAResultBase<RemillAAResult>;
+
+  const llvm::DataLayout &dl;
+};
+
+#endif  // LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+
+// Add remill's alias analysis to `pm`, so that later passes in `pm` that use
+// alias analysis (e.g. GVN, LICM, DSE) can see through the memory intrinsics.
+// This does nothing on LLVM versions before 4.0.
+void AddRemillAliasAnalysis(llvm::legacy::PassManagerBase &pm);
+
+}  // namespace remill
+
+#endif  // REMILL_BC_REMILLAA_H_
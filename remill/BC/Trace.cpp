@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <ios>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+
+#include "remill/Arch/Arch.h"
+#include "remill/Arch/JumpTable.h"
+#include "remill/BC/IntrinsicTable.h"
+#include "remill/BC/Lifter.h"
+#include "remill/BC/Profile.h"
+#include "remill/BC/Trace.h"
+#include "remill/BC/Util.h"
+#include "remill/OS/Image.h"
+
+namespace remill {
+namespace {
+
+// Decode the guest block at `pc`. Returns `false` if not even the first
+// instruction of the block decodes.
+static bool DecodeBlock(const Arch *arch, const MappedImage &image,
+                        const BlockProfile &profile, uint64_t pc,
+                        unsigned max_instructions, TraceBlock *block) {
+  block->pc = pc;
+  block->instructions.clear();
+  while (block->instructions.size() < max_instructions) {
+    Instruction inst;
+    if (!arch->DecodeInstruction(pc, image, inst)) {
+      break;
+    }
+    block->instructions.push_back(inst);
+    if (inst.IsControlFlow()) {
+      break;
+    }
+
+    // Stop where another profiled block starts, so that trace blocks line up
+    // with the lifted blocks that were profiled.
+    pc = inst.next_pc;
+    if (profile.BlockCount(pc)) {
+      break;
+    }
+  }
+  return !block->instructions.empty();
+}
+
+// The statically known successors of `block`, i.e. the blocks that a trace
+// through `block` can continue into.
+static std::vector<uint64_t> Successors(const TraceBlock &block) {
+  const auto &last = block.instructions.back();
+  switch (last.category) {
+    case Instruction::kCategoryNormal:
+    case Instruction::kCategoryNoOp:
+    case Instruction::kCategoryConditionalAsyncHyperCall:
+      return {last.next_pc};
+
+    case Instruction::kCategoryDirectJump:
+      return {last.branch_taken_pc};
+
+    case Instruction::kCategoryConditionalBranch:
+      if (last.branch_taken_pc == last.branch_not_taken_pc) {
+        return {last.branch_taken_pc};
+      }
+      return {last.branch_not_taken_pc, last.branch_taken_pc};
+
+    case Instruction::kCategoryIndirectJump:
+      return block.jump_targets;
+
+    default:
+      return {};
+  }
+}
+
+// The statically known places where execution goes after leaving `block`,
+// including the targets and return addresses of function calls.
+static std::vector<uint64_t> ExitTargets(const TraceBlock &block) {
+  auto targets = Successors(block);
+  const auto &last = block.instructions.back();
+  switch (last.category) {
+    case Instruction::kCategoryDirectFunctionCall:
+      targets.push_back(last.branch_taken_pc);
+      targets.push_back(last.next_pc);
+      break;
+
+    case Instruction::kCategoryIndirectFunctionCall:
+      targets.push_back(last.next_pc);
+      break;
+
+    default:
+      break;
+  }
+  return targets;
+}
+
+// Find the successor of `block` that executes most often after it. Returns
+// `false` if `block` has no statically known successors, or if its edge
+// counts say that none of them ever executed after it.
+static bool HottestSuccessor(const BlockProfile &profile,
+                             const TraceBlock &block, uint64_t *next_pc) {
+  auto use_edges = profile.HasEdgesFrom(block.pc);
+  uint64_t best_count = 0;
+  auto found = false;
+  for (auto succ : Successors(block)) {
+    auto count = use_edges ? profile.EdgeCount(block.pc, succ) :
+                             profile.BlockCount(succ);
+    if (!found || count > best_count) {
+      found = true;
+      best_count = count;
+      *next_pc = succ;
+    }
+  }
+  return found && (!use_edges || best_count);
+}
+
+// Recover the jump table used by the indirect jump that ends the last block
+// of `trace`. The previous block on the trace, if any, is included in the
+// analysis because that is often where the table index is bounds checked.
+static void RecoverTraceJumpTable(const Arch *arch, const MappedImage &image,
+                                  Trace *trace) {
+  auto &block = trace->blocks.back();
+  if (block.instructions.back().category !=
+      Instruction::kCategoryIndirectJump) {
+    return;
+  }
+
+  std::vector<Instruction> path;
+  if (2 <= trace->blocks.size()) {
+    const auto &pred = trace->blocks[trace->blocks.size() - 2];
+    path.insert(path.end(), pred.instructions.begin(),
+                pred.instructions.end());
+  }
+  path.insert(path.end(), block.instructions.begin(),
+              block.instructions.end());
+
+  JumpTable table;
+  if (RecoverJumpTable(arch, image, path, &table)) {
+    block.jump_targets = table.targets;
+  }
+}
+
+// Orders candidate trace heads, as `(count, pc)` pairs, hottest first. Ties
+// are broken by address so that selection is deterministic.
+struct HotterFirst {
+  bool operator()(const std::pair<uint64_t, uint64_t> &a,
+                  const std::pair<uint64_t, uint64_t> &b) const {
+    if (a.first != b.first) {
+      return a.first > b.first;
+    }
+    return a.second < b.second;
+  }
+};
+
+}  // namespace
+
+TraceSelectionOptions::TraceSelectionOptions(void)
+    : hot_threshold(50),
+      max_blocks(16),
+      max_instructions(256),
+      max_traces(0) {}
+
+std::vector<Trace> SelectTraces(const Arch *arch, const MappedImage &image,
+                                const BlockProfile &profile,
+                                const TraceSelectionOptions &options) {
+  // Decoded blocks, or `nullptr` if a block doesn't decode.
+  std::unordered_map<uint64_t, std::unique_ptr<TraceBlock>> decoded_blocks;
+  auto get_block = [&] (uint64_t pc) -> const TraceBlock * {
+    auto block_it = decoded_blocks.find(pc);
+    if (block_it == decoded_blocks.end()) {
+      std::unique_ptr<TraceBlock> block(new TraceBlock);
+      if (!DecodeBlock(arch, image, profile, pc, options.max_instructions,
+                       block.get())) {
+        block.reset();
+      }
+      block_it = decoded_blocks.emplace(pc, std::move(block)).first;
+    }
+    return block_it->second.get();
+  };
+
+  // Addresses of every trace head that has been selected or is a candidate.
+  std::unordered_set<uint64_t> heads;
+  std::set<std::pair<uint64_t, uint64_t>, HotterFirst> candidates;
+  auto add_candidate = [&] (uint64_t pc) {
+    auto count = profile.BlockCount(pc);
+    if (count >= options.hot_threshold && heads.insert(pc).second) {
+      candidates.insert({count, pc});
+    }
+  };
+
+  // Start with the hot targets of backward branches.
+  for (const auto &entry : profile.blocks) {
+    if (entry.second < options.hot_threshold) {
+      continue;
+    }
+    if (auto block = get_block(entry.first)) {
+      for (auto succ : Successors(*block)) {
+        if (succ <= block->pc) {
+          add_candidate(succ);
+        }
+      }
+    }
+  }
+
+  std::vector<Trace> traces;
+  while (!candidates.empty() &&
+         (!options.max_traces || traces.size() < options.max_traces)) {
+    auto head = *candidates.begin();
+    candidates.erase(candidates.begin());
+
+    Trace trace;
+    trace.count = head.first;
+    std::unordered_set<uint64_t> on_trace;
+    size_t num_instructions = 0;
+
+    for (auto pc = head.second; ; ) {
+      auto block = get_block(pc);
+      if (!block || (num_instructions + block->instructions.size() >
+                     options.max_instructions)) {
+        break;
+      }
+
+      trace.blocks.push_back(*block);
+      RecoverTraceJumpTable(arch, image, &trace);
+      on_trace.insert(pc);
+      num_instructions += block->instructions.size();
+      if (trace.blocks.size() >= options.max_blocks) {
+        break;
+      }
+
+      uint64_t next_pc = 0;
+      if (!HottestSuccessor(profile, trace.blocks.back(), &next_pc) ||
+          next_pc <= pc || on_trace.count(next_pc) || heads.count(next_pc) ||
+          profile.BlockCount(next_pc) < options.hot_threshold) {
+        break;
+      }
+      pc = next_pc;
+    }
+
+    if (trace.blocks.empty()) {
+      continue;
+    }
+
+    // The hot targets of side exits become candidate trace heads.
+    for (size_t i = 0; i < trace.blocks.size(); ++i) {
+      for (auto exit_pc : ExitTargets(trace.blocks[i])) {
+        if (i + 1 == trace.blocks.size() ||
+            exit_pc != trace.blocks[i + 1].pc) {
+          add_candidate(exit_pc);
+        }
+      }
+    }
+
+    DLOG(INFO)
+        << "Selected trace at " << std::hex << head.second << std::dec
+        << " with " << trace.blocks.size() << " blocks and "
+        << num_instructions << " instructions";
+
+    traces.push_back(std::move(trace));
+  }
+
+  return traces;
+}
+
+bool LiftTrace(InstructionLifter *lifter, const Trace &trace,
+               llvm::Function *func, const TraceExitFinder &find_exit,
+               const TraceCalleeFinder &find_callee) {
+  CHECK(!trace.blocks.empty())
+      << "Cannot lift an empty trace into " << func->getName().str();
+
+  auto &context = func->getContext();
+  auto intrinsics = lifter->intrinsics;
+  CloneBlockFunctionPrologueInto(func);
+
+  std::map<uint64_t, llvm::BasicBlock *> blocks;
+  for (const auto &trace_block : trace.blocks) {
+    std::stringstream ss;
+    ss << "block_" << std::hex << trace_block.pc;
+    blocks[trace_block.pc] = llvm::BasicBlock::Create(context, ss.str(), func);
+  }
+
+  llvm::BranchInst::Create(blocks[trace.blocks.front().pc],
+                           &(func->getEntryBlock()));
+
+  // Get the block that continues execution at `pc`, i.e. the block of the
+  // trace at `pc`, or else a side exit to `pc`.
+  std::map<uint64_t, llvm::BasicBlock *> exits;
+  auto get_successor = [&] (uint64_t pc) -> llvm::BasicBlock * {
+    auto block_it = blocks.find(pc);
+    if (block_it != blocks.end()) {
+      return block_it->second;
+    }
+
+    auto &exit = exits[pc];
+    if (!exit) {
+      std::stringstream ss;
+      ss << "exit_" << std::hex << pc;
+      exit = llvm::BasicBlock::Create(context, ss.str(), func);
+      StoreProgramCounter(exit, pc);
+      llvm::Function *dest = find_exit ? find_exit(pc) : nullptr;
+      AddTerminatingTailCall(exit, dest ? dest : intrinsics->missing_block);
+    }
+    return exit;
+  };
+
+  for (const auto &trace_block : trace.blocks) {
+    auto block = blocks[trace_block.pc];
+    for (auto inst : trace_block.instructions) {
+      if (!lifter->LiftIntoBlock(inst, block)) {
+        LOG(ERROR)
+            << "Unable to lift instruction at " << std::hex << inst.pc
+            << " of trace " << trace.blocks.front().pc;
+        return false;
+      }
+    }
+
+    const auto &last = trace_block.instructions.back();
+    llvm::IRBuilder<> ir(block);
+    switch (last.category) {
+      case Instruction::kCategoryInvalid:
+      case Instruction::kCategoryError:
+        AddTerminatingTailCall(block, intrinsics->error);
+        break;
+
+      case Instruction::kCategoryNormal:
+      case Instruction::kCategoryNoOp:
+        ir.CreateBr(get_successor(last.next_pc));
+        break;
+
+      case Instruction::kCategoryDirectJump:
+        ir.CreateBr(get_successor(last.branch_taken_pc));
+        break;
+
+      case Instruction::kCategoryConditionalBranch: {
+        auto taken = get_successor(last.branch_taken_pc);
+        auto not_taken = get_successor(last.branch_not_taken_pc);
+        ir.CreateCondBr(LoadBranchTaken(block), taken, not_taken);
+        break;
+      }
+
+      case Instruction::kCategoryIndirectJump: {
+        if (trace_block.jump_targets.empty()) {
+          AddTerminatingTailCall(block, intrinsics->jump);
+          break;
+        }
+
+        // Dispatch on the computed target, so that a target that the table
+        // recovery missed still goes through `__remill_jump`.
+        auto default_case = llvm::BasicBlock::Create(context, "", func);
+        AddTerminatingTailCall(default_case, intrinsics->jump);
+        auto pc = LoadProgramCounter(block);
+        auto pc_type = llvm::cast<llvm::IntegerType>(pc->getType());
+        auto dispatch = ir.CreateSwitch(
+            pc, default_case,
+            static_cast<unsigned>(trace_block.jump_targets.size()));
+        for (auto target : trace_block.jump_targets) {
+          dispatch->addCase(llvm::ConstantInt::get(pc_type, target),
+                            get_successor(target));
+        }
+        break;
+      }
+
+      case Instruction::kCategoryDirectFunctionCall: {
+        // A call to the next instruction only reads the program counter, and
+        // never returns.
+        llvm::Function *callee = nullptr;
+        if (find_callee && last.branch_taken_pc != last.next_pc) {
+          callee = find_callee(last.branch_taken_pc);
+        }
+        if (!callee) {
+          AddTerminatingTailCall(block, intrinsics->function_call);
+          break;
+        }
+
+        // The call's semantics have already pushed the return address and
+        // set `PC` to the callee.
+        auto memory = ir.CreateCall(callee, LiftedFunctionArgs(block));
+        ir.CreateStore(memory, LoadMemoryPointerRef(block));
+
+        // The return site is only reached directly if the callee returned to
+        // it, and if the runtime doesn't need to take over, e.g. because the
+        // callee stopped the vCPU.
+        auto pc = LoadProgramCounter(block);
+        auto ret_pc = llvm::ConstantInt::get(pc->getType(), last.next_pc);
+        auto check = llvm::BasicBlock::Create(context, "", func);
+        auto slow_path = llvm::BasicBlock::Create(context, "", func);
+        AddTerminatingTailCall(slow_path, intrinsics->jump);
+        ir.CreateCondBr(ir.CreateICmpEQ(pc, ret_pc), check, slow_path);
+
+        ir.SetInsertPoint(check);
+        llvm::Value *args[] = {
+          LoadStatePointer(check),
+          ret_pc,
+          LoadMemoryPointer(check)
+        };
+        ir.CreateCondBr(ir.CreateCall(intrinsics->resume_after_call, args),
+                        get_successor(last.next_pc), slow_path);
+        break;
+      }
+
+      case Instruction::kCategoryIndirectFunctionCall:
+        AddTerminatingTailCall(block, intrinsics->function_call);
+        break;
+
+      case Instruction::kCategoryFunctionReturn:
+        AddTerminatingTailCall(block, intrinsics->function_return);
+        break;
+
+      case Instruction::kCategoryAsyncHyperCall:
+        AddTerminatingTailCall(block, intrinsics->async_hyper_call);
+        break;
+
+      case Instruction::kCategoryConditionalAsyncHyperCall: {
+        auto hyper_call = llvm::BasicBlock::Create(context, "", func);
+        AddTerminatingTailCall(hyper_call, intrinsics->async_hyper_call);
+        auto not_taken = get_successor(last.next_pc);
+        ir.CreateCondBr(LoadBranchTaken(block), hyper_call, not_taken);
+        break;
+      }
+    }
+  }
+
+  return true;
+}
+
+}  // namespace remill
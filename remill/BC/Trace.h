@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_BC_TRACE_H_
+#define REMILL_BC_TRACE_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "remill/Arch/Instruction.h"
+
+namespace llvm {
+class Function;
+}  // namespace llvm
+
+namespace remill {
+
+class Arch;
+class BlockProfile;
+class InstructionLifter;
+class MappedImage;
+
+// A guest basic block on a trace. The block ends with its first control-flow
+// instruction, or just before the start of another profiled block.
+struct TraceBlock {
+  uint64_t pc;
+  std::vector<Instruction> instructions;
+
+  // Targets of the indirect jump that ends this block, if the jump goes
+  // through a jump table that `RecoverJumpTable` recognizes.
+  std::vector<uint64_t> jump_targets;
+};
+
+// A single-entry, multi-exit path through hot guest blocks. Execution enters
+// at the first block (the trace head), and leaves the trace through a side
+// exit whenever it goes somewhere other than the next block on the trace.
+struct Trace {
+  std::vector<TraceBlock> blocks;
+
+  // Execution count of the trace head.
+  uint64_t count;
+};
+
+struct TraceSelectionOptions {
+  TraceSelectionOptions(void);
+
+  // Minimum execution count of the blocks on a trace.
+  uint64_t hot_threshold;
+
+  // Maximum number of blocks and instructions in a trace.
+  unsigned max_blocks;
+  unsigned max_instructions;
+
+  // Maximum number of traces to select. Zero means no limit.
+  unsigned max_traces;
+};
+
+// Select hot traces, using a static version of the Next Executing Tail (NET)
+// heuristic of Dynamo:
+//
+//  1)  Trace heads are the hot targets of backward branches (i.e. loop
+//      headers), and then the hot targets of the side exits of traces that
+//      have already been selected. Heads are picked hottest first.
+//  2)  A trace grows from its head by following the hottest successor of
+//      each block, as measured by the edge counts of `profile` or, if the
+//      block has no edge counts, by the block counts of its successors.
+//  3)  A trace stops at a backward branch, at another trace head, at a block
+//      that isn't hot, at an instruction whose successors aren't known
+//      statically (e.g. an indirect call, or return, or an indirect jump that
+//      doesn't go through a recognized jump table), or when it reaches the
+//      size limits of `options`.
+//
+// Where a dynamic translator would record the path that executes next (NET)
+// or most recently (MRET), this uses the path that the profile says executes
+// most often. Blocks are decoded out of `image`, and may appear on more than
+// one trace.
+std::vector<Trace> SelectTraces(const Arch *arch, const MappedImage &image,
+                                const BlockProfile &profile,
+                                const TraceSelectionOptions &options);
+
+// Returns the lifted function that a side exit to `pc` should tail-call, e.g.
+// the normal lifted block at `pc`, or `nullptr` to tail-call
+// `__remill_missing_block`, which hands `pc` back to the dispatcher.
+using TraceExitFinder = std::function<llvm::Function *(uint64_t pc)>;
+
+// Returns the lifted function that a direct function call to `pc` should
+// call natively, or `nullptr` to tail-call `__remill_function_call`, which
+// hands `pc` back to the dispatcher.
+using TraceCalleeFinder = std::function<llvm::Function *(uint64_t pc)>;
+
+// Lift `trace` into `func`, which must be a declaration of a lifted function
+// (see `DeclareLiftedFunction`). Every block of the trace is lifted into its
+// own LLVM basic block, and control flow between blocks on the trace, such as
+// a loop back to the trace head, becomes a direct branch. Side exits tail-call
+// the function returned by `find_exit`. An indirect jump through a recovered
+// jump table becomes a `switch` on the computed program counter, whose cases
+// are the table's targets, and whose default case tail-calls `__remill_jump`.
+// Other indirect jumps, calls, returns and hyper calls end the trace by
+// tail-calling the matching intrinsic, just like they end a normal lifted
+// block.
+//
+// If `find_callee` returns a lifted function for the target of a direct
+// function call, then the call becomes a real LLVM call to that function,
+// rather than a tail-call to `__remill_function_call`. Lifted code returns
+// by tail-calling `__remill_function_return`, and so the callee eventually
+// returns to the call site, with the guest return address (e.g. popped off
+// of the stack by `ret`) in `PC`. If that is the fall-through address of the
+// call, and `__remill_resume_after_call` says that the runtime doesn't need
+// to take over, then execution continues at the return site in the same
+// function. Otherwise, e.g. if the callee left through the dispatcher,
+// returned somewhere else, or stopped the vCPU, then the call site tail-calls
+// `__remill_jump`. Matching native calls and returns lets the host predict
+// the returns, and lets LLVM inline callees. The host stack grows with the
+// guest's call depth.
+bool LiftTrace(InstructionLifter *lifter, const Trace &trace,
+               llvm::Function *func, const TraceExitFinder &find_exit=nullptr,
+               const TraceCalleeFinder &find_callee=nullptr);
+
+}  // namespace remill
+
+#endif  // REMILL_BC_TRACE_H_
@@ -17,6 +17,7 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include <fstream>
 #include <sstream>
 #include <system_error>
 #include <unordered_map>
@@ -116,6 +117,175 @@ llvm::CallInst *AddTerminatingTailCall(llvm::BasicBlock *source_block,
   return call_target_instr;
 }
 
+namespace {
+
+// Find a named instruction in the entry block of `function`.
+static llvm::Instruction *FindVarInEntryBlock(llvm::Function *function,
+                                              const std::string &name) {
+  for (auto &instr : function->getEntryBlock()) {
+    if (instr.getName() == name) {
+      return &instr;
+    }
+  }
+  return nullptr;
+}
+
+// Free an instruction that was never inserted into a block.
+static void DeleteInstruction(llvm::Instruction *inst) {
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(5, 0)
+  inst->deleteValue();
+#else
+  delete inst;
+#endif
+}
+
+// Recompute `val`, which is defined in the entry block of
+// `__remill_basic_block`, in terms of the arguments of `func`. New
+// instructions are added to `insts`, operands before their users.
+//
+// `__remill_basic_block` is compiled without optimization, so the address of a
+// register is a chain of GEPs and casts of the state pointer, which is itself
+// spilled to and reloaded from an alloca. Loads from such singly-stored
+// allocas are forwarded, and named allocas (e.g. register variables) are
+// recreated along with their initializing stores.
+static llvm::Value *RematerializeValue(
+    llvm::Function *func, llvm::Value *val, ValueMap &value_map,
+    std::vector<llvm::Instruction *> &insts) {
+
+  auto val_it = value_map.find(val);
+  if (val_it != value_map.end()) {
+    return val_it->second;
+  }
+
+  llvm::Value *new_val = nullptr;
+
+  if (auto arg = llvm::dyn_cast<llvm::Argument>(val)) {
+    new_val = NthArgument(func, arg->getArgNo());
+
+  } else if (llvm::isa<llvm::Constant>(val)) {
+    return val;
+
+  } else if (auto alloca = llvm::dyn_cast<llvm::AllocaInst>(val)) {
+    if (!alloca->hasName()) {
+      return nullptr;
+    }
+
+    // Already materialized by an earlier lookup.
+    auto name = alloca->getName().str();
+    if (auto existing = FindVarInEntryBlock(func, name)) {
+      new_val = existing;
+
+    } else {
+      auto new_alloca = alloca->clone();
+      new_alloca->setName(name);
+      insts.push_back(new_alloca);
+      value_map[val] = new_alloca;
+
+      for (auto &instr : *(alloca->getParent())) {
+        auto store = llvm::dyn_cast<llvm::StoreInst>(&instr);
+        if (!store || store->getPointerOperand() != alloca) {
+          continue;
+        }
+        auto stored_val = RematerializeValue(
+            func, store->getValueOperand(), value_map, insts);
+        if (!stored_val) {
+          return nullptr;
+        }
+        auto new_store = store->clone();
+        new_store->setOperand(0, stored_val);
+        new_store->setOperand(1, new_alloca);
+        insts.push_back(new_store);
+      }
+      return new_alloca;
+    }
+
+  } else if (auto load = llvm::dyn_cast<llvm::LoadInst>(val)) {
+    auto alloca = llvm::dyn_cast<llvm::AllocaInst>(load->getPointerOperand());
+    if (!alloca) {
+      return nullptr;
+    }
+    auto store = FindUniqueStore(alloca);
+    if (!store) {
+      return nullptr;
+    }
+    new_val = RematerializeValue(
+        func, store->getValueOperand(), value_map, insts);
+
+  } else if (llvm::isa<llvm::GetElementPtrInst>(val) ||
+             llvm::isa<llvm::CastInst>(val)) {
+    auto inst = llvm::dyn_cast<llvm::Instruction>(val);
+    auto new_inst = inst->clone();
+    for (auto &op : new_inst->operands()) {
+      auto new_op = RematerializeValue(func, op.get(), value_map, insts);
+      if (!new_op) {
+        DeleteInstruction(new_inst);
+        return nullptr;
+      }
+      op.set(new_op);
+    }
+    new_inst->setName(inst->getName());
+    insts.push_back(new_inst);
+    new_val = new_inst;
+
+  } else {
+    return nullptr;
+  }
+
+  value_map[val] = new_val;
+  return new_val;
+}
+
+// Materialize the variable `name` from `__remill_basic_block` into the entry
+// block of `func`. New allocas go after the existing allocas, and the code
+// that initializes them goes before any other code in the entry block.
+static llvm::Value *MaterializeBlockVariable(llvm::Function *func,
+                                             const std::string &name) {
+  auto bb_func = func->getParent()->getFunction("__remill_basic_block");
+  if (!bb_func || bb_func == func || func->isDeclaration()) {
+    return nullptr;
+  }
+
+  auto bb_var = llvm::dyn_cast_or_null<llvm::AllocaInst>(
+      FindVarInEntryBlock(bb_func, name));
+  if (!bb_var) {
+    return nullptr;
+  }
+
+  ValueMap value_map;
+  std::vector<llvm::Instruction *> insts;
+  auto var = RematerializeValue(func, bb_var, value_map, insts);
+  if (!var) {
+    for (auto inst : insts) {
+      inst->dropAllReferences();
+    }
+    for (auto inst : insts) {
+      DeleteInstruction(inst);
+    }
+    return nullptr;
+  }
+
+  auto &entry = func->getEntryBlock();
+  auto insert_pt = entry.begin();
+  while (insert_pt != entry.end() && llvm::isa<llvm::AllocaInst>(*insert_pt)) {
+    ++insert_pt;
+  }
+
+  auto &entry_insts = entry.getInstList();
+  for (auto inst : insts) {
+    if (llvm::isa<llvm::AllocaInst>(inst)) {
+      entry_insts.insert(insert_pt, inst);
+    }
+  }
+  for (auto inst : insts) {
+    if (!llvm::isa<llvm::AllocaInst>(inst)) {
+      entry_insts.insert(insert_pt, inst);
+    }
+  }
+  return var;
+}
+
+}  // namespace
+
 // Find a local variable defined in the entry block of the function. We use
 // this to find register variables.
 llvm::Value *FindVarInFunction(llvm::BasicBlock *block, std::string name,
@@ -124,12 +294,18 @@ llvm::Value *FindVarInFunction(llvm::BasicBlock *block, std::string name,
 }
 
 // Find a local variable defined in the entry block of the function. We use
-// this to find register variables.
+// this to find register variables. If `function` was set up with
+// `CloneBlockFunctionPrologueInto` then variables are materialized on their
+// first use.
 llvm::Value *FindVarInFunction(llvm::Function *function, std::string name,
                                bool allow_failure) {
-  for (auto &instr : function->getEntryBlock()) {
-    if (instr.getName() == name) {
-      return &instr;
+  if (auto var = FindVarInEntryBlock(function, name)) {
+    return var;
+  }
+
+  if (FindVarInEntryBlock(function, "MEMORY")) {
+    if (auto var = MaterializeBlockVariable(function, name)) {
+      return var;
     }
   }
 
@@ -139,6 +315,21 @@ llvm::Value *FindVarInFunction(llvm::Function *function, std::string name,
 }
 
 // Find the machine state pointer.
+llvm::StoreInst *FindUniqueStore(llvm::AllocaInst *alloca) {
+  llvm::StoreInst *found = nullptr;
+  for (auto &instr : *(alloca->getParent())) {
+    if (auto store = llvm::dyn_cast<llvm::StoreInst>(&instr)) {
+      if (store->getPointerOperand() == alloca) {
+        if (found) {
+          return nullptr;
+        }
+        found = store;
+      }
+    }
+  }
+  return found;
+}
+
 llvm::Value *LoadStatePointer(llvm::Function *function) {
   CHECK(kNumBlockArgs == function->arg_size())
       << "Invalid block-like function. Expected two arguments: state "
@@ -447,6 +638,24 @@ void ForEachISel(llvm::Module *module, ISelCallback callback) {
   }
 }
 
+// Load the summaries of the semantics functions of `arch`.
+bool LoadISelSummaries(const std::string &arch, ISelSummaryMap *summaries) {
+  for (auto sem_dir : gSemanticsSearchPaths) {
+    std::stringstream ss;
+    ss << sem_dir << "/" << arch << ".isel";
+    auto summary_path = ss.str();
+    if (!FileExists(summary_path)) {
+      continue;
+    }
+
+    std::ifstream is(summary_path);
+    CHECK(is.good())
+        << "Unable to open ISEL summary file " << summary_path;
+    return ReadISelSummaries(is, summaries);
+  }
+  return false;
+}
+
 // Declare a lifted function of the correct type.
 llvm::Function *DeclareLiftedFunction(llvm::Module *module,
                                       const std::string &name) {
@@ -658,6 +867,47 @@ void CloneBlockFunctionInto(llvm::Function *func) {
   CHECK(remill::FindVarInFunction(func, "MEMORY") != nullptr);
 }
 
+// Make `func` into a lifted function whose entry block only defines the
+// variables that every lifted function needs, i.e. `STATE`, `MEMORY`, `PC`, and
+// `BRANCH_TAKEN`. Register variables are materialized by `FindVarInFunction`
+// the first time that they are looked up.
+void CloneBlockFunctionPrologueInto(llvm::Function *func) {
+  auto bb_func = BasicBlockFunction(func->getParent());
+  CHECK(func->isDeclaration())
+      << "Cannot add a prologue to already-defined function "
+      << func->getName().str();
+
+  func->setAttributes(bb_func->getAttributes());
+  func->setLinkage(bb_func->getLinkage());
+  func->setVisibility(bb_func->getVisibility());
+  func->setCallingConv(bb_func->getCallingConv());
+  func->removeFnAttr(llvm::Attribute::OptimizeNone);
+
+  auto new_args = func->arg_begin();
+  for (llvm::Argument &old_arg : bb_func->args()) {
+    new_args->setName(old_arg.getName());
+    ++new_args;
+  }
+
+  (void) llvm::BasicBlock::Create(
+      func->getContext(), bb_func->getEntryBlock().getName(), func);
+
+  // `MEMORY` marks `func` as having a lazily materialized entry block, so it
+  // must come first.
+  auto memory = MaterializeBlockVariable(func, "MEMORY");
+  CHECK(nullptr != memory)
+      << "Unable to materialize MEMORY variable in " << func->getName().str();
+
+  (void) FindVarInFunction(func, "STATE");
+  (void) FindVarInFunction(func, "BRANCH_TAKEN");
+
+  // Mirrors the `PC = curr_pc` assignment in `__remill_basic_block`.
+  auto &entry = func->getEntryBlock();
+  llvm::IRBuilder<> ir(&entry);
+  ir.CreateStore(NthArgument(func, kPCArgNum),
+                 ir.CreateLoad(FindVarInFunction(func, "PC")));
+}
+
 // Returns a list of callers of a specific function.
 std::vector<llvm::CallInst *> CallersOf(llvm::Function *func) {
   std::vector<llvm::CallInst *> callers;
@@ -22,7 +22,10 @@
 #include <unordered_map>
 #include <vector>
 
+#include "remill/BC/ISelSummary.h"
+
 namespace llvm {
+class AllocaInst;
 class Argument;
 class BasicBlock;
 class CallInst;
@@ -33,6 +36,7 @@ class GlobalVariable;
 class IntegerType;
 class Module;
 class PointerType;
+class StoreInst;
 class Type;
 class Value;
 class LLVMContext;
@@ -57,11 +61,18 @@ llvm::Value *FindVarInFunction(llvm::BasicBlock *block,
                                bool allow_failure=false);
 
 // Find a local variable defined in the entry block of the function. We use
-// this to find register variables.
+// this to find register variables. If `func` was set up with
+// `CloneBlockFunctionPrologueInto` then variables are materialized on their
+// first use.
 llvm::Value *FindVarInFunction(llvm::Function *func,
                                std::string name,
                                bool allow_failure=false);
 
+// Find the store into `alloca` in the block that defines `alloca`, e.g. the
+// unoptimized spill of the state pointer in `__remill_basic_block`. Returns
+// `nullptr` if there isn't exactly one such store.
+llvm::StoreInst *FindUniqueStore(llvm::AllocaInst *alloca);
+
 // Find the machine state pointer. The machine state pointer is, by convention,
 // passed as the first argument to every lifted function.
 llvm::Value *LoadStatePointer(llvm::Function *function);
@@ -144,6 +155,11 @@ using ISelCallback = std::function<
     void(llvm::GlobalVariable *, llvm::Function *)>;
 void ForEachISel(llvm::Module *module, ISelCallback callback);
 
+// Load the summaries of the semantics functions of `arch`, which are
+// generated alongside its semantics bitcode file (see
+// `remill/BC/ISelSummary.h`). Returns `false` if there is no summary file.
+bool LoadISelSummaries(const std::string &arch, ISelSummaryMap *summaries);
+
 // Declare a lifted function of the correct type.
 llvm::Function *DeclareLiftedFunction(llvm::Module *module,
                                       const std::string &name);
@@ -179,6 +195,13 @@ void CloneFunctionInto(llvm::Function *source_func, llvm::Function *dest_func);
 // Make `func` a clone of the `__remill_basic_block` function.
 void CloneBlockFunctionInto(llvm::Function *func);
 
+// Make `func` a lifted function whose entry block only defines the `STATE`,
+// `MEMORY`, `PC`, and `BRANCH_TAKEN` variables of `__remill_basic_block`.
+// Other variables (e.g. registers) are materialized lazily, the first time
+// they are looked up with `FindVarInFunction`. This is a cheaper alternative
+// to `CloneBlockFunctionInto` that also produces much less IR.
+void CloneBlockFunctionPrologueInto(llvm::Function *func);
+
 // Returns a list of callers of a specific function.
 std::vector<llvm::CallInst *> CallersOf(llvm::Function *func);
 
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "remill/OS/FileSystem.h"
+#include "remill/OS/Image.h"
+
+namespace remill {
+namespace {
+
+enum : uint32_t {
+  kELFClass32 = 1,
+  kELFClass64 = 2,
+  kELFDataLittleEndian = 1,
+  kELFDataBigEndian = 2,
+  kELFProgramHeaderLoad = 1,
+  kELFSegmentExecutable = 1,
+  kELFSegmentWritable = 2,
+  kELFSegmentReadable = 4,
+  kELFExtendedNumProgramHeaders = 0xFFFF
+};
+
+// Reads integer fields out of an ELF file of either byte order. The caller
+// checks that fields are in bounds.
+class ELFReader {
+ public:
+  ELFReader(const uint8_t *data_, bool is_big_endian_)
+      : data(data_),
+        is_big_endian(is_big_endian_) {}
+
+  uint64_t Read(uint64_t offset, size_t size) const {
+    uint64_t val = 0;
+    for (size_t i = 0; i < size; ++i) {
+      auto shift = is_big_endian ? (size - i - 1) * 8 : i * 8;
+      val |= static_cast<uint64_t>(data[offset + i]) << shift;
+    }
+    return val;
+  }
+
+ private:
+  const uint8_t * const data;
+  const bool is_big_endian;
+};
+
+}  // namespace
+
+MappedImage::MappedImage(void)
+    : file_data(nullptr),
+      file_size(0),
+      is_elf(false),
+      entry_point(0) {}
+
+MappedImage::~MappedImage(void) {
+  if (file_data) {
+    munmap(const_cast<uint8_t *>(file_data), file_size);
+  }
+}
+
+std::unique_ptr<MappedImage> MappedImage::Open(const std::string &path,
+                                               uint64_t base_address) {
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (-1 == fd) {
+    LOG(ERROR)
+        << "Unable to open " << path << " for mapping: " << strerror(errno);
+    return nullptr;
+  }
+
+  std::unique_ptr<MappedImage> image(new MappedImage);
+  image->file_size = static_cast<size_t>(FileSize(path, fd));
+  if (!image->file_size) {
+    close(fd);
+    LOG(ERROR)
+        << "Unable to map empty file " << path;
+    return nullptr;
+  }
+
+  auto data = mmap(nullptr, image->file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  auto err = errno;
+  close(fd);
+  if (MAP_FAILED == data) {
+    LOG(ERROR)
+        << "Unable to map " << path << ": " << strerror(err);
+    return nullptr;
+  }
+  image->file_data = reinterpret_cast<const uint8_t *>(data);
+
+  if (4 <= image->file_size && !memcmp(image->file_data, "\x7F" "ELF", 4)) {
+    image->is_elf = true;
+    if (!image->LoadELF(path)) {
+      return nullptr;
+    }
+  } else {
+    image->LoadRaw(base_address);
+  }
+
+  std::sort(image->segments.begin(), image->segments.end(),
+            [] (const ImageSegment &a, const ImageSegment &b) {
+              return a.address < b.address;
+            });
+  return image;
+}
+
+// Create a segment for each `PT_LOAD` program header.
+bool MappedImage::LoadELF(const std::string &path) {
+  if (16 > file_size) {
+    LOG(ERROR)
+        << "ELF file " << path << " is truncated";
+    return false;
+  }
+
+  auto elf_class = file_data[4];
+  auto elf_data = file_data[5];
+  if ((kELFClass32 != elf_class && kELFClass64 != elf_class) ||
+      (kELFDataLittleEndian != elf_data && kELFDataBigEndian != elf_data)) {
+    LOG(ERROR)
+        << "ELF file " << path << " has an unsupported class or byte order";
+    return false;
+  }
+
+  const auto is_64bit = kELFClass64 == elf_class;
+  const auto addr_size = is_64bit ? 8UL : 4UL;
+  const auto ehdr_size = is_64bit ? 64UL : 52UL;
+  const auto phdr_size = is_64bit ? 56UL : 32UL;
+  if (ehdr_size > file_size) {
+    LOG(ERROR)
+        << "ELF file " << path << " has a truncated file header";
+    return false;
+  }
+
+  ELFReader reader(file_data, kELFDataBigEndian == elf_data);
+  entry_point = reader.Read(24, addr_size);
+  auto phoff = reader.Read(24 + addr_size, addr_size);
+  auto phentsize = reader.Read(ehdr_size - 10, 2);
+  auto phnum = reader.Read(ehdr_size - 8, 2);
+
+  if (kELFExtendedNumProgramHeaders == phnum) {
+    LOG(ERROR)
+        << "ELF file " << path << " has too many program headers";
+    return false;
+  }
+
+  if (phnum && (phentsize < phdr_size || phoff > file_size ||
+                phnum > (file_size - phoff) / phentsize)) {
+    LOG(ERROR)
+        << "ELF file " << path << " has a truncated program header table";
+    return false;
+  }
+
+  for (uint64_t i = 0; i < phnum; ++i) {
+    auto phdr = phoff + i * phentsize;
+    if (kELFProgramHeaderLoad != reader.Read(phdr, 4)) {
+      continue;
+    }
+
+    uint64_t flags, offset, vaddr, filesz, memsz;
+    if (is_64bit) {
+      flags = reader.Read(phdr + 4, 4);
+      offset = reader.Read(phdr + 8, 8);
+      vaddr = reader.Read(phdr + 16, 8);
+      filesz = reader.Read(phdr + 32, 8);
+      memsz = reader.Read(phdr + 40, 8);
+    } else {
+      offset = reader.Read(phdr + 4, 4);
+      vaddr = reader.Read(phdr + 8, 4);
+      filesz = reader.Read(phdr + 16, 4);
+      memsz = reader.Read(phdr + 20, 4);
+      flags = reader.Read(phdr + 24, 4);
+    }
+
+    if (offset > file_size || filesz > file_size - offset) {
+      LOG(ERROR)
+          << "Segment at " << std::hex << vaddr << std::dec
+          << " of ELF file " << path << " extends past the end of the file";
+      return false;
+    }
+
+    if (!memsz) {
+      continue;
+    }
+
+    ImageSegment seg = {};
+    seg.address = vaddr;
+    seg.size = memsz;
+    seg.data = &(file_data[offset]);
+    seg.data_size = std::min(filesz, memsz);
+    seg.is_readable = !!(kELFSegmentReadable & flags);
+    seg.is_writable = !!(kELFSegmentWritable & flags);
+    seg.is_executable = !!(kELFSegmentExecutable & flags);
+    segments.push_back(seg);
+  }
+  return true;
+}
+
+// Treat the whole file as one segment.
+void MappedImage::LoadRaw(uint64_t base_address) {
+  ImageSegment seg = {};
+  seg.address = base_address;
+  seg.size = file_size;
+  seg.data = file_data;
+  seg.data_size = file_size;
+  seg.is_readable = true;
+  seg.is_executable = true;
+  segments.push_back(seg);
+  entry_point = base_address;
+}
+
+const ImageSegment *MappedImage::FindSegment(uint64_t addr) const {
+  auto it = std::upper_bound(
+      segments.begin(), segments.end(), addr,
+      [] (uint64_t a, const ImageSegment &seg) {
+        return a < seg.address;
+      });
+  if (it == segments.begin()) {
+    return nullptr;
+  }
+  --it;
+  if (it->Contains(addr)) {
+    return &*it;
+  } else {
+    return nullptr;
+  }
+}
+
+bool MappedImage::IsMapped(uint64_t addr) const {
+  return nullptr != FindSegment(addr);
+}
+
+bool MappedImage::IsExecutable(uint64_t addr) const {
+  auto seg = FindSegment(addr);
+  return seg && seg->is_executable;
+}
+
+const uint8_t *MappedImage::ToPointer(uint64_t addr, size_t *num_bytes) const {
+  auto seg = FindSegment(addr);
+  auto offset = addr - (seg ? seg->address : 0);
+  if (!seg || offset >= seg->data_size) {
+    *num_bytes = 0;
+    return nullptr;
+  }
+  *num_bytes = static_cast<size_t>(seg->data_size - offset);
+  return &(seg->data[offset]);
+}
+
+size_t MappedImage::Read(uint64_t addr, void *buff, size_t size) const {
+  auto out = reinterpret_cast<uint8_t *>(buff);
+  size_t num_read = 0;
+  while (num_read < size) {
+    auto seg = FindSegment(addr);
+    if (!seg) {
+      break;
+    }
+
+    auto offset = addr - seg->address;
+    auto num_left = size - num_read;
+    auto num_in_seg = static_cast<size_t>(
+        std::min<uint64_t>(num_left, seg->size - offset));
+    auto num_in_file = static_cast<size_t>(
+        offset < seg->data_size ?
+        std::min<uint64_t>(num_in_seg, seg->data_size - offset) : 0);
+
+    if (num_in_file) {
+      memcpy(&(out[num_read]), &(seg->data[offset]), num_in_file);
+    }
+    memset(&(out[num_read + num_in_file]), 0, num_in_seg - num_in_file);
+    num_read += num_in_seg;
+    addr += num_in_seg;
+    if (!addr) {
+      break;  // Wrapped around the address space.
+    }
+  }
+  return num_read;
+}
+
+void MappedImage::ForEachExecutableRange(
+    ExecutableRangeVisitor visitor) const {
+  auto has_range = false;
+  uint64_t begin = 0;
+  uint64_t end = 0;
+  for (const auto &seg : segments) {
+    if (!seg.is_executable) {
+      continue;
+    }
+    if (has_range && seg.address == end) {
+      end += seg.size;
+      continue;
+    }
+    if (has_range && !visitor(begin, end)) {
+      return;
+    }
+    has_range = true;
+    begin = seg.address;
+    end = seg.address + seg.size;
+  }
+  if (has_range) {
+    visitor(begin, end);
+  }
+}
+
+}  // namespace remill
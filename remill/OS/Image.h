@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_OS_IMAGE_H_
+#define REMILL_OS_IMAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace remill {
+
+// One loadable segment of a `MappedImage`. The first `data_size` bytes of the
+// segment are backed by the file, and the rest are zero.
+struct ImageSegment {
+  uint64_t address;
+  uint64_t size;
+  const uint8_t *data;  // Points into the mapped file.
+  uint64_t data_size;
+  bool is_readable;
+  bool is_writable;
+  bool is_executable;
+
+  inline bool Contains(uint64_t addr) const {
+    return address <= addr && (addr - address) < size;
+  }
+};
+
+using ExecutableRangeVisitor =
+    std::function<bool(uint64_t begin, uint64_t end)>;
+
+// A read-only, memory-mapped view of a binary image. The file is mapped once
+// and segment bytes are read in place, so nothing is copied or paged in until
+// it is actually used. This makes it suitable for very large inputs, e.g.
+// firmware images.
+class MappedImage {
+ public:
+  ~MappedImage(void);
+
+  // Map the file at `path`. ELF files are loaded according to their program
+  // headers. Any other file is treated as a flat binary that is loaded, in
+  // one readable and executable segment, at `base_address`. Returns `nullptr`
+  // if the file can't be mapped, or is a malformed ELF file.
+  static std::unique_ptr<MappedImage> Open(const std::string &path,
+                                           uint64_t base_address=0);
+
+  inline bool IsELF(void) const {
+    return is_elf;
+  }
+
+  // Entry point of an ELF image, or the base address of a flat binary.
+  inline uint64_t EntryPoint(void) const {
+    return entry_point;
+  }
+
+  // Segments, sorted by address.
+  inline const std::vector<ImageSegment> &Segments(void) const {
+    return segments;
+  }
+
+  // Returns the segment containing `addr`, or `nullptr`.
+  const ImageSegment *FindSegment(uint64_t addr) const;
+
+  bool IsMapped(uint64_t addr) const;
+  bool IsExecutable(uint64_t addr) const;
+
+  // Returns a pointer to the file-backed byte at `addr`, and sets `num_bytes`
+  // to the number of file-backed bytes that follow it in the same segment.
+  // Returns `nullptr` if `addr` is unmapped or in the zero-filled part of a
+  // segment. The pointer is valid for the lifetime of the image.
+  const uint8_t *ToPointer(uint64_t addr, size_t *num_bytes) const;
+
+  // Copy up to `size` bytes starting at `addr` into `buff`. Zero-filled
+  // bytes read as zero, and reads can span adjacent segments. Returns the
+  // number of bytes read, which is less than `size` if an unmapped address
+  // was reached.
+  size_t Read(uint64_t addr, void *buff, size_t size) const;
+
+  // Call `visitor` on every maximal range `[begin, end)` of executable
+  // addresses, in order, until it returns `false`. Adjacent executable
+  // segments are merged into one range.
+  void ForEachExecutableRange(ExecutableRangeVisitor visitor) const;
+
+ private:
+  MappedImage(void);
+  MappedImage(const MappedImage &) = delete;
+  MappedImage &operator=(const MappedImage &) = delete;
+
+  bool LoadELF(const std::string &path);
+  void LoadRaw(uint64_t base_address);
+
+  const uint8_t *file_data;
+  size_t file_size;
+  bool is_elf;
+  uint64_t entry_point;
+  std::vector<ImageSegment> segments;
+};
+
+}  // namespace remill
+
+#endif  // REMILL_OS_IMAGE_H_
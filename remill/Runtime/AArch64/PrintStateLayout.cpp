@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <cstdio>
+
+#include "remill/Arch/AArch64/Runtime/State.h"
+
+// This is used by the `print_state_layout.sh` script to describe where each
+// register lives in the `State` structure. See
+// `remill/Runtime/X86/PrintStateLayout.cpp`.
+
+#define PRINT_FIELD(name, field) \
+    printf("STATE_FIELD(\"%s\", %lu, %lu)\n", name, \
+           offsetof(State, field), sizeof(reinterpret_cast<State *>(0)->field))
+
+int main(void) {
+  printf("/* Auto-generated file! Don't modify! */\n\n");
+  printf("STATE_SIZE(%lu)\n", sizeof(State));
+
+  printf("STATE_FIELD(\"hyper_call\", 0, %lu)\n", sizeof(ArchState));
+
+  for (auto i = 0U; i < kNumVecRegisters; ++i) {
+    printf("STATE_FIELD(\"simd.v[%u]\", %lu, %lu)\n", i,
+           offsetof(State, simd) + i * sizeof(vec128_t), sizeof(vec128_t));
+  }
+
+  for (auto i = 0U; i <= 30; ++i) {
+    printf("STATE_FIELD(\"gpr.x%u\", %lu, %lu)\n", i,
+           offsetof(State, gpr.x0) + i * (offsetof(State, gpr.x1) -
+                                          offsetof(State, gpr.x0)),
+           sizeof(Reg));
+  }
+  PRINT_FIELD("gpr.sp", gpr.sp);
+  PRINT_FIELD("gpr.pc", gpr.pc);
+
+  PRINT_FIELD("nzcv", nzcv);
+  PRINT_FIELD("fpcr", fpcr);
+  PRINT_FIELD("fpsr", fpsr);
+
+  PRINT_FIELD("sr.tpidr_el0", sr.tpidr_el0);
+  PRINT_FIELD("sr.tpidrro_el0", sr.tpidrro_el0);
+  PRINT_FIELD("sr.n", sr.n);
+  PRINT_FIELD("sr.z", sr.z);
+  PRINT_FIELD("sr.c", sr.c);
+  PRINT_FIELD("sr.v", sr.v);
+  PRINT_FIELD("sr.ixc", sr.ixc);
+  PRINT_FIELD("sr.ofc", sr.ofc);
+  PRINT_FIELD("sr.ufc", sr.ufc);
+  PRINT_FIELD("sr.idc", sr.idc);
+  return 0;
+}
@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "remill/Runtime/AddressSpace.h"
+
+namespace remill {
+
+// A reference-counted page of guest memory. A page with more than one
+// reference is shared and must be copied before it is written.
+struct Page {
+  std::atomic<uint32_t> num_refs;
+  alignas(16) uint8_t data[AddressSpace::kPageSize];
+};
+
+namespace {
+
+// A page-sized run of zeroes, used to initialize new pages.
+static const uint8_t gZeroPage[AddressSpace::kPageSize] = {};
+
+static Page *NewPage(const uint8_t *data) {
+  auto page = new Page;
+  page->num_refs.store(1, std::memory_order_relaxed);
+  memcpy(page->data, data, AddressSpace::kPageSize);
+  return page;
+}
+
+static Page *AcquirePage(Page *page) {
+  page->num_refs.fetch_add(1, std::memory_order_relaxed);
+  return page;
+}
+
+static void ReleasePage(Page *page) {
+  if (1 == page->num_refs.fetch_sub(1, std::memory_order_acq_rel)) {
+    delete page;
+  }
+}
+
+// Source of address space IDs. Zero is never used, so that it can mean "no
+// base address space".
+static std::atomic<uint64_t> gNextAddressSpaceId(1);
+
+}  // namespace
+
+AddressSpace::AddressSpace(void)
+    : id(gNextAddressSpaceId.fetch_add(1, std::memory_order_relaxed)),
+      version(0),
+      base_id(0),
+      base_version(0),
+      last_read_page_num(0),
+      last_read_page(nullptr),
+      last_write_page_num(0),
+      last_write_page(nullptr) {}
+
+AddressSpace::~AddressSpace(void) {
+  ClearPages();
+}
+
+void AddressSpace::AddMap(uint64_t base, size_t size) {
+  auto first = base >> kPageShift;
+  auto last = (base + size + kPageMask) >> kPageShift;
+  for (auto page_num = first; page_num < last; ++page_num) {
+    auto &page = pages[page_num];
+    if (!page) {
+      page = NewPage(gZeroPage);
+      MarkDirty(page_num);
+    }
+  }
+}
+
+void AddressSpace::RemoveMap(uint64_t base, size_t size) {
+  auto first = base >> kPageShift;
+  auto last = (base + size + kPageMask) >> kPageShift;
+  for (auto page_num = first; page_num < last; ++page_num) {
+    auto page_it = pages.find(page_num);
+    if (page_it != pages.end()) {
+      ReleasePage(page_it->second);
+      pages.erase(page_it);
+      MarkDirty(page_num);
+    }
+  }
+  FlushCache();
+}
+
+bool AddressSpace::IsMapped(uint64_t addr) const {
+  return nullptr != FindPage(addr >> kPageShift);
+}
+
+Page *AddressSpace::FindPage(uint64_t page_num) const {
+  auto page_it = pages.find(page_num);
+  if (page_it == pages.end()) {
+    return nullptr;
+  } else {
+    return page_it->second;
+  }
+}
+
+// Find a page that we can write to. This breaks the sharing of a page if it
+// has multiple referents.
+uint8_t *AddressSpace::FindWritablePage(uint64_t page_num) {
+  if (last_write_page && last_write_page_num == page_num) {
+    return last_write_page;
+  }
+
+  auto page_it = pages.find(page_num);
+  if (page_it == pages.end()) {
+    return nullptr;
+  }
+
+  auto page = page_it->second;
+  if (1 != page->num_refs.load(std::memory_order_acquire)) {
+    auto copy = NewPage(page->data);
+    ReleasePage(page);
+    page_it->second = copy;
+    page = copy;
+    MarkDirty(page_num);
+
+    // The read cache may point into the shared page.
+    if (last_read_page_num == page_num) {
+      last_read_page = nullptr;
+    }
+  }
+
+  last_write_page_num = page_num;
+  last_write_page = page->data;
+  return page->data;
+}
+
+const uint8_t *AddressSpace::ToReadOnlyPointer(uint64_t addr) {
+  auto page_num = addr >> kPageShift;
+  if (!last_read_page || last_read_page_num != page_num) {
+    auto page = FindPage(page_num);
+    if (!page) {
+      return nullptr;
+    }
+    last_read_page_num = page_num;
+    last_read_page = page->data;
+  }
+  return &(last_read_page[addr & kPageMask]);
+}
+
+uint8_t *AddressSpace::ToReadWritePointer(uint64_t addr) {
+  auto data = FindWritablePage(addr >> kPageShift);
+  if (!data) {
+    return nullptr;
+  }
+  return &(data[addr & kPageMask]);
+}
+
+bool AddressSpace::TryRead(uint64_t addr, void *val, size_t size) {
+  auto bytes = reinterpret_cast<uint8_t *>(val);
+  while (size) {
+    auto data = ToReadOnlyPointer(addr);
+    if (!data) {
+      return false;
+    }
+    auto num_bytes = std::min<uint64_t>(size, kPageSize - (addr & kPageMask));
+    memcpy(bytes, data, num_bytes);
+    bytes += num_bytes;
+    addr += num_bytes;
+    size -= num_bytes;
+  }
+  return true;
+}
+
+bool AddressSpace::TryWrite(uint64_t addr, const void *val, size_t size) {
+  auto bytes = reinterpret_cast<const uint8_t *>(val);
+  while (size) {
+    auto data = ToReadWritePointer(addr);
+    if (!data) {
+      return false;
+    }
+    auto num_bytes = std::min<uint64_t>(size, kPageSize - (addr & kPageMask));
+    memcpy(data, bytes, num_bytes);
+    bytes += num_bytes;
+    addr += num_bytes;
+    size -= num_bytes;
+  }
+  return true;
+}
+
+// Once this address space's pages are referenced by another address space,
+// none of them can be written in place.
+void AddressSpace::ShareAllPages(void) {
+  last_write_page = nullptr;
+}
+
+void AddressSpace::FlushCache(void) {
+  last_read_page = nullptr;
+  last_write_page = nullptr;
+}
+
+void AddressSpace::MarkDirty(uint64_t page_num) {
+  ++version;
+  if (base_id) {
+    dirty_pages.insert(page_num);
+  }
+}
+
+// Record that this address space and `that` now have identical pages.
+void AddressSpace::SyncWith(AddressSpace &that) {
+  base_id = that.id;
+  base_version = that.version;
+  dirty_pages.clear();
+}
+
+void AddressSpace::ClearPages(void) {
+  for (const auto &entry : pages) {
+    ReleasePage(entry.second);
+  }
+  pages.clear();
+  FlushCache();
+}
+
+AddressSpace *AddressSpace::Fork(void) {
+  auto that = new AddressSpace;
+  that->pages.reserve(pages.size());
+  for (const auto &entry : pages) {
+    that->pages[entry.first] = AcquirePage(entry.second);
+  }
+  ShareAllPages();
+  that->SyncWith(*this);
+  SyncWith(*that);
+  return that;
+}
+
+void AddressSpace::Restore(AddressSpace &that) {
+  if (&that == this) {
+    return;
+  }
+
+  // Fast path: only the pages that we have changed since we were last in
+  // sync with `that` can differ.
+  if (base_id == that.id && base_version == that.version) {
+    for (auto page_num : dirty_pages) {
+      auto that_page = that.FindPage(page_num);
+      auto page_it = pages.find(page_num);
+      if (page_it != pages.end()) {
+        auto old_page = page_it->second;
+        if (that_page) {
+          page_it->second = AcquirePage(that_page);
+        } else {
+          pages.erase(page_it);
+        }
+        ReleasePage(old_page);
+      } else if (that_page) {
+        pages[page_num] = AcquirePage(that_page);
+      }
+    }
+
+  // Slow path: share all of the pages of `that`. Acquire before releasing,
+  // so that pages common to both address spaces never drop to zero
+  // references.
+  } else {
+    std::unordered_map<uint64_t, Page *> new_pages;
+    new_pages.reserve(that.pages.size());
+    for (const auto &entry : that.pages) {
+      new_pages[entry.first] = AcquirePage(entry.second);
+    }
+    ClearPages();
+    pages.swap(new_pages);
+  }
+
+  ++version;
+  FlushCache();
+  that.ShareAllPages();
+  SyncWith(that);
+}
+
+size_t AddressSpace::NumPages(void) const {
+  return pages.size();
+}
+
+size_t AddressSpace::NumPrivatePages(void) const {
+  size_t num_private = 0;
+  for (const auto &entry : pages) {
+    if (1 == entry.second->num_refs.load(std::memory_order_relaxed)) {
+      ++num_private;
+    }
+  }
+  return num_private;
+}
+
+ExecutionContext::ExecutionContext(const void *state_, size_t state_size_,
+                                   AddressSpace *memory_)
+    : state(reinterpret_cast<const uint8_t *>(state_),
+            reinterpret_cast<const uint8_t *>(state_) + state_size_),
+      memory(memory_) {
+  CHECK(nullptr != memory)
+      << "Execution context must be backed by an address space.";
+}
+
+ExecutionContext::~ExecutionContext(void) {
+  delete memory;
+}
+
+ExecutionContext *ExecutionContext::Fork(void) {
+  return new ExecutionContext(state.data(), state.size(), memory->Fork());
+}
+
+void ExecutionContext::Restore(ExecutionContext &snapshot) {
+  CHECK(snapshot.state.size() == state.size())
+      << "Cannot restore a " << state.size() << "-byte state from a "
+      << snapshot.state.size() << "-byte snapshot.";
+  memcpy(state.data(), snapshot.state.data(), state.size());
+  memory->Restore(*snapshot.memory);
+}
+
+}  // namespace remill
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_RUNTIME_ADDRESSSPACE_H_
+#define REMILL_RUNTIME_ADDRESSSPACE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct Memory;
+
+namespace remill {
+
+struct Page;
+
+// A sparse, page-granular model of a guest address space. Pages are reference
+// counted and shared copy-on-write between an address space and all of its
+// forks and snapshots, so forking or restoring costs one pointer copy per
+// mapped page and no page data is copied until one of the sharers writes to
+// the page.
+//
+// An `AddressSpace` is meant to be used by one thread at a time. Distinct
+// address spaces that share pages can be used concurrently.
+class AddressSpace {
+ public:
+  enum : uint64_t {
+    kPageShift = 12,
+    kPageSize = 1ULL << kPageShift,
+    kPageMask = kPageSize - 1
+  };
+
+  AddressSpace(void);
+  ~AddressSpace(void);
+
+  // Map the zero-filled range `[base, base + size)`. Both `base` and `size`
+  // are rounded out to page boundaries. Already mapped pages are kept.
+  void AddMap(uint64_t base, size_t size);
+
+  // Unmap the range `[base, base + size)`.
+  void RemoveMap(uint64_t base, size_t size);
+
+  bool IsMapped(uint64_t addr) const;
+
+  // Read or write `size` bytes at `addr`. Accesses can straddle pages. Returns
+  // `false`, having possibly done a partial access, if any byte is unmapped.
+  bool TryRead(uint64_t addr, void *val, size_t size);
+  bool TryWrite(uint64_t addr, const void *val, size_t size);
+
+  // Returns a pointer to the host byte backing `addr`, or `nullptr` if `addr`
+  // is unmapped. The pointer is valid until the next fork, snapshot, restore,
+  // or unmap of this address space. A writable pointer is only valid up to
+  // the end of its page; getting one breaks sharing of that page.
+  const uint8_t *ToReadOnlyPointer(uint64_t addr);
+  uint8_t *ToReadWritePointer(uint64_t addr);
+
+  // Returns a new address space that shares all of this address space's
+  // pages copy-on-write. Snapshots are forks that are only ever used as the
+  // source of a later `Restore`.
+  AddressSpace *Fork(void);
+
+  // Make this address space's contents identical to those of `that`. Pages
+  // are shared, not copied. If `that` is unchanged since it was last forked
+  // from or restored into this address space (or vice versa), then only the
+  // pages that this address space has since written, mapped or unmapped are
+  // touched.
+  void Restore(AddressSpace &that);
+
+  // Number of mapped pages, and number of those whose data is private to
+  // this address space (i.e. not shared with a fork or snapshot).
+  size_t NumPages(void) const;
+  size_t NumPrivatePages(void) const;
+
+  // The runtime passes address spaces around as the opaque `Memory *` that
+  // lifted code threads through memory intrinsics.
+  inline Memory *ToMemory(void) {
+    return reinterpret_cast<Memory *>(this);
+  }
+
+  inline static AddressSpace *FromMemory(Memory *memory) {
+    return reinterpret_cast<AddressSpace *>(memory);
+  }
+
+ private:
+  AddressSpace(const AddressSpace &) = delete;
+  AddressSpace(const AddressSpace &&) = delete;
+  AddressSpace &operator=(const AddressSpace &) = delete;
+  AddressSpace &operator=(const AddressSpace &&) = delete;
+
+  Page *FindPage(uint64_t page_num) const;
+  uint8_t *FindWritablePage(uint64_t page_num);
+  void ShareAllPages(void);
+  void ClearPages(void);
+  void FlushCache(void);
+  void MarkDirty(uint64_t page_num);
+  void SyncWith(AddressSpace &that);
+
+  std::unordered_map<uint64_t, Page *> pages;
+
+  // Unique ID of this address space, and a version number that changes
+  // every time that a page is added, removed, or copied on write.
+  const uint64_t id;
+  uint64_t version;
+
+  // The address space that this one was last forked from, forked into, or
+  // restored from, and its version at that time. The two had identical pages
+  // then, so they now only differ in `dirty_pages`, unless the other one has
+  // a newer version.
+  uint64_t base_id;
+  uint64_t base_version;
+  std::unordered_set<uint64_t> dirty_pages;
+
+  // One-entry lookaside caches for the last page read and written. The write
+  // cache only ever holds a page that is private to this address space.
+  uint64_t last_read_page_num;
+  const uint8_t *last_read_page;
+  uint64_t last_write_page_num;
+  uint8_t *last_write_page;
+};
+
+// Machine state together with the address space behind it. The state is an
+// opaque copy of an architecture-specific `State` structure, which is plain
+// old data and so can be cloned with `memcpy`.
+class ExecutionContext {
+ public:
+  // Takes ownership of `memory_`.
+  ExecutionContext(const void *state_, size_t state_size_,
+                   AddressSpace *memory_);
+  ~ExecutionContext(void);
+
+  // Clone the state and fork the memory of this context.
+  ExecutionContext *Fork(void);
+
+  // Restore the state and memory of this context from `snapshot`. The
+  // snapshot must hold a state of the same size.
+  void Restore(ExecutionContext &snapshot);
+
+  inline void *State(void) {
+    return state.data();
+  }
+
+  inline size_t StateSize(void) const {
+    return state.size();
+  }
+
+  inline AddressSpace *Memory(void) const {
+    return memory;
+  }
+
+ private:
+  ExecutionContext(void) = delete;
+  ExecutionContext(const ExecutionContext &) = delete;
+  ExecutionContext &operator=(const ExecutionContext &) = delete;
+
+  std::vector<uint8_t> state;
+  AddressSpace * const memory;
+};
+
+}  // namespace remill
+
+#endif  // REMILL_RUNTIME_ADDRESSSPACE_H_
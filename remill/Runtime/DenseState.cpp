@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <cstring>
+
+#include "remill/Runtime/DenseState.h"
+
+namespace remill {
+namespace {
+
+#define STATE_SIZE(size)
+#define STATE_FIELD(name, offset, size) {name, offset, size},
+
+static const StateLayoutConverter::Field kX86Fields[] = {
+#include "generated/Arch/X86/StateLayout.inc"
+};
+
+static const StateLayoutConverter::Field kX86DenseFields[] = {
+#include "generated/Arch/X86/DenseStateLayout.inc"
+};
+
+static const StateLayoutConverter::Field kAArch64Fields[] = {
+#include "generated/Arch/AArch64/StateLayout.inc"
+};
+
+static const StateLayoutConverter::Field kAArch64DenseFields[] = {
+#include "generated/Arch/AArch64/DenseStateLayout.inc"
+};
+
+#undef STATE_SIZE
+#undef STATE_FIELD
+#define STATE_SIZE(size) size;
+#define STATE_FIELD(name, offset, size)
+
+static const size_t kX86StateSize =
+#include "generated/Arch/X86/StateLayout.inc"
+
+static const size_t kX86DenseStateSize =
+#include "generated/Arch/X86/DenseStateLayout.inc"
+
+static const size_t kAArch64StateSize =
+#include "generated/Arch/AArch64/StateLayout.inc"
+
+static const size_t kAArch64DenseStateSize =
+#include "generated/Arch/AArch64/DenseStateLayout.inc"
+
+#undef STATE_SIZE
+#undef STATE_FIELD
+
+static_assert(sizeof(kX86Fields) == sizeof(kX86DenseFields),
+              "Default and dense x86 layouts have different fields.");
+
+static_assert(sizeof(kAArch64Fields) == sizeof(kAArch64DenseFields),
+              "Default and dense AArch64 layouts have different fields.");
+
+}  // namespace
+
+StateLayoutConverter::StateLayoutConverter(
+    const Field *fields, const Field *dense_fields, size_t num_fields,
+    size_t state_size_, size_t dense_state_size_)
+    : state_size(state_size_),
+      dense_state_size(dense_state_size_) {
+  for (size_t i = 0; i < num_fields; ++i) {
+    const auto &field = fields[i];
+    const auto &dense_field = dense_fields[i];
+    CHECK(!strcmp(field.name, dense_field.name))
+        << "Field " << field.name << " of the default State layout doesn't "
+        << "match field " << dense_field.name << " of the dense layout";
+    CHECK(field.size == dense_field.size)
+        << "Field " << field.name << " has different sizes in the default "
+        << "and dense State layouts";
+
+    if (!runs.empty()) {
+      auto &run = runs.back();
+      if ((run.offset + run.size) == field.offset &&
+          (run.dense_offset + run.size) == dense_field.offset) {
+        run.size += field.size;
+        continue;
+      }
+    }
+    runs.push_back({field.offset, dense_field.offset, field.size});
+  }
+}
+
+const StateLayoutConverter *StateLayoutConverter::Get(ArchName arch_name) {
+  switch (arch_name) {
+    case kArchX86:
+    case kArchX86_AVX:
+    case kArchX86_AVX512:
+    case kArchAMD64:
+    case kArchAMD64_AVX:
+    case kArchAMD64_AVX512: {
+      static const StateLayoutConverter converter(
+          kX86Fields, kX86DenseFields,
+          sizeof(kX86Fields) / sizeof(kX86Fields[0]),
+          kX86StateSize, kX86DenseStateSize);
+      return &converter;
+    }
+
+    case kArchAArch64LittleEndian: {
+      static const StateLayoutConverter converter(
+          kAArch64Fields, kAArch64DenseFields,
+          sizeof(kAArch64Fields) / sizeof(kAArch64Fields[0]),
+          kAArch64StateSize, kAArch64DenseStateSize);
+      return &converter;
+    }
+
+    default:
+      return nullptr;
+  }
+}
+
+void StateLayoutConverter::ToDense(
+    const void *state, void *dense_state) const {
+  auto src = reinterpret_cast<const uint8_t *>(state);
+  auto dest = reinterpret_cast<uint8_t *>(dense_state);
+  memset(dest, 0, dense_state_size);
+  for (const auto &run : runs) {
+    memcpy(&(dest[run.dense_offset]), &(src[run.offset]), run.size);
+  }
+}
+
+void StateLayoutConverter::FromDense(
+    const void *dense_state, void *state) const {
+  auto src = reinterpret_cast<const uint8_t *>(dense_state);
+  auto dest = reinterpret_cast<uint8_t *>(state);
+  for (const auto &run : runs) {
+    memcpy(&(dest[run.offset]), &(src[run.dense_offset]), run.size);
+  }
+}
+
+}  // namespace remill
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_RUNTIME_DENSESTATE_H_
+#define REMILL_RUNTIME_DENSESTATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "remill/Arch/Name.h"
+
+namespace remill {
+
+// Converts between the default `State` structure layout, which is what tools
+// and snapshots see, and the dense layout used by semantics bitcode that was
+// compiled with `DENSE_STATE=1` (e.g. `amd64_avx_dense.bc`). The dense layout
+// drops the `volatile` padding that separates the flags and segment
+// registers, and groups the registers that most lifted code touches (GPRs,
+// the program counter, and flags) into the first cache lines.
+//
+// The field tables are generated by `scripts/<arch>/print_state_layout.sh`.
+class StateLayoutConverter {
+ public:
+  // Returns `nullptr` if there is no dense layout for `arch_name`.
+  static const StateLayoutConverter *Get(ArchName arch_name);
+
+  size_t StateSize(void) const {
+    return state_size;
+  }
+
+  size_t DenseStateSize(void) const {
+    return dense_state_size;
+  }
+
+  // Copy every register from a default-layout `State` into a dense one. The
+  // dense state's padding is zeroed.
+  void ToDense(const void *state, void *dense_state) const;
+
+  // Copy every register from a dense `State` into a default-layout one. The
+  // default state's `volatile` padding is left untouched.
+  void FromDense(const void *dense_state, void *state) const;
+
+  // One entry of a generated layout table.
+  struct Field {
+    const char *name;
+    uint32_t offset;
+    uint32_t size;
+  };
+
+ private:
+  StateLayoutConverter(const Field *fields, const Field *dense_fields,
+                       size_t num_fields, size_t state_size_,
+                       size_t dense_state_size_);
+
+  // A run of bytes that is contiguous in both layouts. Adjacent fields are
+  // coalesced, so that e.g. all vector registers are copied at once.
+  struct Run {
+    uint32_t offset;
+    uint32_t dense_offset;
+    uint32_t size;
+  };
+
+  const size_t state_size;
+  const size_t dense_state_size;
+  std::vector<Run> runs;
+};
+
+}  // namespace remill
+
+#endif  // REMILL_RUNTIME_DENSESTATE_H_
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "remill/Runtime/ExecutionCounters.h"
+
+namespace remill {
+
+void WriteExecutionCountersJSON(std::ostream &os,
+                                const ExecutionCounter *counters,
+                                uint64_t num_counters) {
+  os << "{\"counters\": [";
+  for (uint64_t i = 0; i < num_counters; ++i) {
+    if (i) {
+      os << ", ";
+    }
+
+    // Counter names are derived from ISEL names and program counters, so they
+    // never need escaping.
+    os << "{\"name\": \"" << counters[i].name << "\", \"count\": "
+       << *(counters[i].count) << "}";
+  }
+  os << "]}" << std::endl;
+}
+
+void WriteExecutionCountersCSV(std::ostream &os,
+                               const ExecutionCounter *counters,
+                               uint64_t num_counters) {
+  os << "name,count" << std::endl;
+  for (uint64_t i = 0; i < num_counters; ++i) {
+    os << counters[i].name << "," << *(counters[i].count) << std::endl;
+  }
+}
+
+}  // namespace remill
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_RUNTIME_EXECUTIONCOUNTERS_H_
+#define REMILL_RUNTIME_EXECUTIONCOUNTERS_H_
+
+#include <cstdint>
+#include <ostream>
+
+namespace remill {
+
+// An entry of the `__remill_execution_counters` table that is emitted into
+// lifted code by `EmitExecutionCounterTable`.
+struct ExecutionCounter {
+  const char *name;
+  const uint64_t *count;
+};
+
+// Write out execution counts as a JSON object of the form:
+//
+//    {"counters": [{"name": "isel_ADD_GPRv_GPRv_32", "count": 10}, ...]}
+void WriteExecutionCountersJSON(std::ostream &os,
+                                const ExecutionCounter *counters,
+                                uint64_t num_counters);
+
+// Write out execution counts as CSV, with a header row.
+void WriteExecutionCountersCSV(std::ostream &os,
+                               const ExecutionCounter *counters,
+                               uint64_t num_counters);
+
+}  // namespace remill
+
+#endif  // REMILL_RUNTIME_EXECUTIONCOUNTERS_H_
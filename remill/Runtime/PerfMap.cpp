@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+# include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+
+#include "remill/Runtime/PerfMap.h"
+
+namespace remill {
+namespace {
+
+// Record types and machine numbers of the jitdump format.
+enum : uint32_t {
+  kJITDumpMagic = 0x4A695444,  // "JiTD".
+  kJITDumpVersion = 1,
+
+  kJITCodeLoad = 0,
+  kJITCodeDebugInfo = 2,
+
+  kEM_386 = 3,
+  kEM_X86_64 = 62,
+  kEM_AARCH64 = 183
+};
+
+struct JITDumpHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t total_size;
+  uint32_t elf_mach;
+  uint32_t pad1;
+  uint32_t pid;
+  uint64_t timestamp;
+  uint64_t flags;
+};
+
+struct JITDumpRecordHeader {
+  uint32_t id;
+  uint32_t total_size;
+  uint64_t timestamp;
+};
+
+// Followed by the NUL-terminated name of the code, then the code itself.
+struct JITDumpCodeLoad {
+  JITDumpRecordHeader header;
+  uint32_t pid;
+  uint32_t tid;
+  uint64_t vma;
+  uint64_t code_addr;
+  uint64_t code_size;
+  uint64_t code_index;
+};
+
+// Followed by `nr_entry` entries.
+struct JITDumpDebugInfo {
+  JITDumpRecordHeader header;
+  uint64_t code_addr;
+  uint64_t nr_entry;
+};
+
+// Followed by the NUL-terminated file name.
+struct JITDumpDebugEntry {
+  uint64_t code_addr;
+  uint32_t line;
+  uint32_t discrim;
+};
+
+static_assert(40 == sizeof(JITDumpHeader),
+              "Invalid packing of `JITDumpHeader`.");
+
+static_assert(56 == sizeof(JITDumpCodeLoad),
+              "Invalid packing of `JITDumpCodeLoad`.");
+
+static_assert(32 == sizeof(JITDumpDebugInfo),
+              "Invalid packing of `JITDumpDebugInfo`.");
+
+static_assert(16 == sizeof(JITDumpDebugEntry),
+              "Invalid packing of `JITDumpDebugEntry`.");
+
+static uint32_t HostMachine(void) {
+#if defined(__x86_64__)
+  return kEM_X86_64;
+#elif defined(__i386__)
+  return kEM_386;
+#elif defined(__aarch64__)
+  return kEM_AARCH64;
+#else
+  return 0;
+#endif
+}
+
+// `perf record -k 1` timestamps samples with the monotonic clock, and `perf
+// inject` matches them up with jitdump records by time.
+static uint64_t Timestamp(void) {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL +
+         static_cast<uint64_t>(ts.tv_nsec);
+}
+
+static uint32_t ThreadId(void) {
+#ifdef __linux__
+  return static_cast<uint32_t>(syscall(SYS_gettid));
+#else
+  return static_cast<uint32_t>(getpid());
+#endif
+}
+
+static std::string DebugFileName(const GuestLocation &loc) {
+  std::stringstream ss;
+  ss << loc.isel_name << " (0x" << std::hex << loc.guest_pc << ")";
+  return ss.str();
+}
+
+}  // namespace
+
+std::string GuestCodeName(const std::string &name,
+                          const std::vector<GuestLocation> &locations) {
+  if (locations.empty()) {
+    return name;
+  }
+
+  auto min_pc = locations.front().guest_pc;
+  auto max_pc = min_pc;
+  for (const auto &loc : locations) {
+    min_pc = std::min(min_pc, loc.guest_pc);
+    max_pc = std::max(max_pc, loc.guest_pc);
+  }
+
+  std::stringstream ss;
+  ss << name << " [0x" << std::hex << min_pc << ", 0x" << max_pc << "]";
+  return ss.str();
+}
+
+PerfMapWriter::PerfMapWriter(const std::string &path_, FILE *file_)
+    : path(path_),
+      file(file_) {}
+
+PerfMapWriter::~PerfMapWriter(void) {
+  fclose(file);
+}
+
+std::unique_ptr<PerfMapWriter> PerfMapWriter::Open(void) {
+  std::stringstream ss;
+  ss << "/tmp/perf-" << getpid() << ".map";
+  return Open(ss.str());
+}
+
+std::unique_ptr<PerfMapWriter> PerfMapWriter::Open(const std::string &path) {
+  auto file = fopen(path.c_str(), "w");
+  if (!file) {
+    LOG(ERROR)
+        << "Unable to open perf map " << path << ": " << strerror(errno);
+    return nullptr;
+  }
+  return std::unique_ptr<PerfMapWriter>(new PerfMapWriter(path, file));
+}
+
+void PerfMapWriter::AddCode(const void *code, size_t size,
+                            const std::string &name) {
+  std::lock_guard<std::mutex> locker(lock);
+  fprintf(file, "%lx %lx %s\n",
+          static_cast<unsigned long>(reinterpret_cast<uintptr_t>(code)),
+          static_cast<unsigned long>(size), name.c_str());
+  fflush(file);
+}
+
+JITDumpWriter::JITDumpWriter(const std::string &path_, FILE *file_,
+                             void *marker_, size_t marker_size_)
+    : path(path_),
+      file(file_),
+      marker(marker_),
+      marker_size(marker_size_),
+      next_code_index(0) {}
+
+JITDumpWriter::~JITDumpWriter(void) {
+  munmap(marker, marker_size);
+  fclose(file);
+}
+
+std::unique_ptr<JITDumpWriter> JITDumpWriter::Open(void) {
+  return Open("/tmp");
+}
+
+std::unique_ptr<JITDumpWriter> JITDumpWriter::Open(const std::string &dir) {
+  std::stringstream ss;
+  ss << dir << "/jit-" << getpid() << ".dump";
+  auto path = ss.str();
+
+  auto file = fopen(path.c_str(), "w+");
+  if (!file) {
+    LOG(ERROR)
+        << "Unable to open jitdump file " << path << ": " << strerror(errno);
+    return nullptr;
+  }
+
+  JITDumpHeader header = {};
+  header.magic = kJITDumpMagic;
+  header.version = kJITDumpVersion;
+  header.total_size = sizeof(header);
+  header.elf_mach = HostMachine();
+  header.pid = static_cast<uint32_t>(getpid());
+  header.timestamp = Timestamp();
+  if (1 != fwrite(&header, sizeof(header), 1, file) || fflush(file)) {
+    LOG(ERROR)
+        << "Unable to write jitdump file " << path << ": " << strerror(errno);
+    fclose(file);
+    return nullptr;
+  }
+
+  // The executable mapping of the file is what `perf record` looks for. Its
+  // `mmap` event tells `perf inject` where to find the jitdump file.
+  auto marker_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  auto marker = mmap(nullptr, marker_size, PROT_READ | PROT_EXEC,
+                     MAP_PRIVATE, fileno(file), 0);
+  if (MAP_FAILED == marker) {
+    LOG(ERROR)
+        << "Unable to map jitdump file " << path << ": " << strerror(errno);
+    fclose(file);
+    return nullptr;
+  }
+
+  return std::unique_ptr<JITDumpWriter>(
+      new JITDumpWriter(path, file, marker, marker_size));
+}
+
+void JITDumpWriter::Write(const void *data, size_t size) {
+  if (size && 1 != fwrite(data, size, 1, file)) {
+    LOG(ERROR)
+        << "Unable to write jitdump file " << path << ": " << strerror(errno);
+  }
+}
+
+void JITDumpWriter::AddCode(const void *code, size_t size,
+                            const std::string &name,
+                            const std::vector<GuestLocation> &locations) {
+  std::lock_guard<std::mutex> locker(lock);
+  auto code_addr = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(code));
+  auto timestamp = Timestamp();
+
+  // The line table of some code has to come before the code.
+  if (!locations.empty()) {
+    std::vector<std::string> file_names;
+    file_names.reserve(locations.size());
+
+    JITDumpDebugInfo info = {};
+    info.header.id = kJITCodeDebugInfo;
+    info.header.total_size = sizeof(info);
+    info.header.timestamp = timestamp;
+    info.code_addr = code_addr;
+    info.nr_entry = locations.size();
+    for (const auto &loc : locations) {
+      file_names.push_back(DebugFileName(loc));
+      info.header.total_size += sizeof(JITDumpDebugEntry) +
+                                file_names.back().size() + 1;
+    }
+
+    Write(&info, sizeof(info));
+    for (size_t i = 0; i < locations.size(); ++i) {
+      JITDumpDebugEntry entry = {};
+      entry.code_addr = locations[i].native_address;
+      entry.line = static_cast<uint32_t>(locations[i].guest_pc);
+      Write(&entry, sizeof(entry));
+      Write(file_names[i].c_str(), file_names[i].size() + 1);
+    }
+  }
+
+  JITDumpCodeLoad load = {};
+  load.header.id = kJITCodeLoad;
+  load.header.total_size = static_cast<uint32_t>(
+      sizeof(load) + name.size() + 1 + size);
+  load.header.timestamp = timestamp;
+  load.pid = static_cast<uint32_t>(getpid());
+  load.tid = ThreadId();
+  load.vma = code_addr;
+  load.code_addr = code_addr;
+  load.code_size = size;
+  load.code_index = next_code_index++;
+
+  Write(&load, sizeof(load));
+  Write(name.c_str(), name.size() + 1);
+  Write(code, size);
+  fflush(file);
+}
+
+}  // namespace remill
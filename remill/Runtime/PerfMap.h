@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_RUNTIME_PERFMAP_H_
+#define REMILL_RUNTIME_PERFMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace remill {
+
+// The guest instruction that native code, starting at `native_address`, was
+// compiled from. The guest `PC` and ISEL name come from the `!remill.pc`
+// metadata and debug locations that the lifter attaches to lifted code (see
+// `GetGuestPC` in `remill/BC/Lifter.h`).
+struct GuestLocation {
+  uint64_t native_address;
+  uint64_t guest_pc;
+  std::string isel_name;
+};
+
+// Name JIT-compiled lifted code after the guest code that it implements, e.g.
+// `guest_401000 [0x401000, 0x401017]`. The name of a block of lifted code
+// with no known guest locations is just `name`.
+std::string GuestCodeName(const std::string &name,
+                          const std::vector<GuestLocation> &locations);
+
+// Writes a perf map, i.e. `/tmp/perf-<pid>.map`. `perf report` uses it to
+// name the samples that hit JIT-compiled code, which otherwise show up as
+// anonymous memory. Each line of the map names one range of native code:
+//
+//    <start address> <size> <name>
+//
+// Lines are flushed as they are added, because `perf` reads the map after the
+// process exits, which might not be a clean exit.
+class PerfMapWriter {
+ public:
+  ~PerfMapWriter(void);
+
+  // Open `/tmp/perf-<pid>.map` for the current process.
+  static std::unique_ptr<PerfMapWriter> Open(void);
+
+  // Open the perf map at `path`. Returns `nullptr` on failure.
+  static std::unique_ptr<PerfMapWriter> Open(const std::string &path);
+
+  // Add a range of native code. This is safe to call from multiple threads.
+  void AddCode(const void *code, size_t size, const std::string &name);
+
+  const std::string path;
+
+ private:
+  PerfMapWriter(void) = delete;
+  PerfMapWriter(const PerfMapWriter &) = delete;
+  PerfMapWriter &operator=(const PerfMapWriter &) = delete;
+
+  PerfMapWriter(const std::string &path_, FILE *file_);
+
+  std::mutex lock;
+  FILE * const file;
+};
+
+// Writes a jitdump file, i.e. `<dir>/jit-<pid>.dump`, which is the format of
+// `tools/perf/Documentation/jitdump-specification.txt` in the Linux sources.
+// Unlike a perf map, a jitdump file includes a copy of the native code, so
+// that `perf annotate` can disassemble it, and a line table that maps native
+// addresses back to guest instructions. The line table has one entry per
+// `GuestLocation`, whose "file name" is the ISEL name and guest `PC`, and
+// whose "line" is the low 32 bits of the guest `PC`.
+//
+// To use it, record with a monotonic clock, then inject the JIT-compiled code
+// into the recording:
+//
+//    perf record -k 1 <program>
+//    perf inject --jit -i perf.data -o perf.jit.data
+//    perf report -i perf.jit.data
+//
+// `perf record` only finds the jitdump file if the process maps it into
+// memory as executable, which `Open` does.
+class JITDumpWriter {
+ public:
+  ~JITDumpWriter(void);
+
+  // Open `/tmp/jit-<pid>.dump` for the current process.
+  static std::unique_ptr<JITDumpWriter> Open(void);
+
+  // Open `<dir>/jit-<pid>.dump` for the current process. Returns `nullptr` on
+  // failure.
+  static std::unique_ptr<JITDumpWriter> Open(const std::string &dir);
+
+  // Add a range of native code, along with the guest locations of the code
+  // within the range. Locations must be sorted by native address. This is safe
+  // to call from multiple threads.
+  void AddCode(const void *code, size_t size, const std::string &name,
+               const std::vector<GuestLocation> &locations);
+
+  const std::string path;
+
+ private:
+  JITDumpWriter(void) = delete;
+  JITDumpWriter(const JITDumpWriter &) = delete;
+  JITDumpWriter &operator=(const JITDumpWriter &) = delete;
+
+  JITDumpWriter(const std::string &path_, FILE *file_, void *marker_,
+                size_t marker_size_);
+
+  void Write(const void *data, size_t size);
+
+  std::mutex lock;
+  FILE * const file;
+  void * const marker;
+  const size_t marker_size;
+  uint64_t next_code_index;
+};
+
+}  // namespace remill
+
+#endif  // REMILL_RUNTIME_PERFMAP_H_
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "remill/Runtime/SharedAddressSpace.h"
+
+namespace remill {
+
+SharedAddressSpace::SharedAddressSpace(void)
+    : generation(0) {
+  for (auto &entry : root.entries) {
+    entry.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+SharedAddressSpace::~SharedAddressSpace(void) {
+  for (auto table : leaf_tables) {
+    for (auto &entry : table->entries) {
+      delete[] reinterpret_cast<uint8_t *>(
+          entry.load(std::memory_order_relaxed));
+    }
+  }
+  for (auto page : retired_pages) {
+    delete[] page;
+  }
+  for (auto table : tables) {
+    delete table;
+  }
+}
+
+// Find the leaf entry for `page_num`, optionally creating the interior tables
+// along the way. Must be called with `map_lock` held.
+std::atomic<void *> *SharedAddressSpace::FindLeaf(uint64_t page_num,
+                                                  bool create) {
+  auto table = &root;
+  for (auto level = kNumLevels - 1; level > 0; --level) {
+    auto index = (page_num >> (level * kLevelBits)) & kLevelMask;
+    auto &entry = table->entries[index];
+    auto next = reinterpret_cast<Table *>(
+        entry.load(std::memory_order_relaxed));
+    if (!next) {
+      if (!create) {
+        return nullptr;
+      }
+      next = new Table;
+      for (auto &next_entry : next->entries) {
+        next_entry.store(nullptr, std::memory_order_relaxed);
+      }
+      tables.push_back(next);
+      if (1 == level) {
+        leaf_tables.push_back(next);
+      }
+      entry.store(next, std::memory_order_release);
+    }
+    table = next;
+  }
+  return &(table->entries[page_num & kLevelMask]);
+}
+
+void SharedAddressSpace::AddMap(uint64_t base, size_t size) {
+  std::lock_guard<std::mutex> locker(map_lock);
+  auto first = base >> kPageShift;
+  auto last = (base + size + kPageMask) >> kPageShift;
+  for (auto page_num = first; page_num < last; ++page_num) {
+    auto leaf = FindLeaf(page_num, true);
+    if (!leaf->load(std::memory_order_relaxed)) {
+      auto page = new uint8_t[kPageSize]();
+      leaf->store(page, std::memory_order_release);
+    }
+  }
+}
+
+void SharedAddressSpace::RemoveMap(uint64_t base, size_t size) {
+  std::lock_guard<std::mutex> locker(map_lock);
+  auto first = base >> kPageShift;
+  auto last = (base + size + kPageMask) >> kPageShift;
+  auto removed = false;
+  for (auto page_num = first; page_num < last; ++page_num) {
+    auto leaf = FindLeaf(page_num, false);
+    if (!leaf) {
+      continue;
+    }
+    auto page = reinterpret_cast<uint8_t *>(
+        leaf->exchange(nullptr, std::memory_order_acq_rel));
+    if (page) {
+      retired_pages.push_back(page);
+      removed = true;
+    }
+  }
+
+  if (removed) {
+    generation.fetch_add(1, std::memory_order_acq_rel);
+  }
+}
+
+bool SharedAddressSpace::IsMapped(uint64_t addr) const {
+  return nullptr != ToPointer(addr);
+}
+
+uint8_t *SharedAddressSpace::ToPointer(uint64_t addr) const {
+  auto page_num = addr >> kPageShift;
+  auto table = &root;
+  for (auto level = kNumLevels - 1; level > 0; --level) {
+    auto index = (page_num >> (level * kLevelBits)) & kLevelMask;
+    table = reinterpret_cast<const Table *>(
+        table->entries[index].load(std::memory_order_acquire));
+    if (!table) {
+      return nullptr;
+    }
+  }
+  auto page = reinterpret_cast<uint8_t *>(
+      table->entries[page_num & kLevelMask].load(std::memory_order_acquire));
+  if (!page) {
+    return nullptr;
+  }
+  return &(page[addr & kPageMask]);
+}
+
+bool SharedAddressSpace::TryRead(uint64_t addr, void *val,
+                                 size_t size) const {
+  auto bytes = reinterpret_cast<uint8_t *>(val);
+  while (size) {
+    auto data = ToPointer(addr);
+    if (!data) {
+      return false;
+    }
+    auto num_bytes = std::min<uint64_t>(size, kPageSize - (addr & kPageMask));
+    memcpy(bytes, data, num_bytes);
+    bytes += num_bytes;
+    addr += num_bytes;
+    size -= num_bytes;
+  }
+  return true;
+}
+
+bool SharedAddressSpace::TryWrite(uint64_t addr, const void *val,
+                                  size_t size) {
+  auto bytes = reinterpret_cast<const uint8_t *>(val);
+  while (size) {
+    auto data = ToPointer(addr);
+    if (!data) {
+      return false;
+    }
+    auto num_bytes = std::min<uint64_t>(size, kPageSize - (addr & kPageMask));
+    memcpy(data, bytes, num_bytes);
+    bytes += num_bytes;
+    addr += num_bytes;
+    size -= num_bytes;
+  }
+  return true;
+}
+
+}  // namespace remill
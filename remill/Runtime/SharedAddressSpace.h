@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_RUNTIME_SHAREDADDRESSSPACE_H_
+#define REMILL_RUNTIME_SHAREDADDRESSSPACE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace remill {
+
+// A guest address space that is shared by many vCPUs running on different
+// host threads. Pages are found through a four-level radix table whose
+// entries are published with atomic stores, so lookups never take a lock.
+// Mapping and unmapping are serialized.
+//
+// Unmapped pages are retired rather than freed, because another thread may
+// still be accessing them. Retired pages are freed when the address space is
+// destroyed. Unlike `AddressSpace`, there is no copy-on-write sharing: every
+// vCPU sees every write.
+class SharedAddressSpace {
+ public:
+  enum : uint64_t {
+    kPageShift = 12,
+    kPageSize = 1ULL << kPageShift,
+    kPageMask = kPageSize - 1
+  };
+
+  SharedAddressSpace(void);
+  ~SharedAddressSpace(void);
+
+  // Map the zero-filled range `[base, base + size)`. Both `base` and `size`
+  // are rounded out to page boundaries. Already mapped pages are kept.
+  void AddMap(uint64_t base, size_t size);
+
+  // Unmap the range `[base, base + size)`.
+  void RemoveMap(uint64_t base, size_t size);
+
+  bool IsMapped(uint64_t addr) const;
+
+  // Returns a pointer to the host byte backing `addr`, or `nullptr` if `addr`
+  // is unmapped. The pointer is only valid up to the end of its page, and
+  // stays valid (though possibly stale) for the life of the address space.
+  uint8_t *ToPointer(uint64_t addr) const;
+
+  // Read or write `size` bytes at `addr`. Accesses can straddle pages, and
+  // are not atomic. Returns `false`, having possibly done a partial access,
+  // if any byte is unmapped.
+  bool TryRead(uint64_t addr, void *val, size_t size) const;
+  bool TryWrite(uint64_t addr, const void *val, size_t size);
+
+  // Incremented every time pages are unmapped. vCPUs that cache page
+  // translations flush their caches when this changes.
+  inline uint64_t Generation(void) const {
+    return generation.load(std::memory_order_acquire);
+  }
+
+  // Serializes atomic accesses that can't be done with host atomics, i.e.
+  // misaligned or page-straddling ones, as well as the regions bracketed by
+  // `__remill_atomic_begin` and `__remill_atomic_end`.
+  inline std::mutex &AtomicLock(void) {
+    return atomic_lock;
+  }
+
+ private:
+  SharedAddressSpace(const SharedAddressSpace &) = delete;
+  SharedAddressSpace &operator=(const SharedAddressSpace &) = delete;
+
+  enum : uint64_t {
+    kLevelBits = 13,
+    kLevelSize = 1ULL << kLevelBits,
+    kLevelMask = kLevelSize - 1,
+    kNumLevels = 4
+  };
+
+  struct Table {
+    std::atomic<void *> entries[kLevelSize];
+  };
+
+  std::atomic<void *> *FindLeaf(uint64_t page_num, bool create);
+
+  Table root;
+
+  std::mutex map_lock;
+  std::mutex atomic_lock;
+  std::atomic<uint64_t> generation;
+
+  // All non-root tables, and the subset of them whose entries are pages, so
+  // that they can be freed on destruction.
+  std::vector<Table *> tables;
+  std::vector<Table *> leaf_tables;
+  std::vector<uint8_t *> retired_pages;
+};
+
+}  // namespace remill
+
+#endif  // REMILL_RUNTIME_SHAREDADDRESSSPACE_H_
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include "remill/Runtime/TranslationCache.h"
+
+namespace remill {
+namespace {
+
+// Mix the bits of a program counter, so that nearby PCs don't cluster.
+static uint64_t HashPC(uint64_t pc) {
+  pc ^= pc >> 33;
+  pc *= 0xff51afd7ed558ccdULL;
+  pc ^= pc >> 33;
+  return pc;
+}
+
+}  // namespace
+
+TranslationCache::Table::Table(size_t capacity_)
+    : capacity(capacity_),
+      entries(capacity_) {
+  CHECK(capacity && !(capacity & (capacity - 1)))
+      << "Translation cache capacity " << capacity
+      << " is not a power of two.";
+  for (auto &entry : entries) {
+    entry.pc.store(0, std::memory_order_relaxed);
+    entry.func.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+TranslationCache::TranslationCache(size_t min_capacity)
+    : table(nullptr),
+      size(0) {
+  size_t capacity = 16;
+  while (capacity < min_capacity) {
+    capacity *= 2;
+  }
+  table.store(new Table(capacity), std::memory_order_release);
+}
+
+TranslationCache::~TranslationCache(void) {
+  delete table.load(std::memory_order_acquire);
+  for (auto old_table : retired_tables) {
+    delete old_table;
+  }
+}
+
+LiftedFunction *TranslationCache::Find(const Table *table, uint64_t pc) {
+  const auto mask = table->capacity - 1;
+  for (auto i = HashPC(pc) & mask; ; i = (i + 1) & mask) {
+    const auto &entry = table->entries[i];
+
+    // An entry's PC is published before its function, so a non-null function
+    // implies a valid PC.
+    auto func = entry.func.load(std::memory_order_acquire);
+    if (!func) {
+      return nullptr;
+    } else if (entry.pc.load(std::memory_order_relaxed) == pc) {
+      return func;
+    }
+  }
+}
+
+// Add an entry that is known not to be in the table. Must be called with
+// `insert_lock` held.
+void TranslationCache::Insert(Table *table, uint64_t pc,
+                              LiftedFunction *func) {
+  const auto mask = table->capacity - 1;
+  for (auto i = HashPC(pc) & mask; ; i = (i + 1) & mask) {
+    auto &entry = table->entries[i];
+    if (!entry.func.load(std::memory_order_relaxed)) {
+      entry.pc.store(pc, std::memory_order_relaxed);
+      entry.func.store(func, std::memory_order_release);
+      return;
+    }
+  }
+}
+
+LiftedFunction *TranslationCache::Find(uint64_t pc) const {
+  return Find(table.load(std::memory_order_acquire), pc);
+}
+
+LiftedFunction *TranslationCache::Insert(uint64_t pc, LiftedFunction *func) {
+  CHECK(nullptr != func)
+      << "Cannot add null lifted code for PC " << std::hex << pc;
+
+  std::lock_guard<std::mutex> locker(insert_lock);
+  auto curr_table = table.load(std::memory_order_relaxed);
+  if (auto prev_func = Find(curr_table, pc)) {
+    return prev_func;
+  }
+
+  auto new_size = size.load(std::memory_order_relaxed) + 1;
+  if ((new_size * 2) > curr_table->capacity) {
+    auto new_table = new Table(curr_table->capacity * 2);
+    for (const auto &entry : curr_table->entries) {
+      if (auto entry_func = entry.func.load(std::memory_order_relaxed)) {
+        Insert(new_table, entry.pc.load(std::memory_order_relaxed),
+               entry_func);
+      }
+    }
+    table.store(new_table, std::memory_order_release);
+    retired_tables.push_back(curr_table);
+    curr_table = new_table;
+  }
+
+  Insert(curr_table, pc, func);
+  size.store(new_size, std::memory_order_relaxed);
+  return func;
+}
+
+size_t TranslationCache::Size(void) const {
+  return size.load(std::memory_order_relaxed);
+}
+
+}  // namespace remill
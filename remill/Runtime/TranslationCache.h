@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_RUNTIME_TRANSLATIONCACHE_H_
+#define REMILL_RUNTIME_TRANSLATIONCACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct Memory;
+
+namespace remill {
+
+// A lifted block or function, i.e. something with the same signature as
+// `__remill_basic_block`. The state is the architecture-specific `State`
+// structure.
+typedef Memory *(LiftedFunction)(void *state, uint64_t pc, Memory *memory);
+
+// A thread-safe map from guest program counters to lifted code. Lookups are
+// lock-free, and insertions are serialized.
+//
+// The table is open-addressed with linear probing. When it becomes half full,
+// it is replaced by one that is twice as large. Old tables are retired, not
+// freed, so that concurrent lookups into them stay safe; they are freed when
+// the cache is destroyed.
+class TranslationCache {
+ public:
+  explicit TranslationCache(size_t min_capacity=1024);
+  ~TranslationCache(void);
+
+  // Returns `nullptr` if there is no lifted code for `pc`.
+  LiftedFunction *Find(uint64_t pc) const;
+
+  // Add `func` as the lifted code for `pc`. If another thread already added
+  // code for `pc`, then that code is kept and returned.
+  LiftedFunction *Insert(uint64_t pc, LiftedFunction *func);
+
+  size_t Size(void) const;
+
+ private:
+  TranslationCache(const TranslationCache &) = delete;
+  TranslationCache &operator=(const TranslationCache &) = delete;
+
+  struct Entry {
+    std::atomic<uint64_t> pc;
+    std::atomic<LiftedFunction *> func;  // `nullptr` if the entry is empty.
+  };
+
+  struct Table {
+    explicit Table(size_t capacity_);
+
+    const size_t capacity;  // Always a power of two.
+    std::vector<Entry> entries;
+  };
+
+  static LiftedFunction *Find(const Table *table, uint64_t pc);
+  static void Insert(Table *table, uint64_t pc, LiftedFunction *func);
+
+  std::atomic<Table *> table;
+  std::mutex insert_lock;
+  std::atomic<size_t> size;
+  std::vector<Table *> retired_tables;
+};
+
+}  // namespace remill
+
+#endif  // REMILL_RUNTIME_TRANSLATIONCACHE_H_
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <cstring>
+#include <thread>
+
+#include "remill/Runtime/VCPU.h"
+
+namespace remill {
+
+VCPU::VCPU(VCPUGroup &group_, SharedAddressSpace &memory_,
+           const void *state_, size_t state_size_, uint64_t pc_)
+    : group(group_),
+      memory(memory_),
+      state(reinterpret_cast<const uint8_t *>(state_),
+            reinterpret_cast<const uint8_t *>(state_) + state_size_),
+      pc(pc_),
+      status(kStatusRunnable),
+      num_blocks_executed(0),
+      faulted(false),
+      fault_addr(0),
+      fault_pc(0),
+      tlb_generation(memory_.Generation()) {
+  memset(tlb, 0, sizeof(tlb));
+}
+
+uint8_t *VCPU::ToPointerSlow(uint64_t addr) {
+  auto generation = memory.Generation();
+  if (generation != tlb_generation) {
+    memset(tlb, 0, sizeof(tlb));
+    tlb_generation = generation;
+  }
+
+  auto ptr = memory.ToPointer(addr);
+  if (ptr) {
+    const auto page_num = addr >> SharedAddressSpace::kPageShift;
+    auto &tlb_entry = tlb[page_num % kNumTLBEntries];
+    tlb_entry.page_num = page_num;
+    tlb_entry.page = ptr - (addr & SharedAddressSpace::kPageMask);
+  }
+  return ptr;
+}
+
+void VCPU::Run(void) {
+  while (kStatusRunnable == GetStatus()) {
+    auto func = group.cache.Find(pc);
+    if (!func) {
+      func = group.Translate(pc);
+      if (!func) {
+        LOG(ERROR)
+            << "No lifted code for PC " << std::hex << pc << std::dec;
+        Stop(kStatusNoCode);
+        break;
+      }
+    }
+
+    // The control-flow intrinsics that end every lifted block update `pc`.
+    func(state.data(), pc, ToMemory());
+    num_blocks_executed++;
+  }
+}
+
+VCPUGroup::VCPUGroup(SharedAddressSpace &memory_, TranslationCache &cache_,
+                     Translator translator_)
+    : memory(memory_),
+      cache(cache_),
+      translator(translator_),
+      sync_hyper_call([] (VCPU &vcpu, uint32_t name) {
+        LOG(ERROR)
+            << "Unhandled sync hyper call " << name << " at PC "
+            << std::hex << vcpu.PC() << std::dec;
+        vcpu.Stop();
+      }),
+      async_hyper_call([] (VCPU &vcpu) {
+        vcpu.Stop();
+      }) {}
+
+VCPUGroup::~VCPUGroup(void) {}
+
+VCPU *VCPUGroup::AddVCPU(const void *state, size_t state_size, uint64_t pc) {
+  vcpus.emplace_back(new VCPU(*this, memory, state, state_size, pc));
+  return vcpus.back().get();
+}
+
+void VCPUGroup::SetSyncHyperCallHandler(SyncHyperCallHandler handler) {
+  sync_hyper_call = handler;
+}
+
+void VCPUGroup::SetAsyncHyperCallHandler(AsyncHyperCallHandler handler) {
+  async_hyper_call = handler;
+}
+
+void VCPUGroup::SyncHyperCall(VCPU &vcpu, uint32_t name) const {
+  sync_hyper_call(vcpu, name);
+}
+
+void VCPUGroup::AsyncHyperCall(VCPU &vcpu) const {
+  async_hyper_call(vcpu);
+}
+
+// Lifting is serialized, so that two vCPUs that reach the same new PC at the
+// same time don't both lift it.
+LiftedFunction *VCPUGroup::Translate(uint64_t pc) {
+  std::lock_guard<std::mutex> locker(translate_lock);
+  if (auto func = cache.Find(pc)) {
+    return func;
+  }
+  auto func = translator(pc);
+  if (!func) {
+    return nullptr;
+  }
+  return cache.Insert(pc, func);
+}
+
+void VCPUGroup::Run(void) {
+  std::vector<std::thread> threads;
+  threads.reserve(vcpus.size());
+  for (auto &vcpu : vcpus) {
+    if (VCPU::kStatusRunnable == vcpu->GetStatus()) {
+      auto vcpu_ptr = vcpu.get();
+      threads.emplace_back([vcpu_ptr] (void) { vcpu_ptr->Run(); });
+    }
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace remill
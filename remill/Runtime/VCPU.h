@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_RUNTIME_VCPU_H_
+#define REMILL_RUNTIME_VCPU_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "remill/Runtime/SharedAddressSpace.h"
+#include "remill/Runtime/TranslationCache.h"
+
+struct Memory;
+
+namespace remill {
+
+class VCPUGroup;
+
+// One guest thread. A vCPU owns a copy of an architecture-specific `State`
+// structure, and runs lifted code against an address space that it shares
+// with the other vCPUs of its group.
+//
+// Lifted code threads a `Memory *` through every intrinsic. In this runtime,
+// that pointer is the vCPU itself, so that the memory intrinsics can use the
+// vCPU's private cache of page translations without thread-local lookups.
+class VCPU {
+ public:
+  enum Status {
+    kStatusRunnable,
+    kStatusStopped,  // Stopped by a hyper call handler, or by `Stop`.
+    kStatusError,  // Lifted code called `__remill_error`, or faulted.
+    kStatusNoCode,  // No lifted code could be found for the next PC.
+  };
+
+  inline void *State(void) {
+    return state.data();
+  }
+
+  inline size_t StateSize(void) const {
+    return state.size();
+  }
+
+  // The program counter at which this vCPU will resume execution.
+  inline uint64_t PC(void) const {
+    return pc;
+  }
+
+  inline void SetPC(uint64_t pc_) {
+    pc = pc_;
+  }
+
+  inline Status GetStatus(void) const {
+    return status.load(std::memory_order_acquire);
+  }
+
+  // Stop this vCPU once the currently running lifted code returns. This can
+  // be called from any thread. Only the first reason for stopping is kept.
+  inline void Stop(Status status_=kStatusStopped) {
+    auto expected = kStatusRunnable;
+    status.compare_exchange_strong(expected, status_,
+                                   std::memory_order_acq_rel);
+  }
+
+  // Make a stopped vCPU runnable again, e.g. after handling whatever stopped
+  // it. Must not be called while the vCPU's group is running.
+  inline void Resume(void) {
+    faulted = false;
+    status.store(kStatusRunnable, std::memory_order_release);
+  }
+
+  // Stop this vCPU because lifted code accessed unmapped memory at `addr`.
+  // The rest of the running lifted code still runs, but all of its memory
+  // accesses become no-ops: reads and atomics return zero, and writes are
+  // dropped. Only the first fault is recorded. Must only be called by the
+  // memory intrinsics, on the vCPU's own thread.
+  inline void Fault(uint64_t addr) {
+    if (!faulted) {
+      faulted = true;
+      fault_addr = addr;
+      fault_pc = pc;
+    }
+    Stop(kStatusError);
+  }
+
+  // Returns `true` if lifted code has faulted since this vCPU last resumed.
+  inline bool HasFaulted(void) const {
+    return faulted;
+  }
+
+  // The address of the first faulting memory access.
+  inline uint64_t FaultAddress(void) const {
+    return fault_addr;
+  }
+
+  // The PC of the lifted block that made the first faulting memory access.
+  // Lifted code doesn't tell the memory intrinsics which of its instructions
+  // is running, so this is the PC of the block, and not of the instruction.
+  inline uint64_t FaultPC(void) const {
+    return fault_pc;
+  }
+
+  inline VCPUGroup &Group(void) const {
+    return group;
+  }
+
+  inline SharedAddressSpace &SharedMemory(void) const {
+    return memory;
+  }
+
+  // Returns a pointer to the host byte backing `addr`, or `nullptr` if `addr`
+  // is unmapped. Recent translations are cached.
+  inline uint8_t *ToPointer(uint64_t addr) {
+    const auto page_num = addr >> SharedAddressSpace::kPageShift;
+    auto &tlb_entry = tlb[page_num % kNumTLBEntries];
+    if (tlb_entry.page && tlb_entry.page_num == page_num &&
+        tlb_generation == memory.Generation()) {
+      return &(tlb_entry.page[addr & SharedAddressSpace::kPageMask]);
+    }
+    return ToPointerSlow(addr);
+  }
+
+  inline Memory *ToMemory(void) {
+    return reinterpret_cast<Memory *>(this);
+  }
+
+  inline static VCPU *FromMemory(Memory *memory) {
+    return reinterpret_cast<VCPU *>(memory);
+  }
+
+  // Number of lifted blocks that this vCPU has executed.
+  inline uint64_t NumBlocksExecuted(void) const {
+    return num_blocks_executed;
+  }
+
+ private:
+  friend class VCPUGroup;
+
+  VCPU(VCPUGroup &group_, SharedAddressSpace &memory_, const void *state_,
+       size_t state_size_, uint64_t pc_);
+
+  VCPU(void) = delete;
+  VCPU(const VCPU &) = delete;
+  VCPU &operator=(const VCPU &) = delete;
+
+  uint8_t *ToPointerSlow(uint64_t addr);
+
+  // Run lifted code until this vCPU stops.
+  void Run(void);
+
+  enum : uint64_t {
+    kNumTLBEntries = 64
+  };
+
+  struct TLBEntry {
+    uint64_t page_num;
+    uint8_t *page;
+  };
+
+  VCPUGroup &group;
+  SharedAddressSpace &memory;
+  std::vector<uint8_t> state;
+  uint64_t pc;
+  std::atomic<Status> status;
+  uint64_t num_blocks_executed;
+
+  bool faulted;
+  uint64_t fault_addr;
+  uint64_t fault_pc;
+
+  uint64_t tlb_generation;
+  TLBEntry tlb[kNumTLBEntries];
+};
+
+// A set of vCPUs that share one address space and one translation cache, and
+// that each run on their own host thread.
+class VCPUGroup {
+ public:
+  // Produce lifted code for `pc`, or return `nullptr` if there is none. Calls
+  // are serialized, and are only made for PCs that are not in the
+  // translation cache.
+  typedef std::function<LiftedFunction *(uint64_t pc)> Translator;
+
+  // Handle a synchronous hyper call, e.g. `CPUID`. Lifted code resumes after
+  // the handler returns, unless the handler stops the vCPU. Handlers for a
+  // group can run on many threads at once.
+  typedef std::function<void(VCPU &, uint32_t name)> SyncHyperCallHandler;
+
+  // Handle an asynchronous hyper call, e.g. a system call. The vCPU's PC is
+  // the return address of the hyper call when the handler is called.
+  typedef std::function<void(VCPU &)> AsyncHyperCallHandler;
+
+  VCPUGroup(SharedAddressSpace &memory_, TranslationCache &cache_,
+            Translator translator_);
+  ~VCPUGroup(void);
+
+  // Add a vCPU that will start executing at `pc`. `state` is copied.
+  VCPU *AddVCPU(const void *state, size_t state_size, uint64_t pc);
+
+  // By default, both kinds of hyper calls stop the calling vCPU.
+  void SetSyncHyperCallHandler(SyncHyperCallHandler handler);
+  void SetAsyncHyperCallHandler(AsyncHyperCallHandler handler);
+
+  // Run every runnable vCPU on its own host thread, and wait for all of them
+  // to stop.
+  void Run(void);
+
+  inline const std::vector<std::unique_ptr<VCPU>> &VCPUs(void) const {
+    return vcpus;
+  }
+
+  // Used by the runtime intrinsics.
+  void SyncHyperCall(VCPU &vcpu, uint32_t name) const;
+  void AsyncHyperCall(VCPU &vcpu) const;
+
+ private:
+  friend class VCPU;
+
+  VCPUGroup(void) = delete;
+  VCPUGroup(const VCPUGroup &) = delete;
+  VCPUGroup &operator=(const VCPUGroup &) = delete;
+
+  LiftedFunction *Translate(uint64_t pc);
+
+  SharedAddressSpace &memory;
+  TranslationCache &cache;
+  Translator translator;
+  std::mutex translate_lock;
+  SyncHyperCallHandler sync_hyper_call;
+  AsyncHyperCallHandler async_hyper_call;
+  std::vector<std::unique_ptr<VCPU>> vcpus;
+};
+
+}  // namespace remill
+
+#endif  // REMILL_RUNTIME_VCPU_H_
@@ -0,0 +1,431 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+#include "remill/Arch/Runtime/HyperCall.h"
+#include "remill/Runtime/VCPU.h"
+
+// Implementations of the remill intrinsics for lifted code that runs on the
+// vCPUs of a `remill::VCPUGroup`. The `Memory *` that lifted code threads
+// through the intrinsics is the running `remill::VCPU`.
+//
+// Plain reads and writes of naturally aligned integers are single host
+// accesses, so they don't tear. The atomic intrinsics use host atomics when
+// the access is naturally aligned, and otherwise fall back to holding the
+// address space's atomic lock. Guest memory barriers map to host fences.
+//
+// Misaligned atomics (e.g. x86 split locks), and all 128-bit atomics, are
+// only atomic with respect to other accesses that hold the atomic lock. A
+// plain write, or a naturally aligned atomic, from another vCPU can land in
+// the middle of them.
+//
+// An access to unmapped memory stops the vCPU with `kStatusError`, and turns
+// every later memory access of the running lifted code into a no-op, so that
+// the lifted code doesn't keep going on the strength of made-up values.
+
+#ifndef ADDRESS_SIZE_BITS
+# define ADDRESS_SIZE_BITS 64
+#endif
+
+#if 64 == ADDRESS_SIZE_BITS
+typedef uint64_t addr_t;
+#else
+typedef uint32_t addr_t;
+#endif
+
+struct State;
+
+namespace {
+
+using remill::SharedAddressSpace;
+using remill::VCPU;
+
+static void MemoryFault(VCPU *vcpu, addr_t addr, size_t size) {
+  if (!vcpu->HasFaulted()) {
+    LOG(ERROR)
+        << "Invalid " << size << "-byte memory access to " << std::hex
+        << addr << " in block at PC " << vcpu->PC() << std::dec;
+  }
+  vcpu->Fault(addr);
+}
+
+// Returns a host pointer to `sizeof(T)` bytes at `addr` if they are all on
+// one page, otherwise `nullptr`.
+template <typename T>
+static uint8_t *ContiguousPointer(VCPU *vcpu, addr_t addr) {
+  if (((addr & SharedAddressSpace::kPageMask) + sizeof(T)) >
+      SharedAddressSpace::kPageSize) {
+    return nullptr;
+  }
+  return vcpu->ToPointer(addr);
+}
+
+template <typename T>
+static T ReadMemory(Memory *memory, addr_t addr) {
+  auto vcpu = VCPU::FromMemory(memory);
+  T val = 0;
+  if (vcpu->HasFaulted()) {
+    return val;
+  } else if (auto ptr = ContiguousPointer<T>(vcpu, addr)) {
+    if (!(addr % sizeof(T))) {
+      val = __atomic_load_n(reinterpret_cast<T *>(ptr), __ATOMIC_RELAXED);
+    } else {
+      memcpy(&val, ptr, sizeof(T));
+    }
+  } else if (!vcpu->SharedMemory().TryRead(addr, &val, sizeof(T))) {
+    MemoryFault(vcpu, addr, sizeof(T));
+  }
+  return val;
+}
+
+template <typename T>
+static Memory *WriteMemory(Memory *memory, addr_t addr, T val) {
+  auto vcpu = VCPU::FromMemory(memory);
+  if (vcpu->HasFaulted()) {
+    return memory;
+  } else if (auto ptr = ContiguousPointer<T>(vcpu, addr)) {
+    if (!(addr % sizeof(T))) {
+      __atomic_store_n(reinterpret_cast<T *>(ptr), val, __ATOMIC_RELAXED);
+    } else {
+      memcpy(ptr, &val, sizeof(T));
+    }
+  } else if (!vcpu->SharedMemory().TryWrite(addr, &val, sizeof(T))) {
+    MemoryFault(vcpu, addr, sizeof(T));
+  }
+  return memory;
+}
+
+// Returns a host pointer to `addr` if it can be accessed with host atomics.
+// Misaligned accesses can't be, because they may straddle pages, and host
+// atomics don't support them. Neither can accesses after a fault, so that
+// they go through `LockedReadModifyWrite`, which ignores them.
+template <typename T>
+static T *AtomicPointer(VCPU *vcpu, addr_t addr) {
+  if ((addr % sizeof(T)) || vcpu->HasFaulted()) {
+    return nullptr;
+  }
+  return reinterpret_cast<T *>(vcpu->ToPointer(addr));
+}
+
+// Perform a read-modify-write of `addr` while holding the atomic lock. After
+// a fault, this returns zero and leaves memory alone.
+template <typename T, typename F>
+static T LockedReadModifyWrite(VCPU *vcpu, addr_t addr, F modify) {
+  if (vcpu->HasFaulted()) {
+    return 0;
+  }
+  auto &memory = vcpu->SharedMemory();
+  std::lock_guard<std::mutex> locker(memory.AtomicLock());
+  T prev = 0;
+  if (!memory.TryRead(addr, &prev, sizeof(T))) {
+    MemoryFault(vcpu, addr, sizeof(T));
+    return prev;
+  }
+  T next = prev;
+  if (modify(next) && !memory.TryWrite(addr, &next, sizeof(T))) {
+    MemoryFault(vcpu, addr, sizeof(T));
+  }
+  return prev;
+}
+
+template <typename T>
+static Memory *CompareExchange(Memory *memory, addr_t addr, T &expected,
+                               T desired) {
+  auto vcpu = VCPU::FromMemory(memory);
+  if (auto ptr = AtomicPointer<T>(vcpu, addr)) {
+    __atomic_compare_exchange_n(ptr, &expected, desired, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  } else {
+    const auto compare = expected;
+    expected = LockedReadModifyWrite<T>(vcpu, addr, [=] (T &val) -> bool {
+      if (val != compare) {
+        return false;
+      }
+      val = desired;
+      return true;
+    });
+  }
+  return memory;
+}
+
+}  // namespace
+
+extern "C" {
+
+#define MAKE_RW_MEMORY(size) \
+  uint ## size ## _t __remill_read_memory_ ## size( \
+      Memory *memory, addr_t addr) { \
+    return ReadMemory<uint ## size ## _t>(memory, addr); \
+  } \
+  Memory *__remill_write_memory_ ## size( \
+      Memory *memory, addr_t addr, uint ## size ## _t val) { \
+    return WriteMemory<uint ## size ## _t>(memory, addr, val); \
+  }
+
+MAKE_RW_MEMORY(8)
+MAKE_RW_MEMORY(16)
+MAKE_RW_MEMORY(32)
+MAKE_RW_MEMORY(64)
+
+#undef MAKE_RW_MEMORY
+
+float __remill_read_memory_f32(Memory *memory, addr_t addr) {
+  auto bits = ReadMemory<uint32_t>(memory, addr);
+  float val = 0;
+  memcpy(&val, &bits, sizeof(val));
+  return val;
+}
+
+double __remill_read_memory_f64(Memory *memory, addr_t addr) {
+  auto bits = ReadMemory<uint64_t>(memory, addr);
+  double val = 0;
+  memcpy(&val, &bits, sizeof(val));
+  return val;
+}
+
+Memory *__remill_write_memory_f32(Memory *memory, addr_t addr, float val) {
+  uint32_t bits = 0;
+  memcpy(&bits, &val, sizeof(val));
+  return WriteMemory<uint32_t>(memory, addr, bits);
+}
+
+Memory *__remill_write_memory_f64(Memory *memory, addr_t addr, double val) {
+  uint64_t bits = 0;
+  memcpy(&bits, &val, sizeof(val));
+  return WriteMemory<uint64_t>(memory, addr, bits);
+}
+
+// 80-bit floats are converted through the host's `long double`, which is
+// only the x87 extended precision format on x86 hosts.
+double __remill_read_memory_f80(Memory *memory, addr_t addr) {
+#if defined(__x86_64__) || defined(__i386__)
+  auto vcpu = VCPU::FromMemory(memory);
+  long double val = 0;
+  if (!vcpu->HasFaulted() && !vcpu->SharedMemory().TryRead(addr, &val, 10)) {
+    MemoryFault(vcpu, addr, 10);
+  }
+  return static_cast<double>(val);
+#else
+  LOG(FATAL)
+      << "80-bit float reads are not supported on this host.";
+  return 0;
+#endif
+}
+
+Memory *__remill_write_memory_f80(Memory *memory, addr_t addr, double val) {
+#if defined(__x86_64__) || defined(__i386__)
+  auto vcpu = VCPU::FromMemory(memory);
+  auto val_long = static_cast<long double>(val);
+  if (!vcpu->HasFaulted() &&
+      !vcpu->SharedMemory().TryWrite(addr, &val_long, 10)) {
+    MemoryFault(vcpu, addr, 10);
+  }
+  return memory;
+#else
+  LOG(FATAL)
+      << "80-bit float writes are not supported on this host.";
+  return memory;
+#endif
+}
+
+#define MAKE_ATOMIC_MEMORY(size) \
+  Memory *__remill_compare_exchange_memory_ ## size( \
+      Memory *memory, addr_t addr, uint ## size ## _t &expected, \
+      uint ## size ## _t desired) { \
+    return CompareExchange<uint ## size ## _t>( \
+        memory, addr, expected, desired); \
+  } \
+  Memory *__remill_exchange_memory_ ## size( \
+      Memory *memory, addr_t addr, uint ## size ## _t &value) { \
+    auto vcpu = VCPU::FromMemory(memory); \
+    if (auto ptr = AtomicPointer<uint ## size ## _t>(vcpu, addr)) { \
+      value = __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST); \
+    } else { \
+      const auto new_value = value; \
+      value = LockedReadModifyWrite<uint ## size ## _t>( \
+          vcpu, addr, [=] (uint ## size ## _t &val) -> bool { \
+            val = new_value; \
+            return true; \
+          }); \
+    } \
+    return memory; \
+  } \
+  MAKE_ATOMIC_FETCH_OP(add, +, size) \
+  MAKE_ATOMIC_FETCH_OP(sub, -, size) \
+  MAKE_ATOMIC_FETCH_OP(and, &, size) \
+  MAKE_ATOMIC_FETCH_OP(or, |, size) \
+  MAKE_ATOMIC_FETCH_OP(xor, ^, size)
+
+#define MAKE_ATOMIC_FETCH_OP(name, op, size) \
+  Memory *__remill_fetch_and_ ## name ## _memory_ ## size( \
+      Memory *memory, addr_t addr, uint ## size ## _t &value) { \
+    auto vcpu = VCPU::FromMemory(memory); \
+    if (auto ptr = AtomicPointer<uint ## size ## _t>(vcpu, addr)) { \
+      value = __atomic_fetch_ ## name(ptr, value, __ATOMIC_SEQ_CST); \
+    } else { \
+      const auto rhs = value; \
+      value = LockedReadModifyWrite<uint ## size ## _t>( \
+          vcpu, addr, [=] (uint ## size ## _t &val) -> bool { \
+            val = static_cast<uint ## size ## _t>(val op rhs); \
+            return true; \
+          }); \
+    } \
+    return memory; \
+  }
+
+MAKE_ATOMIC_MEMORY(8)
+MAKE_ATOMIC_MEMORY(16)
+MAKE_ATOMIC_MEMORY(32)
+MAKE_ATOMIC_MEMORY(64)
+
+#undef MAKE_ATOMIC_FETCH_OP
+#undef MAKE_ATOMIC_MEMORY
+
+// Host 128-bit atomics need `cmpxchg16b` or `libatomic`, so these always take
+// the atomic lock. This is only atomic with respect to other locked accesses,
+// e.g. not with respect to plain 64-bit writes to either half.
+Memory *__remill_compare_exchange_memory_128(
+    Memory *memory, addr_t addr, unsigned __int128 &expected,
+    unsigned __int128 desired) {
+  auto vcpu = VCPU::FromMemory(memory);
+  const auto compare = expected;
+  expected = LockedReadModifyWrite<unsigned __int128>(
+      vcpu, addr, [=] (unsigned __int128 &val) -> bool {
+        if (val != compare) {
+          return false;
+        }
+        val = desired;
+        return true;
+      });
+  return memory;
+}
+
+Memory *__remill_barrier_load_load(Memory *memory) {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return memory;
+}
+
+Memory *__remill_barrier_load_store(Memory *memory) {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return memory;
+}
+
+Memory *__remill_barrier_store_load(Memory *memory) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return memory;
+}
+
+Memory *__remill_barrier_store_store(Memory *memory) {
+  std::atomic_thread_fence(std::memory_order_release);
+  return memory;
+}
+
+// Atomic regions of semantics that don't use the typed atomic intrinsics are
+// serialized with all other locked accesses.
+Memory *__remill_atomic_begin(Memory *memory) {
+  VCPU::FromMemory(memory)->SharedMemory().AtomicLock().lock();
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return memory;
+}
+
+Memory *__remill_atomic_end(Memory *memory) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  VCPU::FromMemory(memory)->SharedMemory().AtomicLock().unlock();
+  return memory;
+}
+
+uint8_t __remill_undefined_8(void) {
+  return 0;
+}
+
+uint16_t __remill_undefined_16(void) {
+  return 0;
+}
+
+uint32_t __remill_undefined_32(void) {
+  return 0;
+}
+
+uint64_t __remill_undefined_64(void) {
+  return 0;
+}
+
+float __remill_undefined_f32(void) {
+  return 0;
+}
+
+double __remill_undefined_f64(void) {
+  return 0;
+}
+
+void __remill_defer_inlining(void) {}
+
+// The control-flow intrinsics end every lifted block. They tell the vCPU
+// where to resume, and return to its dispatch loop.
+Memory *__remill_error(State &, addr_t addr, Memory *memory) {
+  auto vcpu = VCPU::FromMemory(memory);
+  vcpu->SetPC(addr);
+  vcpu->Stop(VCPU::kStatusError);
+  return memory;
+}
+
+Memory *__remill_function_call(State &, addr_t addr, Memory *memory) {
+  VCPU::FromMemory(memory)->SetPC(addr);
+  return memory;
+}
+
+Memory *__remill_function_return(State &, addr_t addr, Memory *memory) {
+  VCPU::FromMemory(memory)->SetPC(addr);
+  return memory;
+}
+
+Memory *__remill_jump(State &, addr_t addr, Memory *memory) {
+  VCPU::FromMemory(memory)->SetPC(addr);
+  return memory;
+}
+
+Memory *__remill_missing_block(State &, addr_t addr, Memory *memory) {
+  VCPU::FromMemory(memory)->SetPC(addr);
+  return memory;
+}
+
+// Lifted code only keeps running after a native call to other lifted code if
+// nothing during the call stopped this vCPU.
+bool __remill_resume_after_call(State &, addr_t, Memory *memory) {
+  return VCPU::kStatusRunnable == VCPU::FromMemory(memory)->GetStatus();
+}
+
+Memory *__remill_async_hyper_call(State &, addr_t ret_addr, Memory *memory) {
+  auto vcpu = VCPU::FromMemory(memory);
+  vcpu->SetPC(ret_addr);
+  vcpu->Group().AsyncHyperCall(*vcpu);
+  return memory;
+}
+
+Memory *__remill_sync_hyper_call(State &, Memory *memory,
+                                 SyncHyperCall::Name call) {
+  auto vcpu = VCPU::FromMemory(memory);
+  vcpu->Group().SyncHyperCall(*vcpu, call);
+  return memory;
+}
+
+}  // extern C
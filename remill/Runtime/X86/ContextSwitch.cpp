@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cpuid.h>
+
+#include "remill/Runtime/X86/ContextSwitch.h"
+
+namespace {
+
+// Read the extended control register `XCR0`, which tells us what register
+// state the OS saves and restores on context switches.
+static uint64_t ReadXCR0(void) {
+  uint32_t eax = 0;
+  uint32_t edx = 0;
+  __asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+
+static uint32_t DetectVectorISA(void) {
+  uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return kRemillX86VectorISA_SSE;
+  }
+
+  // Both the CPU and OS need to support `XSAVE` for `XGETBV` to be usable.
+  if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+    return kRemillX86VectorISA_SSE;
+  }
+
+  auto xcr0 = ReadXCR0();
+  if (0x6 != (xcr0 & 0x6)) {  // `XMM` and `YMM` state.
+    return kRemillX86VectorISA_SSE;
+  }
+
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) ||
+      !(ebx & bit_AVX512F)) {
+    return kRemillX86VectorISA_AVX;
+  }
+
+  if (0xE6 != (xcr0 & 0xE6)) {  // Opmask, `ZMM_Hi256`, and `Hi16_ZMM` state.
+    return kRemillX86VectorISA_AVX;
+  }
+
+  return kRemillX86VectorISA_AVX512;
+}
+
+static uint32_t DetectAVX512BW(void) {
+  uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return 0;
+  }
+  return (ebx & bit_AVX512BW) ? 1 : 0;
+}
+
+}  // namespace
+
+extern "C" {
+
+__thread RemillX86NativeContext __remill_x86_native_context = {};
+
+uint32_t __remill_x86_vector_isa = DetectVectorISA();
+
+uint32_t __remill_x86_has_avx512bw = DetectAVX512BW();
+
+}  // extern C
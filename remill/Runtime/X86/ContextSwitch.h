@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_RUNTIME_X86_CONTEXTSWITCH_H_
+#define REMILL_RUNTIME_X86_CONTEXTSWITCH_H_
+
+#include <stdint.h>
+
+// Switches between lifted code, whose machine state lives in an x86 `State`
+// structure, and native code running on the host CPU with that machine state
+// loaded into the real registers. The switch routines are generated from the
+// `State` layout by `scripts/x86/print_context_switch_asm.sh`.
+//
+// What gets switched:
+//
+//    - All 16 general purpose registers, and `RIP` on entry.
+//    - The arithmetic flags and `DF`. The remaining bits of `RFLAGS` are kept
+//      from the host on entry, and the full native `RFLAGS` is stored into
+//      `State::rflag` on exit.
+//    - The vector registers, as wide as the host supports: `XMM0-15`,
+//      `YMM0-15`, or `ZMM0-31`. With AVX512, the opmask registers `K0-7` are
+//      switched too.
+//    - The x87 control word.
+//    - The MMX registers. On entry, the x87 stack is left empty, as the host
+//      ABI requires at function boundaries, because the `State` doesn't record
+//      which x87 stack entries are live. On exit, the x87 stack entries are
+//      stored into `State::st` (empty entries become NaNs), and the condition
+//      codes into `State::sw`, and the x87 stack is emptied.
+//
+// `MXCSR` and the segment bases are not switched; native code runs with the
+// host's.
+//
+// The switch routines keep their bookkeeping in a thread-local variable that
+// is addressed using the local-exec TLS model, so this library must be
+// linked into the main executable and not into a shared library.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct State;
+
+// Vector register sets, ordered by width.
+enum RemillX86VectorISA {
+  kRemillX86VectorISA_SSE = 0,
+  kRemillX86VectorISA_AVX = 1,
+  kRemillX86VectorISA_AVX512 = 2
+};
+
+// Per-thread bookkeeping of the switch routines. This is only exposed so that
+// the layout can be checked by the generator of the switch routines.
+struct RemillX86NativeContext {
+  uint64_t host_rsp;  // Host stack pointer of the innermost switch.
+  struct State *state;  // State of the innermost switch.
+  uint64_t scratch;  // Holds the native `R11` while exiting.
+  uint64_t target;  // Native code address to enter.
+};
+
+// The vector register set that is switched. This is detected when the
+// program starts, and takes into account whether or not the OS has enabled
+// the register set.
+extern uint32_t __remill_x86_vector_isa;
+
+// Whether or not the opmask registers are 64 bits wide (AVX512BW), rather
+// than 16 bits wide. This only matters if `__remill_x86_vector_isa` is
+// `kRemillX86VectorISA_AVX512`.
+extern uint32_t __remill_x86_has_avx512bw;
+
+// Load the machine state in `state` into the native registers and jump to
+// `state->gpr.rip`. This returns once native code transfers control to
+// `__remill_x86_native_exit`, at which point the native machine state has
+// been stored back into `state`. `State::gpr.rip` is left as it was on entry.
+//
+// This can be nested, i.e. the native code can call into lifted code that
+// itself switches to native code.
+void __remill_x86_switch_to_native(struct State *state);
+
+// The native code address that leads back out of
+// `__remill_x86_switch_to_native`. Native code reaches it by jumping or
+// returning to it. All native registers are preserved until they are stored
+// into the `State`.
+void __remill_x86_native_exit(void);
+
+// Call the native function at `state->gpr.rip`, where the stack in `state`
+// is set up as if a `CALL` had just executed, i.e. the return address is on
+// top of the stack. This returns once the native function returns, with
+// `state->gpr.rip` set to the return address.
+//
+// The memory in which the native stack lives is the host's own memory.
+void __remill_x86_call_native(struct State *state);
+
+#ifdef __cplusplus
+}  // extern C
+#endif
+
+#endif  // REMILL_RUNTIME_X86_CONTEXTSWITCH_H_
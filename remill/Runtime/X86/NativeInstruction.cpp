@@ -0,0 +1,453 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+// The `State` structure has the same size/shape across all configurations, so
+// we use the 64-bit, AVX512-enabled one.
+#define ADDRESS_SIZE_BITS 64
+#define HAS_FEATURE_AVX 1
+#define HAS_FEATURE_AVX512 1
+
+#include "remill/Arch/X86/Runtime/State.h"
+#include "remill/Arch/X86/XED.h"
+#include "remill/Runtime/AddressSpace.h"
+#include "remill/Runtime/X86/ContextSwitch.h"
+#include "remill/Runtime/X86/NativeInstruction.h"
+
+namespace remill {
+namespace {
+
+static const xed_state_t kXEDState64 = {
+    XED_MACHINE_MODE_LONG_64,
+    XED_ADDRESS_WIDTH_64b};
+
+enum : size_t {
+  kMaxInstructionSize = 15,
+
+  // Largest memory operand that we copy in and out of guest memory. This
+  // covers `FXSAVE`/`FXRSTOR`.
+  kMaxMemOperandSize = 512,
+
+  kTrampolineSize = 4096,
+  kScratchStackSize = 64 * 1024
+};
+
+// Per-thread memory into which an instruction is copied and executed. The
+// code is never writable and executable at the same time.
+class Trampoline {
+ public:
+  Trampoline(void)
+      : code(reinterpret_cast<uint8_t *>(
+            mmap(nullptr, kTrampolineSize, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))),
+        stack(new uint8_t[kScratchStackSize]),
+        is_executable(false) {
+    CHECK(MAP_FAILED != code)
+        << "Unable to map trampoline for native instruction execution.";
+  }
+
+  void MakeWritable(void) {
+    if (is_executable) {
+      CHECK(!mprotect(code, kTrampolineSize, PROT_READ | PROT_WRITE))
+          << "Unable to make trampoline writable.";
+      is_executable = false;
+    }
+  }
+
+  void MakeExecutable(void) {
+    if (!is_executable) {
+      CHECK(!mprotect(code, kTrampolineSize, PROT_READ | PROT_EXEC))
+          << "Unable to make trampoline executable.";
+      is_executable = true;
+    }
+  }
+
+  ~Trampoline(void) {
+    munmap(code, kTrampolineSize);
+    delete[] stack;
+  }
+
+  // Top of a stack that native code uses, e.g. for signal delivery, when the
+  // instruction doesn't use the guest stack.
+  inline uint64_t StackTop(void) const {
+    return reinterpret_cast<uint64_t>(&(stack[kScratchStackSize])) & ~15ULL;
+  }
+
+  uint8_t * const code;
+  uint8_t * const stack;
+  bool is_executable;
+
+  // Host copy of the instruction's memory operand. The copy is placed at the
+  // same offset within a 64-byte block as the guest address, so that
+  // alignment-checking instructions behave the same way natively.
+  alignas(64) uint8_t mem[kMaxMemOperandSize + 64];
+
+ private:
+  Trampoline(const Trampoline &) = delete;
+  Trampoline &operator=(const Trampoline &) = delete;
+};
+
+static thread_local Trampoline gTrampoline;
+
+// General purpose registers that can hold the address of the host copy of
+// a memory operand, along with their hardware encodings.
+static const struct {
+  xed_reg_enum_t reg;
+  uint8_t encoding;
+} kAddressRegs[] = {
+  {XED_REG_RBX, 3},
+  {XED_REG_RBP, 5},
+  {XED_REG_RSI, 6},
+  {XED_REG_RDI, 7},
+  {XED_REG_R8, 8},
+  {XED_REG_R9, 9},
+  {XED_REG_R10, 10},
+  {XED_REG_R11, 11},
+  {XED_REG_R12, 12},
+  {XED_REG_R13, 13},
+  {XED_REG_R14, 14},
+  {XED_REG_R15, 15},
+  {XED_REG_RAX, 0},
+  {XED_REG_RCX, 1},
+  {XED_REG_RDX, 2},
+};
+
+// Returns the `State` register that holds the general purpose register `reg`,
+// or `nullptr` if `reg` is not a general purpose register.
+static Reg *GPR(State *state, xed_reg_enum_t reg) {
+  switch (xed_get_largest_enclosing_register(reg)) {
+    case XED_REG_RAX: return &(state->gpr.rax);
+    case XED_REG_RBX: return &(state->gpr.rbx);
+    case XED_REG_RCX: return &(state->gpr.rcx);
+    case XED_REG_RDX: return &(state->gpr.rdx);
+    case XED_REG_RSI: return &(state->gpr.rsi);
+    case XED_REG_RDI: return &(state->gpr.rdi);
+    case XED_REG_RSP: return &(state->gpr.rsp);
+    case XED_REG_RBP: return &(state->gpr.rbp);
+    case XED_REG_R8: return &(state->gpr.r8);
+    case XED_REG_R9: return &(state->gpr.r9);
+    case XED_REG_R10: return &(state->gpr.r10);
+    case XED_REG_R11: return &(state->gpr.r11);
+    case XED_REG_R12: return &(state->gpr.r12);
+    case XED_REG_R13: return &(state->gpr.r13);
+    case XED_REG_R14: return &(state->gpr.r14);
+    case XED_REG_R15: return &(state->gpr.r15);
+    default: return nullptr;
+  }
+}
+
+// How an instruction uses registers and memory.
+struct InstructionUses {
+  InstructionUses(void)
+      : regs(),
+        uses_rsp(false),
+        has_mem(false),
+        is_agen(false) {}
+
+  std::vector<xed_reg_enum_t> regs;
+  bool uses_rsp;
+  bool has_mem;
+  bool is_agen;
+};
+
+static void AddRegUse(InstructionUses &uses, xed_reg_enum_t reg) {
+  if (XED_REG_INVALID == reg) {
+    return;
+  }
+  reg = xed_get_largest_enclosing_register(reg);
+  uses.regs.push_back(reg);
+  if (XED_REG_RSP == reg) {
+    uses.uses_rsp = true;
+  }
+}
+
+// Figure out how `xedd` uses registers and memory. Returns `false` if the
+// instruction can't be executed on its own in a trampoline.
+static bool GetInstructionUses(const xed_decoded_inst_t *xedd,
+                               InstructionUses &uses) {
+  if (xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_RING0)) {
+    return false;
+  }
+
+  switch (xed_decoded_inst_get_category(xedd)) {
+    case XED_CATEGORY_XSAVE:
+    case XED_CATEGORY_XSAVEOPT:
+      return false;  // Memory footprint depends on `XCR0`.
+    default:
+      break;
+  }
+
+  // The x87 stack isn't loaded from the `State`, and `MXCSR` is the host's,
+  // so these would run on the wrong state. The MMX and opmask registers are
+  // switched, so e.g. `EMMS` is fine.
+  if (xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_MXCSR) ||
+      xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_MXCSR_RD) ||
+      xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_X87_CONTROL) ||
+      xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_X87_MMX_STATE_R) ||
+      xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_X87_MMX_STATE_CW)) {
+    return false;
+  }
+
+  auto xedi = xed_decoded_inst_inst(xedd);
+  auto num_operands = xed_inst_noperands(xedi);
+  for (auto i = 0U; i < num_operands; ++i) {
+    auto xedo = xed_inst_operand(xedi, i);
+    auto name = xed_operand_name(xedo);
+
+    if (xed_operand_is_register(name)) {
+      auto reg = xed_get_largest_enclosing_register(
+          xed_decoded_inst_get_reg(xedd, name));
+
+      // Changes control flow, or reads the program counter.
+      if (XED_REG_RIP == reg || XED_REG_EIP == reg) {
+        return false;
+      }
+
+      // Changes a segment register.
+      if (XED_REG_CLASS_SR == xed_reg_class(reg) &&
+          xed_operand_written(xedo)) {
+        return false;
+      }
+
+      // Uses the x87 stack, or the x87 control, status or tag words.
+      if (XED_REG_CLASS_X87 == xed_reg_class(reg) ||
+          XED_REG_CLASS_PSEUDOX87 == xed_reg_class(reg) ||
+          XED_REG_CLASS_MXCSR == xed_reg_class(reg)) {
+        return false;
+      }
+
+      AddRegUse(uses, reg);
+
+    } else if (XED_OPERAND_MEM0 == name) {
+      // Implicit memory operands are stack or string accesses.
+      if (XED_OPVIS_SUPPRESSED == xed_operand_operand_visibility(xedo)) {
+        return false;
+      }
+      uses.has_mem = true;
+
+    } else if (XED_OPERAND_MEM1 == name) {
+      return false;
+
+    } else if (XED_OPERAND_AGEN == name) {
+      uses.is_agen = true;
+    }
+  }
+
+  if (uses.has_mem || uses.is_agen) {
+    auto base = xed_decoded_inst_get_base_reg(xedd, 0);
+    auto index = xed_decoded_inst_get_index_reg(xedd, 0);
+
+    // The address would be computed relative to the trampoline.
+    if (uses.is_agen && (XED_REG_RIP == base || XED_REG_EIP == base)) {
+      return false;
+    }
+
+    // Vector-indexed (e.g. gather) accesses touch many locations.
+    if (XED_REG_INVALID != index && XED_REG_CLASS_GPR != xed_reg_class(index)) {
+      return false;
+    }
+
+    if (XED_REG_RIP != base && XED_REG_EIP != base) {
+      AddRegUse(uses, base);
+    }
+    AddRegUse(uses, index);
+  }
+
+  return true;
+}
+
+// Compute the guest address accessed by the memory operand of `xedd`.
+static uint64_t EffectiveAddress(State *state, const xed_decoded_inst_t *xedd,
+                                 uint64_t next_pc) {
+  uint64_t addr = 0;
+  auto base = xed_decoded_inst_get_base_reg(xedd, 0);
+  if (XED_REG_RIP == base || XED_REG_EIP == base) {
+    addr = next_pc;
+  } else if (auto base_reg = GPR(state, base)) {
+    addr = base_reg->qword;
+  }
+
+  if (auto index_reg = GPR(state, xed_decoded_inst_get_index_reg(xedd, 0))) {
+    addr += index_reg->qword * xed_decoded_inst_get_scale(xedd, 0);
+  }
+
+  addr += static_cast<uint64_t>(
+      xed_decoded_inst_get_memory_displacement(xedd, 0));
+
+  if (32 == xed_decoded_inst_get_memop_address_width(xedd, 0)) {
+    addr = static_cast<uint32_t>(addr);
+  }
+
+  switch (xed_decoded_inst_get_seg_reg(xedd, 0)) {
+    case XED_REG_FS:
+      addr += state->addr.fs_base.qword;
+      break;
+    case XED_REG_GS:
+      addr += state->addr.gs_base.qword;
+      break;
+    default:
+      break;
+  }
+
+  return addr;
+}
+
+}  // namespace
+
+NativeInstructionStatus ExecuteInstructionNatively(State *state,
+                                                   AddressSpace *memory) {
+  static std::once_flag xed_init;
+  std::call_once(xed_init, xed_tables_init);
+
+  auto pc = state->gpr.rip.qword;
+  uint8_t bytes[kMaxInstructionSize];
+  auto num_bytes = 0U;
+  for (; num_bytes < kMaxInstructionSize; ++num_bytes) {
+    if (!memory->TryRead(pc + num_bytes, &(bytes[num_bytes]), 1)) {
+      break;
+    }
+  }
+
+  xed_decoded_inst_t xedd;
+  xed_decoded_inst_zero_set_mode(&xedd, &kXEDState64);
+  if (!num_bytes || XED_ERROR_NONE != xed_decode(&xedd, bytes, num_bytes)) {
+    return kNativeInstructionInvalid;
+  }
+
+  InstructionUses uses;
+  if (!GetInstructionUses(&xedd, uses)) {
+    return kNativeInstructionUnsupported;
+  }
+
+  auto inst_size = xed_decoded_inst_get_length(&xedd);
+  auto next_pc = pc + inst_size;
+  auto &trampoline = gTrampoline;
+  trampoline.MakeWritable();
+  auto code = trampoline.code;
+
+  uint64_t mem_addr = 0;
+  size_t mem_size = 0;
+  uint8_t *host_mem = nullptr;
+  Reg *addr_reg = nullptr;
+  uint64_t saved_addr_reg = 0;
+  bool mem_written = false;
+
+  if (!uses.has_mem) {
+    memcpy(code, bytes, inst_size);
+    code += inst_size;
+
+  } else {
+    mem_addr = EffectiveAddress(state, &xedd, next_pc);
+    mem_size = xed_decoded_inst_get_memory_operand_length(&xedd, 0);
+    mem_written = xed_decoded_inst_mem_written(&xedd, 0);
+    if (mem_size > kMaxMemOperandSize) {
+      return kNativeInstructionUnsupported;
+    }
+
+    // Copy in the guest memory, even if it's only written, so that partial
+    // writes (e.g. masked stores) leave the rest of it intact.
+    host_mem = &(trampoline.mem[mem_addr & 63]);
+    if (!memory->TryRead(mem_addr, host_mem, mem_size)) {
+      return kNativeInstructionMemoryFault;
+    }
+
+    // Find a register that the instruction doesn't use, and point it at the
+    // host copy of the memory operand.
+    auto addr_reg_index = 0U;
+    for (const auto &candidate : kAddressRegs) {
+      if (uses.regs.end() == std::find(uses.regs.begin(), uses.regs.end(),
+                                       candidate.reg)) {
+        break;
+      }
+      ++addr_reg_index;
+    }
+    if (addr_reg_index >= sizeof(kAddressRegs) / sizeof(kAddressRegs[0])) {
+      return kNativeInstructionUnsupported;
+    }
+
+    const auto &free_reg = kAddressRegs[addr_reg_index];
+    addr_reg = GPR(state, free_reg.reg);
+    saved_addr_reg = addr_reg->qword;
+
+    // `MOV r64, imm64`.
+    auto host_addr = reinterpret_cast<uint64_t>(host_mem);
+    *code++ = static_cast<uint8_t>(0x48 | (free_reg.encoding >> 3));
+    *code++ = static_cast<uint8_t>(0xB8 | (free_reg.encoding & 7));
+    memcpy(code, &host_addr, sizeof(host_addr));
+    code += sizeof(host_addr);
+
+    // Re-encode the instruction as accessing `[free_reg]`.
+    xed_encoder_request_init_from_decode(&xedd);
+    xed_encoder_request_set_effective_address_size(&xedd, 64);
+    xed_encoder_request_set_seg0(&xedd, XED_REG_INVALID);
+    xed_encoder_request_set_base0(&xedd, free_reg.reg);
+    xed_encoder_request_set_index(&xedd, XED_REG_INVALID);
+    xed_encoder_request_set_scale(&xedd, 1);
+    xed_encoder_request_set_memory_displacement(&xedd, 0, 0);
+
+    unsigned encoded_size = 0;
+    if (XED_ERROR_NONE != xed_encode(&xedd, code, kMaxInstructionSize,
+                                     &encoded_size)) {
+      return kNativeInstructionUnsupported;
+    }
+    code += encoded_size;
+  }
+
+  // `JMP QWORD PTR [RIP + 0]`, followed by the address of the exit routine.
+  static const uint8_t kJumpToExit[] = {0xFF, 0x25, 0x00, 0x00, 0x00, 0x00};
+  auto exit_addr = reinterpret_cast<uint64_t>(__remill_x86_native_exit);
+  memcpy(code, kJumpToExit, sizeof(kJumpToExit));
+  code += sizeof(kJumpToExit);
+  memcpy(code, &exit_addr, sizeof(exit_addr));
+
+  auto saved_rsp = state->gpr.rsp.qword;
+  if (!uses.uses_rsp) {
+    state->gpr.rsp.qword = trampoline.StackTop();
+  }
+
+  trampoline.MakeExecutable();
+  state->gpr.rip.qword = reinterpret_cast<uint64_t>(trampoline.code);
+  __remill_x86_switch_to_native(state);
+  state->gpr.rip.qword = next_pc;
+
+  if (!uses.uses_rsp) {
+    state->gpr.rsp.qword = saved_rsp;
+  }
+
+  if (addr_reg) {
+    addr_reg->qword = saved_addr_reg;
+  }
+
+  // Every mapped page is writable, and all of these were just read.
+  if (mem_written) {
+    auto wrote = memory->TryWrite(mem_addr, host_mem, mem_size);
+    CHECK(wrote)
+        << "Unable to write back memory operand of instruction at "
+        << std::hex << pc << std::dec;
+  }
+
+  return kNativeInstructionExecuted;
+}
+
+}  // namespace remill
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REMILL_RUNTIME_X86_NATIVEINSTRUCTION_H_
+#define REMILL_RUNTIME_X86_NATIVEINSTRUCTION_H_
+
+struct State;
+
+namespace remill {
+
+class AddressSpace;
+
+enum NativeInstructionStatus {
+  // The instruction executed, and `State::gpr.rip` points to the next
+  // instruction.
+  kNativeInstructionExecuted,
+
+  // The instruction bytes could not be read or decoded.
+  kNativeInstructionInvalid,
+
+  // The instruction cannot be executed this way, e.g. because it changes
+  // control flow, accesses the stack or more than one memory location, uses
+  // the x87 stack, or depends on `MXCSR`.
+  kNativeInstructionUnsupported,
+
+  // The instruction's memory operand is not (fully) mapped.
+  kNativeInstructionMemoryFault
+};
+
+// Execute the 64-bit x86 instruction at `state->gpr.rip` on the host CPU. This
+// is meant for handling the `kAMD64EmulateInstruction` hyper call, which
+// lifted code makes in place of unsupported instructions, and only works when
+// the host is itself x86-64.
+//
+// The instruction is re-encoded so that its memory operand, if any, refers to
+// a host copy of the guest memory from `memory`, and is then run on a
+// per-thread trampoline with `state` loaded into the native registers (see
+// `remill/Runtime/X86/ContextSwitch.h`). The guest stack pointer is only
+// loaded if the instruction uses it.
+//
+// Faults raised by the instruction itself (e.g. a division by zero) are
+// delivered to the host process as signals.
+NativeInstructionStatus ExecuteInstructionNatively(State *state,
+                                                   AddressSpace *memory);
+
+}  // namespace remill
+
+#endif  // REMILL_RUNTIME_X86_NATIVEINSTRUCTION_H_
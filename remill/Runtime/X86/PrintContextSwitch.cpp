@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "remill/Arch/X86/Runtime/State.h"
+#include "remill/Runtime/X86/ContextSwitch.h"
+
+// This is used by the `print_context_switch_asm.sh` script to generate
+// `generated/Arch/X86/ContextSwitch.S`, which implements the routines declared
+// in `remill/Runtime/X86/ContextSwitch.h`. Unlike `tests/X86/PrintSaveState.cpp`,
+// the generated code is meant to be fast: flags are packed and unpacked with
+// plain ALU instructions, and only one vector register set is moved.
+//
+// Note: We compile this using the 64-bit, AVX512-enabled version of the
+//       `State` structure. This doesn't actually matter because the `State`
+//       structure has the same size/shape across all configurations.
+
+namespace {
+
+// Returns the memory operand for `field` of the calling thread's
+// `RemillX86NativeContext`.
+#define CONTEXT(field) \
+    ContextOperand(offsetof(RemillX86NativeContext, field)).c_str()
+
+static std::string ContextOperand(size_t offset) {
+  char buff[128];
+  snprintf(buff, sizeof(buff),
+           "QWORD PTR fs:[__remill_x86_native_context@tpoff + %lu]", offset);
+  return buff;
+}
+
+struct GPRInfo {
+  const char *name;
+  size_t offset;
+};
+
+static const GPRInfo kGPRs[] = {
+  {"RAX", offsetof(State, gpr.rax.qword)},
+  {"RBX", offsetof(State, gpr.rbx.qword)},
+  {"RCX", offsetof(State, gpr.rcx.qword)},
+  {"RDX", offsetof(State, gpr.rdx.qword)},
+  {"RSI", offsetof(State, gpr.rsi.qword)},
+  {"RDI", offsetof(State, gpr.rdi.qword)},
+  {"RSP", offsetof(State, gpr.rsp.qword)},
+  {"RBP", offsetof(State, gpr.rbp.qword)},
+  {"R8", offsetof(State, gpr.r8.qword)},
+  {"R9", offsetof(State, gpr.r9.qword)},
+  {"R10", offsetof(State, gpr.r10.qword)},
+  {"R11", offsetof(State, gpr.r11.qword)},
+  {"R12", offsetof(State, gpr.r12.qword)},
+  {"R13", offsetof(State, gpr.r13.qword)},
+  {"R14", offsetof(State, gpr.r14.qword)},
+  {"R15", offsetof(State, gpr.r15.qword)},
+};
+
+struct FlagInfo {
+  unsigned bit;
+  size_t offset;
+};
+
+static const FlagInfo kFlags[] = {
+  {0, offsetof(State, aflag.cf)},
+  {2, offsetof(State, aflag.pf)},
+  {4, offsetof(State, aflag.af)},
+  {6, offsetof(State, aflag.zf)},
+  {7, offsetof(State, aflag.sf)},
+  {10, offsetof(State, aflag.df)},
+  {11, offsetof(State, aflag.of)},
+};
+
+// Print a function prologue.
+static void BeginFunction(const char *name) {
+  printf("    .globl %s\n", name);
+  printf("    .type %s, @function\n", name);
+  printf("    .p2align 4\n");
+  printf("%s:\n", name);
+}
+
+static void EndFunction(const char *name) {
+  printf("    .size %s, . - %s\n\n", name, name);
+}
+
+// Print code that moves the vector registers to or from the `State` pointed
+// to by `state_reg`. The vector register set is chosen at runtime.
+static void MoveVectorRegs(const char *state_reg, bool to_state) {
+  printf("    cmp DWORD PTR [RIP + __remill_x86_vector_isa], %d\n",
+         kRemillX86VectorISA_AVX);
+  printf("    je 2f\n");
+  printf("    ja 3f\n");
+
+  struct {
+    const char *move;
+    const char *reg_prefix;
+    unsigned num_regs;
+  } const kVecISAs[] = {
+    {"movdqu", "XMM", 16},
+    {"vmovdqu", "YMM", 16},
+    {"vmovdqu64", "ZMM", kNumVecRegisters},
+  };
+
+  for (unsigned isa = 0; isa < 3; ++isa) {
+    const auto &vec_isa = kVecISAs[isa];
+    if (isa) {
+      printf("%u:\n", isa + 1);
+    }
+    for (unsigned i = 0; i < vec_isa.num_regs; ++i) {
+      auto offset = offsetof(State, vec) + i * sizeof(VectorReg);
+      if (to_state) {
+        printf("    %s [%s + %lu], %s%u\n",
+               vec_isa.move, state_reg, offset, vec_isa.reg_prefix, i);
+      } else {
+        printf("    %s %s%u, [%s + %lu]\n",
+               vec_isa.move, vec_isa.reg_prefix, i, state_reg, offset);
+      }
+    }
+
+    // The opmask registers are 64 bits wide with AVX512BW, and 16 bits wide
+    // otherwise. `KMOVW` to a register zero-extends, so the upper bits of the
+    // `State`'s registers are cleared.
+    if (2 == isa) {
+      printf("    cmp DWORD PTR [RIP + __remill_x86_has_avx512bw], 0\n");
+      printf("    je 5f\n");
+      for (unsigned i = 0; i < 8; ++i) {
+        auto offset = offsetof(State, k_reg.elems[0].val) + i * 16;
+        if (to_state) {
+          printf("    kmovq QWORD PTR [%s + %lu], K%u\n", state_reg, offset, i);
+        } else {
+          printf("    kmovq K%u, QWORD PTR [%s + %lu]\n", i, state_reg, offset);
+        }
+      }
+      printf("    jmp 6f\n");
+      printf("5:\n");
+      for (unsigned i = 0; i < 8; ++i) {
+        auto offset = offsetof(State, k_reg.elems[0].val) + i * 16;
+        if (to_state) {
+          printf("    kmovw EAX, K%u\n", i);
+          printf("    mov QWORD PTR [%s + %lu], RAX\n", state_reg, offset);
+        } else {
+          printf("    kmovw K%u, WORD PTR [%s + %lu]\n", i, state_reg, offset);
+        }
+      }
+      printf("6:\n");
+    }
+
+    // The host code that we return to may use legacy SSE instructions, which
+    // are slow while the upper halves of the `YMM` registers are dirty.
+    if (isa && to_state) {
+      printf("    vzeroupper\n");
+    }
+    printf("    jmp 4f\n");
+  }
+  printf("4:\n");
+}
+
+static void PrintSwitchToNative(void) {
+  BeginFunction("__remill_x86_switch_to_native");
+
+  // Save the host's callee-saved registers and control words. This leaves the
+  // stack 16-byte aligned.
+  printf("    push RBX\n");
+  printf("    push RBP\n");
+  printf("    push R12\n");
+  printf("    push R13\n");
+  printf("    push R14\n");
+  printf("    push R15\n");
+  printf("    lea RSP, [RSP - 8]\n");
+  printf("    stmxcsr DWORD PTR [RSP]\n");
+  printf("    fnstcw WORD PTR [RSP + 4]\n");
+
+  // Save the context of any enclosing switch, and make this the innermost one.
+  printf("    push %s\n", CONTEXT(host_rsp));
+  printf("    push %s\n", CONTEXT(state));
+  printf("    mov %s, RSP\n", CONTEXT(host_rsp));
+  printf("    mov %s, RDI\n", CONTEXT(state));
+  printf("    mov RAX, QWORD PTR [RDI + %lu]\n", offsetof(State, gpr.rip.qword));
+  printf("    mov %s, RAX\n", CONTEXT(target));
+
+  // Loading the x87 control word is slow, and it rarely differs between the
+  // host and the `State`. The host's control word is just above the two saved
+  // context entries.
+  printf("    mov AX, WORD PTR [RDI + %lu]\n", offsetof(State, fpu_control));
+  printf("    cmp AX, WORD PTR [RSP + 20]\n");
+  printf("    je 1f\n");
+  printf("    fldcw WORD PTR [RDI + %lu]\n", offsetof(State, fpu_control));
+  printf("1:\n");
+  MoveVectorRegs("RDI", false);
+
+  // The MMX registers alias the x87 registers. `EMMS` leaves the x87 stack
+  // empty, which is what the host ABI requires at function boundaries; the
+  // `State` doesn't record which x87 stack entries are live, so those aren't
+  // loaded.
+  for (unsigned i = 0; i < 8; ++i) {
+    printf("    movq MM%u, QWORD PTR [RDI + %lu]\n", i,
+           offsetof(State, mmx.elems[0].val) + i * 16);
+  }
+  printf("    emms\n");
+
+  // Set the arithmetic flags without `POPFQ`, which is slow and would also
+  // take the system flags (e.g. `TF`, `AC`) from the `State`. `SAHF` sets
+  // `SF`, `ZF`, `AF`, `PF`, and `CF`; `OF` comes from an addition that
+  // overflows only if the `State`'s `OF` is set. The host ABI guarantees
+  // that `DF` is clear, and setting it is slow, so it is only set if needed.
+  printf("    movzx EAX, BYTE PTR [RDI + %lu]\n", kFlags[0].offset);
+  printf("    and EAX, 1\n");
+  for (const auto &flag : kFlags) {
+    if (flag.bit && flag.bit < 8) {
+      printf("    movzx ECX, BYTE PTR [RDI + %lu]\n", flag.offset);
+      printf("    and ECX, 1\n");
+      printf("    shl ECX, %u\n", flag.bit);
+      printf("    or EAX, ECX\n");
+    }
+  }
+  printf("    or EAX, 2\n");  // Bit 1 of `RFLAGS` is always set.
+  printf("    mov AH, AL\n");
+  printf("    cmp BYTE PTR [RDI + %lu], 0\n", offsetof(State, aflag.df));
+  printf("    je 1f\n");
+  printf("    std\n");
+  printf("1:\n");
+  printf("    movzx ECX, BYTE PTR [RDI + %lu]\n", offsetof(State, aflag.of));
+  printf("    and ECX, 1\n");
+  printf("    add CL, 0x7f\n");
+  printf("    sahf\n");
+
+  // Nothing below changes the flags. `RDI` holds the `State` pointer, so it is
+  // loaded last, and the target is then reached through the context.
+  for (const auto &gpr : kGPRs) {
+    if (strcmp(gpr.name, "RDI")) {
+      printf("    mov %s, QWORD PTR [RDI + %lu]\n", gpr.name, gpr.offset);
+    }
+  }
+  printf("    mov RDI, QWORD PTR [RDI + %lu]\n", offsetof(State, gpr.rdi.qword));
+  printf("    jmp %s\n", CONTEXT(target));
+
+  EndFunction("__remill_x86_switch_to_native");
+}
+
+static void PrintNativeExit(void) {
+  BeginFunction("__remill_x86_native_exit");
+
+  // Free up `R11` to hold the `State` pointer. Nothing here touches the native
+  // stack, and nothing changes the flags until they are saved.
+  printf("    mov %s, R11\n", CONTEXT(scratch));
+  printf("    mov R11, %s\n", CONTEXT(state));
+  for (const auto &gpr : kGPRs) {
+    if (strcmp(gpr.name, "R11")) {
+      printf("    mov QWORD PTR [R11 + %lu], %s\n", gpr.offset, gpr.name);
+    }
+  }
+  printf("    mov RAX, %s\n", CONTEXT(scratch));
+  printf("    mov QWORD PTR [R11 + %lu], RAX\n",
+         offsetof(State, gpr.r11.qword));
+
+  // Back onto the host stack, and store the arithmetic flags while they are
+  // still live. There is no `SETcc` for `AF`, so it comes from `LAHF`, and
+  // `DF` comes from the saved `RFLAGS`.
+  printf("    mov RSP, %s\n", CONTEXT(host_rsp));
+  printf("    setc BYTE PTR [R11 + %lu]\n", offsetof(State, aflag.cf));
+  printf("    setp BYTE PTR [R11 + %lu]\n", offsetof(State, aflag.pf));
+  printf("    setz BYTE PTR [R11 + %lu]\n", offsetof(State, aflag.zf));
+  printf("    sets BYTE PTR [R11 + %lu]\n", offsetof(State, aflag.sf));
+  printf("    seto BYTE PTR [R11 + %lu]\n", offsetof(State, aflag.of));
+  printf("    lahf\n");
+  printf("    pushfq\n");
+  printf("    pop RCX\n");
+  printf("    mov QWORD PTR [R11 + %lu], RCX\n", offsetof(State, rflag));
+  printf("    shr EAX, 12\n");  // `AF` is bit 4 of `AH`.
+  printf("    and EAX, 1\n");
+  printf("    mov BYTE PTR [R11 + %lu], AL\n", offsetof(State, aflag.af));
+  printf("    shr ECX, 10\n");
+  printf("    and ECX, 1\n");
+  printf("    mov BYTE PTR [R11 + %lu], CL\n", offsetof(State, aflag.df));
+
+  // The host ABI requires that `DF` is clear.
+  printf("    cld\n");
+
+  MoveVectorRegs("R11", true);
+
+  // Save the x87 state below the host stack pointer, which is 16-byte aligned.
+  // Reading the MMX registers marks every x87 register as valid, so the x87
+  // state is then reloaded, and its stack entries are popped into the `State`
+  // with all exceptions masked. Popping an empty entry stores a NaN. This
+  // leaves the x87 stack empty.
+  printf("    lea RSP, [RSP - 512]\n");
+  printf("    fxsave64 [RSP]\n");
+  for (unsigned i = 0; i < 8; ++i) {
+    printf("    movq QWORD PTR [R11 + %lu], MM%u\n",
+           offsetof(State, mmx.elems[0].val) + i * 16, i);
+  }
+  printf("    fxrstor64 [RSP]\n");
+  printf("    mov WORD PTR [RSP + %lu], 0x37f\n", sizeof(FPU) - 2);
+  printf("    fldcw WORD PTR [RSP + %lu]\n", sizeof(FPU) - 2);
+  for (unsigned i = 0; i < 8; ++i) {
+    printf("    fstp QWORD PTR [R11 + %lu]\n",
+           offsetof(State, st.elems[0].val) + i * 16);
+  }
+  printf("    fnclex\n");
+  printf("    mov AX, WORD PTR [RSP + %lu]\n", offsetof(FPU, cwd));
+  printf("    mov WORD PTR [R11 + %lu], AX\n", offsetof(State, fpu_control));
+
+  // `SAHF` of the high byte of the status word puts `C0`, `C2` and `C3` into
+  // `CF`, `PF` and `ZF`. `C1` has no flag, so it is shifted out.
+  printf("    movzx EAX, WORD PTR [RSP + %lu]\n", offsetof(FPU, swd));
+  printf("    sahf\n");
+  printf("    setc BYTE PTR [R11 + %lu]\n", offsetof(State, sw.c0));
+  printf("    setp BYTE PTR [R11 + %lu]\n", offsetof(State, sw.c2));
+  printf("    setz BYTE PTR [R11 + %lu]\n", offsetof(State, sw.c3));
+  printf("    shr EAX, 9\n");
+  printf("    and EAX, 1\n");
+  printf("    mov BYTE PTR [R11 + %lu], AL\n", offsetof(State, sw.c1));
+  printf("    lea RSP, [RSP + 512]\n");
+
+  // Restore the context of the enclosing switch, and then the host's state.
+  // The control registers are only reloaded if native code changed them.
+  printf("    pop %s\n", CONTEXT(state));
+  printf("    pop %s\n", CONTEXT(host_rsp));
+  printf("    stmxcsr DWORD PTR [RSP - 4]\n");
+  printf("    mov EAX, DWORD PTR [RSP - 4]\n");
+  printf("    cmp EAX, DWORD PTR [RSP]\n");
+  printf("    je 1f\n");
+  printf("    ldmxcsr DWORD PTR [RSP]\n");
+  printf("1:\n");
+  printf("    cmp WORD PTR [RSP + 4], 0x37f\n");  // Loaded above.
+  printf("    je 1f\n");
+  printf("    fldcw WORD PTR [RSP + 4]\n");
+  printf("1:\n");
+  printf("    lea RSP, [RSP + 8]\n");
+  printf("    pop R15\n");
+  printf("    pop R14\n");
+  printf("    pop R13\n");
+  printf("    pop R12\n");
+  printf("    pop RBP\n");
+  printf("    pop RBX\n");
+  printf("    ret\n");
+
+  EndFunction("__remill_x86_native_exit");
+}
+
+static void PrintCallNative(void) {
+  BeginFunction("__remill_x86_call_native");
+
+  // Swap the return address on the native stack for the exit routine, and
+  // remember the real return address on the host stack.
+  printf("    mov RAX, QWORD PTR [RDI + %lu]\n", offsetof(State, gpr.rsp.qword));
+  printf("    mov RCX, QWORD PTR [RAX]\n");
+  printf("    lea RDX, [RIP + __remill_x86_native_exit]\n");
+  printf("    mov QWORD PTR [RAX], RDX\n");
+  printf("    push RDI\n");
+  printf("    push RCX\n");
+  printf("    call __remill_x86_switch_to_native\n");
+  printf("    pop RCX\n");
+  printf("    pop RDI\n");
+  printf("    mov QWORD PTR [RDI + %lu], RCX\n", offsetof(State, gpr.rip.qword));
+  printf("    ret\n");
+
+  EndFunction("__remill_x86_call_native");
+}
+
+}  // namespace
+
+int main(void) {
+  printf("/* Auto-generated file! Don't modify! */\n\n");
+  printf("    .intel_syntax noprefix\n");
+  printf("    .text\n\n");
+
+  PrintSwitchToNative();
+  PrintNativeExit();
+  PrintCallNative();
+
+  printf("    .section .note.GNU-stack, \"\", @progbits\n");
+  return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <cstdio>
+
+#include "remill/Arch/X86/Runtime/State.h"
+
+// This is used by the `print_state_layout.sh` script to describe where each
+// register lives in the `State` structure. It is compiled once with
+// `DENSE_STATE=0` and once with `DENSE_STATE=1`, and the fields are printed in
+// the same order both times, so that `remill/Runtime/DenseState.cpp` can pair
+// them up to convert between the two layouts. The `volatile` padding of the
+// default layout is not part of any field.
+//
+// Note: We compile this using the 64-bit, AVX512-enabled version of the
+//       `State` structure. This doesn't actually matter because the `State`
+//       structure has the same size/shape across all configurations.
+
+#define PRINT_FIELD(name, field) \
+    printf("STATE_FIELD(\"%s\", %lu, %lu)\n", name, \
+           offsetof(State, field), sizeof(reinterpret_cast<State *>(0)->field))
+
+int main(void) {
+  printf("/* Auto-generated file! Don't modify! */\n\n");
+  printf("STATE_SIZE(%lu)\n", sizeof(State));
+
+  printf("STATE_FIELD(\"hyper_call\", 0, %lu)\n", sizeof(ArchState));
+
+  for (auto i = 0U; i < kNumVecRegisters; ++i) {
+    printf("STATE_FIELD(\"vec[%u]\", %lu, %lu)\n", i,
+           offsetof(State, vec) + i * sizeof(VectorReg), sizeof(VectorReg));
+  }
+
+  PRINT_FIELD("aflag.cf", aflag.cf);
+  PRINT_FIELD("aflag.pf", aflag.pf);
+  PRINT_FIELD("aflag.af", aflag.af);
+  PRINT_FIELD("aflag.zf", aflag.zf);
+  PRINT_FIELD("aflag.sf", aflag.sf);
+  PRINT_FIELD("aflag.df", aflag.df);
+  PRINT_FIELD("aflag.of", aflag.of);
+  PRINT_FIELD("rflag", rflag);
+
+  PRINT_FIELD("seg.ss", seg.ss);
+  PRINT_FIELD("seg.es", seg.es);
+  PRINT_FIELD("seg.gs", seg.gs);
+  PRINT_FIELD("seg.fs", seg.fs);
+  PRINT_FIELD("seg.ds", seg.ds);
+  PRINT_FIELD("seg.cs", seg.cs);
+
+  PRINT_FIELD("addr.fs_base", addr.fs_base);
+  PRINT_FIELD("addr.gs_base", addr.gs_base);
+
+  PRINT_FIELD("gpr.rax", gpr.rax);
+  PRINT_FIELD("gpr.rbx", gpr.rbx);
+  PRINT_FIELD("gpr.rcx", gpr.rcx);
+  PRINT_FIELD("gpr.rdx", gpr.rdx);
+  PRINT_FIELD("gpr.rsi", gpr.rsi);
+  PRINT_FIELD("gpr.rdi", gpr.rdi);
+  PRINT_FIELD("gpr.rsp", gpr.rsp);
+  PRINT_FIELD("gpr.rbp", gpr.rbp);
+  PRINT_FIELD("gpr.r8", gpr.r8);
+  PRINT_FIELD("gpr.r9", gpr.r9);
+  PRINT_FIELD("gpr.r10", gpr.r10);
+  PRINT_FIELD("gpr.r11", gpr.r11);
+  PRINT_FIELD("gpr.r12", gpr.r12);
+  PRINT_FIELD("gpr.r13", gpr.r13);
+  PRINT_FIELD("gpr.r14", gpr.r14);
+  PRINT_FIELD("gpr.r15", gpr.r15);
+  PRINT_FIELD("gpr.rip", gpr.rip);
+
+  PRINT_FIELD("st", st);
+  PRINT_FIELD("mmx", mmx);
+  PRINT_FIELD("sw", sw);
+  PRINT_FIELD("xcr0", xcr0);
+  PRINT_FIELD("fpu_control", fpu_control);
+  PRINT_FIELD("k_reg", k_reg);
+  return 0;
+}
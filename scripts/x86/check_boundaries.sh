@@ -0,0 +1,99 @@
+#!/usr/bin/env bash
+# Copyright (c) 2017 Trail of Bits, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Cross-checks the instruction lengths and direct branch targets found by
+# `Arch::DecodeInstructionBoundary` against GNU `objdump`, over the
+# executable code of some x86-64 ELF binaries. For example:
+#
+#   check_boundaries.sh build/tools/benchmark_decode/remill-benchmark-decode \
+#       /bin/ls /usr/bin/python3
+#
+# Both tools sweep the code linearly, so they can briefly lose sync after
+# data or padding in the code. Those instructions are counted, but only
+# disagreements about instructions that both tools found are errors.
+
+if [[ "$#" -lt 2 ]] ; then
+  echo "Usage: $0 <remill-benchmark-decode> <binary> [<binary> ...]"
+  exit 1
+fi
+
+DECODER=$1
+shift
+
+TMP=$(mktemp -d)
+trap "rm -rf ${TMP}" EXIT
+
+STATUS=0
+
+for BINARY in "$@" ; do
+  ${DECODER} \
+      --arch amd64 \
+      --iterations 1 \
+      --binary_in "${BINARY}" \
+      --boundaries_out ${TMP}/remill.txt > /dev/null || exit 1
+
+  # One line per instruction: hexadecimal PC, length, and hexadecimal direct
+  # branch target (or `-`).
+  objdump -d -w --insn-width=16 "${BINARY}" | awk -F '\t' '
+    $1 ~ /^ *[0-9a-f]+:$/ && NF >= 3 && $3 !~ /\(bad\)/ {
+      pc = $1
+      gsub(/[ :]/, "", pc)
+      num_bytes = split($2, bytes, " ")
+      target = "-"
+      num_words = split($3, words, " ")
+      for (i = 1; i < num_words; ++i) {
+        if (words[i] ~ /^(j[a-z]+|call[lq]?|loop[a-z]*)$/) {
+          if (words[i + 1] ~ /^[0-9a-f]+$/) {
+            target = words[i + 1]
+          }
+          break
+        }
+      }
+      print pc, num_bytes, target
+    }' > ${TMP}/objdump.txt
+
+  awk -v binary="${BINARY}" '
+    FNR == NR {
+      num_bytes[$1] = $2
+      target[$1] = $3
+      next
+    }
+    !($1 in num_bytes) {
+      ++num_unsynced
+      next
+    }
+    {
+      ++num_checked
+      if (num_bytes[$1] != $2) {
+        if (num_wrong++ < 20) {
+          print binary ": " $1 ": remill length " num_bytes[$1] \
+                ", objdump length " $2
+        }
+      } else if ("-" != target[$1] && target[$1] != $3) {
+        if (num_wrong++ < 20) {
+          print binary ": " $1 ": remill target " target[$1] \
+                ", objdump target " $3
+        }
+      }
+    }
+    END {
+      print binary ": " num_checked + 0 " instructions checked, " \
+            num_wrong + 0 " disagreements, " num_unsynced + 0 \
+            " only found by objdump"
+      exit (num_wrong > 0)
+    }' ${TMP}/remill.txt ${TMP}/objdump.txt || STATUS=1
+done
+
+exit ${STATUS}
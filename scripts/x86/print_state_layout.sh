@@ -0,0 +1,47 @@
+#!/usr/bin/env bash
+# Copyright (c) 2017 Trail of Bits, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# This script is a convenience script for generating the tables that describe
+# the default and dense (`DENSE_STATE=1`) layouts of the `State` structure.
+# These are used by `remill/Runtime/DenseState.cpp`.
+
+DIR=$(dirname $(dirname $( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )))
+
+CXX=$(which c++)
+
+mkdir -p $DIR/generated/Arch/X86
+
+pushd /tmp
+
+for DENSE in 0 1 ; do
+  ${CXX} \
+      -std=gnu++11 \
+      -Wno-nested-anon-types -Wno-variadic-macros -Wno-extended-offsetof \
+      -Wno-invalid-offsetof \
+      -Wno-return-type-c-linkage \
+      -I${DIR} \
+      -m64 -DADDRESS_SIZE_BITS=64 -DHAS_FEATURE_AVX=1 -DHAS_FEATURE_AVX512=1 \
+      -DDENSE_STATE=${DENSE} \
+      $DIR/remill/Runtime/X86/PrintStateLayout.cpp
+
+  if [[ "${DENSE}" == "1" ]] ; then
+    ./a.out > $DIR/generated/Arch/X86/DenseStateLayout.inc
+  else
+    ./a.out > $DIR/generated/Arch/X86/StateLayout.inc
+  fi
+  rm ./a.out
+done
+
+popd
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include "remill/Arch/AArch64/Decode.h"
+#include "remill/Arch/Arch.h"
+#include "remill/Arch/Instruction.h"
+#include "remill/Arch/Name.h"
+#include "remill/BC/Util.h"
+#include "remill/OS/OS.h"
+
+// Generates a corpus of random test cases in the format of `Tests.S`. Each
+// test case is one randomly chosen encoding of some instruction form, run
+// against random inputs. The corpus is then lifted and run just like the
+// hand-written tests, via `lift-aarch64-fuzz-tests` and
+// `run-aarch64-fuzz-tests`.
+//
+// Candidate encodings are random 32-bit words, bucketed by the
+// `aarch64::InstForm` that they extract to. Loads and stores have their base
+// register forced to `SP`, and every test case moves `SP` down by
+// `kStackAdjust` bytes around the instruction, so that native and lifted
+// executions access the same (recording) stack memory.
+
+DEFINE_string(fuzz_out, "",
+              "Name of the file in which to place the generated tests.");
+
+DEFINE_uint64(seed, 0,
+              "Seed for the random number generator. Zero means to use the "
+              "current time.");
+
+DEFINE_int32(encodings_per_iform, 4,
+             "Maximum number of distinct encodings to generate per iform.");
+
+DEFINE_int32(inputs_per_encoding, 8,
+             "Number of random input tuples to run each encoding with.");
+
+DEFINE_uint64(max_attempts, 50000000,
+              "Maximum number of candidate encodings to try.");
+
+DECLARE_string(arch);
+DECLARE_string(os);
+
+namespace {
+
+// How far below the top of the recording stack each instruction runs.
+// Memory operands must fall within `[-kStackAdjust, kStackAdjust)` of `SP`.
+static constexpr int64_t kStackAdjust = 2048;
+
+// Largest number of bytes that one memory operand can access (e.g. `LD4` of
+// four `Q` registers).
+static constexpr int64_t kMaxAccessSize = 64;
+
+// Loads and stores are the encodings where `op0<2> == 1` and `op0<0> == 0`.
+// In all of them, `Rn` is the base register.
+static bool IsLoadStore(uint32_t bits) {
+  return (bits & (1U << 27)) && !(bits & (1U << 25));
+}
+
+// Returns `true` if `reg` names a register that the test harness owns, or
+// one that differs between native and lifted runs.
+static bool IsHarnessRegister(const std::string &reg) {
+  return "X28" == reg || "W28" == reg || "PC" == reg;
+}
+
+static bool IsStackPointer(const std::string &reg) {
+  return "SP" == reg || "WSP" == reg;
+}
+
+// Returns `true` if the behavior of instructions of this class depends on
+// something other than their architectural inputs.
+static bool IsNonDeterministic(aarch64::InstName iclass) {
+  switch (iclass) {
+    case aarch64::InstName::MRS:
+    case aarch64::InstName::MSR:
+    case aarch64::InstName::SYS:
+    case aarch64::InstName::SYSL:
+    case aarch64::InstName::HINT:
+    case aarch64::InstName::CLREX:
+    case aarch64::InstName::HLT:
+    case aarch64::InstName::BRK:
+    case aarch64::InstName::SVC:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Checks that the operands of `inst` are safe to run in the test harness.
+static bool HasSafeOperands(const remill::Instruction &inst) {
+  for (const auto &op : inst.operands) {
+    switch (op.type) {
+      case remill::Operand::kTypeRegister:
+        if (IsHarnessRegister(op.reg.name) ||
+            (remill::Operand::kActionWrite == op.action &&
+             IsStackPointer(op.reg.name))) {
+          return false;
+        }
+        break;
+
+      case remill::Operand::kTypeShiftRegister:
+        if (IsHarnessRegister(op.shift_reg.reg.name)) {
+          return false;
+        }
+        break;
+
+      case remill::Operand::kTypeAddress:
+        if (IsHarnessRegister(op.addr.base_reg.name) ||
+            IsHarnessRegister(op.addr.index_reg.name)) {
+          return false;
+        }
+        if (op.addr.IsMemoryAccess()) {
+          if ("SP" != op.addr.base_reg.name ||
+              !op.addr.index_reg.name.empty() ||
+              -kStackAdjust > op.addr.displacement ||
+              (kStackAdjust - kMaxAccessSize) < op.addr.displacement) {
+            return false;
+          }
+        } else if (op.addr.IsControlFlowTarget()) {
+          return false;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+class Generator {
+ public:
+  Generator(const remill::Arch *arch_, llvm::Module *semantics_,
+            uint64_t seed)
+      : arch(arch_),
+        semantics(semantics_),
+        gen(seed) {}
+
+  // Returns a random candidate encoding.
+  uint32_t RandomCandidate(void) {
+    auto bits = static_cast<uint32_t>(gen());
+    if (IsLoadStore(bits)) {
+      bits |= 0x1FU << 5;  // `Rn = SP`.
+    }
+    return bits;
+  }
+
+  // Returns a random input value, biased towards edge cases.
+  uint64_t RandomInput(void) {
+    switch (gen() % 8) {
+      case 0: return 0;
+      case 1: return ~0ULL;
+      case 2: return 1ULL << (gen() % 64);
+      case 3: return (1ULL << (gen() % 64)) - 1;
+      case 4: return static_cast<uint8_t>(gen());
+      case 5: return static_cast<uint16_t>(gen());
+      case 6: return static_cast<uint32_t>(gen());
+      default: return gen();
+    }
+  }
+
+  // Tries to turn `bits` into a test case. Returns the extracted instruction
+  // data on success.
+  bool Accept(uint32_t bits, aarch64::InstData *data) {
+    auto bytes = reinterpret_cast<const uint8_t *>(&bits);
+    *data = {};
+    if (!aarch64::TryExtract(bytes, *data) ||
+        IsNonDeterministic(data->iclass)) {
+      return false;
+    }
+
+    std::string inst_bytes(reinterpret_cast<const char *>(bytes), 4);
+    remill::Instruction inst;
+    return arch->DecodeInstruction(0, inst_bytes, inst) &&
+           remill::Instruction::kCategoryNormal == inst.category &&
+           HasSafeOperands(inst) &&
+           remill::FindGlobaVariable(semantics, "ISEL_" + inst.function);
+  }
+
+  const remill::Arch * const arch;
+  llvm::Module * const semantics;
+  std::mt19937_64 gen;
+};
+
+}  // namespace
+
+extern "C" int main(int argc, char *argv[]) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  CHECK(!FLAGS_fuzz_out.empty())
+      << "Must specify an output file with --fuzz_out.";
+
+  auto os = remill::GetOSName(REMILL_OS);
+  auto arch_name = remill::GetArchName(FLAGS_arch);
+  auto arch = remill::Arch::Get(os, arch_name);
+  CHECK(arch->IsAArch64())
+      << "Can only generate random AArch64 test cases.";
+
+  auto context = new llvm::LLVMContext;
+  auto module = remill::LoadTargetSemantics(context);
+
+  auto seed = FLAGS_seed;
+  if (!seed) {
+    seed = static_cast<uint64_t>(
+        std::chrono::system_clock::now().time_since_epoch().count());
+  }
+
+  Generator generator(arch, module, seed);
+
+  std::vector<uint32_t> num_encodings;
+  std::set<aarch64::InstName> iclasses;
+  std::set<uint32_t> seen;
+
+  std::ofstream os_out(FLAGS_fuzz_out);
+  CHECK(os_out.good())
+      << "Could not open " << FLAGS_fuzz_out << " for writing.";
+
+  os_out << "/* Auto-generated file! Don't modify! */\n"
+         << "/* Seed: " << seed << " */\n\n";
+
+  const auto begin = std::chrono::steady_clock::now();
+  uint64_t num_attempts = 0;
+  uint64_t num_tests = 0;
+  uint64_t num_iforms = 0;
+
+  for (; num_attempts < FLAGS_max_attempts; ++num_attempts) {
+    aarch64::InstData data;
+    const auto bits = generator.RandomCandidate();
+    if (!generator.Accept(bits, &data)) {
+      continue;
+    }
+
+    const auto iform_id = static_cast<size_t>(data.iform);
+    if (iform_id >= num_encodings.size()) {
+      num_encodings.resize(iform_id + 1, 0);
+    }
+    auto &count = num_encodings[iform_id];
+    if (count >= static_cast<uint32_t>(FLAGS_encodings_per_iform) ||
+        !seen.insert(bits).second) {
+      continue;
+    }
+
+    if (!count) {
+      ++num_iforms;
+    }
+    iclasses.insert(data.iclass);
+
+    const auto iform_name = aarch64::InstFormToString(data.iform);
+    os_out << "TEST_BEGIN(" << iform_name << ", fuzz_" << iform_name << "_"
+           << count << ", 3)\n"
+           << "TEST_INPUTS(\n";
+    for (auto i = 0; i < FLAGS_inputs_per_encoding; ++i) {
+      os_out << "    0x" << std::hex << generator.RandomInput()
+             << ", 0x" << generator.RandomInput()
+             << ", 0x" << generator.RandomInput() << std::dec
+             << ((i + 1) < FLAGS_inputs_per_encoding ? ",\n" : ")\n");
+    }
+    os_out << "    sub sp, sp, #" << kStackAdjust << "\n"
+           << "    .inst 0x" << std::hex << bits << std::dec << "\n"
+           << "    add sp, sp, #" << kStackAdjust << "\n"
+           << "TEST_END\n\n";
+
+    ++count;
+    ++num_tests;
+  }
+
+  const auto secs = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin).count();
+
+  LOG(INFO)
+      << "Generated " << num_tests << " tests covering " << num_iforms
+      << " instruction forms of " << iclasses.size()
+      << " instructions from " << num_attempts << " candidates in " << secs
+      << "s using seed " << seed;
+
+  return 0;
+}
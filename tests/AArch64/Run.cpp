@@ -16,15 +16,20 @@
 
 #define _XOPEN_SOURCE
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <dlfcn.h>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -32,6 +37,7 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <arm_neon.h>
 #include <setjmp.h>
 #include <signal.h>
 #include <ucontext.h>
@@ -44,6 +50,10 @@
 DECLARE_string(arch);
 DECLARE_string(os);
 
+DEFINE_int32(num_threads, 0,
+             "Number of threads on which to run test cases. Zero means one "
+             "thread per core.");
+
 namespace {
 
 struct alignas(128) Stack {
@@ -52,61 +62,84 @@ struct alignas(128) Stack {
   uint8_t _redzone2[128];
 };
 
-// Native test case code executes off of `gStack`. The state of the stack
-// after executing this code is saved in `gBackupStack`. Lifted test case
-// code executes off of the normal runtime stack, but emulates operations
-// that act on `gStack`.
+// Initial contents of every recording stack. This is filled in once, before
+// any test runs, and is only read afterwards.
 static Stack gRandomStack;
-static Stack gLiftedStack;
-static Stack gNativeStack;
-static Stack gSigStack;
 
-static const auto gStackBase = reinterpret_cast<uintptr_t>(
-    &(gLiftedStack.bytes[0]));
+// Native test case code executes off of `gLiftedStack`. The state of the stack
+// after executing this code is saved in `gNativeStack`. Lifted test case
+// code executes off of the normal runtime stack, but emulates operations
+// that act on `gLiftedStack`. Test cases run on many threads at once, so
+// each thread has its own stacks.
+static __thread Stack gLiftedStack;
+static __thread Stack gNativeStack;
+static __thread Stack gSigStack;
+
+// Bytes of `AArch64State` that are compared between the lifted and native
+// runs. Ignored bytes are zero.
+struct alignas(16) StateMask {
+  uint8_t bytes[sizeof(AArch64State)];
+};
 
-static const auto gStackLimit = reinterpret_cast<uintptr_t>(
-    &(gLiftedStack._redzone2[0]));
+static_assert(0 == (sizeof(AArch64State) % sizeof(uint8x16_t)),
+              "`AArch64State` must be a multiple of 16 bytes in size.");
+
+static StateMask gStateMask;
+
+// Total number of lifted vs. native comparisons, and how many of them found
+// a difference.
+static std::atomic<uint64_t> gNumChecks(0);
+static std::atomic<uint64_t> gNumDivergences(0);
 
 template <typename T>
 NEVER_INLINE static T &AccessMemory(addr_t addr) {
-  if (!(addr >= gStackBase && (addr + sizeof(T)) <= gStackLimit)) {
+  const auto stack_base = reinterpret_cast<uintptr_t>(
+      &(gLiftedStack.bytes[0]));
+  const auto stack_limit = reinterpret_cast<uintptr_t>(
+      &(gLiftedStack._redzone2[0]));
+  if (!(addr >= stack_base && (addr + sizeof(T)) <= stack_limit)) {
     EXPECT_TRUE(!"Memory access falls outside the valid range of the stack.");
   }
   return *reinterpret_cast<T *>(static_cast<uintptr_t>(addr));
 }
 
-// Used to handle exceptions in instructions.
-static sigjmp_buf gJmpBuf;
-static sigjmp_buf gUnsupportedInstrBuf;
+// Used to handle exceptions in instructions. Signals are delivered to the
+// thread that raised them, so these are per-thread.
+static __thread sigjmp_buf gJmpBuf;
+static __thread sigjmp_buf gUnsupportedInstrBuf;
 
 // Are we running in a native test case or a lifted one?
-static bool gInNativeTest = false;
+static __thread bool gInNativeTest = false;
 
 extern "C" {
 
+// The following variables are thread-local, and are accessed by the code in
+// `Tests.S` using local-exec TLS addressing.
 
 // Native state before we run the native test case. We then use this as the
 // initial state for the lifted testcase. The lifted test case code mutates
 // this, and we require that after running the lifted testcase, `gAArch64StateBefore`
 // matches `gAArch64StateAfter`,
-std::aligned_storage<sizeof(AArch64State), alignof(AArch64State)>::type gLiftedState;
+__thread std::aligned_storage<sizeof(AArch64State),
+                              alignof(AArch64State)>::type gLiftedState;
 
 // Native state after running the native test case.
-std::aligned_storage<sizeof(AArch64State), alignof(AArch64State)>::type gNativeState;
+__thread std::aligned_storage<sizeof(AArch64State),
+                              alignof(AArch64State)>::type gNativeState;
 
 // Address of the native test to run. The `InvokeTestCase` function saves
 // the native program state but then needs a way to figure out where to go
 // without storing that information in any register. So what we do is we
 // store it here and indirectly `JMP` into the native test case code after
 // saving the machine state to `gAArch64StateBefore`.
-uintptr_t gTestToRun = 0;
+__thread uintptr_t gTestToRun = 0;
 
 // Used for swapping the stack pointer between `gStack` and the normal
 // call stack. This lets us run both native and lifted testcase code on
 // the same stack.
-uint8_t *gStackSwitcher = nullptr;
+__thread uint8_t *gStackSwitcher = nullptr;
 
-uint64_t gStackSaveSlots[2] = {0, 0};
+__thread uint64_t gStackSaveSlots[2] = {0, 0};
 
 // Invoke a native test case addressed by `gTestToRun` and store the machine
 // state before and after executing the test in `gAArch64StateBefore` and
@@ -158,6 +191,53 @@ Memory *__remill_barrier_store_store(Memory *) { return nullptr; }
 Memory *__remill_atomic_begin(Memory *) { return nullptr; }
 Memory *__remill_atomic_end(Memory *) { return nullptr; }
 
+#define MAKE_ATOMIC_MEMORY(size) \
+  NEVER_INLINE Memory *__remill_compare_exchange_memory_ ## size( \
+      Memory *memory, addr_t addr, uint ## size ## _t &expected, \
+      uint ## size ## _t desired) { \
+    __atomic_compare_exchange_n( \
+        &AccessMemory<uint ## size ## _t>(addr), &expected, desired, false, \
+        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); \
+    return memory; \
+  } \
+  NEVER_INLINE Memory *__remill_exchange_memory_ ## size( \
+      Memory *memory, addr_t addr, uint ## size ## _t &value) { \
+    value = __atomic_exchange_n( \
+        &AccessMemory<uint ## size ## _t>(addr), value, __ATOMIC_SEQ_CST); \
+    return memory; \
+  } \
+  MAKE_ATOMIC_FETCH_OP(add, size) \
+  MAKE_ATOMIC_FETCH_OP(sub, size) \
+  MAKE_ATOMIC_FETCH_OP(and, size) \
+  MAKE_ATOMIC_FETCH_OP(or, size) \
+  MAKE_ATOMIC_FETCH_OP(xor, size)
+
+#define MAKE_ATOMIC_FETCH_OP(name, size) \
+  NEVER_INLINE Memory *__remill_fetch_and_ ## name ## _memory_ ## size( \
+      Memory *memory, addr_t addr, uint ## size ## _t &value) { \
+    value = __atomic_fetch_ ## name( \
+        &AccessMemory<uint ## size ## _t>(addr), value, __ATOMIC_SEQ_CST); \
+    return memory; \
+  }
+
+MAKE_ATOMIC_MEMORY(8)
+MAKE_ATOMIC_MEMORY(16)
+MAKE_ATOMIC_MEMORY(32)
+MAKE_ATOMIC_MEMORY(64)
+
+// The test memory is private to the thread running the test, so this doesn't
+// need to be a real 128-bit atomic.
+NEVER_INLINE Memory *__remill_compare_exchange_memory_128(
+    Memory *memory, addr_t addr, uint128_t &expected, uint128_t desired) {
+  auto &mem = AccessMemory<uint128_t>(addr);
+  auto prev = mem;
+  if (prev == expected) {
+    mem = desired;
+  }
+  expected = prev;
+  return memory;
+}
+
 void __remill_defer_inlining(void) {}
 
 Memory *__remill_error(AArch64State &, addr_t, Memory *) {
@@ -168,6 +248,10 @@ Memory *__remill_missing_block(AArch64State &, addr_t, Memory *memory) {
   return memory;
 }
 
+bool __remill_resume_after_call(AArch64State &, addr_t, Memory *) {
+  return true;
+}
+
 Memory *__remill_sync_hyper_call(AArch64State &, Memory *, SyncHyperCall::Name) {
   __builtin_unreachable();
 }
@@ -227,6 +311,46 @@ typedef Memory *(LiftedFunc)(AArch64State &, addr_t, Memory *);
 static std::map<uint64_t, LiftedFunc *> gTranslatedFuncs;
 
 static std::vector<const test::TestInfo *> gTests;
+
+// Marks `size` bytes at `offset` in `AArch64State` as not being compared.
+static void IgnoreStateBytes(size_t offset, size_t size) {
+  memset(&(gStateMask.bytes[offset]), 0, size);
+}
+
+#define IGNORE_STATE_FIELD(field) \
+    IgnoreStateBytes(offsetof(AArch64State, field), \
+                     sizeof(static_cast<AArch64State *>(nullptr)->field))
+
+// Initializes the mask of compared `AArch64State` bytes. `X28` holds the
+// `State *` in the native test cases, `X30` holds the return address, and
+// lifted code doesn't update the flag and FPU control registers.
+static void InitStateMask(void) {
+  memset(&gStateMask, 0xFF, sizeof(gStateMask));
+  IGNORE_STATE_FIELD(gpr.x28);
+  IGNORE_STATE_FIELD(gpr.x30);
+  IGNORE_STATE_FIELD(hyper_call);
+  IGNORE_STATE_FIELD(hyper_call_vector);
+  IGNORE_STATE_FIELD(nzcv);
+  IGNORE_STATE_FIELD(fpcr);
+  IGNORE_STATE_FIELD(fpsr);
+}
+
+#undef IGNORE_STATE_FIELD
+
+// Compares the masked bytes of two states, 16 bytes at a time.
+static bool StatesMatch(const void *a, const void *b) {
+  auto a_bytes = reinterpret_cast<const uint8_t *>(a);
+  auto b_bytes = reinterpret_cast<const uint8_t *>(b);
+  auto diff = vdupq_n_u8(0);
+  for (auto i = 0UL; i < sizeof(AArch64State); i += sizeof(uint8x16_t)) {
+    diff = vorrq_u8(
+        diff,
+        vandq_u8(veorq_u8(vld1q_u8(&(a_bytes[i])), vld1q_u8(&(b_bytes[i]))),
+                 vld1q_u8(&(gStateMask.bytes[i]))));
+  }
+  return !vmaxvq_u8(diff);
+}
+
 }  // namespace
 
 class InstrTest : public ::testing::TestWithParam<const test::TestInfo *> {};
@@ -285,8 +409,9 @@ static void RunWithFlags(const test::TestInfo *info,
 
   auto lifted_func = gTranslatedFuncs[info->test_begin];
 
-  // Includes the additional injected `adrp` and `add`.
-  lifted_state->gpr.pc.aword = static_cast<addr_t>(info->test_begin + 4 + 4);
+  // Includes the additional injected `mrs` and two `add`s.
+  lifted_state->gpr.pc.aword = static_cast<addr_t>(
+      info->test_begin + 4 + 4 + 4);
 
   // This will execute on our stack but the lifted code will operate on
   // `gLiftedStack`. The mechanism behind this is that `gLiftedState` is the
@@ -305,41 +430,42 @@ static void RunWithFlags(const test::TestInfo *info,
   // The native test doesn't update
   native_state->gpr.pc.qword = info->test_end;
 
-  // Used in the test cases to hold the `State *`.
-  lifted_state->gpr.x28.qword = 0;
-  native_state->gpr.x28.qword = 0;
+  ++gNumChecks;
+  auto diverged = false;
 
-  // Link pointer register (i.e. return address).
-  lifted_state->gpr.x30.qword = 0;
-  native_state->gpr.x30.qword = 0;
+  // Fast path: compare everything but the ignored bytes (see
+  // `InitStateMask`) in one go. Only if that fails do we zero the ignored
+  // parts and compare the states piece by piece, to say what is different.
+  if (!StatesMatch(&gLiftedState, &gNativeState)) {
+    diverged = true;
 
-  native_state->hyper_call_vector = 0;
-  lifted_state->hyper_call_vector = 0;
+    // Used in the test cases to hold the `State *`.
+    lifted_state->gpr.x28.qword = 0;
+    native_state->gpr.x28.qword = 0;
 
-  native_state->hyper_call = AsyncHyperCall::kInvalid;
-  lifted_state->hyper_call = AsyncHyperCall::kInvalid;
+    // Link pointer register (i.e. return address).
+    lifted_state->gpr.x30.qword = 0;
+    native_state->gpr.x30.qword = 0;
 
-  EXPECT_TRUE(lifted_state->sr.n == native_state->sr.n);
-  EXPECT_TRUE(lifted_state->sr.z == native_state->sr.z);
-  EXPECT_TRUE(lifted_state->sr.c == native_state->sr.c);
-  EXPECT_TRUE(lifted_state->sr.v == native_state->sr.v);
-  EXPECT_TRUE(lifted_state->gpr == native_state->gpr);
+    native_state->hyper_call_vector = 0;
+    lifted_state->hyper_call_vector = 0;
 
-  // The lifted code won't update these.
-  native_state->nzcv.flat = 0;
-  lifted_state->nzcv.flat = 0;
-  native_state->fpcr.flat = 0;
-  lifted_state->fpcr.flat = 0;
-  native_state->fpsr.flat = 0;
-  lifted_state->fpsr.flat = 0;
+    native_state->hyper_call = AsyncHyperCall::kInvalid;
+    lifted_state->hyper_call = AsyncHyperCall::kInvalid;
+
+    EXPECT_TRUE(lifted_state->sr.n == native_state->sr.n);
+    EXPECT_TRUE(lifted_state->sr.z == native_state->sr.z);
+    EXPECT_TRUE(lifted_state->sr.c == native_state->sr.c);
+    EXPECT_TRUE(lifted_state->sr.v == native_state->sr.v);
+    EXPECT_TRUE(lifted_state->gpr == native_state->gpr);
 
-  if (gLiftedState != gNativeState) {
     LOG(ERROR)
         << "States did not match for " << desc;
     EXPECT_TRUE(!"Lifted and native states did not match.");
   }
 
   if (gLiftedStack != gNativeStack) {
+    diverged = true;
     LOG(ERROR)
         << "Stacks did not match for " << desc;
 
@@ -356,13 +482,57 @@ static void RunWithFlags(const test::TestInfo *info,
 
     EXPECT_TRUE(!"Lifted and native stacks did not match.");
   }
+  if (diverged) {
+    ++gNumDivergences;
+  }
+}
+
+// Sets up the calling thread's alternate signal stack. The signal handlers
+// themselves are shared by all threads.
+static void SetupSignalStack(void) {
+  stack_t sig_stack;
+  sig_stack.ss_sp = &gSigStack;
+  sig_stack.ss_size = SIGSTKSZ;
+  sig_stack.ss_flags = 0;
+  sigaltstack(&sig_stack, nullptr);
+}
+
+// Runs `job(i)` for every `i` in `[0, num_jobs)`, spread across
+// `--num_threads` worker threads. Each worker has its own stacks, state
+// structures and jump buffers, so any two jobs can run at the same time.
+static void RunJobs(size_t num_jobs, const std::function<void(size_t)> &job) {
+  auto num_threads = static_cast<size_t>(std::max(0, FLAGS_num_threads));
+  if (!num_threads) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  num_threads = std::min(num_threads, num_jobs);
+
+  std::atomic<size_t> next_job(0);
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&] (void) {
+      SetupSignalStack();
+      for (auto i = next_job++; i < num_jobs; i = next_job++) {
+        job(i);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
 }
 
+// Number of combinations of the four NZCV flags that each set of test
+// arguments is run with.
+static constexpr uint32_t kNumFlagCombinations = 0x10U;
+
 TEST_P(InstrTest, SemanticsMatchNative) {
   auto info = GetParam();
   CHECK(0 < info->num_args)
       << "Test " << info->test_name << " must have at least one argument!";
 
+  std::vector<const uint64_t *> arg_sets;
+  std::vector<std::string> descs;
   for (auto args = info->args_begin;
        args < info->args_end;
        args += info->num_args) {
@@ -377,18 +547,25 @@ TEST_P(InstrTest, SemanticsMatchNative) {
         }
       }
     }
-    auto desc = ss.str();
-    for (uint32_t i = 0; i <= 0xFU; ++i) {
-      NZCV flags;
-      flags.flat = i << 28;
+    arg_sets.push_back(args);
+    descs.push_back(ss.str());
+  }
 
-      std::stringstream ss2;
-      ss2 << desc << " and N=" << flags.n << ", Z=" << flags.z << ", C="
-         << flags.c << ", V=" << flags.v;
+  // Go through all possible flag combinations of every set of arguments.
+  // Each pair of arguments and flags is an independent job.
+  RunJobs(arg_sets.size() * kNumFlagCombinations, [&] (size_t job) {
+    const auto args = arg_sets[job / kNumFlagCombinations];
+    const auto &desc = descs[job / kNumFlagCombinations];
 
-      RunWithFlags(info, flags, ss2.str(), args[0], args[1], args[2]);
-    }
-  }
+    NZCV flags;
+    flags.flat = static_cast<uint32_t>(job % kNumFlagCombinations) << 28;
+
+    std::stringstream ss2;
+    ss2 << desc << " and N=" << flags.n << ", Z=" << flags.z << ", C="
+       << flags.c << ", V=" << flags.v;
+
+    RunWithFlags(info, flags, ss2.str(), args[0], args[1], args[2]);
+  });
 }
 
 INSTANTIATE_TEST_CASE_P(
@@ -507,12 +684,6 @@ static void SetupSignals(void) {
   sigset_t set;
   sigemptyset(&set);
   sigprocmask(SIG_SETMASK, &set, nullptr);
-
-  stack_t sig_stack;
-  sig_stack.ss_sp = &gSigStack;
-  sig_stack.ss_size = SIGSTKSZ;
-  sig_stack.ss_flags = 0;
-  sigaltstack(&sig_stack, nullptr);
 }
 
 int main(int argc, char **argv) {
@@ -547,8 +718,20 @@ int main(int argc, char **argv) {
     b = static_cast<uint8_t>(random());
   }
 
+  InitStateMask();
   testing::InitGoogleTest(&argc, argv);
 
   SetupSignals();
-  return RUN_ALL_TESTS();
+
+  const auto begin = std::chrono::steady_clock::now();
+  const auto ret = RUN_ALL_TESTS();
+  const auto secs = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin).count();
+
+  std::cout
+      << "Ran " << gNumChecks << " lifted vs. native checks in " << secs
+      << "s (" << static_cast<uint64_t>(gNumChecks / std::max(secs, 1e-9))
+      << " checks/s); " << gNumDivergences << " diverged." << std::endl;
+
+  return ret;
 }
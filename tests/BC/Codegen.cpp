@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dlfcn.h>
+#include <stdlib.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include "remill/BC/Codegen.h"
+#include "remill/BC/Compat/IRReader.h"
+#include "remill/BC/Version.h"
+#include "remill/OS/FileSystem.h"
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+# include <llvm/Object/ObjectFile.h>
+#endif
+
+// Tests that compiling a module on one thread and on many threads produces
+// the same object files, and that the linked object files behave like the
+// module they came from.
+
+#ifndef REMILL_TEST_CXX
+# define REMILL_TEST_CXX "c++"
+#endif
+
+namespace {
+
+// Functions that call each other and share internal globals, so that some
+// references cross partitions.
+static const char kModule[] = R"(
+@table = internal constant [4 x i64] [i64 3, i64 5, i64 7, i64 11]
+@counter = internal global i64 0
+
+define internal i64 @square(i64 %x) noinline {
+  %sq = mul i64 %x, %x
+  ret i64 %sq
+}
+
+define i64 @sum_squares(i64 %n) noinline {
+entry:
+  br label %loop
+loop:
+  %i = phi i64 [ 0, %entry ], [ %next_i, %loop ]
+  %sum = phi i64 [ 0, %entry ], [ %next_sum, %loop ]
+  %sq = call i64 @square(i64 %i)
+  %next_sum = add i64 %sum, %sq
+  %next_i = add i64 %i, 1
+  %done = icmp uge i64 %next_i, %n
+  br i1 %done, label %exit, label %loop
+exit:
+  ret i64 %next_sum
+}
+
+define i64 @fib(i64 %n) noinline {
+entry:
+  %small = icmp ult i64 %n, 2
+  br i1 %small, label %base, label %recurse
+base:
+  ret i64 %n
+recurse:
+  %n1 = sub i64 %n, 1
+  %n2 = sub i64 %n, 2
+  %f1 = call i64 @fib(i64 %n1)
+  %f2 = call i64 @fib(i64 %n2)
+  %f = add i64 %f1, %f2
+  ret i64 %f
+}
+
+define i64 @lookup(i64 %i) noinline {
+  %idx = and i64 %i, 3
+  %ptr = getelementptr [4 x i64], [4 x i64]* @table, i64 0, i64 %idx
+  %val = load i64, i64* %ptr
+  %sq = call i64 @square(i64 %val)
+  ret i64 %sq
+}
+
+define i64 @count(i64 %by) noinline {
+  %old = load i64, i64* @counter
+  %new = add i64 %old, %by
+  store i64 %new, i64* @counter
+  ret i64 %new
+}
+)";
+
+enum : unsigned {
+  kNumPartitions = 4
+};
+
+typedef uint64_t (UnaryFunction)(uint64_t);
+
+static std::string ReadFile(const std::string &path) {
+  std::ifstream is(path, std::ios::binary);
+  std::stringstream ss;
+  ss << is.rdbuf();
+  return ss.str();
+}
+
+// Returns the names of the symbols that `object_file` defines and exports.
+static std::set<std::string> DefinedSymbols(const std::string &object_file) {
+  std::set<std::string> names;
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+  auto binary = llvm::object::ObjectFile::createObjectFile(object_file);
+  if (!binary) {
+    llvm::consumeError(binary.takeError());
+    ADD_FAILURE() << "Unable to read " << object_file;
+    return names;
+  }
+  for (const auto &sym : binary->getBinary()->symbols()) {
+# if LLVM_VERSION_NUMBER >= LLVM_VERSION(11, 0)
+    auto flags = llvm::cantFail(sym.getFlags());
+# else
+    auto flags = sym.getFlags();
+# endif
+    if (!(flags & llvm::object::SymbolRef::SF_Global) ||
+        (flags & llvm::object::SymbolRef::SF_Undefined)) {
+      continue;
+    }
+    if (auto name = sym.getName()) {
+      names.insert(name->str());
+    } else {
+      llvm::consumeError(name.takeError());
+    }
+  }
+#endif
+  return names;
+}
+
+class CodegenTest : public testing::Test {
+ protected:
+  void SetUp(void) override {
+    char dir_template[] = "/tmp/remill_codegen_XXXXXX";
+    ASSERT_TRUE(nullptr != mkdtemp(dir_template));
+    dir = dir_template;
+  }
+
+  void TearDown(void) override {
+    for (auto handle : handles) {
+      dlclose(handle);
+    }
+    for (const auto &path : paths) {
+      remill::RemoveFile(path);
+    }
+    rmdir(dir.c_str());
+  }
+
+  // Compile `kModule` for the host on `num_threads` threads, into object
+  // files whose names start with `name`.
+  std::vector<std::string> Compile(const std::string &name,
+                                   unsigned num_threads) {
+    llvm::LLVMContext context;
+    llvm::SMDiagnostic diag;
+    auto module = llvm::parseIR(
+        llvm::MemoryBufferRef(kModule, name), diag, context);
+    CHECK(module != nullptr) << diag.getMessage().str();
+    module->setTargetTriple(llvm::sys::getProcessTriple());
+
+    remill::ParallelCodegenOptions options;
+    options.num_partitions = kNumPartitions;
+    options.num_threads = num_threads;
+    options.opt_level = 2;
+
+    std::vector<std::string> object_files;
+    EXPECT_TRUE(remill::CompileModuleInParallel(
+        std::move(module), dir + "/" + name, options, &object_files));
+    paths.insert(paths.end(), object_files.begin(), object_files.end());
+    return object_files;
+  }
+
+  // Link `object_files` into a shared library, and load it.
+  void *Load(const std::string &name,
+             const std::vector<std::string> &object_files) {
+    auto library = dir + "/" + name + ".so";
+    std::stringstream cmd;
+    cmd << REMILL_TEST_CXX << " -shared -o " << library;
+    for (const auto &object_file : object_files) {
+      cmd << " " << object_file;
+    }
+    paths.push_back(library);
+    if (std::system(cmd.str().c_str())) {
+      ADD_FAILURE() << "Unable to link with: " << cmd.str();
+      return nullptr;
+    }
+    auto handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+    EXPECT_TRUE(nullptr != handle) << dlerror();
+    if (handle) {
+      handles.push_back(handle);
+    }
+    return handle;
+  }
+
+  std::string dir;
+  std::vector<std::string> paths;
+  std::vector<void *> handles;
+};
+
+}  // namespace
+
+TEST_F(CodegenTest, SameObjectFilesOnAnyNumberOfThreads) {
+  auto serial = Compile("serial", 1);
+  auto parallel = Compile("parallel", kNumPartitions);
+  ASSERT_EQ(kNumPartitions, serial.size());
+  ASSERT_EQ(kNumPartitions, parallel.size());
+
+  std::set<std::string> all_symbols;
+  for (unsigned i = 0; i < kNumPartitions; ++i) {
+    EXPECT_TRUE(ReadFile(serial[i]) == ReadFile(parallel[i]))
+        << serial[i] << " differs from " << parallel[i];
+
+    auto serial_symbols = DefinedSymbols(serial[i]);
+    EXPECT_TRUE(serial_symbols == DefinedSymbols(parallel[i]))
+        << serial[i] << " defines different symbols than " << parallel[i];
+
+    // Every symbol is defined by exactly one partition.
+    for (const auto &name : serial_symbols) {
+      EXPECT_TRUE(all_symbols.insert(name).second) << name;
+    }
+  }
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+  for (auto name : {"sum_squares", "fib", "lookup", "count"}) {
+    EXPECT_EQ(1, all_symbols.count(name)) << name;
+  }
+#endif
+}
+
+TEST_F(CodegenTest, SameBehaviorOnAnyNumberOfThreads) {
+  auto serial = Load("serial", Compile("serial", 1));
+  auto parallel = Load("parallel", Compile("parallel", kNumPartitions));
+  ASSERT_TRUE(serial && parallel);
+
+  for (auto handle : {serial, parallel}) {
+    auto sum_squares = reinterpret_cast<UnaryFunction *>(
+        dlsym(handle, "sum_squares"));
+    auto fib = reinterpret_cast<UnaryFunction *>(dlsym(handle, "fib"));
+    auto lookup = reinterpret_cast<UnaryFunction *>(dlsym(handle, "lookup"));
+    auto count = reinterpret_cast<UnaryFunction *>(dlsym(handle, "count"));
+    ASSERT_TRUE(sum_squares && fib && lookup && count);
+
+    EXPECT_EQ(285, sum_squares(10));
+    EXPECT_EQ(55, fib(10));
+    EXPECT_EQ(49, lookup(2));
+    EXPECT_EQ(121, lookup(7));
+    EXPECT_EQ(3, count(3));
+    EXPECT_EQ(7, count(4));
+  }
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+
+#include "remill/BC/Compat/IRReader.h"
+#include "remill/BC/Optimizer.h"
+#include "remill/BC/Profile.h"
+#include "remill/BC/Util.h"
+#include "remill/BC/Version.h"
+
+// Tests for `OptimizeLiftedModule`, over a hand-written module that looks
+// like lifted code: lifted functions that call a semantics function, the
+// `__remill_undefined_*` intrinsics, and some internal helpers.
+
+namespace {
+
+enum : unsigned {
+  kNumLiftedFunctions = 8,
+  kNumThreads = 4
+};
+
+static std::string ModuleText(void) {
+  std::stringstream ss;
+  ss << R"(
+%struct.State = type { i64, i64 }
+%struct.Memory = type opaque
+
+@ISEL_ADD =
+    constant %struct.Memory* (%struct.Memory*, %struct.State*, i64)* @ADD
+@counter = internal global i64 0
+
+declare i8 @__remill_undefined_8()
+
+define internal %struct.Memory* @ADD(%struct.Memory* %mem,
+                                     %struct.State* %state, i64 %imm) noinline {
+  %rax = getelementptr %struct.State, %struct.State* %state, i32 0, i32 0
+  %old = load i64, i64* %rax
+  %new = add i64 %old, %imm
+  store i64 %new, i64* %rax
+  ret %struct.Memory* %mem
+}
+
+define internal i64 @helper(i64 %x) noinline {
+  %y = mul i64 %x, 3
+  ret i64 %y
+}
+
+; Keeps the intrinsics alive, and isn't lifted code.
+define void @__remill_intrinsics() {
+  %u = call i8 @__remill_undefined_8()
+  ret void
+}
+)";
+
+  for (unsigned i = 0; i < kNumLiftedFunctions; ++i) {
+    ss << R"(
+define %struct.Memory* @sub_)" << i << R"((%struct.State* %state, i64 %pc,
+                                %struct.Memory* %mem) {
+  %rax = getelementptr %struct.State, %struct.State* %state, i32 0, i32 0
+  %rbx = getelementptr %struct.State, %struct.State* %state, i32 0, i32 1
+  %mem1 = call %struct.Memory* @ADD(%struct.Memory* %mem,
+                                    %struct.State* %state, i64 )" << i << R"()
+  %mem2 = call %struct.Memory* @ADD(%struct.Memory* %mem1,
+                                    %struct.State* %state, i64 1)
+  %u = call i8 @__remill_undefined_8()
+  %u64 = zext i8 %u to i64
+  store i64 %u64, i64* %rbx
+  %count = load i64, i64* @counter
+  %next_count = call i64 @helper(i64 %count)
+  store i64 %next_count, i64* @counter
+  ret %struct.Memory* %mem2
+}
+)";
+  }
+  return ss.str();
+}
+
+class OptimizerTest : public testing::Test {
+ protected:
+  // Parse and optimize a new copy of the module on `num_threads` threads.
+  std::unique_ptr<llvm::Module> Optimize(
+      unsigned num_threads, remill::OptimizationProfile *profile=nullptr) {
+    const auto text = ModuleText();
+    llvm::SMDiagnostic diag;
+    auto module = llvm::parseIR(
+        llvm::MemoryBufferRef(text, "lifted"), diag, context);
+    CHECK(module != nullptr) << diag.getMessage().str();
+
+    remill::OptimizationOptions options;
+    options.num_threads = num_threads;
+    options.profile = profile;
+    remill::OptimizeLiftedModule(module.get(), options);
+    return module;
+  }
+
+  llvm::LLVMContext context;
+};
+
+// Returns the instructions of `func`, one per line. Function headers aren't
+// included, because attribute group numbers depend on the order of functions
+// in the module, which linking partitions back in can change.
+static std::string Instructions(llvm::Function *func) {
+  std::stringstream ss;
+  for (auto &block : *func) {
+    for (auto &inst : block) {
+      ss << remill::LLVMThingToString(&inst) << "\n";
+    }
+  }
+  return ss.str();
+}
+
+// Returns the names of the functions in `module` that call `callee`.
+static std::set<std::string> CallerNames(llvm::Module *module,
+                                         const char *callee) {
+  std::set<std::string> names;
+  for (auto call : remill::CallersOf(module->getFunction(callee))) {
+    names.insert(call->getParent()->getParent()->getName().str());
+  }
+  return names;
+}
+
+}  // namespace
+
+TEST_F(OptimizerTest, SameCodeOnAnyNumberOfThreads) {
+  auto serial = Optimize(1);
+  auto parallel = Optimize(kNumThreads);
+
+  for (auto &func : *serial) {
+    auto parallel_func = parallel->getFunction(func.getName());
+    ASSERT_TRUE(parallel_func != nullptr) << func.getName().str();
+    EXPECT_EQ(Instructions(&func), Instructions(parallel_func))
+        << func.getName().str();
+  }
+  for (auto &var : serial->globals()) {
+    auto parallel_var = parallel->getNamedGlobal(var.getName());
+    ASSERT_TRUE(parallel_var != nullptr) << var.getName().str();
+    EXPECT_EQ(var.getLinkage(), parallel_var->getLinkage());
+  }
+  EXPECT_EQ(serial->size(), parallel->size());
+  EXPECT_EQ(serial->global_size(), parallel->global_size());
+
+  // The semantics were inlined everywhere.
+  EXPECT_TRUE(remill::CallersOf(serial->getFunction("ADD")).empty());
+  EXPECT_TRUE(remill::CallersOf(parallel->getFunction("ADD")).empty());
+}
+
+TEST_F(OptimizerTest, RemovesUndefinedIntrinsicsOnlyFromLiftedFunctions) {
+  for (auto num_threads : {1U, static_cast<unsigned>(kNumThreads)}) {
+    auto module = Optimize(num_threads);
+    EXPECT_EQ(std::set<std::string>({"__remill_intrinsics"}),
+              CallerNames(module.get(), "__remill_undefined_8"))
+        << "with " << num_threads << " threads";
+  }
+}
+
+TEST_F(OptimizerTest, RestoresInternalLinkage) {
+  for (auto num_threads : {1U, static_cast<unsigned>(kNumThreads)}) {
+    auto module = Optimize(num_threads);
+    for (auto name : {"ADD", "helper"}) {
+      auto func = module->getFunction(name);
+      ASSERT_TRUE(func != nullptr) << name;
+      EXPECT_TRUE(func->hasInternalLinkage()) << name;
+      EXPECT_EQ(llvm::GlobalValue::DefaultVisibility, func->getVisibility());
+    }
+    auto counter = module->getNamedGlobal("counter");
+    ASSERT_TRUE(counter != nullptr);
+    EXPECT_TRUE(counter->hasInternalLinkage());
+    EXPECT_TRUE(module->getFunction("sub_0")->hasExternalLinkage());
+    EXPECT_TRUE(nullptr == module->getNamedValue("__remill_unnamed"));
+  }
+}
+
+TEST_F(OptimizerTest, FillsOptimizationProfile) {
+  remill::OptimizationProfile serial_profile;
+  Optimize(1, &serial_profile);
+  for (auto name : {"always-inline", "remove-undefined-intrinsics", "sroa",
+                    "early-cse", "instcombine", "gvn", "dse", "adce"}) {
+    EXPECT_EQ(1, serial_profile.passes[name].num_runs) << name;
+  }
+  EXPECT_EQ(2, serial_profile.passes["simplifycfg"].num_runs);
+  EXPECT_EQ(0, serial_profile.passes.count("extract-partitions"));
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(3, 9)
+  // Every thread runs the whole function pipeline over its own partition.
+  remill::OptimizationProfile parallel_profile;
+  Optimize(kNumThreads, &parallel_profile);
+  EXPECT_EQ(1, parallel_profile.passes["extract-partitions"].num_runs);
+  EXPECT_EQ(1, parallel_profile.passes["link-partitions"].num_runs);
+  EXPECT_EQ(kNumThreads, parallel_profile.passes["gvn"].num_runs);
+  EXPECT_EQ(2 * kNumThreads, parallel_profile.passes["simplifycfg"].num_runs);
+#endif  // LLVM_VERSION_NUMBER >= LLVM_VERSION(3, 9)
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Transforms/Scalar.h>
+
+#include "remill/BC/Compat/IRReader.h"
+#include "remill/BC/RemillAA.h"
+#include "remill/BC/Version.h"
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+# include <llvm/Transforms/Scalar/GVN.h>
+#endif
+
+// Tests that `RemillAA` lets GVN and DSE see through the memory intrinsics,
+// i.e. that values in the `State` structure survive guest memory accesses.
+
+namespace {
+
+static const char kModule[] = R"(
+%struct.State = type { i64, i64 }
+%struct.Memory = type opaque
+
+declare i64 @__remill_read_memory_64(%struct.Memory*, i64)
+declare %struct.Memory* @__remill_write_memory_64(%struct.Memory*, i64, i64)
+
+; The second and third loads of `RAX` are redundant.
+define i64 @redundant_loads(%struct.State* %state, %struct.Memory* %mem) {
+  %rax = getelementptr %struct.State, %struct.State* %state, i32 0, i32 0
+  %a = load i64, i64* %rax
+  %mem1 = call %struct.Memory* @__remill_write_memory_64(
+      %struct.Memory* %mem, i64 16, i64 %a)
+  %b = load i64, i64* %rax
+  %c = call i64 @__remill_read_memory_64(%struct.Memory* %mem1, i64 16)
+  %d = load i64, i64* %rax
+  %sum1 = add i64 %b, %c
+  %sum2 = add i64 %sum1, %d
+  ret i64 %sum2
+}
+
+; The first store to `RAX` is dead.
+define %struct.Memory* @dead_store(%struct.State* %state,
+                                   %struct.Memory* %mem) {
+  %rax = getelementptr %struct.State, %struct.State* %state, i32 0, i32 0
+  store i64 1, i64* %rax
+  %mem1 = call %struct.Memory* @__remill_write_memory_64(
+      %struct.Memory* %mem, i64 16, i64 2)
+  %val = call i64 @__remill_read_memory_64(%struct.Memory* %mem1, i64 16)
+  store i64 %val, i64* %rax
+  ret %struct.Memory* %mem1
+}
+)";
+
+// Counts the instructions of type `T` in `func`.
+template <typename T>
+static unsigned NumInstructions(llvm::Function *func) {
+  unsigned num_insts = 0;
+  for (auto &block : *func) {
+    for (auto &inst : block) {
+      if (llvm::isa<T>(&inst)) {
+        ++num_insts;
+      }
+    }
+  }
+  return num_insts;
+}
+
+class RemillAATest : public testing::Test {
+ protected:
+  void SetUp(void) override {
+    llvm::SMDiagnostic diag;
+    module = llvm::parseIR(
+        llvm::MemoryBufferRef(kModule, "remill_aa"), diag, context);
+    ASSERT_TRUE(module != nullptr) << diag.getMessage().str();
+  }
+
+  // Run `pass` over every function, with or without `RemillAA`.
+  void Run(llvm::Pass *pass, bool use_remill_aa) {
+    llvm::legacy::FunctionPassManager fpm(module.get());
+    if (use_remill_aa) {
+      remill::AddRemillAliasAnalysis(fpm);
+    }
+    fpm.add(pass);
+    fpm.doInitialization();
+    for (auto &func : *module) {
+      fpm.run(func);
+    }
+    fpm.doFinalization();
+  }
+
+  llvm::LLVMContext context;
+  std::unique_ptr<llvm::Module> module;
+};
+
+}  // namespace
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+
+TEST_F(RemillAATest, GVNRemovesLoadsAcrossMemoryIntrinsics) {
+  auto func = module->getFunction("redundant_loads");
+  Run(llvm::createGVNPass(), false);
+  EXPECT_EQ(3, NumInstructions<llvm::LoadInst>(func));
+
+  Run(llvm::createGVNPass(), true);
+  EXPECT_EQ(1, NumInstructions<llvm::LoadInst>(func));
+  EXPECT_EQ(2, NumInstructions<llvm::CallInst>(func));
+}
+
+TEST_F(RemillAATest, DSERemovesStoresAcrossMemoryIntrinsics) {
+  auto func = module->getFunction("dead_store");
+  Run(llvm::createDeadStoreEliminationPass(), false);
+  EXPECT_EQ(2, NumInstructions<llvm::StoreInst>(func));
+
+  Run(llvm::createDeadStoreEliminationPass(), true);
+  EXPECT_EQ(1, NumInstructions<llvm::StoreInst>(func));
+  EXPECT_EQ(2, NumInstructions<llvm::CallInst>(func));
+}
+
+#endif  // LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "remill/OS/FileSystem.h"
+#include "remill/OS/Image.h"
+
+// Tests for `MappedImage`, using small ELF files that are built in memory and
+// written out to temporary files.
+
+namespace {
+
+// Appends little- or big-endian integers to a buffer.
+class Writer {
+ public:
+  explicit Writer(bool is_big_endian_)
+      : is_big_endian(is_big_endian_) {}
+
+  void Write(uint64_t val, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      auto shift = is_big_endian ? (size - i - 1) * 8 : i * 8;
+      bytes.push_back(static_cast<char>((val >> shift) & 0xFF));
+    }
+  }
+
+  void Pad(size_t size) {
+    bytes.resize(size, '\0');
+  }
+
+  std::string bytes;
+
+ private:
+  const bool is_big_endian;
+};
+
+struct Segment {
+  uint64_t vaddr;
+  uint64_t memsz;
+  uint32_t flags;
+  std::string data;
+};
+
+enum : uint32_t {
+  kPF_X = 1,
+  kPF_W = 2,
+  kPF_R = 4
+};
+
+// Build an ELF file with one program header per segment, followed by the
+// segments' data.
+static std::string BuildELF(bool is_64bit, bool is_big_endian,
+                            uint64_t entry,
+                            const std::vector<Segment> &segs) {
+  Writer w(is_big_endian);
+  const size_t addr_size = is_64bit ? 8 : 4;
+  const size_t ehdr_size = is_64bit ? 64 : 52;
+  const size_t phdr_size = is_64bit ? 56 : 32;
+
+  w.bytes = "\x7F" "ELF";
+  w.Write(is_64bit ? 2 : 1, 1);
+  w.Write(is_big_endian ? 2 : 1, 1);
+  w.Write(1, 1);  // Version.
+  w.Pad(16);
+  w.Write(2, 2);  // `ET_EXEC`.
+  w.Write(0, 2);
+  w.Write(1, 4);
+  w.Write(entry, addr_size);
+  w.Write(ehdr_size, addr_size);  // Program headers follow the file header.
+  w.Write(0, addr_size);
+  w.Write(0, 4);
+  w.Write(ehdr_size, 2);
+  w.Write(phdr_size, 2);
+  w.Write(segs.size(), 2);
+  w.Write(0, 2);
+  w.Write(0, 2);
+  w.Write(0, 2);
+  EXPECT_EQ(ehdr_size, w.bytes.size());
+
+  auto offset = ehdr_size + phdr_size * segs.size();
+  for (const auto &seg : segs) {
+    w.Write(1, 4);  // `PT_LOAD`.
+    if (is_64bit) {
+      w.Write(seg.flags, 4);
+      w.Write(offset, 8);
+      w.Write(seg.vaddr, 8);
+      w.Write(seg.vaddr, 8);
+      w.Write(seg.data.size(), 8);
+      w.Write(seg.memsz, 8);
+      w.Write(0x1000, 8);
+    } else {
+      w.Write(offset, 4);
+      w.Write(seg.vaddr, 4);
+      w.Write(seg.vaddr, 4);
+      w.Write(seg.data.size(), 4);
+      w.Write(seg.memsz, 4);
+      w.Write(seg.flags, 4);
+      w.Write(0x1000, 4);
+    }
+    offset += seg.data.size();
+  }
+
+  for (const auto &seg : segs) {
+    w.bytes += seg.data;
+  }
+  return w.bytes;
+}
+
+static std::string WriteTempFile(const std::string &name,
+                                 const std::string &contents) {
+  auto path = testing::TempDir() + name;
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  os.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+  return path;
+}
+
+}  // namespace
+
+TEST(MappedImage, LoadsELFSegments) {
+  const std::vector<Segment> segs = {
+    {0x402000, 0x10, kPF_R | kPF_W, "DATA"},  // Zero-filled after 4 bytes.
+    {0x400000, 0x8, kPF_R | kPF_X, "\x90\x90\xC3\xCC\xCC\xCC\xCC\xCC"},
+    {0x400008, 0x4, kPF_R | kPF_X, "\x55\x48\x89\xE5"},
+  };
+  auto path = WriteTempFile("elf64le", BuildELF(true, false, 0x400000, segs));
+  auto image = remill::MappedImage::Open(path);
+  ASSERT_TRUE(image != nullptr);
+  EXPECT_TRUE(image->IsELF());
+  EXPECT_EQ(0x400000, image->EntryPoint());
+
+  // Segments are sorted by address.
+  ASSERT_EQ(3, image->Segments().size());
+  EXPECT_EQ(0x400000, image->Segments()[0].address);
+  EXPECT_EQ(0x400008, image->Segments()[1].address);
+  EXPECT_EQ(0x402000, image->Segments()[2].address);
+
+  EXPECT_TRUE(image->IsExecutable(0x400000));
+  EXPECT_TRUE(image->IsExecutable(0x40000B));
+  EXPECT_FALSE(image->IsExecutable(0x40000C));
+  EXPECT_FALSE(image->IsExecutable(0x402000));
+  EXPECT_TRUE(image->IsMapped(0x40200F));
+  EXPECT_FALSE(image->IsMapped(0x402010));
+  EXPECT_FALSE(image->IsMapped(0x3FFFFF));
+
+  // Pointers point into the mapped file, and stop at the end of the file-
+  // backed part of a segment.
+  size_t num_bytes = 0;
+  auto bytes = image->ToPointer(0x400002, &num_bytes);
+  ASSERT_TRUE(bytes != nullptr);
+  EXPECT_EQ(6, num_bytes);
+  EXPECT_EQ(0xC3, bytes[0]);
+  EXPECT_EQ(&(image->Segments()[0].data[2]), bytes);
+  EXPECT_TRUE(image->ToPointer(0x402003, &num_bytes) != nullptr);
+  EXPECT_EQ(1, num_bytes);
+  EXPECT_TRUE(image->ToPointer(0x402004, &num_bytes) == nullptr);
+  EXPECT_EQ(0, num_bytes);
+
+  // Reads span adjacent segments, and see zeroes past the end of the file-
+  // backed part of a segment.
+  uint8_t buff[8] = {};
+  EXPECT_EQ(4, image->Read(0x400006, buff, 4));
+  EXPECT_EQ(0xCC, buff[1]);
+  EXPECT_EQ(0x55, buff[2]);
+  EXPECT_EQ(0x48, buff[3]);
+  EXPECT_EQ(2, image->Read(0x40000A, buff, 8));
+
+  std::fill(buff, buff + 8, 0xFF);
+  EXPECT_EQ(8, image->Read(0x402000, buff, 8));
+  EXPECT_EQ('D', buff[0]);
+  EXPECT_EQ('A', buff[3]);
+  EXPECT_EQ(0, buff[4]);
+  EXPECT_EQ(0, buff[7]);
+
+  // Adjacent executable segments are merged into one range.
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  image->ForEachExecutableRange([&] (uint64_t begin, uint64_t end) {
+    ranges.emplace_back(begin, end);
+    return true;
+  });
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(0x400000, ranges[0].first);
+  EXPECT_EQ(0x40000C, ranges[0].second);
+
+  remill::RemoveFile(path);
+}
+
+TEST(MappedImage, LoadsBigEndianELF32) {
+  const std::vector<Segment> segs = {
+    {0x80000000, 0x8, kPF_R | kPF_X,
+     std::string("\x3C\x1C\x00\x05\x27\x9C\x80\x10", 8)},
+    {0x80010000, 0x4, kPF_R | kPF_X, std::string("\x03\xE0\x00\x08", 4)},
+  };
+  auto path = WriteTempFile(
+      "elf32be", BuildELF(false, true, 0x80000004, segs));
+  auto image = remill::MappedImage::Open(path);
+  ASSERT_TRUE(image != nullptr);
+  EXPECT_EQ(0x80000004, image->EntryPoint());
+  EXPECT_TRUE(image->IsExecutable(0x80010003));
+
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  image->ForEachExecutableRange([&] (uint64_t begin, uint64_t end) {
+    ranges.emplace_back(begin, end);
+    return true;
+  });
+  ASSERT_EQ(2, ranges.size());
+  EXPECT_EQ(0x80000008, ranges[0].second);
+  EXPECT_EQ(0x80010000, ranges[1].first);
+
+  remill::RemoveFile(path);
+}
+
+TEST(MappedImage, LoadsRawBinaries) {
+  auto path = WriteTempFile("raw", std::string("\x90\x90\xC3", 3));
+  auto image = remill::MappedImage::Open(path, 0x8000);
+  ASSERT_TRUE(image != nullptr);
+  EXPECT_FALSE(image->IsELF());
+  EXPECT_EQ(0x8000, image->EntryPoint());
+  EXPECT_TRUE(image->IsExecutable(0x8002));
+  EXPECT_FALSE(image->IsMapped(0x8003));
+
+  size_t num_bytes = 0;
+  auto bytes = image->ToPointer(0x8001, &num_bytes);
+  ASSERT_TRUE(bytes != nullptr);
+  EXPECT_EQ(2, num_bytes);
+  EXPECT_EQ(0xC3, bytes[1]);
+
+  remill::RemoveFile(path);
+}
+
+TEST(MappedImage, RejectsMalformedELF) {
+  const std::vector<Segment> segs = {
+    {0x400000, 0x100, kPF_R | kPF_X, std::string(0x100, '\xCC')},
+  };
+  auto elf = BuildELF(true, false, 0x400000, segs);
+
+  auto truncated_path = WriteTempFile("truncated", elf.substr(0, 40));
+  EXPECT_TRUE(remill::MappedImage::Open(truncated_path) == nullptr);
+  remill::RemoveFile(truncated_path);
+
+  auto short_path = WriteTempFile("short", elf.substr(0, elf.size() - 1));
+  EXPECT_TRUE(remill::MappedImage::Open(short_path) == nullptr);
+  remill::RemoveFile(short_path);
+
+  EXPECT_TRUE(remill::MappedImage::Open("/does/not/exist") == nullptr);
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "remill/Runtime/AddressSpace.h"
+
+// Tests for copy-on-write forking, snapshotting and restoring of address
+// spaces.
+
+namespace {
+
+enum : uint64_t {
+  kPageSize = remill::AddressSpace::kPageSize,
+  kBase = 0x10000,
+  kNumPages = 4
+};
+
+static uint32_t Read32(remill::AddressSpace *memory, uint64_t addr) {
+  uint32_t val = 0;
+  EXPECT_TRUE(memory->TryRead(addr, &val, sizeof(val)));
+  return val;
+}
+
+static void Write32(remill::AddressSpace *memory, uint64_t addr,
+                    uint32_t val) {
+  EXPECT_TRUE(memory->TryWrite(addr, &val, sizeof(val)));
+}
+
+class AddressSpaceTest : public testing::Test {
+ protected:
+  void SetUp(void) override {
+    memory.reset(new remill::AddressSpace);
+    memory->AddMap(kBase, kNumPages * kPageSize);
+    for (uint64_t i = 0; i < kNumPages; ++i) {
+      Write32(memory.get(), kBase + i * kPageSize, static_cast<uint32_t>(i));
+    }
+  }
+
+  std::unique_ptr<remill::AddressSpace> memory;
+};
+
+}  // namespace
+
+TEST_F(AddressSpaceTest, AccessesStraddlePages) {
+  uint64_t val = 0x1122334455667788ULL;
+  auto addr = kBase + kPageSize - 4;
+  EXPECT_TRUE(memory->TryWrite(addr, &val, sizeof(val)));
+  uint64_t read_val = 0;
+  EXPECT_TRUE(memory->TryRead(addr, &read_val, sizeof(read_val)));
+  EXPECT_EQ(val, read_val);
+
+  auto end = kBase + kNumPages * kPageSize;
+  EXPECT_FALSE(memory->IsMapped(end));
+  EXPECT_FALSE(memory->TryRead(end - 4, &read_val, sizeof(read_val)));
+}
+
+TEST_F(AddressSpaceTest, ForksAreIsolated) {
+  std::unique_ptr<remill::AddressSpace> fork(memory->Fork());
+  EXPECT_EQ(kNumPages, fork->NumPages());
+  EXPECT_EQ(0, fork->NumPrivatePages());
+  EXPECT_EQ(0, memory->NumPrivatePages());
+
+  // Writes on either side break the sharing of only the written page.
+  Write32(fork.get(), kBase, 100);
+  Write32(memory.get(), kBase + kPageSize, 200);
+  EXPECT_EQ(100, Read32(fork.get(), kBase));
+  EXPECT_EQ(0, Read32(memory.get(), kBase));
+  EXPECT_EQ(1, Read32(fork.get(), kBase + kPageSize));
+  EXPECT_EQ(200, Read32(memory.get(), kBase + kPageSize));
+  EXPECT_EQ(2, fork->NumPrivatePages());
+  EXPECT_EQ(2, memory->NumPrivatePages());
+
+  // Maps and unmaps are private too.
+  fork->RemoveMap(kBase + 3 * kPageSize, kPageSize);
+  memory->AddMap(kBase + kNumPages * kPageSize, kPageSize);
+  EXPECT_FALSE(fork->IsMapped(kBase + 3 * kPageSize));
+  EXPECT_TRUE(memory->IsMapped(kBase + 3 * kPageSize));
+  EXPECT_FALSE(fork->IsMapped(kBase + kNumPages * kPageSize));
+
+  // The pages of a deleted fork become private to the survivor.
+  fork.reset();
+  EXPECT_EQ(kNumPages + 1, memory->NumPrivatePages());
+  EXPECT_EQ(3, Read32(memory.get(), kBase + 3 * kPageSize));
+}
+
+TEST_F(AddressSpaceTest, RestoresSnapshots) {
+  std::unique_ptr<remill::AddressSpace> snapshot(memory->Fork());
+
+  for (int run = 0; run < 3; ++run) {
+    Write32(memory.get(), kBase, 100);
+    Write32(memory.get(), kBase + 2 * kPageSize, 300);
+    memory->RemoveMap(kBase + 3 * kPageSize, kPageSize);
+    memory->AddMap(kBase + kNumPages * kPageSize, kPageSize);
+
+    memory->Restore(*snapshot);
+    EXPECT_EQ(kNumPages, memory->NumPages());
+    EXPECT_EQ(0, memory->NumPrivatePages());
+    EXPECT_FALSE(memory->IsMapped(kBase + kNumPages * kPageSize));
+    for (uint64_t i = 0; i < kNumPages; ++i) {
+      EXPECT_EQ(i, Read32(memory.get(), kBase + i * kPageSize));
+    }
+  }
+
+  // Restoring never changes the snapshot.
+  EXPECT_EQ(kNumPages, snapshot->NumPages());
+  EXPECT_EQ(0, Read32(snapshot.get(), kBase));
+}
+
+TEST_F(AddressSpaceTest, RestoresChangedSnapshots) {
+  std::unique_ptr<remill::AddressSpace> snapshot(memory->Fork());
+  Write32(memory.get(), kBase, 100);
+
+  // The snapshot differs from `memory` in more than `memory`'s writes, so
+  // all pages must be restored.
+  Write32(snapshot.get(), kBase + kPageSize, 200);
+  snapshot->AddMap(kBase + kNumPages * kPageSize, kPageSize);
+  memory->Restore(*snapshot);
+  EXPECT_EQ(0, Read32(memory.get(), kBase));
+  EXPECT_EQ(200, Read32(memory.get(), kBase + kPageSize));
+  EXPECT_TRUE(memory->IsMapped(kBase + kNumPages * kPageSize));
+
+  // Restoring from a snapshot other than the last one also restores all
+  // pages.
+  std::unique_ptr<remill::AddressSpace> other(memory->Fork());
+  Write32(other.get(), kBase + 2 * kPageSize, 300);
+  std::unique_ptr<remill::AddressSpace> other_snapshot(other->Fork());
+  Write32(memory.get(), kBase, 400);
+  memory->Restore(*other_snapshot);
+  EXPECT_EQ(0, Read32(memory.get(), kBase));
+  EXPECT_EQ(300, Read32(memory.get(), kBase + 2 * kPageSize));
+  EXPECT_EQ(2, Read32(snapshot.get(), kBase + 2 * kPageSize));
+}
+
+TEST_F(AddressSpaceTest, RestoresExecutionContexts) {
+  uint64_t state = 1;
+  remill::ExecutionContext context(&state, sizeof(state), memory.release());
+  std::unique_ptr<remill::ExecutionContext> snapshot(context.Fork());
+
+  *reinterpret_cast<uint64_t *>(context.State()) = 2;
+  Write32(context.Memory(), kBase, 100);
+  context.Restore(*snapshot);
+  EXPECT_EQ(1, *reinterpret_cast<uint64_t *>(context.State()));
+  EXPECT_EQ(0, Read32(context.Memory(), kBase));
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "remill/Arch/Runtime/Runtime.h"
+#include "remill/Arch/X86/Runtime/State.h"
+#include "remill/Runtime/DenseState.h"
+
+// Round trips between the default and dense `State` layouts.
+
+namespace {
+
+enum : uint8_t {
+  kPaddingByte = 0xCC
+};
+
+// Fill `bytes` with a pattern that has no `kPaddingByte`s in it.
+static void FillPattern(std::vector<uint8_t> &bytes) {
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    bytes[i] = static_cast<uint8_t>(i % 199);
+  }
+}
+
+// Round trip every byte of a default-layout `State` through the dense layout.
+// Every byte must either come back the same, or be padding that is left
+// alone. The dense `State`, on the other hand, must come back exactly.
+static void CheckRoundTrip(remill::ArchName arch_name) {
+  auto converter = remill::StateLayoutConverter::Get(arch_name);
+  ASSERT_TRUE(converter != nullptr);
+
+  std::vector<uint8_t> state(converter->StateSize());
+  std::vector<uint8_t> dense_state(converter->DenseStateSize());
+  std::vector<uint8_t> round_trip(state.size(), kPaddingByte);
+  std::vector<uint8_t> dense_round_trip(dense_state.size());
+  FillPattern(state);
+
+  converter->ToDense(state.data(), dense_state.data());
+  converter->FromDense(dense_state.data(), round_trip.data());
+  converter->ToDense(round_trip.data(), dense_round_trip.data());
+  EXPECT_TRUE(dense_state == dense_round_trip);
+
+  size_t num_copied = 0;
+  for (size_t i = 0; i < state.size(); ++i) {
+    if (kPaddingByte != round_trip[i]) {
+      EXPECT_EQ(state[i], round_trip[i]) << "at offset " << i;
+      ++num_copied;
+    }
+  }
+
+  // The dense layout can only drop padding.
+  EXPECT_GE(dense_state.size(), num_copied);
+  EXPECT_LT(state.size() / 2, num_copied);
+}
+
+}  // namespace
+
+TEST(DenseState, RoundTripsX86State) {
+  CheckRoundTrip(remill::kArchAMD64_AVX512);
+}
+
+TEST(DenseState, RoundTripsAArch64State) {
+  CheckRoundTrip(remill::kArchAArch64LittleEndian);
+}
+
+TEST(DenseState, MovesX86Registers) {
+  auto converter = remill::StateLayoutConverter::Get(remill::kArchAMD64);
+  ASSERT_TRUE(converter != nullptr);
+  ASSERT_EQ(sizeof(State), converter->StateSize());
+
+  State state = {};
+  state.gpr.rax.qword = 0x1122334455667788ULL;
+  state.gpr.rip.qword = 0x401000;
+  state.aflag.zf = 1;
+  state.vec[31].xmm.qwords.elems[1] = 0xAABBCCDDULL;
+  state.mmx.elems[7].val.qwords.elems[0] = 7;
+  state.k_reg.elems[7].val = 0xFFFF;
+  state.fpu_control.flat = 0x37f;
+
+  std::vector<uint8_t> dense_state(converter->DenseStateSize());
+  converter->ToDense(&state, dense_state.data());
+
+  // The GPRs come right after the `ArchState` in the dense layout.
+  uint64_t rax = 0;
+  memcpy(&rax, &(dense_state[sizeof(ArchState)]), sizeof(rax));
+  EXPECT_EQ(state.gpr.rax.qword, rax);
+
+  State round_trip = {};
+  converter->FromDense(dense_state.data(), &round_trip);
+  EXPECT_EQ(state.gpr.rax.qword, round_trip.gpr.rax.qword);
+  EXPECT_EQ(state.gpr.rip.qword, round_trip.gpr.rip.qword);
+  EXPECT_EQ(state.aflag.zf, round_trip.aflag.zf);
+  EXPECT_EQ(state.vec[31].xmm.qwords.elems[1],
+            round_trip.vec[31].xmm.qwords.elems[1]);
+  EXPECT_EQ(state.mmx.elems[7].val.qwords.elems[0],
+            round_trip.mmx.elems[7].val.qwords.elems[0]);
+  EXPECT_EQ(state.k_reg.elems[7].val, round_trip.k_reg.elems[7].val);
+  EXPECT_EQ(state.fpu_control.flat, round_trip.fpu_control.flat);
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
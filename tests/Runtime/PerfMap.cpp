@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "remill/OS/FileSystem.h"
+#include "remill/Runtime/PerfMap.h"
+
+// Tests for the perf map and jitdump writers. The "JIT-compiled code" is just
+// a buffer of bytes; the writers never execute it.
+
+namespace {
+
+static std::string ReadFile(const std::string &path) {
+  std::ifstream is(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(is),
+                     std::istreambuf_iterator<char>());
+}
+
+// Reads native-endian integers and strings out of a jitdump file.
+class Reader {
+ public:
+  explicit Reader(const std::string &bytes_)
+      : bytes(bytes_),
+        offset(0) {}
+
+  uint64_t Read(size_t size) {
+    uint64_t val = 0;
+    EXPECT_LE(offset + size, bytes.size());
+    if (offset + size <= bytes.size()) {
+      memcpy(&val, &(bytes[offset]), size);  // Assumes little-endian.
+    }
+    offset += size;
+    return val;
+  }
+
+  std::string ReadString(void) {
+    auto end = bytes.find('\0', offset);
+    EXPECT_NE(std::string::npos, end);
+    auto str = bytes.substr(offset, end - offset);
+    offset = end + 1;
+    return str;
+  }
+
+  const std::string bytes;
+  size_t offset;
+};
+
+static const uint8_t kCode[] = {0x55, 0x48, 0x89, 0xE5, 0x5D, 0xC3};
+
+}  // namespace
+
+TEST(PerfMap, NamesCodeAfterGuestPCs) {
+  std::vector<remill::GuestLocation> locs = {
+    {0x1000, 0x401004, "ADD_GPRv_IMMz_64"},
+    {0x1004, 0x401000, "PUSH_GPRv_50"},
+    {0x1008, 0x401017, "RET_NEAR"},
+  };
+  EXPECT_EQ("block_401000 [0x401000, 0x401017]",
+            remill::GuestCodeName("block_401000", locs));
+  EXPECT_EQ("block_401000", remill::GuestCodeName("block_401000", {}));
+}
+
+TEST(PerfMap, WritesPerfMap) {
+  auto path = testing::TempDir() + "perf-test.map";
+  auto map = remill::PerfMapWriter::Open(path);
+  ASSERT_TRUE(map != nullptr);
+  map->AddCode(reinterpret_cast<void *>(0x7f0000001000ULL), 0x20, "block_0");
+  map->AddCode(reinterpret_cast<void *>(0x7f0000001020ULL), 0x8,
+               "block_401000 [0x401000, 0x401017]");
+
+  // Lines are flushed as they're added.
+  EXPECT_EQ("7f0000001000 20 block_0\n"
+            "7f0000001020 8 block_401000 [0x401000, 0x401017]\n",
+            ReadFile(path));
+  map.reset();
+  remill::RemoveFile(path);
+}
+
+TEST(PerfMap, WritesJITDump) {
+  auto dir = testing::TempDir();
+  auto dump = remill::JITDumpWriter::Open(dir);
+  ASSERT_TRUE(dump != nullptr);
+
+  std::stringstream ss;
+  ss << "jit-" << getpid() << ".dump";
+  EXPECT_NE(std::string::npos, dump->path.find(ss.str()));
+
+  std::vector<remill::GuestLocation> locs = {
+    {reinterpret_cast<uintptr_t>(&(kCode[0])), 0x401000, "PUSH_GPRv_50"},
+    {reinterpret_cast<uintptr_t>(&(kCode[1])), 0x100401001, "MOV_GPRv_GPRv_89"},
+  };
+  dump->AddCode(kCode, sizeof(kCode), "block_401000", locs);
+  dump->AddCode(kCode, sizeof(kCode), "block_401000_again", {});
+
+  Reader r(ReadFile(dump->path));
+
+  // File header.
+  EXPECT_EQ(0x4A695444, r.Read(4));
+  EXPECT_EQ(1, r.Read(4));
+  EXPECT_EQ(40, r.Read(4));
+  r.Read(4);  // Machine.
+  r.Read(4);
+  EXPECT_EQ(getpid(), r.Read(4));
+  auto header_time = r.Read(8);
+  EXPECT_EQ(0, r.Read(8));
+
+  // The line table comes before the code that it describes.
+  auto record_begin = r.offset;
+  EXPECT_EQ(2, r.Read(4));
+  auto record_size = r.Read(4);
+  EXPECT_LE(header_time, r.Read(8));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(kCode), r.Read(8));
+  EXPECT_EQ(2, r.Read(8));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(&(kCode[0])), r.Read(8));
+  EXPECT_EQ(0x401000, r.Read(4));
+  EXPECT_EQ(0, r.Read(4));
+  EXPECT_EQ("PUSH_GPRv_50 (0x401000)", r.ReadString());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(&(kCode[1])), r.Read(8));
+  EXPECT_EQ(0x401001, r.Read(4));  // Truncated to 32 bits.
+  EXPECT_EQ(0, r.Read(4));
+  EXPECT_EQ("MOV_GPRv_GPRv_89 (0x100401001)", r.ReadString());
+  EXPECT_EQ(record_begin + record_size, r.offset);
+
+  // The code itself.
+  for (auto i = 0U; i < 2U; ++i) {
+    record_begin = r.offset;
+    EXPECT_EQ(0, r.Read(4));
+    record_size = r.Read(4);
+    r.Read(8);
+    EXPECT_EQ(getpid(), r.Read(4));
+    r.Read(4);  // Thread ID.
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(kCode), r.Read(8));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(kCode), r.Read(8));
+    EXPECT_EQ(sizeof(kCode), r.Read(8));
+    EXPECT_EQ(i, r.Read(8));
+    EXPECT_EQ(i ? "block_401000_again" : "block_401000", r.ReadString());
+    EXPECT_EQ(std::string(reinterpret_cast<const char *>(kCode),
+                          sizeof(kCode)),
+              r.bytes.substr(r.offset, sizeof(kCode)));
+    r.offset += sizeof(kCode);
+    EXPECT_EQ(record_begin + record_size, r.offset);
+  }
+  EXPECT_EQ(r.bytes.size(), r.offset);
+
+  auto path = dump->path;
+  dump.reset();
+  remill::RemoveFile(path);
+}
+
+TEST(PerfMap, FailsToOpenMissingDirectories) {
+  EXPECT_TRUE(remill::PerfMapWriter::Open("/does/not/exist.map") == nullptr);
+  EXPECT_TRUE(remill::JITDumpWriter::Open("/does/not/exist") == nullptr);
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
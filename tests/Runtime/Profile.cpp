@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include "remill/BC/Profile.h"
+#include "remill/Runtime/ExecutionCounters.h"
+
+// Tests for the lifting and optimization profiles, and for the execution
+// counters that are emitted into lifted code and written out at runtime.
+
+TEST(LiftingProfile, AccumulatesPerISel) {
+  remill::LiftingProfile profile;
+  profile.Record("ADD_GPRv_GPRv_32", 10, 100);
+  profile.Record("ADD_GPRv_GPRv_32", 12, 50);
+  profile.Record("MOV_GPRv_MEMv_32", 3, 20);
+
+  ASSERT_EQ(2, profile.isels.size());
+  const auto &add = profile.isels["ADD_GPRv_GPRv_32"];
+  EXPECT_EQ(2, add.num_lifted);
+  EXPECT_EQ(22, add.num_ir_insts);
+  EXPECT_EQ(150, add.lift_time_ns);
+
+  std::stringstream json;
+  profile.WriteJSON(json);
+  EXPECT_EQ(
+      "{\"isels\": ["
+      "{\"name\": \"ADD_GPRv_GPRv_32\", \"num_lifted\": 2, "
+      "\"num_ir_insts\": 22, \"lift_time_ns\": 150}, "
+      "{\"name\": \"MOV_GPRv_MEMv_32\", \"num_lifted\": 1, "
+      "\"num_ir_insts\": 3, \"lift_time_ns\": 20}]}\n", json.str());
+
+  std::stringstream csv;
+  profile.WriteCSV(csv);
+  EXPECT_EQ(
+      "name,num_lifted,num_ir_insts,lift_time_ns\n"
+      "ADD_GPRv_GPRv_32,2,22,150\n"
+      "MOV_GPRv_MEMv_32,1,3,20\n", csv.str());
+}
+
+TEST(OptimizationProfile, MergesPerPass) {
+  remill::OptimizationProfile profile;
+  profile.Record("Dead Store Elimination", 10);
+
+  remill::OptimizationProfile other;
+  other.Record("Dead Store Elimination", 5);
+  other.Record("Global Value \"Numbering\"", 7);
+  profile.Merge(other);
+
+  ASSERT_EQ(2, profile.passes.size());
+  EXPECT_EQ(2, profile.passes["Dead Store Elimination"].num_runs);
+  EXPECT_EQ(15, profile.passes["Dead Store Elimination"].time_ns);
+
+  // Pass names are escaped.
+  std::stringstream json;
+  profile.WriteJSON(json);
+  EXPECT_EQ(
+      "{\"passes\": ["
+      "{\"name\": \"Dead Store Elimination\", \"num_runs\": 2, "
+      "\"time_ns\": 15}, "
+      "{\"name\": \"Global Value \\\"Numbering\\\"\", \"num_runs\": 1, "
+      "\"time_ns\": 7}]}\n", json.str());
+
+  // Pass names are quoted, because they can contain commas and quotes.
+  profile.Record("Loop Invariant Code Motion, again", 3);
+  std::stringstream csv;
+  profile.WriteCSV(csv);
+  EXPECT_EQ(
+      "name,num_runs,time_ns\n"
+      "\"Dead Store Elimination\",2,15\n"
+      "\"Global Value \"\"Numbering\"\"\",1,7\n"
+      "\"Loop Invariant Code Motion, again\",1,3\n", csv.str());
+}
+
+TEST(ExecutionCounters, EmitsCounterTable) {
+  llvm::LLVMContext context;
+  llvm::Module module("counters", context);
+  auto func_type = llvm::FunctionType::get(
+      llvm::Type::getVoidTy(context), false);
+  auto func = llvm::Function::Create(
+      func_type, llvm::GlobalValue::ExternalLinkage, "lifted", &module);
+  auto block = llvm::BasicBlock::Create(context, "", func);
+
+  auto block_counter = remill::GetOrCreateExecutionCounter(
+      &module, "block_1000");
+  EXPECT_EQ(block_counter,
+            remill::GetOrCreateExecutionCounter(&module, "block_1000"));
+  EXPECT_EQ(std::string(remill::kExecutionCounterPrefix) + "block_1000",
+            block_counter->getName().str());
+
+  // The increment is appended to the block, and ends in the store.
+  remill::AddExecutionCounterIncrement(block, block_counter);
+  auto store = llvm::dyn_cast<llvm::StoreInst>(&(block->back()));
+  ASSERT_TRUE(store != nullptr);
+  EXPECT_EQ(block_counter, store->getPointerOperand());
+  llvm::ReturnInst::Create(context, block);
+
+  // Emitting the table twice replaces the first table.
+  remill::GetOrCreateExecutionCounter(&module, "isel_ADD_GPRv_GPRv_32");
+  remill::EmitExecutionCounterTable(&module);
+  remill::GetOrCreateExecutionCounter(&module, "edge_1000_1010");
+  remill::EmitExecutionCounterTable(&module);
+
+  auto table = module.getGlobalVariable("__remill_execution_counters");
+  ASSERT_TRUE(table != nullptr);
+  auto table_type = llvm::cast<llvm::ArrayType>(table->getValueType());
+  EXPECT_EQ(3, table_type->getNumElements());
+
+  auto size = module.getGlobalVariable("__remill_num_execution_counters");
+  ASSERT_TRUE(size != nullptr);
+  auto num_counters = llvm::cast<llvm::ConstantInt>(size->getInitializer());
+  EXPECT_EQ(3, num_counters->getZExtValue());
+}
+
+TEST(ExecutionCounters, WritesBlockProfiles) {
+  const uint64_t block_count = 10;
+  const uint64_t edge_count = 4;
+  const uint64_t isel_count = 7;
+  const remill::ExecutionCounter counters[] = {
+    {"block_1000", &block_count},
+    {"edge_1000_1010", &edge_count},
+    {"isel_ADD_GPRv_GPRv_32", &isel_count},
+  };
+
+  std::stringstream json;
+  remill::WriteExecutionCountersJSON(json, counters, 3);
+  EXPECT_EQ(
+      "{\"counters\": ["
+      "{\"name\": \"block_1000\", \"count\": 10}, "
+      "{\"name\": \"edge_1000_1010\", \"count\": 4}, "
+      "{\"name\": \"isel_ADD_GPRv_GPRv_32\", \"count\": 7}]}\n", json.str());
+
+  // The CSV output is what `BlockProfile` reads back in; it skips counters
+  // that aren't of blocks or edges.
+  std::stringstream csv;
+  remill::WriteExecutionCountersCSV(csv, counters, 3);
+  EXPECT_EQ(
+      "name,count\n"
+      "block_1000,10\n"
+      "edge_1000_1010,4\n"
+      "isel_ADD_GPRv_GPRv_32,7\n", csv.str());
+
+  remill::BlockProfile profile;
+  ASSERT_TRUE(profile.Parse(csv));
+  EXPECT_EQ(10, profile.BlockCount(0x1000));
+  EXPECT_EQ(4, profile.EdgeCount(0x1000, 0x1010));
+  EXPECT_TRUE(profile.HasEdgesFrom(0x1000));
+  EXPECT_FALSE(profile.HasEdgesFrom(0x1010));
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
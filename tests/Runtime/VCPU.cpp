@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "remill/Runtime/SharedAddressSpace.h"
+#include "remill/Runtime/TranslationCache.h"
+#include "remill/Runtime/VCPU.h"
+
+DEFINE_uint64(num_vcpus, 0,
+              "Number of vCPUs to run at once. Zero means two per core.");
+
+DEFINE_uint64(num_iterations, 20000,
+              "Number of lifted blocks that each vCPU executes.");
+
+struct State;
+
+// The intrinsics implemented by the vCPU runtime.
+extern "C" {
+uint64_t __remill_read_memory_64(Memory *, uint64_t);
+Memory *__remill_write_memory_64(Memory *, uint64_t, uint64_t);
+Memory *__remill_compare_exchange_memory_32(
+    Memory *, uint64_t, uint32_t &, uint32_t);
+Memory *__remill_exchange_memory_32(Memory *, uint64_t, uint32_t &);
+Memory *__remill_fetch_and_add_memory_64(Memory *, uint64_t, uint64_t &);
+Memory *__remill_fetch_and_add_memory_16(Memory *, uint64_t, uint16_t &);
+Memory *__remill_barrier_load_store(Memory *);
+Memory *__remill_barrier_store_store(Memory *);
+Memory *__remill_jump(State &, uint64_t, Memory *);
+Memory *__remill_async_hyper_call(State &, uint64_t, Memory *);
+}  // extern C
+
+namespace {
+
+enum : uint64_t {
+  kDataAddr = 0x10000,
+  kCounterAddr = kDataAddr,
+  kLockAddr = kDataAddr + 0x40,
+  kLockedPairAddr = kDataAddr + 0x80,
+
+  // Deliberately straddles a page boundary, so that the atomic lock is used.
+  kStraddlingCounterAddr = kDataAddr + 0x1000 - 1,
+
+  kSlotsAddr = kDataAddr + 0x2000,
+  kDataSize = 0x10000,
+
+  kUnmappedAddr = 0x1000,
+
+  kFirstBlockPC = 0x400000,
+  kNumBlocks = 257,
+  kBlockSize = 0x10,
+  kExitPC = 0xdead0000
+};
+
+// What the hand-written "lifted" blocks use as their `State` structure.
+struct TestState {
+  uint64_t iterations_left;
+  uint64_t slot_addr;  // Private to one vCPU.
+};
+
+static uint64_t NumVCPUs(void) {
+  if (FLAGS_num_vcpus) {
+    return FLAGS_num_vcpus;
+  }
+  return std::max(2U, std::thread::hardware_concurrency() * 2);
+}
+
+static Memory *Jump(void *state, uint64_t pc, Memory *memory) {
+  return __remill_jump(*reinterpret_cast<State *>(state), pc, memory);
+}
+
+// Each iteration does an atomic increment, an unaligned atomic increment, an
+// increment of a pair of words under a spin lock, and a plain increment of
+// this vCPU's private slot. Blocks form a ring, so that every vCPU reaches
+// every block's PC, and block lookups race with translations.
+static Memory *StressBlock(void *state_, uint64_t pc, Memory *memory) {
+  auto &state = *reinterpret_cast<TestState *>(state_);
+
+  uint64_t one = 1;
+  memory = __remill_fetch_and_add_memory_64(memory, kCounterAddr, one);
+
+  uint16_t one_16 = 1;
+  memory = __remill_fetch_and_add_memory_16(
+      memory, kStraddlingCounterAddr, one_16);
+
+  for (;;) {
+    uint32_t expected = 0;
+    memory = __remill_compare_exchange_memory_32(
+        memory, kLockAddr, expected, 1);
+    if (!expected) {
+      break;
+    }
+  }
+  memory = __remill_barrier_load_store(memory);
+  auto first = __remill_read_memory_64(memory, kLockedPairAddr);
+  auto second = __remill_read_memory_64(memory, kLockedPairAddr + 8);
+  memory = __remill_write_memory_64(memory, kLockedPairAddr, first + 1);
+  memory = __remill_write_memory_64(memory, kLockedPairAddr + 8, second + 1);
+  memory = __remill_barrier_store_store(memory);
+  uint32_t unlocked = 0;
+  memory = __remill_exchange_memory_32(memory, kLockAddr, unlocked);
+
+  auto slot = __remill_read_memory_64(memory, state.slot_addr);
+  memory = __remill_write_memory_64(memory, state.slot_addr, slot + 1);
+
+  if (!--state.iterations_left) {
+    return __remill_async_hyper_call(
+        *reinterpret_cast<State *>(state_), kExitPC, memory);
+  }
+
+  auto block_index = (pc - kFirstBlockPC) / kBlockSize;
+  auto next_pc = kFirstBlockPC + ((block_index + 1) % kNumBlocks) * kBlockSize;
+  return Jump(state_, next_pc, memory);
+}
+
+// Faults on its first access, and then tries to change mapped memory.
+static Memory *FaultingBlock(void *state, uint64_t, Memory *memory) {
+  memory = __remill_write_memory_64(memory, kUnmappedAddr, 1);
+  memory = __remill_write_memory_64(memory, kDataAddr, 1);
+  uint64_t one = 1;
+  memory = __remill_fetch_and_add_memory_64(memory, kDataAddr + 8, one);
+  uint32_t expected = 0;
+  memory = __remill_compare_exchange_memory_32(
+      memory, kDataAddr + 16, expected, 1);
+  if (__remill_read_memory_64(memory, kDataAddr + 24)) {
+    memory = __remill_write_memory_64(memory, kDataAddr + 32, 1);
+  }
+  return Jump(state, kExitPC, memory);
+}
+
+static uint64_t ReadData(remill::SharedAddressSpace &memory, uint64_t addr) {
+  uint64_t val = 0;
+  EXPECT_TRUE(memory.TryRead(addr, &val, sizeof(val)));
+  return val;
+}
+
+}  // namespace
+
+TEST(TranslationCache, ConcurrentFindAndInsert) {
+  remill::TranslationCache cache(16);  // Force many resizes.
+  const uint64_t num_pcs = 20000;
+  const auto num_threads = std::max(2U, std::thread::hardware_concurrency());
+  std::atomic<uint64_t> num_wrong(0);
+  std::vector<std::thread> threads;
+  for (auto i = 0U; i < num_threads; ++i) {
+    threads.emplace_back([&cache, &num_wrong, i, num_threads] (void) {
+      for (uint64_t pc = i; pc < num_pcs; pc += num_threads) {
+        cache.Insert(pc, Jump);
+      }
+      for (uint64_t pc = 0; pc < num_pcs; ++pc) {
+        auto func = cache.Find(pc);
+        if (func && func != Jump) {
+          num_wrong++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, num_wrong.load());
+  EXPECT_EQ(num_pcs, cache.Size());
+  for (uint64_t pc = 0; pc < num_pcs; ++pc) {
+    EXPECT_EQ(Jump, cache.Find(pc));
+  }
+  EXPECT_TRUE(nullptr == cache.Find(num_pcs));
+}
+
+TEST(VCPUGroup, AtomicsAndBarriersUnderContention) {
+  const auto num_vcpus = NumVCPUs();
+  const auto num_iterations = FLAGS_num_iterations;
+
+  remill::SharedAddressSpace memory;
+  memory.AddMap(kDataAddr, kDataSize);
+  remill::TranslationCache cache;
+
+  std::atomic<uint64_t> num_translations(0);
+  remill::VCPUGroup group(memory, cache,
+                          [&] (uint64_t pc) -> remill::LiftedFunction * {
+    num_translations++;
+    auto offset = pc - kFirstBlockPC;
+    if (pc < kFirstBlockPC || (offset % kBlockSize) ||
+        (offset / kBlockSize) >= kNumBlocks) {
+      return nullptr;
+    }
+    return &StressBlock;
+  });
+
+  for (uint64_t i = 0; i < num_vcpus; ++i) {
+    TestState state = {num_iterations, kSlotsAddr + (i * 8)};
+    auto start_pc = kFirstBlockPC + (i % kNumBlocks) * kBlockSize;
+    group.AddVCPU(&state, sizeof(state), start_pc);
+  }
+
+  group.Run();
+
+  const auto total = num_vcpus * num_iterations;
+  EXPECT_EQ(total, ReadData(memory, kCounterAddr));
+  EXPECT_EQ(total, ReadData(memory, kLockedPairAddr));
+  EXPECT_EQ(total, ReadData(memory, kLockedPairAddr + 8));
+
+  uint16_t straddling_counter = 0;
+  EXPECT_TRUE(memory.TryRead(kStraddlingCounterAddr, &straddling_counter,
+                             sizeof(straddling_counter)));
+  EXPECT_EQ(static_cast<uint16_t>(total), straddling_counter);
+
+  for (uint64_t i = 0; i < num_vcpus; ++i) {
+    const auto &vcpu = group.VCPUs()[i];
+    EXPECT_EQ(remill::VCPU::kStatusStopped, vcpu->GetStatus());
+    EXPECT_EQ(kExitPC, vcpu->PC());
+    EXPECT_EQ(num_iterations, vcpu->NumBlocksExecuted());
+    EXPECT_EQ(num_iterations, ReadData(memory, kSlotsAddr + (i * 8)));
+  }
+
+  // Every block is translated at most once, no matter how many vCPUs reach
+  // it at the same time.
+  EXPECT_LE(num_translations.load(), kNumBlocks);
+  EXPECT_EQ(num_translations.load(), cache.Size());
+}
+
+TEST(VCPUGroup, UnmappedMemoryStopsOnlyTheFaultingVCPU) {
+  remill::SharedAddressSpace memory;
+  memory.AddMap(kDataAddr, kDataSize);
+  remill::TranslationCache cache;
+  remill::VCPUGroup group(memory, cache,
+                          [] (uint64_t) -> remill::LiftedFunction * {
+    return &StressBlock;
+  });
+
+  TestState good_state = {1, kSlotsAddr};
+  TestState bad_state = {1, kUnmappedAddr};
+  auto good_vcpu = group.AddVCPU(&good_state, sizeof(good_state),
+                                 kFirstBlockPC);
+  auto bad_vcpu = group.AddVCPU(&bad_state, sizeof(bad_state), kFirstBlockPC);
+  group.Run();
+
+  EXPECT_EQ(remill::VCPU::kStatusStopped, good_vcpu->GetStatus());
+  EXPECT_FALSE(good_vcpu->HasFaulted());
+  EXPECT_EQ(remill::VCPU::kStatusError, bad_vcpu->GetStatus());
+  EXPECT_TRUE(bad_vcpu->HasFaulted());
+  EXPECT_EQ(kUnmappedAddr, bad_vcpu->FaultAddress());
+  EXPECT_EQ(kFirstBlockPC, bad_vcpu->FaultPC());
+}
+
+TEST(VCPUGroup, MemoryAccessesAfterAFaultAreIgnored) {
+  remill::SharedAddressSpace memory;
+  memory.AddMap(kDataAddr, kDataSize);
+  uint64_t val = 1;
+  EXPECT_TRUE(memory.TryWrite(kDataAddr + 24, &val, sizeof(val)));
+  remill::TranslationCache cache;
+  remill::VCPUGroup group(memory, cache,
+                          [] (uint64_t) -> remill::LiftedFunction * {
+    return &FaultingBlock;
+  });
+
+  TestState state = {1, kSlotsAddr};
+  auto vcpu = group.AddVCPU(&state, sizeof(state), kFirstBlockPC);
+  group.Run();
+
+  EXPECT_EQ(remill::VCPU::kStatusError, vcpu->GetStatus());
+  EXPECT_EQ(1, vcpu->NumBlocksExecuted());
+  EXPECT_EQ(kUnmappedAddr, vcpu->FaultAddress());
+  EXPECT_EQ(kFirstBlockPC, vcpu->FaultPC());
+  EXPECT_EQ(0, ReadData(memory, kDataAddr));
+  EXPECT_EQ(0, ReadData(memory, kDataAddr + 8));
+  EXPECT_EQ(0, ReadData(memory, kDataAddr + 16));
+  EXPECT_EQ(0, ReadData(memory, kDataAddr + 32));
+
+  // Resuming forgets the fault.
+  vcpu->Resume();
+  EXPECT_FALSE(vcpu->HasFaulted());
+  EXPECT_EQ(remill::VCPU::kStatusRunnable, vcpu->GetStatus());
+}
+
+TEST(VCPUGroup, UnmappingFlushesCachedTranslations) {
+  remill::SharedAddressSpace memory;
+  memory.AddMap(kDataAddr, kDataSize);
+  remill::TranslationCache cache;
+  remill::VCPUGroup group(memory, cache,
+                          [] (uint64_t) -> remill::LiftedFunction * {
+    return &StressBlock;
+  });
+
+  TestState state = {2, kSlotsAddr};
+  auto vcpu = group.AddVCPU(&state, sizeof(state), kFirstBlockPC);
+  EXPECT_TRUE(nullptr != vcpu->ToPointer(kSlotsAddr));
+  memory.RemoveMap(kSlotsAddr, remill::SharedAddressSpace::kPageSize);
+  EXPECT_TRUE(nullptr == vcpu->ToPointer(kSlotsAddr));
+  EXPECT_FALSE(memory.IsMapped(kSlotsAddr));
+  EXPECT_TRUE(memory.IsMapped(kCounterAddr));
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "remill/Arch/Runtime/Runtime.h"
+#include "remill/Arch/X86/Runtime/State.h"
+#include "remill/Runtime/X86/ContextSwitch.h"
+
+// Round trips through `__remill_x86_switch_to_native` and
+// `__remill_x86_native_exit`, via small native stubs that change one part of
+// the machine state and then exit.
+
+extern "C" {
+void ContextSwitchNopStub(void);
+void ContextSwitchGPRStub(void);
+void ContextSwitchMMXStub(void);
+void ContextSwitchX87Stub(void);
+void ContextSwitchX87LessStub(void);
+void ContextSwitchX87EqualStub(void);
+}  // extern C
+
+__asm__(
+    ".intel_syntax noprefix\n"
+    ".text\n"
+    "ContextSwitchNopStub:\n"
+    "    jmp __remill_x86_native_exit\n"
+    "ContextSwitchGPRStub:\n"
+    "    add RAX, RBX\n"
+    "    jmp __remill_x86_native_exit\n"
+    "ContextSwitchMMXStub:\n"
+    "    paddq MM0, MM1\n"
+    "    jmp __remill_x86_native_exit\n"
+    "ContextSwitchX87Stub:\n"
+    "    fld1\n"
+    "    fldpi\n"
+    "    jmp __remill_x86_native_exit\n"
+    "ContextSwitchX87LessStub:\n"
+    "    fld1\n"
+    "    fldz\n"
+    "    fcompp\n"
+    "    jmp __remill_x86_native_exit\n"
+    "ContextSwitchX87EqualStub:\n"
+    "    fldz\n"
+    "    fldz\n"
+    "    fcompp\n"
+    "    jmp __remill_x86_native_exit\n"
+    ".att_syntax prefix\n");
+
+namespace {
+
+struct alignas(16) Stack {
+  uint8_t bytes[4096];
+};
+
+class ContextSwitchTest : public testing::Test {
+ protected:
+  void SetUp(void) override {
+    state.reset(new State);
+    memset(state.get(), 0, sizeof(State));
+    stack.reset(new Stack);
+
+    auto gprs = &(state->gpr.rax);
+    for (uint64_t i = 0; i < 16; ++i) {
+      gprs[i * 2].qword = 0x1111111111111111ULL * (i + 1);
+    }
+    state->gpr.rsp.qword = reinterpret_cast<uintptr_t>(&(stack->bytes[2048]));
+    state->fpu_control.flat = 0x37f;
+    for (unsigned i = 0; i < kNumVecRegisters; ++i) {
+      state->vec[i].xmm.qwords.elems[0] = i + 1;
+      state->vec[i].xmm.qwords.elems[1] = ~static_cast<uint64_t>(i);
+    }
+    for (unsigned i = 0; i < 8; ++i) {
+      state->mmx.elems[i].val.qwords.elems[0] = 0x100 + i;
+      state->k_reg.elems[i].val = 0x1000 + i;
+    }
+  }
+
+  // Run the native code at `stub`, and return a copy of the `State` from
+  // before the switch.
+  State Run(void (*stub)(void)) {
+    state->gpr.rip.qword = reinterpret_cast<uintptr_t>(stub);
+    State before;
+    memcpy(&before, state.get(), sizeof(State));
+    __remill_x86_switch_to_native(state.get());
+    return before;
+  }
+
+  std::unique_ptr<State> state;
+  std::unique_ptr<Stack> stack;
+};
+
+}  // namespace
+
+TEST_F(ContextSwitchTest, RoundTripsRegisters) {
+  state->aflag.cf = 1;
+  state->aflag.zf = 1;
+  state->aflag.sf = 1;
+  state->aflag.df = 1;
+  auto before = Run(ContextSwitchNopStub);
+
+  EXPECT_EQ(0, memcmp(&(before.gpr), &(state->gpr), sizeof(GPR)));
+  EXPECT_EQ(1, state->aflag.cf);
+  EXPECT_EQ(0, state->aflag.pf);
+  EXPECT_EQ(0, state->aflag.af);
+  EXPECT_EQ(1, state->aflag.zf);
+  EXPECT_EQ(1, state->aflag.sf);
+  EXPECT_EQ(1, state->aflag.df);
+  EXPECT_EQ(0, state->aflag.of);
+  EXPECT_EQ(0x37f, state->fpu_control.flat);
+
+  for (unsigned i = 0; i < 16; ++i) {
+    EXPECT_EQ(0, memcmp(&(before.vec[i].xmm), &(state->vec[i].xmm),
+                        sizeof(vec128_t)));
+  }
+  for (unsigned i = 0; i < 8; ++i) {
+    EXPECT_EQ(before.mmx.elems[i].val.qwords.elems[0],
+              state->mmx.elems[i].val.qwords.elems[0]);
+  }
+
+  if (kRemillX86VectorISA_AVX512 == __remill_x86_vector_isa) {
+    auto mask = __remill_x86_has_avx512bw ? ~0ULL : 0xFFFFULL;
+    for (unsigned i = 0; i < 8; ++i) {
+      EXPECT_EQ(before.k_reg.elems[i].val & mask, state->k_reg.elems[i].val);
+    }
+  }
+}
+
+TEST_F(ContextSwitchTest, RoundTripsOtherFlags) {
+  state->aflag.pf = 1;
+  state->aflag.af = 1;
+  state->aflag.of = 1;
+  Run(ContextSwitchNopStub);
+
+  EXPECT_EQ(0, state->aflag.cf);
+  EXPECT_EQ(1, state->aflag.pf);
+  EXPECT_EQ(1, state->aflag.af);
+  EXPECT_EQ(0, state->aflag.zf);
+  EXPECT_EQ(0, state->aflag.sf);
+  EXPECT_EQ(0, state->aflag.df);
+  EXPECT_EQ(1, state->aflag.of);
+}
+
+TEST_F(ContextSwitchTest, StoresNativeGPRs) {
+  auto before = Run(ContextSwitchGPRStub);
+  EXPECT_EQ(before.gpr.rax.qword + before.gpr.rbx.qword,
+            state->gpr.rax.qword);
+  EXPECT_EQ(before.gpr.rbx.qword, state->gpr.rbx.qword);
+  EXPECT_EQ(before.gpr.r11.qword, state->gpr.r11.qword);
+  EXPECT_EQ(before.gpr.rsp.qword, state->gpr.rsp.qword);
+
+  // `State::gpr.rip` is left as it was on entry.
+  EXPECT_EQ(before.gpr.rip.qword, state->gpr.rip.qword);
+}
+
+TEST_F(ContextSwitchTest, StoresNativeMMX) {
+  auto before = Run(ContextSwitchMMXStub);
+  EXPECT_EQ(before.mmx.elems[0].val.qwords.elems[0] +
+                before.mmx.elems[1].val.qwords.elems[0],
+            state->mmx.elems[0].val.qwords.elems[0]);
+  EXPECT_EQ(before.mmx.elems[1].val.qwords.elems[0],
+            state->mmx.elems[1].val.qwords.elems[0]);
+}
+
+TEST_F(ContextSwitchTest, StoresNativeX87Stack) {
+  Run(ContextSwitchX87Stub);
+  EXPECT_EQ(M_PI, state->st.elems[0].val);
+  EXPECT_EQ(1.0, state->st.elems[1].val);
+  for (unsigned i = 2; i < 8; ++i) {
+    EXPECT_TRUE(std::isnan(state->st.elems[i].val));
+  }
+
+  // The x87 stack is empty again once back in the host, so this doesn't
+  // overflow it.
+  for (int i = 0; i < 8; ++i) {
+    Run(ContextSwitchX87Stub);
+  }
+  volatile long double one = 1.0L;
+  EXPECT_EQ(2.0L, one + one);
+}
+
+TEST_F(ContextSwitchTest, StoresNativeX87ConditionCodes) {
+  Run(ContextSwitchX87LessStub);
+  EXPECT_EQ(1, state->sw.c0);
+  EXPECT_EQ(0, state->sw.c1);
+  EXPECT_EQ(0, state->sw.c2);
+  EXPECT_EQ(0, state->sw.c3);
+
+  Run(ContextSwitchX87EqualStub);
+  EXPECT_EQ(0, state->sw.c0);
+  EXPECT_EQ(0, state->sw.c2);
+  EXPECT_EQ(1, state->sw.c3);
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
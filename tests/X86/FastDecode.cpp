@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "remill/Arch/Arch.h"
+#include "remill/Arch/Instruction.h"
+#include "remill/Arch/Name.h"
+#include "remill/Arch/X86/Decode.h"
+#include "remill/OS/OS.h"
+
+DECLARE_bool(x86_fast_decode);
+
+// Exhaustively compares the fast-path decoder against XED. Every encoding of
+// every handled opcode, with every REX prefix, ModRM and SIB byte, is decoded
+// twice, once with and once without the fast path, and the two decoded
+// instructions must be identical. The instruction boundary decoder is
+// compared against the full decoder on random bytes.
+
+namespace {
+
+static void DescribeRegister(std::stringstream &ss,
+                             const remill::Operand::Register &reg) {
+  ss << " " << reg.name << ":" << reg.size;
+}
+
+// Every field of an instruction that is set by the decoder.
+static std::string Describe(const remill::Instruction &inst) {
+  std::stringstream ss;
+  ss << inst.function << " isel=" << inst.isel_id
+     << " size=" << inst.bytes.size() << std::hex
+     << " next=" << inst.next_pc
+     << " taken=" << inst.branch_taken_pc
+     << " not_taken=" << inst.branch_not_taken_pc << std::dec
+     << " category=" << inst.category
+     << " operand_size=" << inst.operand_size;
+  for (const auto &op : inst.operands) {
+    ss << std::endl << "  type=" << op.type << " action=" << op.action
+       << " size=" << op.size;
+    switch (op.type) {
+      case remill::Operand::kTypeRegister:
+        DescribeRegister(ss, op.reg);
+        break;
+      case remill::Operand::kTypeImmediate:
+        ss << std::hex << " imm=" << op.imm.val << std::dec
+           << " signed=" << op.imm.is_signed;
+        break;
+      case remill::Operand::kTypeAddress:
+        ss << " kind=" << op.addr.kind;
+        DescribeRegister(ss, op.addr.segment_base_reg);
+        DescribeRegister(ss, op.addr.base_reg);
+        DescribeRegister(ss, op.addr.index_reg);
+        ss << " scale=" << op.addr.scale
+           << " disp=" << op.addr.displacement
+           << " address_size=" << op.addr.address_size;
+        break;
+      default:
+        break;
+    }
+  }
+  return ss.str();
+}
+
+static std::string Hex(const std::string &bytes) {
+  std::stringstream ss;
+  ss << std::hex;
+  for (auto b : bytes) {
+    ss << " " << static_cast<unsigned>(static_cast<uint8_t>(b));
+  }
+  return ss.str();
+}
+
+// Decode `bytes` with and without the fast path, and compare the results.
+// Returns `false` if the fast path doesn't handle `bytes`, or if the decoded
+// bytes were already compared.
+static bool CompareDecoders(const remill::Arch *arch, const std::string &bytes,
+                            std::unordered_set<std::string> &seen) {
+  remill::x86::FastInstruction finst;
+  if (!remill::x86::FastDecode(
+          reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size(),
+          arch->IsAMD64(), &finst)) {
+    return false;
+  }
+
+  if (!seen.insert(bytes.substr(0, finst.num_bytes)).second) {
+    return false;
+  }
+
+  const uint64_t pc = 0x1000;
+  remill::Instruction fast_inst;
+  remill::Instruction xed_inst;
+
+  FLAGS_x86_fast_decode = true;
+  EXPECT_TRUE(arch->DecodeInstruction(pc, bytes, fast_inst));
+  FLAGS_x86_fast_decode = false;
+  EXPECT_TRUE(arch->DecodeInstruction(pc, bytes, xed_inst));
+  FLAGS_x86_fast_decode = true;
+
+  EXPECT_EQ(Describe(xed_inst), Describe(fast_inst))
+      << "Decoders disagree on" << Hex(fast_inst.bytes) << ":" << std::endl
+      << xed_inst.Serialize() << std::endl << fast_inst.Serialize();
+  EXPECT_EQ(xed_inst.bytes, fast_inst.bytes);
+  return true;
+}
+
+static uint64_t CompareAllEncodings(remill::ArchName arch_name) {
+  auto arch = remill::Arch::Get(remill::kOSLinux, arch_name);
+  std::vector<std::string> prefixes = {""};
+  if (arch->IsAMD64()) {
+    for (auto rex = 0x40; rex <= 0x4F; ++rex) {
+      prefixes.push_back(std::string(1, static_cast<char>(rex)));
+    }
+  }
+
+  std::vector<std::string> opcodes;
+  for (auto opcode = 0; opcode <= 0xFF; ++opcode) {
+    opcodes.push_back(std::string(1, static_cast<char>(opcode)));
+  }
+  for (auto opcode = 0x80; opcode <= 0x8F; ++opcode) {
+    opcodes.push_back(std::string("\x0F") + static_cast<char>(opcode));
+  }
+
+  // Displacements and immediates alternate between negative and positive
+  // values, so that both sign- and zero-extension are checked.
+  const std::string fillers[] = {
+    "\x81\x92\xA3\xB4\xC5\xD6\xE7\xF8\x89\x9A\xAB\xBC\xCD\xDE",
+    "\x71\x62\x53\x44\x35\x26\x17\x08\x79\x6A\x5B\x4C\x3D\x2E"
+  };
+
+  std::unordered_set<std::string> seen;
+  uint64_t num_compared = 0;
+  uint64_t num_tried = 0;
+
+  for (const auto &prefix : prefixes) {
+    for (const auto &opcode : opcodes) {
+      for (auto modrm = 0; modrm <= 0xFF; ++modrm) {
+        auto has_sib = 4 == (modrm & 7) && 0xC0 != (modrm & 0xC0);
+        for (auto sib = 0; sib <= (has_sib ? 0xFF : 0); ++sib) {
+          auto bytes = prefix + opcode + static_cast<char>(modrm);
+          if (has_sib) {
+            bytes += static_cast<char>(sib);
+          }
+          bytes += fillers[num_tried++ % 2];
+          bytes.resize(15);
+          if (CompareDecoders(arch, bytes, seen)) {
+            ++num_compared;
+          }
+        }
+      }
+    }
+  }
+  return num_compared;
+}
+
+// Returns `true` if `bytes` starts with a far `CALL` or `JMP`, whose pointer
+// operand isn't supported by `DecodeInstruction`.
+static bool IsFarBranch(const std::string &bytes, bool is_64bit) {
+  static const xed_state_t kXEDState32 = {
+      XED_MACHINE_MODE_LEGACY_32,
+      XED_ADDRESS_WIDTH_32b};
+  static const xed_state_t kXEDState64 = {
+      XED_MACHINE_MODE_LONG_64,
+      XED_ADDRESS_WIDTH_64b};
+
+  xed_decoded_inst_t xedd;
+  xed_decoded_inst_zero_set_mode(&xedd, is_64bit ? &kXEDState64 : &kXEDState32);
+  if (XED_ERROR_NONE != xed_decode(
+          &xedd, reinterpret_cast<const uint8_t *>(bytes.data()),
+          static_cast<uint32_t>(bytes.size()))) {
+    return false;
+  }
+  auto xedi = xed_decoded_inst_inst(&xedd);
+  for (auto i = 0U; i < xed_inst_noperands(xedi); ++i) {
+    if (XED_OPERAND_PTR == xed_operand_name(xed_inst_operand(xedi, i))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Decode random bytes with both `DecodeInstruction` and
+// `DecodeInstructionBoundary`. Returns the number of valid instructions.
+static uint64_t CompareBoundaries(remill::ArchName arch_name) {
+  static const uint8_t kPrefixes[] = {
+    0x0F, 0x66, 0x67, 0xF2, 0xF3, 0x48, 0x41, 0x4C, 0xC4, 0xC5, 0x62
+  };
+
+  auto arch = remill::Arch::Get(remill::kOSLinux, arch_name);
+  std::mt19937 gen(arch_name);
+  std::uniform_int_distribution<unsigned> byte_dist(0, 0xFF);
+  std::uniform_int_distribution<size_t> prefix_dist(0, sizeof(kPrefixes));
+  uint64_t num_valid = 0;
+
+  for (auto i = 0; i < 200000; ++i) {
+    std::string bytes;
+
+    // Bias the bytes towards prefixes and opcode escapes, which are otherwise
+    // rare.
+    auto prefix = prefix_dist(gen);
+    if (prefix < sizeof(kPrefixes)) {
+      bytes.push_back(static_cast<char>(kPrefixes[prefix]));
+    }
+    while (bytes.size() < 15) {
+      bytes.push_back(static_cast<char>(byte_dist(gen)));
+    }
+
+    remill::Instruction inst;
+    remill::InstructionBoundary boundary;
+    const uint64_t pc = 0x10000;
+    if (IsFarBranch(bytes, arch->IsAMD64()) ||
+        !arch->DecodeInstruction(pc, bytes, inst)) {
+      continue;
+    }
+
+    ++num_valid;
+    EXPECT_TRUE(arch->DecodeInstructionBoundary(
+        pc, reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size(),
+        boundary))
+        << "Boundary not found for" << Hex(inst.bytes);
+    EXPECT_EQ(inst.NumBytes(), boundary.NumBytes())
+        << "Wrong length for" << Hex(inst.bytes);
+    EXPECT_EQ(inst.category, boundary.category)
+        << "Wrong category for" << Hex(inst.bytes);
+    EXPECT_EQ(inst.branch_taken_pc, boundary.branch_taken_pc)
+        << "Wrong branch target for" << Hex(inst.bytes);
+  }
+  return num_valid;
+}
+
+}  // namespace
+
+TEST(FastDecode, MatchesXEDOnAMD64) {
+  EXPECT_LT(1000000, CompareAllEncodings(remill::kArchAMD64));
+}
+
+TEST(FastDecode, MatchesXEDOnX86) {
+  EXPECT_LT(100000, CompareAllEncodings(remill::kArchX86));
+}
+
+TEST(InstructionBoundary, MatchesFullDecoder) {
+
+  // Most random bytes don't decode, and XED failures are logged.
+  FLAGS_minloglevel = google::GLOG_FATAL;
+  EXPECT_LT(10000, CompareBoundaries(remill::kArchAMD64));
+  EXPECT_LT(10000, CompareBoundaries(remill::kArchAMD64_AVX512));
+  EXPECT_LT(10000, CompareBoundaries(remill::kArchX86));
+  FLAGS_minloglevel = google::GLOG_INFO;
+}
+
+TEST(FastDecode, FallsBackToXED) {
+  remill::x86::FastInstruction inst;
+  const uint8_t op_size_prefix[] = {0x66, 0x89, 0xC0};  // `MOV AX, AX`.
+  const uint8_t lock_prefix[] = {0xF0, 0x01, 0x00};  // `LOCK ADD [RAX], EAX`.
+  const uint8_t xchg_r8[] = {0x41, 0x90};  // `XCHG R8D, EAX`.
+  const uint8_t lea_reg[] = {0x8D, 0xC0};  // Invalid.
+  const uint8_t truncated[] = {0x48, 0x8B, 0x44, 0x24};
+  EXPECT_FALSE(remill::x86::FastDecode(op_size_prefix, 3, true, &inst));
+  EXPECT_FALSE(remill::x86::FastDecode(lock_prefix, 3, true, &inst));
+  EXPECT_FALSE(remill::x86::FastDecode(xchg_r8, 2, true, &inst));
+  EXPECT_FALSE(remill::x86::FastDecode(lea_reg, 2, true, &inst));
+  EXPECT_FALSE(remill::x86::FastDecode(truncated, 4, true, &inst));
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include "remill/Arch/Arch.h"
+#include "remill/Arch/Instruction.h"
+#include "remill/Arch/Name.h"
+#include "remill/Arch/X86/XED.h"
+#include "remill/BC/Util.h"
+#include "remill/OS/OS.h"
+
+// Generates a corpus of random test cases in the format of `Tests.S`. Each
+// test case is one randomly chosen encoding of some iform, run against
+// random inputs. The corpus is then lifted and run just like the hand-written
+// tests, via `lift-*-fuzz-tests` and `run-*-fuzz-tests`.
+//
+// Candidate encodings are made of random bytes behind a randomly chosen
+// opcode escape, and are decoded with XED. The memory operand of each kept
+// encoding is then re-targeted by XED's encoder to a displacement below the
+// stack pointer, so that native and lifted executions access the same
+// (recording) stack memory.
+
+DEFINE_string(fuzz_out, "",
+              "Name of the file in which to place the generated tests.");
+
+DEFINE_uint64(seed, 0,
+              "Seed for the random number generator. Zero means to use the "
+              "current time.");
+
+DEFINE_int32(encodings_per_iform, 4,
+             "Maximum number of distinct encodings to generate per iform.");
+
+DEFINE_int32(inputs_per_encoding, 8,
+             "Number of random input tuples to run each encoding with.");
+
+DEFINE_uint64(max_attempts, 50000000,
+              "Maximum number of candidate encodings to try.");
+
+DECLARE_string(arch);
+DECLARE_string(os);
+
+namespace {
+
+// Memory operands are placed at `[RSP - kStackSlotSize * k]` for some `k` in
+// `[1, kNumStackSlots]`. The test runner starts each test with `RSP` aligned
+// to 128 bytes, so every operand is naturally aligned.
+static constexpr int64_t kStackSlotSize = 64;
+static constexpr int64_t kNumStackSlots = 16;
+
+// Opcode escapes that candidate encodings are built from. Random bytes follow
+// the escape, so this only biases the generator towards the maps where
+// most iforms live.
+static const std::vector<uint8_t> kEscapes[] = {
+  {},
+  {0x0F},
+  {0x0F, 0x38},
+  {0x0F, 0x3A},
+  {0xC5},
+  {0xC4},
+};
+
+static const uint8_t kLegacyPrefixes[] = {0x66, 0xF2, 0xF3, 0xF0};
+
+// Returns `true` if the instruction's behavior depends on something other
+// than its architectural inputs, or if it can't run in user mode.
+static bool IsNonDeterministic(const xed_decoded_inst_t *xedd) {
+  switch (xed_decoded_inst_get_category(xedd)) {
+    case XED_CATEGORY_SYSTEM:
+    case XED_CATEGORY_IO:
+    case XED_CATEGORY_IOSTRINGOP:
+    case XED_CATEGORY_INTERRUPT:
+    case XED_CATEGORY_SYSCALL:
+    case XED_CATEGORY_SYSRET:
+    case XED_CATEGORY_SEGOP:
+    case XED_CATEGORY_RDRAND:
+    case XED_CATEGORY_RDSEED:
+    case XED_CATEGORY_XSAVE:
+    case XED_CATEGORY_XSAVEOPT:
+      return true;
+    default:
+      break;
+  }
+  switch (xed_decoded_inst_get_iclass(xedd)) {
+    case XED_ICLASS_RDTSC:
+    case XED_ICLASS_RDTSCP:
+    case XED_ICLASS_RDPMC:
+      return true;
+    default:
+      return !!xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_RING0);
+  }
+}
+
+// Returns `true` if the instruction faults on some of its random inputs. The
+// test runner doesn't catch signals, so a fault would kill the whole run.
+// `DIV` and `IDIV` raise `#DE` when dividing by zero or when the quotient
+// overflows, which random inputs hit most of the time.
+static bool MayFault(const xed_decoded_inst_t *xedd) {
+  switch (xed_decoded_inst_get_iclass(xedd)) {
+    case XED_ICLASS_DIV:
+    case XED_ICLASS_IDIV:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns `true` if the instruction reads or writes an opmask register,
+// or is masked by one. The test runner neither initializes nor records the
+// opmask registers, so native and lifted runs would start out differently.
+// XED gives unmasked EVEX forms an operand for `k0`, so this excludes all
+// EVEX forms.
+static bool UsesOpmaskRegisters(const xed_decoded_inst_t *xedd) {
+  if (xed_decoded_inst_masking(xedd)) {
+    return true;
+  }
+  auto xedi = xed_decoded_inst_inst(xedd);
+  for (auto i = 0U; i < xed_inst_noperands(xedi); ++i) {
+    auto op_name = xed_operand_name(xed_inst_operand(xedi, i));
+    if (xed_operand_is_register(op_name) &&
+        XED_REG_CLASS_MASK == xed_reg_class(
+            xed_decoded_inst_get_reg(xedd, op_name))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns `true` if any register operand (implicit or explicit) is one that
+// the test harness owns, or that differs between native and lifted runs.
+static bool UsesHarnessRegisters(const xed_decoded_inst_t *xedd) {
+  auto xedi = xed_decoded_inst_inst(xedd);
+  for (auto i = 0U; i < xed_inst_noperands(xedi); ++i) {
+    auto xedo = xed_inst_operand(xedi, i);
+    auto op_name = xed_operand_name(xedo);
+    if (!xed_operand_is_register(op_name)) {
+      continue;
+    }
+    auto reg = xed_get_largest_enclosing_register(
+        xed_decoded_inst_get_reg(xedd, op_name));
+    switch (reg) {
+      case XED_REG_RIP:
+      case XED_REG_ES:
+      case XED_REG_CS:
+      case XED_REG_SS:
+      case XED_REG_DS:
+      case XED_REG_FS:
+      case XED_REG_GS:
+      case XED_REG_STACKPUSH:
+      case XED_REG_STACKPOP:
+        return true;
+      case XED_REG_RSP:
+        if (xed_operand_written(xedo)) {
+          return true;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return false;
+}
+
+// Re-encodes the memory operand of `xedd`, if any, so that it is
+// `[RSP + disp]`. Returns the new encoding, or an empty string if the
+// instruction can't be re-targeted.
+static std::string RetargetMemoryOperand(const xed_decoded_inst_t *xedd,
+                                         int64_t disp) {
+  auto num_mem_ops = xed_decoded_inst_number_of_memory_operands(xedd);
+  std::string bytes;
+  if (!num_mem_ops) {
+    auto len = xed_decoded_inst_get_length(xedd);
+    for (auto i = 0U; i < len; ++i) {
+      bytes.push_back(static_cast<char>(xed_decoded_inst_get_byte(xedd, i)));
+    }
+    return bytes;
+  }
+
+  if (1 != num_mem_ops ||
+      64 != xed_decoded_inst_get_memop_address_width(xedd, 0) ||
+      kStackSlotSize < xed_decoded_inst_get_memory_operand_length(xedd, 0)) {
+    return bytes;
+  }
+
+  auto seg = xed_decoded_inst_get_seg_reg(xedd, 0);
+  if (XED_REG_FS == seg || XED_REG_GS == seg) {
+    return bytes;
+  }
+
+  xed_encoder_request_t req = *xedd;
+  xed_encoder_request_init_from_decode(&req);
+  xed_encoder_request_set_base0(&req, XED_REG_RSP);
+  xed_encoder_request_set_index(&req, XED_REG_INVALID);
+  xed_encoder_request_set_scale(&req, 1);
+  xed_encoder_request_set_seg0(&req, XED_REG_INVALID);
+  xed_encoder_request_set_memory_displacement(
+      &req, disp, (-128 <= disp) ? 1 : 4);
+
+  uint8_t buff[XED_MAX_INSTRUCTION_BYTES] = {};
+  unsigned len = 0;
+  if (XED_ERROR_NONE != xed_encode(&req, buff, sizeof(buff), &len)) {
+    return bytes;
+  }
+  bytes.insert(bytes.end(), buff, buff + len);
+  return bytes;
+}
+
+// Decodes `bytes` with XED in 64-bit mode.
+static bool Decode64(const std::string &bytes, xed_decoded_inst_t *xedd) {
+  static const xed_state_t kXEDState64 = {
+      XED_MACHINE_MODE_LONG_64,
+      XED_ADDRESS_WIDTH_64b};
+  xed_decoded_inst_zero_set_mode(xedd, &kXEDState64);
+  xed_decoded_inst_set_input_chip(xedd, XED_CHIP_INVALID);
+  return XED_ERROR_NONE == xed_decode(
+      xedd, reinterpret_cast<const uint8_t *>(bytes.data()),
+      static_cast<uint32_t>(bytes.size()));
+}
+
+class Generator {
+ public:
+  Generator(const remill::Arch *arch_, llvm::Module *semantics_,
+            uint64_t seed)
+      : arch(arch_),
+        semantics(semantics_),
+        gen(seed) {}
+
+  // Returns a random candidate encoding.
+  std::string RandomCandidate(void) {
+    std::string bytes;
+    if (!(gen() % 4)) {
+      bytes.push_back(static_cast<char>(kLegacyPrefixes[gen() % 4]));
+    }
+    const auto &escape = kEscapes[gen() % (sizeof(kEscapes) /
+                                           sizeof(kEscapes[0]))];
+    if (escape.empty() || 0x0F == escape[0]) {
+      if (gen() % 2) {
+        bytes.push_back(static_cast<char>(0x40 | (gen() % 16)));
+      }
+    }
+    bytes.insert(bytes.end(), escape.begin(), escape.end());
+    while (bytes.size() < XED_MAX_INSTRUCTION_BYTES) {
+      bytes.push_back(static_cast<char>(gen()));
+    }
+    return bytes;
+  }
+
+  // Returns a random input value, biased towards edge cases.
+  uint64_t RandomInput(void) {
+    switch (gen() % 8) {
+      case 0: return 0;
+      case 1: return ~0ULL;
+      case 2: return 1ULL << (gen() % 64);
+      case 3: return (1ULL << (gen() % 64)) - 1;
+      case 4: return static_cast<uint8_t>(gen());
+      case 5: return static_cast<uint16_t>(gen());
+      case 6: return static_cast<uint32_t>(gen());
+      default: return gen();
+    }
+  }
+
+  // Tries to turn `candidate` into a test case. Returns the iform and the
+  // final encoding on success.
+  bool Accept(const std::string &candidate, xed_iform_enum_t *iform,
+              std::string *bytes, uint64_t *undefined_flags) {
+    xed_decoded_inst_t xedd;
+    if (!Decode64(candidate, &xedd) ||
+        IsNonDeterministic(&xedd) ||
+        MayFault(&xedd) ||
+        UsesHarnessRegisters(&xedd) ||
+        UsesOpmaskRegisters(&xedd)) {
+      return false;
+    }
+
+    auto disp = -kStackSlotSize * static_cast<int64_t>(
+        1 + (gen() % kNumStackSlots));
+    *bytes = RetargetMemoryOperand(&xedd, disp);
+    if (bytes->empty()) {
+      return false;
+    }
+
+    // Make sure that re-encoding didn't change the meaning of the
+    // instruction, and that it still only touches the stack.
+    xed_decoded_inst_t new_xedd;
+    *iform = xed_decoded_inst_get_iform_enum(&xedd);
+    if (!Decode64(*bytes, &new_xedd) ||
+        *iform != xed_decoded_inst_get_iform_enum(&new_xedd) ||
+        xed_decoded_inst_get_length(&new_xedd) != bytes->size()) {
+      return false;
+    }
+    if (xed_decoded_inst_number_of_memory_operands(&new_xedd) &&
+        (XED_REG_RSP != xed_decoded_inst_get_base_reg(&new_xedd, 0) ||
+         XED_REG_INVALID != xed_decoded_inst_get_index_reg(&new_xedd, 0))) {
+      return false;
+    }
+
+    remill::Instruction inst;
+    if (!arch->DecodeInstruction(0, *bytes, inst) ||
+        remill::Instruction::kCategoryNormal != inst.category ||
+        inst.NumBytes() != bytes->size() ||
+        !remill::FindGlobaVariable(semantics, "ISEL_" + inst.function)) {
+      return false;
+    }
+
+    *undefined_flags = 0;
+    if (auto rflags = xed_decoded_inst_get_rflags_info(&new_xedd)) {
+      *undefined_flags =
+          xed_simple_flag_get_undefined_flag_set(rflags)->flat;
+    }
+    return true;
+  }
+
+  const remill::Arch * const arch;
+  llvm::Module * const semantics;
+  std::mt19937_64 gen;
+};
+
+}  // namespace
+
+extern "C" int main(int argc, char *argv[]) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  CHECK(!FLAGS_fuzz_out.empty())
+      << "Must specify an output file with --fuzz_out.";
+
+  auto os = remill::GetOSName(REMILL_OS);
+  auto arch_name = remill::GetArchName(FLAGS_arch);
+  auto arch = remill::Arch::Get(os, arch_name);
+  CHECK(arch->IsAMD64())
+      << "Random test cases are run natively in 64-bit mode, and so can only "
+      << "be generated for 64-bit architectures.";
+
+  auto context = new llvm::LLVMContext;
+  auto module = remill::LoadTargetSemantics(context);
+
+  auto seed = FLAGS_seed;
+  if (!seed) {
+    seed = static_cast<uint64_t>(
+        std::chrono::system_clock::now().time_since_epoch().count());
+  }
+
+  Generator generator(arch, module, seed);
+
+  std::vector<uint32_t> num_encodings(XED_IFORM_LAST, 0);
+  std::ofstream os_out(FLAGS_fuzz_out);
+  CHECK(os_out.good())
+      << "Could not open " << FLAGS_fuzz_out << " for writing.";
+
+  os_out << "/* Auto-generated file! Don't modify! */\n"
+         << "/* Seed: " << seed << " */\n\n";
+
+  const auto begin = std::chrono::steady_clock::now();
+  uint64_t num_attempts = 0;
+  uint64_t num_tests = 0;
+  uint64_t num_iforms = 0;
+  std::set<std::string> seen;
+
+  for (; num_attempts < FLAGS_max_attempts; ++num_attempts) {
+    xed_iform_enum_t iform = XED_IFORM_INVALID;
+    std::string bytes;
+    uint64_t undefined_flags = 0;
+    if (!generator.Accept(generator.RandomCandidate(), &iform, &bytes,
+                          &undefined_flags)) {
+      continue;
+    }
+
+    auto &count = num_encodings[iform];
+    if (count >= static_cast<uint32_t>(FLAGS_encodings_per_iform) ||
+        !seen.insert(bytes).second) {
+      continue;
+    }
+
+    if (!count) {
+      ++num_iforms;
+    }
+
+    os_out << "TEST_BEGIN_64(fuzz_" << xed_iform_enum_t2str(iform) << "_"
+           << count << ", 3)\n";
+    if (undefined_flags) {
+      os_out << "TEST_IGNORE_FLAGS(| 0x" << std::hex << undefined_flags
+             << std::dec << ")\n";
+    }
+    os_out << "TEST_INPUTS(\n";
+    for (auto i = 0; i < FLAGS_inputs_per_encoding; ++i) {
+      os_out << "    0x" << std::hex << generator.RandomInput()
+             << ", 0x" << generator.RandomInput()
+             << ", 0x" << generator.RandomInput() << std::dec
+             << ((i + 1) < FLAGS_inputs_per_encoding ? ",\n" : ")\n");
+    }
+    os_out << "    .byte ";
+    for (auto i = 0U; i < bytes.size(); ++i) {
+      os_out << (i ? ", " : "") << "0x" << std::hex << std::setw(2)
+             << std::setfill('0')
+             << static_cast<unsigned>(static_cast<uint8_t>(bytes[i]))
+             << std::dec;
+    }
+    os_out << "\nTEST_END_64\n\n";
+
+    ++count;
+    ++num_tests;
+  }
+
+  const auto secs = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin).count();
+
+  LOG(INFO)
+      << "Generated " << num_tests << " tests covering " << num_iforms
+      << " iforms from " << num_attempts << " candidates in " << secs
+      << "s using seed " << seed;
+
+  return 0;
+}
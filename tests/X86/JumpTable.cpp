@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "remill/Arch/Arch.h"
+#include "remill/Arch/Instruction.h"
+#include "remill/Arch/JumpTable.h"
+#include "remill/Arch/Name.h"
+#include "remill/OS/FileSystem.h"
+#include "remill/OS/Image.h"
+#include "remill/OS/OS.h"
+
+// Tests for jump table recovery over small, hand-assembled amd64 and AArch64
+// `switch` statements.
+
+namespace {
+
+//    1000:  cmp edi, 3
+//    1003:  ja 1029
+//    1005:  mov edi, edi
+//    1007:  lea rdx, [rip + 0x1e]    ; Table at 102c.
+//    100e:  movsxd rax, dword ptr [rdx + rdi * 4]
+//    1012:  add rax, rdx
+//    1015:  jmp rax
+//    1017:  mov eax, 1              ; Case 0.
+//    101c:  ret
+//    101d:  mov eax, 2              ; Cases 1 and 3.
+//    1022:  ret
+//    1023:  mov eax, 3              ; Case 2.
+//    1028:  ret
+//    1029:  xor eax, eax            ; Default.
+//    102b:  ret
+//    102c:  .long -0x15, -0xf, -0x9, -0xf
+static const char kRelativeSwitch[] =
+    "\x83\xFF\x03"
+    "\x77\x24"
+    "\x89\xFF"
+    "\x48\x8D\x15\x1E\x00\x00\x00"
+    "\x48\x63\x04\xBA"
+    "\x48\x01\xD0"
+    "\xFF\xE0"
+    "\xB8\x01\x00\x00\x00"
+    "\xC3"
+    "\xB8\x02\x00\x00\x00"
+    "\xC3"
+    "\xB8\x03\x00\x00\x00"
+    "\xC3"
+    "\x31\xC0"
+    "\xC3"
+    "\xEB\xFF\xFF\xFF"
+    "\xF1\xFF\xFF\xFF"
+    "\xF7\xFF\xFF\xFF"
+    "\xF1\xFF\xFF\xFF";
+
+//    1000:  cmp edi, 2
+//    1003:  ja 100c
+//    1005:  jmp qword ptr [rdi * 8 + 0x1010]
+//    100c:  xor eax, eax
+//    100e:  ret
+//    100f:  nop
+//    1010:  .quad 0x100c, 0x100e, 0x100c
+static const char kAbsoluteSwitch[] =
+    "\x83\xFF\x02"
+    "\x77\x07"
+    "\xFF\x24\xFD\x10\x10\x00\x00"
+    "\x31\xC0"
+    "\xC3"
+    "\x90"
+    "\x0C\x10\x00\x00\x00\x00\x00\x00"
+    "\x0E\x10\x00\x00\x00\x00\x00\x00"
+    "\x0C\x10\x00\x00\x00\x00\x00\x00";
+
+//    1000:  cmp w0, #3
+//    1004:  b.hi 1038
+//    1008:  adrp x1, 1000
+//    100c:  add x1, x1, #0x40         ; Table at 1040.
+//    1010:  ldrb w1, [x1, w0, uxtw]
+//    1014:  adr x2, 1028
+//    1018:  add x1, x2, w1, sxtb #2
+//    101c:  br x1
+//    1020:  mov w0, #1                ; Case 0.
+//    1024:  ret
+//    1028:  mov w0, #2                ; Cases 1 and 3.
+//    102c:  ret
+//    1030:  mov w0, #3                ; Case 2.
+//    1034:  ret
+//    1038:  mov w0, wzr               ; Default.
+//    103c:  ret
+//    1040:  .byte -2, 0, 2, 0
+static const char kAArch64Switch[] =
+    "\x1F\x0C\x00\x71"
+    "\xA8\x01\x00\x54"
+    "\x01\x00\x00\x90"
+    "\x21\x00\x01\x91"
+    "\x21\x48\x60\x38"
+    "\xA2\x00\x00\x10"
+    "\x41\x88\x21\x8B"
+    "\x20\x00\x1F\xD6"
+    "\x20\x00\x80\x52"
+    "\xC0\x03\x5F\xD6"
+    "\x40\x00\x80\x52"
+    "\xC0\x03\x5F\xD6"
+    "\x60\x00\x80\x52"
+    "\xC0\x03\x5F\xD6"
+    "\xE0\x03\x1F\x2A"
+    "\xC0\x03\x5F\xD6"
+    "\xFE\x00\x02\x00";
+
+class JumpTableTest : public testing::Test {
+ protected:
+  void SetUp(void) override {
+    path = testing::TempDir() + "jump_table";
+    arch = remill::Arch::Get(remill::kOSLinux, remill::kArchAMD64);
+  }
+
+  void TearDown(void) override {
+    remill::RemoveFile(path);
+  }
+
+  template <size_t kSize>
+  void Load(const char (&code)[kSize]) {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    os.write(code, kSize - 1);
+    os.close();
+    image = remill::MappedImage::Open(path, 0x1000);
+    ASSERT_TRUE(image != nullptr);
+  }
+
+  // Decode the fall-through path from `begin` up to and including the first
+  // indirect jump.
+  std::vector<remill::Instruction> DecodePath(uint64_t begin) {
+    std::vector<remill::Instruction> insts;
+    for (auto pc = begin; ; ) {
+      remill::Instruction inst;
+      if (!arch->DecodeInstruction(pc, *image, inst)) {
+        ADD_FAILURE() << "Unable to decode instruction at " << pc;
+        break;
+      }
+      insts.push_back(inst);
+      if (inst.category == remill::Instruction::kCategoryIndirectJump) {
+        break;
+      }
+      pc = inst.next_pc;
+    }
+    return insts;
+  }
+
+  std::string path;
+  std::unique_ptr<remill::MappedImage> image;
+  const remill::Arch *arch;
+};
+
+}  // namespace
+
+TEST_F(JumpTableTest, RecoversRelativeTable) {
+  Load(kRelativeSwitch);
+  remill::JumpTable table;
+  ASSERT_TRUE(remill::RecoverJumpTable(arch, *image, DecodePath(0x1000),
+                                       &table));
+  EXPECT_EQ(0x1015, table.jump_pc);
+  EXPECT_EQ(0x102c, table.table_address);
+  EXPECT_TRUE(table.is_bounded);
+  EXPECT_EQ(4, table.num_entries);
+  EXPECT_EQ(std::vector<uint64_t>({0x1017, 0x101d, 0x1023}), table.targets);
+}
+
+TEST_F(JumpTableTest, ScansUnboundedTable) {
+  Load(kRelativeSwitch);
+
+  // Without the bounds check, the table is scanned until the end of the image.
+  remill::JumpTable table;
+  ASSERT_TRUE(remill::RecoverJumpTable(arch, *image, DecodePath(0x1005),
+                                       &table));
+  EXPECT_FALSE(table.is_bounded);
+  EXPECT_EQ(4, table.num_entries);
+  EXPECT_EQ(std::vector<uint64_t>({0x1017, 0x101d, 0x1023}), table.targets);
+
+  // Without the `lea`, the table address is unknown.
+  EXPECT_FALSE(remill::RecoverJumpTable(arch, *image, DecodePath(0x100e),
+                                        &table));
+}
+
+TEST_F(JumpTableTest, RecoversAbsoluteTable) {
+  Load(kAbsoluteSwitch);
+  remill::JumpTable table;
+  ASSERT_TRUE(remill::RecoverJumpTable(arch, *image, DecodePath(0x1000),
+                                       &table));
+  EXPECT_EQ(0x1005, table.jump_pc);
+  EXPECT_EQ(0x1010, table.table_address);
+  EXPECT_TRUE(table.is_bounded);
+  EXPECT_EQ(3, table.num_entries);
+  EXPECT_EQ(std::vector<uint64_t>({0x100c, 0x100e}), table.targets);
+}
+
+TEST_F(JumpTableTest, RecoversAArch64Table) {
+  arch = remill::Arch::Get(remill::kOSLinux,
+                           remill::kArchAArch64LittleEndian);
+  Load(kAArch64Switch);
+  remill::JumpTable table;
+  ASSERT_TRUE(remill::RecoverJumpTable(arch, *image, DecodePath(0x1000),
+                                       &table));
+  EXPECT_EQ(0x101c, table.jump_pc);
+  EXPECT_EQ(0x1040, table.table_address);
+  EXPECT_TRUE(table.is_bounded);
+  EXPECT_EQ(4, table.num_entries);
+
+  // The entries are signed, and scaled by the instruction size.
+  EXPECT_EQ(std::vector<uint64_t>({0x1020, 0x1028, 0x1030}), table.targets);
+
+  // Without the bounds check, the table is scanned until the end of the image.
+  ASSERT_TRUE(remill::RecoverJumpTable(arch, *image, DecodePath(0x1008),
+                                       &table));
+  EXPECT_FALSE(table.is_bounded);
+  EXPECT_EQ(4, table.num_entries);
+  EXPECT_EQ(std::vector<uint64_t>({0x1020, 0x1028, 0x1030}), table.targets);
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
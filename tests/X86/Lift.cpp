@@ -49,6 +49,9 @@
 DEFINE_string(bc_out, "",
               "Name of the file in which to place the generated bitcode.");
 
+DEFINE_bool(lazy_prologue, false,
+            "Only define the register variables that lifted code uses.");
+
 DECLARE_string(arch);
 DECLARE_string(os);
 
@@ -70,7 +73,11 @@ static void AddFunctionToModule(llvm::Module *module,
   auto word_type = llvm::Type::getIntNTy(module->getContext(),
                                          arch->address_size);
   auto func = remill::DeclareLiftedFunction(module, ss.str());
-  remill::CloneBlockFunctionInto(func);
+  if (FLAGS_lazy_prologue) {
+    remill::CloneBlockFunctionPrologueInto(func);
+  } else {
+    remill::CloneBlockFunctionInto(func);
+  }
 
   func->setLinkage(llvm::GlobalValue::ExternalLinkage);
   func->setVisibility(llvm::GlobalValue::DefaultVisibility);
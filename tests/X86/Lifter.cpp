@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <llvm/Transforms/Utils/Cloning.h>
+
+#include "remill/Arch/Arch.h"
+#include "remill/Arch/Instruction.h"
+#include "remill/Arch/Name.h"
+#include "remill/BC/Compat/DebugInfo.h"
+#include "remill/BC/Compat/Verifier.h"
+#include "remill/BC/IntrinsicTable.h"
+#include "remill/BC/ISelSummary.h"
+#include "remill/BC/Lifter.h"
+#include "remill/BC/Profile.h"
+#include "remill/BC/Util.h"
+#include "remill/BC/Version.h"
+#include "remill/OS/OS.h"
+
+// Tests for the options of the instruction lifter, over small hand-assembled
+// amd64 blocks.
+
+namespace {
+
+//    1000:  mov eax, [rbx + 8]
+//    1003:  mov ecx, [rbx + 8]
+//    1006:  add rbx, 1
+//    100a:  mov edx, [rbx + 8]
+static const char kReuse[] =
+    "\x8B\x43\x08"
+    "\x8B\x4B\x08"
+    "\x48\x83\xC3\x01"
+    "\x8B\x53\x08";
+
+//    1000:  mov eax, [rip + 0x10]
+//    1006:  mov ecx, [rip + 0x10]
+static const char kPCRelative[] =
+    "\x8B\x05\x10\x00\x00\x00"
+    "\x8B\x0D\x10\x00\x00\x00";
+
+//    1000:  add rsp, 8
+//    1004:  add dword ptr [rip + 0x10], 5
+static const char kSpecialize[] =
+    "\x48\x83\xC4\x08"
+    "\x83\x05\x10\x00\x00\x00\x05";
+
+class LifterTest : public testing::Test {
+ protected:
+  void SetUp(void) override {
+    arch = remill::Arch::Get(remill::kOSLinux, remill::kArchAMD64);
+    module.reset(remill::LoadModuleFromFile(
+        &context, remill::FindSemanticsBitcodeFile("amd64")));
+    intrinsics.reset(new remill::IntrinsicTable(module.get()));
+    word_type = llvm::Type::getIntNTy(context, arch->address_size);
+  }
+
+  // Lift the instructions in `code`, which starts at `pc`, into a new block
+  // function named `name`.
+  template <size_t kSize>
+  llvm::Function *Lift(const std::string &name, uint64_t pc,
+                       const char (&code)[kSize],
+                       const remill::LifterOptions &options) {
+    remill::InstructionLifter lifter(word_type, intrinsics.get(), options);
+    return Lift(lifter, name, pc, code);
+  }
+
+  template <size_t kSize>
+  llvm::Function *Lift(remill::InstructionLifter &lifter,
+                       const std::string &name, uint64_t pc,
+                       const char (&code)[kSize]) {
+    auto func = remill::DeclareLiftedFunction(module.get(), name);
+    remill::CloneBlockFunctionInto(func);
+
+    std::string bytes(code, kSize - 1);
+    auto block = &(func->front());
+    insts.clear();
+    for (size_t offset = 0; offset < bytes.size(); ) {
+      remill::Instruction inst;
+      CHECK(arch->DecodeInstruction(pc + offset, bytes.substr(offset), inst))
+          << "Unable to decode instruction at " << std::hex << pc + offset;
+      CHECK(lifter.LiftIntoBlock(inst, block))
+          << "Unable to lift instruction at " << std::hex << pc + offset;
+      offset += inst.NumBytes();
+      insts.push_back(inst);
+    }
+    remill::AddTerminatingTailCall(block, intrinsics->missing_block);
+    return func;
+  }
+
+  const remill::Arch *arch;
+  llvm::LLVMContext context;
+  std::unique_ptr<llvm::Module> module;
+  std::unique_ptr<remill::IntrinsicTable> intrinsics;
+  llvm::IntegerType *word_type;
+  std::vector<remill::Instruction> insts;
+};
+
+// Returns the calls in `func` to semantics functions, i.e. to functions that
+// are defined in the module, in program order.
+static std::vector<llvm::CallInst *> SemanticsCalls(llvm::Function *func) {
+  std::vector<llvm::CallInst *> calls;
+  for (auto &block : *func) {
+    for (auto &inst : block) {
+      if (auto call = llvm::dyn_cast<llvm::CallInst>(&inst)) {
+        auto callee = call->getCalledFunction();
+        if (callee && !callee->isDeclaration()) {
+          calls.push_back(call);
+        }
+      }
+    }
+  }
+  return calls;
+}
+
+// Returns the address operand of a `MOV_GPRv_MEMv` semantics call.
+static llvm::Value *LoadAddress(llvm::CallInst *call) {
+  return call->getArgOperand(call->getNumArgOperands() - 1);
+}
+
+// Returns the stores in `block` that increment `counter`.
+static std::vector<llvm::StoreInst *> CounterIncrements(
+    llvm::BasicBlock *block, llvm::GlobalVariable *counter) {
+  std::vector<llvm::StoreInst *> stores;
+  for (auto &inst : *block) {
+    if (auto store = llvm::dyn_cast<llvm::StoreInst>(&inst)) {
+      if (store->getPointerOperand() == counter) {
+        stores.push_back(store);
+      }
+    }
+  }
+  return stores;
+}
+
+// Returns the specialized semantics functions in `module`.
+static std::vector<llvm::Function *> SpecializedFunctions(
+    llvm::Module *module) {
+  std::vector<llvm::Function *> funcs;
+  for (auto &func : *module) {
+    if (std::string::npos != func.getName().find("_spec")) {
+      funcs.push_back(&func);
+    }
+  }
+  return funcs;
+}
+
+static bool SameRanges(const std::vector<remill::StateRange> &a,
+                       const std::vector<remill::StateRange> &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].begin != b[i].begin || a[i].end != b[i].end) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_F(LifterTest, ReusesAddressesUntilRegistersChange) {
+  remill::LifterOptions options;
+  options.reuse_addresses = true;
+  auto calls = SemanticsCalls(Lift("reuse", 0x1000, kReuse, options));
+  ASSERT_EQ(4, calls.size());
+  EXPECT_EQ(LoadAddress(calls[0]), LoadAddress(calls[1]));
+
+  // `add rbx, 1` writes `RBX`, so the address is recomputed.
+  EXPECT_NE(LoadAddress(calls[0]), LoadAddress(calls[3]));
+
+  // Without the option, every address is computed separately.
+  calls = SemanticsCalls(Lift("no_reuse", 0x1000, kReuse,
+                              remill::LifterOptions()));
+  ASSERT_EQ(4, calls.size());
+  EXPECT_NE(LoadAddress(calls[0]), LoadAddress(calls[1]));
+}
+
+TEST_F(LifterTest, FoldsPCRelativeAddresses) {
+  remill::LifterOptions options;
+  options.reuse_addresses = true;
+  auto calls = SemanticsCalls(Lift("pc_relative", 0x1000, kPCRelative,
+                                   options));
+  ASSERT_EQ(2, calls.size());
+  ASSERT_EQ(2, insts.size());
+
+  // Both instructions have the same displacement, but different `PC`s, so
+  // their addresses are different constants.
+  for (size_t i = 0; i < calls.size(); ++i) {
+    auto addr = llvm::dyn_cast<llvm::ConstantInt>(LoadAddress(calls[i]));
+    ASSERT_TRUE(addr != nullptr);
+    const auto &op = insts[i].operands.back();
+    EXPECT_EQ(insts[i].pc + static_cast<uint64_t>(op.addr.displacement),
+              addr->getZExtValue());
+  }
+  EXPECT_NE(LoadAddress(calls[0]), LoadAddress(calls[1]));
+}
+
+TEST_F(LifterTest, SharesSpecializedSemantics) {
+  remill::LifterOptions options;
+  options.specialize_semantics = true;
+  {
+    remill::InstructionLifter lifter(word_type, intrinsics.get(), options);
+    Lift(lifter, "spec_1000", 0x1000, kSpecialize);
+    Lift(lifter, "spec_2000", 0x2000, kSpecialize);
+    Lift(lifter, "spec_3000", 0x3000, kSpecialize);
+
+    // One body for every `add rsp, 8`, and one for every
+    // `add dword ptr [rip + 0x10], 5`, even though the latter's address
+    // depends on the `PC`.
+    EXPECT_EQ(2, SpecializedFunctions(module.get()).size());
+  }
+
+  // The bodies that were inlined everywhere are erased with the lifter.
+  for (auto func : SpecializedFunctions(module.get())) {
+    EXPECT_FALSE(func->use_empty()) << func->getName().str();
+  }
+}
+
+TEST_F(LifterTest, CountsEachBlockOnce) {
+  remill::LifterOptions options;
+  options.execution_counters = remill::LifterOptions::kCountBlockExecutions;
+  remill::InstructionLifter lifter(word_type, intrinsics.get(), options);
+  auto func = remill::DeclareLiftedFunction(module.get(), "counted");
+  remill::CloneBlockFunctionInto(func);
+  auto block = &(func->front());
+
+  std::string bytes(kReuse, sizeof(kReuse) - 1);
+  remill::Instruction inst;
+  ASSERT_TRUE(arch->DecodeInstruction(0x1000, bytes, inst));
+  ASSERT_TRUE(lifter.LiftIntoBlock(inst, block));
+  ASSERT_TRUE(lifter.LiftIntoBlock(inst, block));
+
+  auto counter = module->getGlobalVariable(
+      std::string(remill::kExecutionCounterPrefix) + "block_1000", true);
+  ASSERT_TRUE(counter != nullptr);
+  auto stores = CounterIncrements(block, counter);
+  ASSERT_EQ(1, stores.size());
+
+  // If the increment is removed, e.g. because the block was emptied and
+  // reused, then the block is counted again.
+  auto add = llvm::cast<llvm::Instruction>(stores[0]->getValueOperand());
+  auto load = llvm::cast<llvm::Instruction>(add->getOperand(0));
+  stores[0]->eraseFromParent();
+  add->eraseFromParent();
+  load->eraseFromParent();
+  ASSERT_TRUE(lifter.LiftIntoBlock(inst, block));
+  EXPECT_EQ(1, CounterIncrements(block, counter).size());
+}
+
+TEST_F(LifterTest, ISelSummariesMatchSemantics) {
+  remill::ISelSummaryMap summaries;
+  ASSERT_TRUE(remill::LoadISelSummaries("amd64", &summaries));
+
+  auto expected_summaries = remill::SummarizeISels(module.get());
+  EXPECT_EQ(expected_summaries.size(), summaries.size());
+  for (const auto &entry : expected_summaries) {
+    const auto &expected = entry.second;
+    auto summary_it = summaries.find(entry.first);
+    ASSERT_TRUE(summary_it != summaries.end())
+        << "No summary for " << entry.first;
+    const auto &summary = summary_it->second;
+    EXPECT_TRUE(SameRanges(expected.reads, summary.reads)) << entry.first;
+    EXPECT_TRUE(SameRanges(expected.writes, summary.writes)) << entry.first;
+    EXPECT_EQ(expected.reads_memory, summary.reads_memory) << entry.first;
+    EXPECT_EQ(expected.writes_memory, summary.writes_memory) << entry.first;
+    EXPECT_EQ(expected.may_hyper_call, summary.may_hyper_call)
+        << entry.first;
+    EXPECT_TRUE(expected.operands == summary.operands) << entry.first;
+  }
+}
+
+TEST_F(LifterTest, UsesISelSummaries) {
+  remill::LifterOptions options;
+  options.reuse_addresses = true;
+  Lift("summary", 0x1000, kReuse, options);
+
+  // Pretend that the first `mov` may make a hyper call, which could change
+  // any register.
+  remill::ISelSummaryMap summaries;
+  summaries["ISEL_" + insts[0].function].may_hyper_call = true;
+  options.isel_summaries = &summaries;
+  auto calls = SemanticsCalls(Lift("summary_hyper_call", 0x1000, kReuse,
+                                   options));
+  ASSERT_EQ(4, calls.size());
+  EXPECT_NE(LoadAddress(calls[0]), LoadAddress(calls[1]));
+}
+
+TEST_F(LifterTest, AnnotatesGuestPCs) {
+  remill::LifterOptions options;
+  options.annotate_pcs = true;
+  std::vector<remill::Instruction> low_insts;
+  llvm::Function *low = nullptr;
+  llvm::Function *high = nullptr;
+  {
+    remill::InstructionLifter lifter(word_type, intrinsics.get(), options);
+    low = Lift(lifter, "annotated", 0x1000, kReuse);
+    low_insts = insts;
+    high = Lift(lifter, "annotated_high", 0x100001000, kReuse);
+  }
+
+  auto low_calls = SemanticsCalls(low);
+  ASSERT_EQ(low_insts.size(), low_calls.size());
+  for (size_t i = 0; i < low_calls.size(); ++i) {
+    uint64_t pc = 0;
+    std::string isel_name;
+    ASSERT_TRUE(remill::GetGuestPC(low_calls[i], &pc, &isel_name));
+    EXPECT_EQ(low_insts[i].pc, pc);
+    EXPECT_EQ(low_insts[i].function, isel_name);
+  }
+
+  // The ISEL name is optional.
+  uint64_t pc = 0;
+  auto high_calls = SemanticsCalls(high);
+  ASSERT_EQ(insts.size(), high_calls.size());
+  ASSERT_TRUE(remill::GetGuestPC(high_calls[1], &pc));
+  EXPECT_EQ(0x100001003ULL, pc);
+
+#if LLVM_VERSION_NUMBER >= LLVM_VERSION(4, 0)
+  // The debug location holds the low 32 bits of the `PC`.
+  EXPECT_EQ(0x1003, high_calls[1]->getDebugLoc().getLine());
+
+  // The inlined semantics have no `!remill.pc` metadata, but they inherit
+  // the debug location of the call.
+  auto before = high_calls[1]->getPrevNode();
+  auto after = high_calls[1]->getNextNode();
+  llvm::InlineFunctionInfo info;
+# if LLVM_VERSION_NUMBER < LLVM_VERSION(11, 0)
+  ASSERT_TRUE(llvm::InlineFunction(high_calls[1], info));
+# else
+  ASSERT_TRUE(llvm::InlineFunction(*high_calls[1], info).isSuccess());
+# endif
+  ASSERT_EQ(before->getParent(), after->getParent());
+  ASSERT_NE(after, before->getNextNode());
+  for (auto inst = before->getNextNode(); inst != after;
+       inst = inst->getNextNode()) {
+    std::string isel_name;
+    ASSERT_TRUE(remill::GetGuestPC(inst, &pc, &isel_name));
+    EXPECT_EQ(0x100001003ULL, pc);
+    EXPECT_EQ(insts[1].function, isel_name);
+  }
+#endif
+
+  // The debug info is finished once the lifter is destroyed.
+  EXPECT_FALSE(llvm::verifyModule(*module, &llvm::errs()));
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
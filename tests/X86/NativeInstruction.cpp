@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "remill/Arch/Runtime/Runtime.h"
+#include "remill/Arch/X86/Runtime/State.h"
+#include "remill/Runtime/AddressSpace.h"
+#include "remill/Runtime/X86/ContextSwitch.h"
+#include "remill/Runtime/X86/NativeInstruction.h"
+
+// Tests for executing single guest instructions on the host CPU.
+
+namespace {
+
+enum : uint64_t {
+  kCodeAddr = 0x10000,
+  kDataAddr = 0x20000,
+  kPageSize = remill::AddressSpace::kPageSize
+};
+
+class NativeInstructionTest : public testing::Test {
+ protected:
+  void SetUp(void) override {
+    state.reset(new State);
+    memset(state.get(), 0, sizeof(State));
+    state->fpu_control.flat = 0x37f;
+    memory.reset(new remill::AddressSpace);
+    memory->AddMap(kCodeAddr, kPageSize);
+    memory->AddMap(kDataAddr, kPageSize);
+  }
+
+  // Execute the instruction in `code`.
+  template <size_t kSize>
+  remill::NativeInstructionStatus Execute(const char (&code)[kSize]) {
+    CHECK(memory->TryWrite(kCodeAddr, code, kSize - 1));
+    state->gpr.rip.qword = kCodeAddr;
+    return remill::ExecuteInstructionNatively(state.get(), memory.get());
+  }
+
+  std::unique_ptr<State> state;
+  std::unique_ptr<remill::AddressSpace> memory;
+};
+
+// Returns `true` if any mapping of this process is writable and executable.
+static bool HasWritableCode(void) {
+  std::ifstream maps("/proc/self/maps");
+  std::string line;
+  while (std::getline(maps, line)) {
+    if (std::string::npos != line.find(" rwx")) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST_F(NativeInstructionTest, ExecutesRegisterInstructions) {
+  state->gpr.rax.qword = 1;
+  state->gpr.rbx.qword = 2;
+  ASSERT_EQ(remill::kNativeInstructionExecuted,
+            Execute("\x48\x01\xD8"));  // add rax, rbx
+  EXPECT_EQ(3, state->gpr.rax.qword);
+  EXPECT_EQ(2, state->gpr.rbx.qword);
+  EXPECT_EQ(kCodeAddr + 3, state->gpr.rip.qword);
+  EXPECT_FALSE(HasWritableCode());
+}
+
+TEST_F(NativeInstructionTest, ExecutesMemoryInstructions) {
+  uint32_t val = 10;
+  ASSERT_TRUE(memory->TryWrite(kDataAddr + 8, &val, sizeof(val)));
+  state->gpr.rax.qword = 5;
+  state->gpr.rbx.qword = kDataAddr;
+  ASSERT_EQ(remill::kNativeInstructionExecuted,
+            Execute("\x01\x43\x08"));  // add [rbx + 8], eax
+  ASSERT_TRUE(memory->TryRead(kDataAddr + 8, &val, sizeof(val)));
+  EXPECT_EQ(15, val);
+  EXPECT_EQ(kDataAddr, state->gpr.rbx.qword);
+
+  state->gpr.rbx.qword = kDataAddr + kPageSize;
+  EXPECT_EQ(remill::kNativeInstructionMemoryFault,
+            Execute("\x01\x43\x08"));
+}
+
+TEST_F(NativeInstructionTest, ExecutesMMXInstructions) {
+  state->mmx.elems[0].val.qwords.elems[0] = 1;
+  state->mmx.elems[1].val.qwords.elems[0] = 2;
+  ASSERT_EQ(remill::kNativeInstructionExecuted,
+            Execute("\x0F\xD4\xC1"));  // paddq mm0, mm1
+  EXPECT_EQ(3, state->mmx.elems[0].val.qwords.elems[0]);
+  EXPECT_EQ(remill::kNativeInstructionExecuted,
+            Execute("\x0F\x77"));  // emms
+}
+
+TEST_F(NativeInstructionTest, ExecutesOpmaskInstructions) {
+  if (kRemillX86VectorISA_AVX512 != __remill_x86_vector_isa) {
+    return;
+  }
+  state->k_reg.elems[2].val = 0xFF0F;
+  state->k_reg.elems[3].val = 0x0FFF;
+  ASSERT_EQ(remill::kNativeInstructionExecuted,
+            Execute("\xC5\xEC\x41\xCB"));  // kandw k1, k2, k3
+  EXPECT_EQ(0x0F0F, state->k_reg.elems[1].val);
+}
+
+TEST_F(NativeInstructionTest, RejectsX87AndMXCSRInstructions) {
+  state->gpr.rbx.qword = kDataAddr;
+  EXPECT_EQ(remill::kNativeInstructionUnsupported,
+            Execute("\xD9\xE8"));  // fld1
+  EXPECT_EQ(remill::kNativeInstructionUnsupported,
+            Execute("\xDD\x03"));  // fld qword ptr [rbx]
+  EXPECT_EQ(remill::kNativeInstructionUnsupported,
+            Execute("\xD9\x2B"));  // fldcw [rbx]
+  EXPECT_EQ(remill::kNativeInstructionUnsupported,
+            Execute("\x0F\xAE\x03"));  // fxsave [rbx]
+  EXPECT_EQ(remill::kNativeInstructionUnsupported,
+            Execute("\x0F\x58\xC1"));  // addps xmm0, xmm1
+  EXPECT_EQ(remill::kNativeInstructionUnsupported,
+            Execute("\x0F\xAE\x13"));  // ldmxcsr [rbx]
+}
+
+TEST_F(NativeInstructionTest, RejectsControlFlow) {
+  EXPECT_EQ(remill::kNativeInstructionUnsupported,
+            Execute("\xEB\x00"));  // jmp .+2
+  EXPECT_EQ(remill::kNativeInstructionUnsupported,
+            Execute("\x50"));  // push rax
+}
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
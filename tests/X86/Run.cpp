@@ -16,15 +16,20 @@
 
 #define _XOPEN_SOURCE
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <dlfcn.h>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -32,6 +37,7 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <emmintrin.h>
 #include <setjmp.h>
 #include <signal.h>
 #include <ucontext.h>
@@ -44,6 +50,10 @@
 DECLARE_string(arch);
 DECLARE_string(os);
 
+DEFINE_int32(num_threads, 0,
+             "Number of threads on which to run test cases. Zero means one "
+             "thread per core.");
+
 namespace {
 
 struct alignas(128) Stack {
@@ -52,39 +62,58 @@ struct alignas(128) Stack {
   uint8_t _redzone2[128];
 };
 
-// Native test case code executes off of `gStack`. The state of the stack
-// after executing this code is saved in `gBackupStack`. Lifted test case
-// code executes off of the normal runtime stack, but emulates operations
-// that act on `gStack`.
+// Initial contents of every recording stack. This is filled in once, before
+// any test runs, and is only read afterwards.
 static Stack gRandomStack;
-static Stack gLiftedStack;
-static Stack gNativeStack;
-static Stack gSigStack;
+
+// Native test case code executes off of `gLiftedStack`. The state of the stack
+// after executing this code is saved in `gNativeStack`. Lifted test case
+// code executes off of the normal runtime stack, but emulates operations
+// that act on `gLiftedStack`. Test cases run on many threads at once, so
+// each thread has its own stacks.
+static __thread Stack gLiftedStack;
+static __thread Stack gNativeStack;
+static __thread Stack gSigStack;
 
 static Flags gRflagsInitial;
 
-static const addr_t g64BitMask = IF_64BIT_ELSE(~0UL, 0UL);
+// Bytes of `X86State` that are compared between the lifted and native runs.
+// Ignored bytes are zero.
+struct alignas(16) StateMask {
+  uint8_t bytes[sizeof(X86State)];
+};
 
-static const auto gStackBase = reinterpret_cast<uintptr_t>(
-    &(gLiftedStack.bytes[0]));
+static_assert(0 == (sizeof(X86State) % sizeof(__m128i)),
+              "`X86State` must be a multiple of 16 bytes in size.");
 
-static const auto gStackLimit = reinterpret_cast<uintptr_t>(
-    &(gLiftedStack._redzone2[0]));
+static StateMask gStateMask;
+
+// Total number of lifted vs. native comparisons, and how many of them found
+// a difference.
+static std::atomic<uint64_t> gNumChecks(0);
+static std::atomic<uint64_t> gNumDivergences(0);
+
+static const addr_t g64BitMask = IF_64BIT_ELSE(~0UL, 0UL);
 
 template <typename T>
 NEVER_INLINE static T &AccessMemory(addr_t addr) {
-  if (!(addr >= gStackBase && (addr + sizeof(T)) <= gStackLimit)) {
+  const auto stack_base = reinterpret_cast<uintptr_t>(
+      &(gLiftedStack.bytes[0]));
+  const auto stack_limit = reinterpret_cast<uintptr_t>(
+      &(gLiftedStack._redzone2[0]));
+  if (!(addr >= stack_base && (addr + sizeof(T)) <= stack_limit)) {
     EXPECT_TRUE(!"Memory access falls outside the valid range of the stack.");
   }
   return *reinterpret_cast<T *>(static_cast<uintptr_t>(addr));
 }
 
-// Used to handle exceptions in instructions.
-static sigjmp_buf gJmpBuf;
-static sigjmp_buf gUnsupportedInstrBuf;
+// Used to handle exceptions in instructions. Signals are delivered to the
+// thread that raised them, so these are per-thread.
+static __thread sigjmp_buf gJmpBuf;
+static __thread sigjmp_buf gUnsupportedInstrBuf;
 
 // Are we running in a native test case or a lifted one?
-static bool gInNativeTest = false;
+static __thread bool gInNativeTest = false;
 
 // Long doubles may be represented as 16-byte values depending on LLVM's
 // `DataLayout`, so we marshal into this format.
@@ -98,30 +127,36 @@ static_assert(16 == sizeof(LongDoubleStorage),
 
 extern "C" {
 
+// The following variables are thread-local, and are accessed by the code in
+// `Tests.S` and `generated/Arch/X86/SaveState.S` using local-exec TLS
+// addressing.
+
 // Used to record the FPU. We will use this to migrate native X87 or MMX
 // state into the `X86State` structure.
-FPU gFPU = {};
+__thread FPU gFPU = {};
 
 // Native state before we run the native test case. We then use this as the
 // initial state for the lifted testcase. The lifted test case code mutates
 // this, and we require that after running the lifted testcase, `gX86StateBefore`
 // matches `gX86StateAfter`,
-std::aligned_storage<sizeof(X86State), alignof(X86State)>::type gLiftedState;
+__thread std::aligned_storage<sizeof(X86State), alignof(X86State)>::type
+    gLiftedState;
 
 // Native state after running the native test case.
-std::aligned_storage<sizeof(X86State), alignof(X86State)>::type gNativeState;
+__thread std::aligned_storage<sizeof(X86State), alignof(X86State)>::type
+    gNativeState;
 
 // Address of the native test to run. The `InvokeTestCase` function saves
 // the native program state but then needs a way to figure out where to go
 // without storing that information in any register. So what we do is we
 // store it here and indirectly `JMP` into the native test case code after
 // saving the machine state to `gX86StateBefore`.
-uintptr_t gTestToRun = 0;
+__thread uintptr_t gTestToRun = 0;
 
 // Used for swapping the stack pointer between `gStack` and the normal
 // call stack. This lets us run both native and lifted testcase code on
 // the same stack.
-uint8_t *gStackSwitcher = nullptr;
+__thread uint8_t *gStackSwitcher = nullptr;
 
 // We need to capture the native flags state, and so we need a `PUSHFQ`.
 // Unfortunately, this will be done on the 'recording' stack (`gStack`) in
@@ -129,7 +164,7 @@ uint8_t *gStackSwitcher = nullptr;
 // the lifted execution. What we need to do is save the value just below the
 // top of the stack before the `PUSHFQ` clobbers it, then after we've recorded
 // the native flags we restore what was clobbered by `PUSHFQ`.
-uint64_t gStackSaveSlot = 0;
+__thread uint64_t gStackSaveSlot = 0;
 
 // Invoke a native test case addressed by `gTestToRun` and store the machine
 // state before and after executing the test in `gX86StateBefore` and
@@ -189,6 +224,53 @@ Memory *__remill_barrier_store_store(Memory *) { return nullptr; }
 Memory *__remill_atomic_begin(Memory *) { return nullptr; }
 Memory *__remill_atomic_end(Memory *) { return nullptr; }
 
+#define MAKE_ATOMIC_MEMORY(size) \
+  NEVER_INLINE Memory *__remill_compare_exchange_memory_ ## size( \
+      Memory *memory, addr_t addr, uint ## size ## _t &expected, \
+      uint ## size ## _t desired) { \
+    __atomic_compare_exchange_n( \
+        &AccessMemory<uint ## size ## _t>(addr), &expected, desired, false, \
+        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); \
+    return memory; \
+  } \
+  NEVER_INLINE Memory *__remill_exchange_memory_ ## size( \
+      Memory *memory, addr_t addr, uint ## size ## _t &value) { \
+    value = __atomic_exchange_n( \
+        &AccessMemory<uint ## size ## _t>(addr), value, __ATOMIC_SEQ_CST); \
+    return memory; \
+  } \
+  MAKE_ATOMIC_FETCH_OP(add, size) \
+  MAKE_ATOMIC_FETCH_OP(sub, size) \
+  MAKE_ATOMIC_FETCH_OP(and, size) \
+  MAKE_ATOMIC_FETCH_OP(or, size) \
+  MAKE_ATOMIC_FETCH_OP(xor, size)
+
+#define MAKE_ATOMIC_FETCH_OP(name, size) \
+  NEVER_INLINE Memory *__remill_fetch_and_ ## name ## _memory_ ## size( \
+      Memory *memory, addr_t addr, uint ## size ## _t &value) { \
+    value = __atomic_fetch_ ## name( \
+        &AccessMemory<uint ## size ## _t>(addr), value, __ATOMIC_SEQ_CST); \
+    return memory; \
+  }
+
+MAKE_ATOMIC_MEMORY(8)
+MAKE_ATOMIC_MEMORY(16)
+MAKE_ATOMIC_MEMORY(32)
+MAKE_ATOMIC_MEMORY(64)
+
+// The test memory is private to the thread running the test, so this doesn't
+// need to be a real 128-bit atomic.
+NEVER_INLINE Memory *__remill_compare_exchange_memory_128(
+    Memory *memory, addr_t addr, uint128_t &expected, uint128_t desired) {
+  auto &mem = AccessMemory<uint128_t>(addr);
+  auto prev = mem;
+  if (prev == expected) {
+    mem = desired;
+  }
+  expected = prev;
+  return memory;
+}
+
 void __remill_defer_inlining(void) {}
 
 Memory *__remill_error(X86State &, addr_t, Memory *) {
@@ -199,6 +281,10 @@ Memory *__remill_missing_block(X86State &, addr_t, Memory *memory) {
   return memory;
 }
 
+bool __remill_resume_after_call(X86State &, addr_t, Memory *) {
+  return true;
+}
+
 Memory *__remill_sync_hyper_call(
     X86State &state, Memory *mem, SyncHyperCall::Name call) {
   auto eax = state.gpr.rax.dword;
@@ -364,6 +450,46 @@ static void ResetFlags(void) {
   asm("push %0; popfq;" : : "m"(gRflagsInitial));
 }
 
+// Marks `size` bytes at `offset` in `X86State` as not being compared.
+static void IgnoreStateBytes(size_t offset, size_t size) {
+  memset(&(gStateMask.bytes[offset]), 0, size);
+}
+
+#define IGNORE_STATE_FIELD(field) \
+    IgnoreStateBytes(offsetof(X86State, field), \
+                     sizeof(static_cast<X86State *>(nullptr)->field))
+
+// Initializes the mask of compared `X86State` bytes. The program counters
+// are not compared because the native and lifted code live in different
+// binaries, and the arithmetic flags are compared via `rflag`.
+static void InitStateMask(void) {
+  memset(&gStateMask, 0xFF, sizeof(gStateMask));
+  IGNORE_STATE_FIELD(gpr.rip);
+  IGNORE_STATE_FIELD(aflag);
+  IGNORE_STATE_FIELD(hyper_call);
+  IGNORE_STATE_FIELD(hyper_call_vector);
+}
+
+#undef IGNORE_STATE_FIELD
+
+// Compares the masked bytes of two states, 16 bytes at a time.
+static bool StatesMatch(const void *a, const void *b) {
+  auto a_vec = reinterpret_cast<const __m128i *>(a);
+  auto b_vec = reinterpret_cast<const __m128i *>(b);
+  auto mask_vec = reinterpret_cast<const __m128i *>(&gStateMask);
+  auto diff = _mm_setzero_si128();
+  for (auto i = 0UL; i < sizeof(X86State) / sizeof(__m128i); ++i) {
+    diff = _mm_or_si128(
+        diff,
+        _mm_and_si128(
+            _mm_xor_si128(_mm_loadu_si128(&(a_vec[i])),
+                          _mm_loadu_si128(&(b_vec[i]))),
+            _mm_load_si128(&(mask_vec[i]))));
+  }
+  return 0xFFFF == _mm_movemask_epi8(
+      _mm_cmpeq_epi8(diff, _mm_setzero_si128()));
+}
+
 }  // namespace
 
 class InstrTest : public ::testing::TestWithParam<const test::TestInfo *> {};
@@ -445,16 +571,6 @@ static void RunWithFlags(const test::TestInfo *info,
 
   ResetFlags();
 
-  // Don't compare the program counters. The code that is lifted is equivalent
-  // to the code that is tested but because they are part of separate binaries
-  // it means that there is not necessarily any relation between their values.
-  //
-  // This also lets us compare 32-bit-only lifted code with 32-bit only
-  // testcases, where the native 32-bit code actually emulates the 32-bit
-  // behavior in 64-bit (because all of this code is compiled as 64-bit).
-  lifted_state->gpr.rip.aword = 0;
-  native_state->gpr.rip.aword = 0;
-
   // Copy the aflags state back into the rflags state.
   lifted_state->rflag.cf = lifted_state->aflag.cf;
   lifted_state->rflag.pf = lifted_state->aflag.pf;
@@ -464,10 +580,6 @@ static void RunWithFlags(const test::TestInfo *info,
   lifted_state->rflag.df = lifted_state->aflag.df;
   lifted_state->rflag.of = lifted_state->aflag.of;
 
-  // No longer want to compare these.
-  memset(&(native_state->aflag), 0, sizeof(native_state->aflag));
-  memset(&(lifted_state->aflag), 0, sizeof(lifted_state->aflag));
-
   // Only compare the non-undefined flags state.
   native_state->rflag.flat |= info->ignored_flags_mask;
   lifted_state->rflag.flat |= info->ignored_flags_mask;
@@ -476,11 +588,6 @@ static void RunWithFlags(const test::TestInfo *info,
   native_state->rflag.flat &= 0x0ED7UL;
   lifted_state->rflag.flat &= 0x0ED7UL;
 
-  native_state->hyper_call_vector = 0;
-  lifted_state->hyper_call_vector = 0;
-  native_state->hyper_call = AsyncHyperCall::kInvalid;
-  lifted_state->hyper_call = AsyncHyperCall::kInvalid;
-
   // Compare the FPU states.
   for (auto i = 0U; i < 8U; ++i) {
     auto lifted_st = lifted_state->st.elems[i].val;
@@ -492,20 +599,45 @@ static void RunWithFlags(const test::TestInfo *info,
     }
   }
 
-  // Compare the register states.
-  for (auto i = 0UL; i < kNumVecRegisters; ++i) {
-    EXPECT_TRUE(lifted_state->vec[i] == native_state->vec[i]);
-  }
-  EXPECT_TRUE(lifted_state->aflag == native_state->aflag);
-  EXPECT_TRUE(lifted_state->rflag == native_state->rflag);
-  EXPECT_TRUE(lifted_state->seg == native_state->seg);
-  EXPECT_TRUE(lifted_state->gpr == native_state->gpr);
-  if (gLiftedState != gNativeState) {
+  ++gNumChecks;
+  auto diverged = false;
+
+  // Fast path: compare everything but the ignored bytes (see
+  // `InitStateMask`) in one go. Only if that fails do we zero the ignored
+  // parts and compare the states piece by piece, to say what is different.
+  if (!StatesMatch(&gLiftedState, &gNativeState)) {
+    diverged = true;
+
+    // Don't compare the program counters. The code that is lifted is
+    // equivalent to the code that is tested but because they are part of
+    // separate binaries it means that there is not necessarily any relation
+    // between their values.
+    //
+    // This also lets us compare 32-bit-only lifted code with 32-bit only
+    // testcases, where the native 32-bit code actually emulates the 32-bit
+    // behavior in 64-bit (because all of this code is compiled as 64-bit).
+    lifted_state->gpr.rip.aword = 0;
+    native_state->gpr.rip.aword = 0;
+    memset(&(native_state->aflag), 0, sizeof(native_state->aflag));
+    memset(&(lifted_state->aflag), 0, sizeof(lifted_state->aflag));
+    native_state->hyper_call_vector = 0;
+    lifted_state->hyper_call_vector = 0;
+    native_state->hyper_call = AsyncHyperCall::kInvalid;
+    lifted_state->hyper_call = AsyncHyperCall::kInvalid;
+
+    // Compare the register states.
+    for (auto i = 0UL; i < kNumVecRegisters; ++i) {
+      EXPECT_TRUE(lifted_state->vec[i] == native_state->vec[i]);
+    }
+    EXPECT_TRUE(lifted_state->rflag == native_state->rflag);
+    EXPECT_TRUE(lifted_state->seg == native_state->seg);
+    EXPECT_TRUE(lifted_state->gpr == native_state->gpr);
     LOG(ERROR)
         << "States did not match for " << desc;
     EXPECT_TRUE(!"Lifted and native states did not match.");
   }
   if (gLiftedStack != gNativeStack) {
+    diverged = true;
     LOG(ERROR)
         << "Stacks did not match for " << desc;
 
@@ -522,10 +654,54 @@ static void RunWithFlags(const test::TestInfo *info,
 
     EXPECT_TRUE(!"Lifted and native stacks did not match.");
   }
+  if (diverged) {
+    ++gNumDivergences;
+  }
+}
+
+// Sets up the calling thread's alternate signal stack. The signal handlers
+// themselves are shared by all threads.
+static void SetupSignalStack(void) {
+  stack_t sig_stack;
+  sig_stack.ss_sp = &gSigStack;
+  sig_stack.ss_size = SIGSTKSZ;
+  sig_stack.ss_flags = 0;
+  sigaltstack(&sig_stack, nullptr);
+}
+
+// Runs `job(i)` for every `i` in `[0, num_jobs)`, spread across
+// `--num_threads` worker threads. Each worker has its own stacks, state
+// structures and jump buffers, so any two jobs can run at the same time.
+static void RunJobs(size_t num_jobs, const std::function<void(size_t)> &job) {
+  auto num_threads = static_cast<size_t>(std::max(0, FLAGS_num_threads));
+  if (!num_threads) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  num_threads = std::min(num_threads, num_jobs);
+
+  std::atomic<size_t> next_job(0);
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&] (void) {
+      SetupSignalStack();
+      for (auto i = next_job++; i < num_jobs; i = next_job++) {
+        job(i);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
 }
 
+// Number of combinations of the seven arithmetic flags that each set of test
+// arguments is run with.
+static constexpr uint32_t kNumFlagCombinations = 0x80U;
+
 TEST_P(InstrTest, SemanticsMatchNative) {
   auto info = GetParam();
+  std::vector<const uint64_t *> arg_sets;
+  std::vector<std::string> descs;
   for (auto args = info->args_begin;
        args < info->args_end;
        args += info->num_args) {
@@ -540,7 +716,15 @@ TEST_P(InstrTest, SemanticsMatchNative) {
         }
       }
     }
-    auto desc = ss.str();
+    arg_sets.push_back(args);
+    descs.push_back(ss.str());
+  }
+
+  // Go through all possible flag combinations of every set of arguments.
+  // Each pair of arguments and flags is an independent job.
+  RunJobs(arg_sets.size() * kNumFlagCombinations, [&] (size_t job) {
+    const auto args = arg_sets[job / kNumFlagCombinations];
+    const auto &desc = descs[job / kNumFlagCombinations];
 
     union EFLAGS {
       uint32_t flat;
@@ -558,33 +742,30 @@ TEST_P(InstrTest, SemanticsMatchNative) {
 
     static_assert(sizeof(EFLAGS) == 4, "Invalid packing of `union EFLAGS`.");
 
-    // Go through all possible flag combinations.
-    for (uint32_t i = 0U; i <= 0x7FU; ++i) {
-      EFLAGS eflags;
-      eflags.flat = i;
-
-      std::stringstream ss2;
-      ss2 << desc << " and"
-         << " CF=" << eflags.cf
-         << " PF=" << eflags.pf
-         << " AF=" << eflags.af
-         << " ZF=" << eflags.zf
-         << " SF=" << eflags.sf
-         << " DF=" << eflags.df
-         << " OF=" << eflags.of;
-
-      Flags flags = gRflagsInitial;
-      flags.cf = eflags.cf;
-      flags.pf = eflags.pf;
-      flags.af = eflags.af;
-      flags.zf = eflags.zf;
-      flags.sf = eflags.sf;
-      flags.df = eflags.df;
-      flags.of = eflags.of;
-
-      RunWithFlags(info, flags, ss2.str(), args[0], args[1], args[2]);
-    }
-  }
+    EFLAGS eflags;
+    eflags.flat = static_cast<uint32_t>(job % kNumFlagCombinations);
+
+    std::stringstream ss2;
+    ss2 << desc << " and"
+       << " CF=" << eflags.cf
+       << " PF=" << eflags.pf
+       << " AF=" << eflags.af
+       << " ZF=" << eflags.zf
+       << " SF=" << eflags.sf
+       << " DF=" << eflags.df
+       << " OF=" << eflags.of;
+
+    Flags flags = gRflagsInitial;
+    flags.cf = eflags.cf;
+    flags.pf = eflags.pf;
+    flags.af = eflags.af;
+    flags.zf = eflags.zf;
+    flags.sf = eflags.sf;
+    flags.df = eflags.df;
+    flags.of = eflags.of;
+
+    RunWithFlags(info, flags, ss2.str(), args[0], args[1], args[2]);
+  });
 }
 
 INSTANTIATE_TEST_CASE_P(
@@ -680,12 +861,6 @@ static void SetupSignals(void) {
   sigset_t set;
   sigemptyset(&set);
   sigprocmask(SIG_SETMASK, &set, nullptr);
-
-  stack_t sig_stack;
-  sig_stack.ss_sp = &gSigStack;
-  sig_stack.ss_size = SIGSTKSZ;
-  sig_stack.ss_flags = 0;
-  sigaltstack(&sig_stack, nullptr);
 }
 
 int main(int argc, char **argv) {
@@ -722,8 +897,20 @@ int main(int argc, char **argv) {
     b = static_cast<uint8_t>(random());
   }
 
+  InitStateMask();
   testing::InitGoogleTest(&argc, argv);
 
   SetupSignals();
-  return RUN_ALL_TESTS();
+
+  const auto begin = std::chrono::steady_clock::now();
+  const auto ret = RUN_ALL_TESTS();
+  const auto secs = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin).count();
+
+  std::cout
+      << "Ran " << gNumChecks << " lifted vs. native checks in " << secs
+      << "s (" << static_cast<uint64_t>(gNumChecks / std::max(secs, 1e-9))
+      << " checks/s); " << gNumDivergences << " diverged." << std::endl;
+
+  return ret;
 }
@@ -0,0 +1,549 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Transforms/IPO.h>
+
+#include "remill/Arch/Arch.h"
+#include "remill/Arch/Name.h"
+#include "remill/Arch/X86/Runtime/State.h"
+#include "remill/BC/Codegen.h"
+#include "remill/BC/IntrinsicTable.h"
+#include "remill/BC/Lifter.h"
+#include "remill/BC/Profile.h"
+#include "remill/BC/Trace.h"
+#include "remill/BC/Util.h"
+#include "remill/OS/FileSystem.h"
+#include "remill/OS/Image.h"
+#include "remill/OS/OS.h"
+
+// Tests for profile-guided trace selection over a small, hand-assembled
+// amd64 loop whose body is an if/else, and for lifting traces.
+
+#ifndef REMILL_TEST_CXX
+# define REMILL_TEST_CXX "c++"
+#endif
+
+namespace {
+
+//    1000:  mov ecx, 100
+//    1005:  test cl, 1       ; Loop header.
+//    1008:  jz 100e
+//    100a:  add eax, ecx
+//    100c:  jmp 1010
+//    100e:  sub eax, ecx
+//    1010:  dec ecx
+//    1012:  jnz 1005
+//    1014:  ret
+static const char kLoop[] =
+    "\xB9\x64\x00\x00\x00"
+    "\xF6\xC1\x01"
+    "\x74\x04"
+    "\x01\xC8"
+    "\xEB\x02"
+    "\x29\xC8"
+    "\xFF\xC9"
+    "\x75\xF1"
+    "\xC3";
+
+static const char kLoopProfile[] =
+    "name,count\n"
+    "block_1000,1\n"
+    "block_1005,100\n"
+    "block_100a,50\n"
+    "block_100e,50\n"
+    "block_1010,100\n"
+    "block_1014,1\n"
+    "isel_RET_NEAR,1\n";
+
+//    2000:  call 2006
+//    2005:  ret
+//    2006:  ret
+static const char kCall[] =
+    "\xE8\x01\x00\x00\x00"
+    "\xC3"
+    "\xC3";
+
+//    3000:  call 3006
+//    3005:  ret
+//    3006:  ret            ; Returns to its caller.
+//    3007:  pop rax        ; Returns to its caller's caller.
+//    3008:  ret
+static const char kReturns[] =
+    "\xE8\x01\x00\x00\x00"
+    "\xC3"
+    "\xC3"
+    "\x58"
+    "\xC3";
+
+// Where the lifted code of `kReturns` returned to the runtime.
+struct Exit {
+  const char *intrinsic;
+  uint64_t pc;
+};
+
+static Exit gExit = {};
+
+// What `__remill_resume_after_call` returns, and how often it was called.
+static bool gResumeAfterCall = true;
+static unsigned gNumResumeChecks = 0;
+
+class TraceTest : public testing::Test {
+ protected:
+  void SetUp(void) override {
+    path = testing::TempDir() + "trace_loop";
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    os.write(kLoop, sizeof(kLoop) - 1);
+    os.close();
+
+    image = remill::MappedImage::Open(path, 0x1000);
+    ASSERT_TRUE(image != nullptr);
+    arch = remill::Arch::Get(remill::kOSLinux, remill::kArchAMD64);
+
+    std::stringstream ss(kLoopProfile);
+    ASSERT_TRUE(profile.Parse(ss));
+  }
+
+  void TearDown(void) override {
+    remill::RemoveFile(path);
+  }
+
+  std::vector<remill::Trace> Select(void) {
+    return remill::SelectTraces(arch, *image, profile, options);
+  }
+
+  std::string path;
+  std::unique_ptr<remill::MappedImage> image;
+  const remill::Arch *arch;
+  remill::BlockProfile profile;
+  remill::TraceSelectionOptions options;
+};
+
+static std::vector<uint64_t> BlockPCs(const remill::Trace &trace) {
+  std::vector<uint64_t> pcs;
+  for (const auto &block : trace.blocks) {
+    pcs.push_back(block.pc);
+  }
+  return pcs;
+}
+
+// Returns the calls in `func` to `callee`.
+static std::vector<llvm::CallInst *> CallsTo(llvm::Function *func,
+                                             llvm::Function *callee) {
+  std::vector<llvm::CallInst *> calls;
+  for (auto &block : *func) {
+    for (auto &inst : block) {
+      if (auto call = llvm::dyn_cast<llvm::CallInst>(&inst)) {
+        if (call->getCalledFunction() == callee) {
+          calls.push_back(call);
+        }
+      }
+    }
+  }
+  return calls;
+}
+
+// Decode the `num_insts` instructions starting at `pc` into a trace with
+// one block.
+static remill::Trace DecodeTrace(const remill::Arch *arch,
+                                 const remill::MappedImage &image,
+                                 uint64_t pc, size_t num_insts) {
+  remill::Trace trace;
+  trace.count = 1;
+  trace.blocks.resize(1);
+  trace.blocks[0].pc = pc;
+  trace.blocks[0].instructions.resize(num_insts);
+  for (auto &inst : trace.blocks[0].instructions) {
+    CHECK(arch->DecodeInstruction(pc, image, inst));
+    pc = inst.next_pc;
+  }
+  return trace;
+}
+
+// Internalize everything in `module` except for the functions in `names`,
+// and then remove what they don't use, so that only the intrinsics that the
+// lifted code calls are left undefined.
+static void KeepOnly(llvm::Module *module,
+                     const std::set<std::string> &names) {
+  for (auto used_name : {"llvm.used", "llvm.compiler.used"}) {
+    if (auto used = module->getGlobalVariable(used_name)) {
+      used->eraseFromParent();
+    }
+  }
+  for (auto &func : *module) {
+    if (!func.isDeclaration() && !names.count(func.getName().str())) {
+      func.setLinkage(llvm::GlobalValue::InternalLinkage);
+      func.setComdat(nullptr);
+    }
+  }
+  for (auto &var : module->globals()) {
+    if (!var.isDeclaration()) {
+      var.setLinkage(llvm::GlobalValue::InternalLinkage);
+      var.setComdat(nullptr);
+    }
+  }
+  llvm::legacy::PassManager pm;
+  pm.add(llvm::createGlobalDCEPass());
+  pm.run(*module);
+}
+
+using LiftedFunction = Memory *(State &, addr_t, Memory *);
+
+// Lifts the calls in `kReturns`, compiles them for the host, and runs them
+// against the intrinsics below. The guest stack is on the host stack.
+class TraceReturnTest : public testing::Test {
+ protected:
+  void SetUp(void) override {
+    char dir_template[] = "/tmp/remill_trace_XXXXXX";
+    ASSERT_TRUE(nullptr != mkdtemp(dir_template));
+    dir = dir_template;
+    state.reset(new State);
+  }
+
+  void TearDown(void) override {
+    if (handle) {
+      dlclose(handle);
+    }
+    for (const auto &path : paths) {
+      remill::RemoveFile(path);
+    }
+    rmdir(dir.c_str());
+  }
+
+  // Compile `module` into a shared library, and load it.
+  void Load(std::unique_ptr<llvm::Module> module) {
+    remill::ParallelCodegenOptions options;
+    options.num_partitions = 1;
+    options.num_threads = 1;
+    options.opt_level = 2;
+
+    std::vector<std::string> object_files;
+    ASSERT_TRUE(remill::CompileModuleInParallel(
+        std::move(module), dir + "/returns", options, &object_files));
+    paths.insert(paths.end(), object_files.begin(), object_files.end());
+
+    auto library = dir + "/returns.so";
+    std::stringstream cmd;
+    cmd << REMILL_TEST_CXX << " -shared -o " << library;
+    for (const auto &object_file : object_files) {
+      cmd << " " << object_file;
+    }
+    paths.push_back(library);
+    ASSERT_EQ(0, std::system(cmd.str().c_str()))
+        << "Unable to link with: " << cmd.str();
+    handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+    ASSERT_TRUE(nullptr != handle) << dlerror();
+  }
+
+  LiftedFunction *Find(const char *name) {
+    return reinterpret_cast<LiftedFunction *>(dlsym(handle, name));
+  }
+
+  // Run `func` from the call at `0x3000`. The return address of whoever
+  // called `0x3000` is `0x4000`.
+  void Run(LiftedFunction *func) {
+    memset(state.get(), 0, sizeof(State));
+    memset(stack, 0, sizeof(stack));
+    stack[8] = 0x4000;
+    state->gpr.rsp.qword = reinterpret_cast<uintptr_t>(&(stack[8]));
+    state->gpr.rip.qword = 0x3000;
+    gExit = {};
+    gNumResumeChecks = 0;
+    func(*state, 0x3000, nullptr);
+  }
+
+  std::string dir;
+  std::vector<std::string> paths;
+  void *handle = nullptr;
+  std::unique_ptr<State> state;
+  uint64_t stack[16];
+};
+
+}  // namespace
+
+// The intrinsics that the lifted code of `kReturns` calls. Guest addresses
+// are host addresses.
+extern "C" {
+
+uint64_t __remill_read_memory_64(Memory *, addr_t addr) {
+  return *reinterpret_cast<uint64_t *>(addr);
+}
+
+Memory *__remill_write_memory_64(Memory *memory, addr_t addr, uint64_t val) {
+  *reinterpret_cast<uint64_t *>(addr) = val;
+  return memory;
+}
+
+Memory *__remill_function_return(State &, addr_t, Memory *memory) {
+  return memory;
+}
+
+Memory *__remill_jump(State &, addr_t pc, Memory *memory) {
+  gExit = {"__remill_jump", pc};
+  return memory;
+}
+
+Memory *__remill_missing_block(State &, addr_t pc, Memory *memory) {
+  gExit = {"__remill_missing_block", pc};
+  return memory;
+}
+
+bool __remill_resume_after_call(State &, addr_t, Memory *) {
+  ++gNumResumeChecks;
+  return gResumeAfterCall;
+}
+
+}  // extern C
+
+TEST(BlockProfile, ParsesExecutionCounters) {
+  std::stringstream ss(
+      "name,count\n"
+      "block_401000,120\r\n"
+      "isel_ADD_GPRv_IMMz_64,7\n"
+      "edge_401000_401020,100\n"
+      "block_401000,5\n");
+  remill::BlockProfile profile;
+  ASSERT_TRUE(profile.Parse(ss));
+  EXPECT_EQ(125, profile.BlockCount(0x401000));
+  EXPECT_EQ(0, profile.BlockCount(0x401020));
+  EXPECT_EQ(100, profile.EdgeCount(0x401000, 0x401020));
+  EXPECT_TRUE(profile.HasEdgesFrom(0x401000));
+  EXPECT_FALSE(profile.HasEdgesFrom(0x401020));
+
+  std::stringstream bad_block("block_zz,1\n");
+  EXPECT_FALSE(profile.Parse(bad_block));
+
+  std::stringstream bad_count("block_401000,-1\n");
+  EXPECT_FALSE(profile.Parse(bad_count));
+
+  std::stringstream bad_edge("edge_401000,1\n");
+  EXPECT_FALSE(profile.Parse(bad_edge));
+}
+
+TEST_F(TraceTest, SelectsLoopTraces) {
+  auto traces = Select();
+  ASSERT_EQ(2, traces.size());
+
+  // The loop header is the target of a backward branch. Both sides of the
+  // if/else are equally hot, so the trace takes the fall-through.
+  EXPECT_EQ(100, traces[0].count);
+  EXPECT_EQ(std::vector<uint64_t>({0x1005, 0x100a, 0x1010}),
+            BlockPCs(traces[0]));
+  ASSERT_EQ(2, traces[0].blocks[0].instructions.size());
+  EXPECT_EQ(remill::Instruction::kCategoryConditionalBranch,
+            traces[0].blocks[0].instructions[1].category);
+
+  // The `else` side is a hot side exit of the first trace, so it heads the
+  // second trace, which runs until the backward branch.
+  EXPECT_EQ(50, traces[1].count);
+  EXPECT_EQ(std::vector<uint64_t>({0x100e, 0x1010}), BlockPCs(traces[1]));
+}
+
+TEST_F(TraceTest, FollowsHotEdges) {
+  std::stringstream ss(
+      "edge_1005_100a,20\n"
+      "edge_1005_100e,80\n");
+  ASSERT_TRUE(profile.Parse(ss));
+
+  auto traces = Select();
+  ASSERT_EQ(2, traces.size());
+  EXPECT_EQ(std::vector<uint64_t>({0x1005, 0x100e, 0x1010}),
+            BlockPCs(traces[0]));
+  EXPECT_EQ(std::vector<uint64_t>({0x100a, 0x1010}), BlockPCs(traces[1]));
+}
+
+TEST_F(TraceTest, RespectsLimits) {
+  options.max_blocks = 2;
+  auto traces = Select();
+  ASSERT_FALSE(traces.empty());
+  EXPECT_EQ(std::vector<uint64_t>({0x1005, 0x100a}), BlockPCs(traces[0]));
+
+  options.max_blocks = 16;
+  options.max_traces = 1;
+  EXPECT_EQ(1, Select().size());
+
+  options.max_traces = 0;
+  options.hot_threshold = 51;
+  traces = Select();
+  ASSERT_EQ(1, traces.size());
+  EXPECT_EQ(std::vector<uint64_t>({0x1005}), BlockPCs(traces[0]));
+
+  options.hot_threshold = 101;
+  EXPECT_TRUE(Select().empty());
+}
+
+TEST(TraceLift, CallsLiftedCalleesNatively) {
+  auto path = testing::TempDir() + "trace_call";
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  os.write(kCall, sizeof(kCall) - 1);
+  os.close();
+
+  auto image = remill::MappedImage::Open(path, 0x2000);
+  ASSERT_TRUE(image != nullptr);
+  auto arch = remill::Arch::Get(remill::kOSLinux, remill::kArchAMD64);
+
+  remill::Trace trace;
+  trace.count = 1;
+  trace.blocks.resize(1);
+  trace.blocks[0].pc = 0x2000;
+  trace.blocks[0].instructions.resize(1);
+  ASSERT_TRUE(arch->DecodeInstruction(0x2000, *image,
+                                      trace.blocks[0].instructions[0]));
+  remill::RemoveFile(path);
+
+  llvm::LLVMContext context;
+  std::unique_ptr<llvm::Module> module(remill::LoadModuleFromFile(
+      &context, remill::FindSemanticsBitcodeFile("amd64")));
+  auto word_type = llvm::Type::getIntNTy(context, arch->address_size);
+  remill::IntrinsicTable intrinsics(module.get());
+  remill::InstructionLifter lifter(word_type, &intrinsics);
+
+  auto callee = remill::DeclareLiftedFunction(module.get(), "callee");
+  auto find_callee = [=] (uint64_t pc) -> llvm::Function * {
+    return pc == 0x2006 ? callee : nullptr;
+  };
+
+  // The call is a real call, and the return site is reached directly if the
+  // callee returns to it.
+  auto func = remill::DeclareLiftedFunction(module.get(), "trace_native");
+  ASSERT_TRUE(remill::LiftTrace(&lifter, trace, func, nullptr, find_callee));
+  auto calls = CallsTo(func, callee);
+  ASSERT_EQ(1, calls.size());
+  EXPECT_FALSE(calls[0]->isTailCall());
+  EXPECT_TRUE(CallsTo(func, intrinsics.function_call).empty());
+  EXPECT_EQ(1, CallsTo(func, intrinsics.jump).size());
+  EXPECT_EQ(1, CallsTo(func, intrinsics.missing_block).size());
+  EXPECT_EQ(1, CallsTo(func, intrinsics.resume_after_call).size());
+
+  // Without a lifted callee, the call goes through the dispatcher.
+  func = remill::DeclareLiftedFunction(module.get(), "trace_dispatch");
+  ASSERT_TRUE(remill::LiftTrace(&lifter, trace, func));
+  EXPECT_EQ(1, CallsTo(func, intrinsics.function_call).size());
+  EXPECT_TRUE(CallsTo(func, intrinsics.jump).empty());
+}
+
+#if defined(__x86_64__)
+
+TEST_F(TraceReturnTest, ChecksNativeReturns) {
+  auto path = dir + "/trace_returns";
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  os.write(kReturns, sizeof(kReturns) - 1);
+  os.close();
+
+  auto image = remill::MappedImage::Open(path, 0x3000);
+  ASSERT_TRUE(image != nullptr);
+  auto arch = remill::Arch::Get(remill::kOSLinux, remill::kArchAMD64);
+  auto caller = DecodeTrace(arch, *image, 0x3000, 1);
+  auto callee_ret = DecodeTrace(arch, *image, 0x3006, 1);
+  auto callee_pop_ret = DecodeTrace(arch, *image, 0x3007, 2);
+  remill::RemoveFile(path);
+
+  llvm::LLVMContext context;
+  std::unique_ptr<llvm::Module> module(remill::LoadModuleFromFile(
+      &context, remill::FindSemanticsBitcodeFile("amd64")));
+  auto word_type = llvm::Type::getIntNTy(context, arch->address_size);
+  remill::IntrinsicTable intrinsics(module.get());
+  remill::InstructionLifter lifter(word_type, &intrinsics);
+
+  // `caller_match` calls a callee that returns to it, and `caller_mismatch`
+  // calls one that returns to the caller's caller.
+  auto ret = remill::DeclareLiftedFunction(module.get(), "callee_ret");
+  auto pop_ret = remill::DeclareLiftedFunction(module.get(), "callee_pop_ret");
+  ASSERT_TRUE(remill::LiftTrace(&lifter, callee_ret, ret));
+  ASSERT_TRUE(remill::LiftTrace(&lifter, callee_pop_ret, pop_ret));
+  ASSERT_TRUE(remill::LiftTrace(
+      &lifter, caller,
+      remill::DeclareLiftedFunction(module.get(), "caller_match"), nullptr,
+      [=] (uint64_t) -> llvm::Function * { return ret; }));
+  ASSERT_TRUE(remill::LiftTrace(
+      &lifter, caller,
+      remill::DeclareLiftedFunction(module.get(), "caller_mismatch"), nullptr,
+      [=] (uint64_t) -> llvm::Function * { return pop_ret; }));
+
+  KeepOnly(module.get(), {"caller_match", "caller_mismatch"});
+  Load(std::move(module));
+  ASSERT_TRUE(nullptr != handle);
+  auto caller_match = Find("caller_match");
+  auto caller_mismatch = Find("caller_mismatch");
+  ASSERT_TRUE(nullptr != caller_match);
+  ASSERT_TRUE(nullptr != caller_mismatch);
+
+  // The callee returned to the call site, so the trace continues at the
+  // return site, which isn't on the trace.
+  const auto sp = reinterpret_cast<uintptr_t>(&(stack[8]));
+  gResumeAfterCall = true;
+  Run(caller_match);
+  EXPECT_STREQ("__remill_missing_block", gExit.intrinsic);
+  EXPECT_EQ(0x3005, gExit.pc);
+  EXPECT_EQ(1, gNumResumeChecks);
+  EXPECT_EQ(sp, state->gpr.rsp.qword);
+
+  // The runtime wants to take over after the call, e.g. because the vCPU
+  // was stopped, so the trace goes back to the dispatcher at the return site.
+  gResumeAfterCall = false;
+  Run(caller_match);
+  EXPECT_STREQ("__remill_jump", gExit.intrinsic);
+  EXPECT_EQ(0x3005, gExit.pc);
+  EXPECT_EQ(1, gNumResumeChecks);
+  EXPECT_EQ(sp, state->gpr.rsp.qword);
+
+  // The callee returned somewhere else, so the trace goes back to the
+  // dispatcher there, without asking the runtime.
+  gResumeAfterCall = true;
+  Run(caller_mismatch);
+  EXPECT_STREQ("__remill_jump", gExit.intrinsic);
+  EXPECT_EQ(0x4000, gExit.pc);
+  EXPECT_EQ(0, gNumResumeChecks);
+  EXPECT_EQ(0x3005, state->gpr.rax.qword);
+  EXPECT_EQ(sp + 8, state->gpr.rsp.qword);
+}
+
+#endif  // defined(__x86_64__)
+
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "remill/Arch/Arch.h"
+#include "remill/Arch/Instruction.h"
+#include "remill/Arch/Name.h"
+#include "remill/OS/Image.h"
+#include "remill/OS/OS.h"
+
+DECLARE_string(arch);
+DECLARE_string(os);
+
+DEFINE_string(binary_in, "",
+              "ELF file, or file of raw machine code, to sweep. Every "
+              "executable segment of an ELF file is swept.");
+
+DEFINE_uint64(address, 0,
+              "Address of the first byte of --binary_in, if it is a file "
+              "of raw machine code.");
+
+DEFINE_uint64(iterations, 10, "Number of times to sweep the code.");
+
+DEFINE_string(boundaries_out, "",
+              "File in which to list every instruction found by "
+              "DecodeInstructionBoundary, one per line, as the hexadecimal "
+              "PC, the length, and the hexadecimal direct branch target "
+              "(or '-'). Used by scripts/x86/check_boundaries.sh.");
+
+// Compares how long it takes to linearly sweep the executable code of a
+// binary using `Arch::DecodeInstructionBoundary` against using
+// `Arch::DecodeInstruction`, and reports how often the two sweeps disagree.
+// Both decoders read the code directly out of the mapped binary.
+
+namespace {
+
+struct SweepResult {
+  std::vector<uint64_t> boundaries;
+  std::chrono::duration<double> time;
+};
+
+// Bytes to skip over when a sweep hits something that doesn't decode.
+static uint64_t SkipSize(const remill::Arch *arch) {
+  if (arch->IsX86() || arch->IsAMD64()) {
+    return 1;
+  } else {
+    return arch->MaxInstructionSize();
+  }
+}
+
+static SweepResult SweepBoundaries(const remill::Arch *arch,
+                                   const remill::MappedImage &image) {
+  SweepResult result;
+  const auto skip_size = SkipSize(arch);
+  remill::InstructionBoundary boundary;
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto i = 0ULL; i < FLAGS_iterations; ++i) {
+    result.boundaries.clear();
+    image.ForEachExecutableRange([&] (uint64_t begin, uint64_t end) {
+      for (auto pc = begin; pc < end; ) {
+        if (arch->DecodeInstructionBoundary(pc, image, boundary)) {
+          result.boundaries.push_back(pc);
+          pc += boundary.NumBytes();
+        } else {
+          pc += skip_size;
+        }
+      }
+      return true;
+    });
+  }
+  result.time = std::chrono::steady_clock::now() - start;
+  return result;
+}
+
+static SweepResult SweepInstructions(const remill::Arch *arch,
+                                     const remill::MappedImage &image) {
+  SweepResult result;
+  const auto skip_size = SkipSize(arch);
+  remill::Instruction inst;
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto i = 0ULL; i < FLAGS_iterations; ++i) {
+    result.boundaries.clear();
+    image.ForEachExecutableRange([&] (uint64_t begin, uint64_t end) {
+      for (auto pc = begin; pc < end; ) {
+        inst.Reset();
+        if (arch->DecodeInstruction(pc, image, inst)) {
+          result.boundaries.push_back(pc);
+          pc += inst.NumBytes();
+        } else {
+          pc += skip_size;
+        }
+      }
+      return true;
+    });
+  }
+  result.time = std::chrono::steady_clock::now() - start;
+  return result;
+}
+
+// Returns `true` if `boundary` has a direct branch target.
+static bool HasBranchTarget(const remill::InstructionBoundary &boundary) {
+  switch (boundary.category) {
+    case remill::Instruction::kCategoryDirectJump:
+    case remill::Instruction::kCategoryDirectFunctionCall:
+    case remill::Instruction::kCategoryConditionalBranch:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// List every instruction found by a boundary sweep in `os`.
+static void WriteBoundaries(const remill::Arch *arch,
+                            const remill::MappedImage &image,
+                            std::ostream &os) {
+  const auto skip_size = SkipSize(arch);
+  remill::InstructionBoundary boundary;
+  image.ForEachExecutableRange([&] (uint64_t begin, uint64_t end) {
+    for (auto pc = begin; pc < end; ) {
+      if (!arch->DecodeInstructionBoundary(pc, image, boundary)) {
+        pc += skip_size;
+        continue;
+      }
+      os << std::hex << pc << " " << std::dec << boundary.NumBytes() << " ";
+      if (HasBranchTarget(boundary)) {
+        os << std::hex << boundary.branch_taken_pc << std::dec << "\n";
+      } else {
+        os << "-\n";
+      }
+      pc += boundary.NumBytes();
+    }
+    return true;
+  });
+}
+
+// Total number of executable bytes in `image`.
+static uint64_t NumExecutableBytes(const remill::MappedImage &image) {
+  uint64_t num_bytes = 0;
+  image.ForEachExecutableRange([&] (uint64_t begin, uint64_t end) {
+    num_bytes += end - begin;
+    return true;
+  });
+  return num_bytes;
+}
+
+static void PrintResult(const char *name, const SweepResult &result,
+                        uint64_t num_bytes) {
+  auto ms = result.time.count() * 1000.0 / FLAGS_iterations;
+  std::cout
+      << name << ": " << result.boundaries.size() << " instructions in "
+      << ms << " ms per sweep ("
+      << (static_cast<double>(num_bytes) / (1024.0 * 1024.0)) / ms
+      << " MiB/ms)" << std::endl;
+}
+
+}  // namespace
+
+extern "C" int main(int argc, char *argv[]) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  CHECK(!FLAGS_binary_in.empty())
+      << "Please specify a binary with --binary_in.";
+
+  CHECK(!FLAGS_arch.empty())
+      << "Please specify an architecture with --arch.";
+
+  CHECK(0 < FLAGS_iterations)
+      << "Please specify a positive number of --iterations.";
+
+  if (FLAGS_os.empty()) {
+    FLAGS_os = REMILL_OS;
+  }
+
+  auto image = remill::MappedImage::Open(FLAGS_binary_in, FLAGS_address);
+  CHECK(image != nullptr)
+      << "Unable to load " << FLAGS_binary_in;
+
+  auto arch = remill::GetTargetArch();
+  auto boundaries = SweepBoundaries(arch, *image);
+  auto instructions = SweepInstructions(arch, *image);
+  auto num_bytes = NumExecutableBytes(*image);
+
+  PrintResult("DecodeInstructionBoundary", boundaries, num_bytes);
+  PrintResult("DecodeInstruction", instructions, num_bytes);
+  std::cout
+      << "Speedup: "
+      << (instructions.time.count() / boundaries.time.count())
+      << "x" << std::endl;
+
+  // On valid code, every instruction found by the full decoder is also found
+  // by the boundary decoder. The boundary decoder may additionally accept
+  // some invalid bytes (e.g. data in the code), after which the two sweeps
+  // can briefly disagree.
+  uint64_t num_missed = 0;
+  auto it = boundaries.boundaries.begin();
+  for (auto offset : instructions.boundaries) {
+    while (it != boundaries.boundaries.end() && *it < offset) {
+      ++it;
+    }
+    if (it == boundaries.boundaries.end() || *it != offset) {
+      ++num_missed;
+    }
+  }
+
+  std::cout
+      << "Boundaries found by DecodeInstruction but not by "
+      << "DecodeInstructionBoundary: " << num_missed << std::endl;
+
+  if (!FLAGS_boundaries_out.empty()) {
+    std::ofstream os(FLAGS_boundaries_out);
+    CHECK(os.good())
+        << "Unable to open " << FLAGS_boundaries_out << " for writing.";
+    WriteBoundaries(arch, *image, os);
+  }
+
+  return 0;
+}
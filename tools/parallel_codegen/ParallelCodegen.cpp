@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include <llvm/Support/TargetSelect.h>
+
+#include "remill/BC/Codegen.h"
+#include "remill/BC/Util.h"
+#include "remill/OS/FileSystem.h"
+
+DEFINE_string(bc_in, "", "Lifted bitcode file to compile.");
+
+DEFINE_string(obj_out, "",
+              "Name of the object file to produce. The object files of the "
+              "partitions are named `<obj_out>.<N>.o`.");
+
+DEFINE_uint64(num_partitions, 0,
+              "Number of partitions to split the bitcode into. Zero means "
+              "one per hardware thread. Set this explicitly to get the same "
+              "object files on every machine.");
+
+DEFINE_uint64(num_threads, 0,
+              "Number of partitions to compile at once. Zero means one per "
+              "hardware thread.");
+
+DEFINE_uint64(opt_level, 2, "Optimization level, from 0 to 3.");
+
+DEFINE_string(cpu, "", "Target CPU, e.g. `haswell`.");
+
+DEFINE_string(features, "", "Target CPU features, e.g. `+avx2,+bmi2`.");
+
+DEFINE_string(linker, "ld",
+              "Linker used to combine the object files of the partitions "
+              "into one relocatable object file, with `-r`. If empty, the "
+              "object files of the partitions are kept as-is.");
+
+// Compiles lifted bitcode to native code. The bitcode is split into
+// partitions, which are optimized and compiled in parallel, and then linked
+// back together. This is a multi-core replacement for running `llc` over the
+// whole module.
+
+namespace {
+
+// Quote `arg` for the shell.
+static std::string Quote(const std::string &arg) {
+  std::stringstream ss;
+  ss << "'";
+  for (auto c : arg) {
+    if ('\'' == c) {
+      ss << "'\\''";
+    } else {
+      ss << c;
+    }
+  }
+  ss << "'";
+  return ss.str();
+}
+
+}  // namespace
+
+extern "C" int main(int argc, char *argv[]) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  CHECK(!FLAGS_bc_in.empty())
+      << "Please specify a bitcode file with --bc_in.";
+
+  CHECK(!FLAGS_obj_out.empty())
+      << "Please specify an output object file with --obj_out.";
+
+  CHECK(3 >= FLAGS_opt_level)
+      << "Please specify an --opt_level between 0 and 3.";
+
+  llvm::InitializeAllTargetInfos();
+  llvm::InitializeAllTargets();
+  llvm::InitializeAllTargetMCs();
+  llvm::InitializeAllAsmPrinters();
+
+  auto context = new llvm::LLVMContext;
+  std::unique_ptr<llvm::Module> module(
+      remill::LoadModuleFromFile(context, FLAGS_bc_in));
+
+  remill::ParallelCodegenOptions options;
+  options.num_partitions = static_cast<unsigned>(FLAGS_num_partitions);
+  options.num_threads = static_cast<unsigned>(FLAGS_num_threads);
+  options.opt_level = static_cast<unsigned>(FLAGS_opt_level);
+  options.cpu = FLAGS_cpu;
+  options.features = FLAGS_features;
+
+  std::vector<std::string> object_files;
+  remill::CompileModuleInParallel(
+      std::move(module), FLAGS_obj_out, options, &object_files);
+
+  if (FLAGS_linker.empty()) {
+    return EXIT_SUCCESS;
+  }
+
+  // Object files are linked in partition order, so that the output is also
+  // deterministic.
+  std::stringstream cmd;
+  cmd << Quote(FLAGS_linker) << " -r -o " << Quote(FLAGS_obj_out);
+  for (const auto &object_file : object_files) {
+    cmd << " " << Quote(object_file);
+  }
+
+  CHECK(!std::system(cmd.str().c_str()))
+      << "Unable to link " << FLAGS_obj_out << " with: " << cmd.str();
+
+  for (const auto &object_file : object_files) {
+    remill::RemoveFile(object_file);
+  }
+  return EXIT_SUCCESS;
+}
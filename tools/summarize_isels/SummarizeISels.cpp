@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2017 Trail of Bits, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include "remill/BC/ISelSummary.h"
+#include "remill/BC/Util.h"
+
+DEFINE_string(bc_in, "", "Semantics bitcode file to summarize.");
+
+DEFINE_string(summary_out, "",
+              "Name of the file in which to place the ISEL summaries.");
+
+// Generates the table of per-ISEL `State` reads and writes that goes
+// alongside a semantics bitcode file. This runs as part of building the
+// semantics (see `remill/Arch/X86/Runtime/CMakeLists.txt`).
+extern "C" int main(int argc, char *argv[]) {
+
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  CHECK(!FLAGS_bc_in.empty())
+      << "Please specify a semantics bitcode file with --bc_in.";
+
+  CHECK(!FLAGS_summary_out.empty())
+      << "Please specify an output file with --summary_out.";
+
+  auto context = new llvm::LLVMContext;
+  auto module = remill::LoadModuleFromFile(context, FLAGS_bc_in);
+  auto summaries = remill::SummarizeISels(module);
+
+  auto tmp_name = FLAGS_summary_out + ".tmp";
+  std::ofstream os(tmp_name);
+  CHECK(os.good())
+      << "Unable to open " << tmp_name << " for writing.";
+
+  remill::WriteISelSummaries(os, summaries);
+  os.close();
+  CHECK(!os.fail())
+      << "Unable to write ISEL summaries to " << tmp_name;
+
+  CHECK(!rename(tmp_name.c_str(), FLAGS_summary_out.c_str()))
+      << "Unable to rename " << tmp_name << " to " << FLAGS_summary_out;
+
+  delete module;
+  delete context;
+  return 0;
+}